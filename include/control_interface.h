@@ -21,6 +21,7 @@
 #ifndef SUSHI_CONTROL_INTERFACE_H
 #define SUSHI_CONTROL_INTERFACE_H
 
+#include <cstdint>
 #include <utility>
 #include <optional>
 #include <vector>
@@ -66,6 +67,13 @@ struct CpuTimings
     float max;
 };
 
+struct AudioLevel
+{
+    float peak;
+    float rms;
+    float dc_offset;
+};
+
 enum class ParameterType
 {
     BOOL,
@@ -149,6 +157,10 @@ public:
     virtual ControlStatus                           reset_track_timings(int track_id) = 0;
     virtual ControlStatus                           reset_processor_timings(int processor_id) = 0;
 
+    // Audio levels
+    virtual std::pair<ControlStatus, std::vector<AudioLevel>> get_engine_input_levels() const = 0;
+    virtual std::pair<ControlStatus, std::vector<AudioLevel>> get_engine_output_levels() const = 0;
+
     // Track control
     virtual std::pair<ControlStatus, int>           get_track_id(const std::string& track_name) const = 0;
     virtual std::pair<ControlStatus, TrackInfo>     get_track_info(int track_id) const = 0;
@@ -177,6 +189,10 @@ public:
     virtual ControlStatus                              set_parameter_value(int processor_id, int parameter_id, float value) = 0;
     virtual ControlStatus                              set_string_property_value(int processor_id, int parameter_id, const std::string& value) = 0;
 
+    // Session control
+    virtual std::pair<ControlStatus, std::vector<uint8_t>> save_session() const = 0;
+    virtual ControlStatus                              restore_session(const std::vector<uint8_t>& session) = 0;
+
 
 protected:
     SushiControl() = default;
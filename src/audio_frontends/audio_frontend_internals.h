@@ -24,6 +24,8 @@
 #include <xmmintrin.h>
 #endif
 
+#include "library/chunk_size.h"
+
 namespace sushi {
 namespace audio_frontend {
 
@@ -60,6 +62,20 @@ inline float map_audio_to_cv(float audio)
     return (audio + 1.0f) * 0.5f;
 }
 
+/**
+ * @brief Maps a chunk of audio rate cv from an audio input [-1, 1] range to cv range [0, 1]
+ * @param input A float array of size audio_chunk_size() with the audio input signal
+ * @param output A float array of size audio_chunk_size() where the cv signal will be written
+ * @param gain Gain applied to the input before remapping, for hardware specific corrections
+ */
+inline void map_audio_to_cv_signal(const float* input, float* output, float gain = 1.0f)
+{
+    for (int i = 0 ; i < audio_chunk_size(); ++i)
+    {
+        output[i] = map_audio_to_cv(input[i] * gain);
+    }
+}
+
 /**
  * @return Maps a sample from a cv input [0, 1] range to audio range [-1, 1]
  * @param cv A cv value
@@ -73,7 +89,7 @@ inline float map_cv_to_audio(float cv)
 /**
  * @brief Helper function to do ramping of cv outputs that are updated once per
  *        audio chunk.
- * @param output A float array of size AUDIO_CHUNK_SIZE where the smoothed data will
+ * @param output A float array of size audio_chunk_size() where the smoothed data will
  *               be copied to.
  * @param current_value The current value of the smoother
  * @param target_value The target value for the smoother
@@ -81,8 +97,8 @@ inline float map_cv_to_audio(float cv)
  */
 inline float ramp_cv_output(float* output, float current_value, float target_value)
 {
-    float inc = (target_value - current_value) / (AUDIO_CHUNK_SIZE - 1);
-    for (int i = 0 ; i < AUDIO_CHUNK_SIZE; ++i)
+    float inc = (target_value - current_value) / (audio_chunk_size() - 1);
+    for (int i = 0 ; i < audio_chunk_size(); ++i)
     {
         output[i] = current_value + inc * i;
     }
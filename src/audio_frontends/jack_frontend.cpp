@@ -19,12 +19,15 @@
  */
 
 #ifdef SUSHI_BUILD_WITH_JACK
+#include <algorithm>
+
 #include <jack/midiport.h>
 
 #include "logging.h"
 #include "jack_frontend.h"
 #include "audio_frontend_internals.h"
 #include "control_frontends/alsa_midi_frontend.h"
+#include "library/midi_decoder.h"
 
 namespace sushi {
 namespace audio_frontend {
@@ -56,12 +59,26 @@ AudioFrontendStatus JackFrontend::init(BaseAudioFrontendConfiguration* config)
         return AudioFrontendStatus::AUDIO_HW_ERROR;
     }
     _no_cv_output_ports = jack_config->cv_outputs;
+    if (_midi_dispatcher)
+    {
+        _no_midi_input_ports = std::clamp(jack_config->midi_inputs, 0, MAX_FRONTEND_MIDI_PORTS);
+        _no_midi_output_ports = std::clamp(jack_config->midi_outputs, 0, MAX_FRONTEND_MIDI_PORTS);
+        SUSHI_LOG_WARNING_IF(_no_midi_input_ports != jack_config->midi_inputs ||
+                             _no_midi_output_ports != jack_config->midi_outputs,
+                             "Number of Jack midi ports limited to {}", MAX_FRONTEND_MIDI_PORTS);
+    }
     return setup_client(jack_config->client_name, jack_config->server_name);
 }
 
 
 void JackFrontend::cleanup()
 {
+    /* Counted in the process callback, where logging is not allowed */
+    int dropped_events = _dropped_midi_output_events.exchange(0);
+    if (dropped_events > 0)
+    {
+        SUSHI_LOG_WARNING("{} midi events could not be written to Jack midi ports", dropped_events);
+    }
     if (_client)
     {
         jack_client_close(_client);
@@ -132,6 +149,12 @@ AudioFrontendStatus JackFrontend::setup_client(const std::string& client_name,
         SUSHI_LOG_ERROR("Failed to setup cv ports");
         return status;
     }
+    status = setup_midi_ports();
+    if (status != AudioFrontendStatus::OK)
+    {
+        SUSHI_LOG_ERROR("Failed to setup midi ports");
+        return status;
+    }
     return AudioFrontendStatus::OK;
 }
 
@@ -217,6 +240,37 @@ AudioFrontendStatus JackFrontend::setup_cv_ports()
     return AudioFrontendStatus::OK;
 }
 
+AudioFrontendStatus JackFrontend::setup_midi_ports()
+{
+    for (int i = 0; i < _no_midi_input_ports; ++i)
+    {
+        _midi_input_ports[i] = jack_port_register (_client,
+                                                   std::string("midi_input_" + std::to_string(i)).c_str(),
+                                                   JACK_DEFAULT_MIDI_TYPE,
+                                                   JackPortIsInput,
+                                                   0);
+        if (_midi_input_ports[i] == nullptr)
+        {
+            SUSHI_LOG_ERROR("Failed to open Jack midi input port {}.", i);
+            return AudioFrontendStatus::AUDIO_HW_ERROR;
+        }
+    }
+    for (int i = 0; i < _no_midi_output_ports; ++i)
+    {
+        _midi_output_ports[i] = jack_port_register (_client,
+                                                    std::string("midi_output_" + std::to_string(i)).c_str(),
+                                                    JACK_DEFAULT_MIDI_TYPE,
+                                                    JackPortIsOutput,
+                                                    0);
+        if (_midi_output_ports[i] == nullptr)
+        {
+            SUSHI_LOG_ERROR("Failed to open Jack midi output port {}.", i);
+            return AudioFrontendStatus::AUDIO_HW_ERROR;
+        }
+    }
+    return AudioFrontendStatus::OK;
+}
+
 /*
  * Searches for external ports and tries to autoconnect them with sushis ports.
  */
@@ -268,9 +322,10 @@ AudioFrontendStatus JackFrontend::connect_ports()
 int JackFrontend::internal_process_callback(jack_nframes_t framecount)
 {
     set_flush_denormals_to_zero();
-    if (framecount < 64 || framecount % 64)
+    const jack_nframes_t chunk_size = audio_chunk_size();
+    if (framecount < chunk_size || framecount % chunk_size)
     {
-        SUSHI_LOG_CRITICAL("Chunk size not a multiple of AUDIO_CHUNK_SIZE. Skipping.");
+        SUSHI_LOG_CRITICAL("Jack buffer size not a multiple of the audio chunk size. Skipping.");
         return 0;
     }
     jack_nframes_t 	current_frames{0};
@@ -285,13 +340,23 @@ int JackFrontend::internal_process_callback(jack_nframes_t framecount)
     {
         _start_frame = current_frames;
     }
-    /* Process in chunks of AUDIO_CHUNK_SIZE */
+    _midi_input_index.fill(0);
+    for (int i = 0; i < _no_midi_output_ports; ++i)
+    {
+        jack_midi_clear_buffer(jack_port_get_buffer(_midi_output_ports[i], framecount));
+    }
+    /* Process in chunks of audio_chunk_size(), with all chunks of the period
+     * rendered during one wakeup of the engine's worker threads */
     Time start_time = std::chrono::microseconds(current_usecs);
-    for (jack_nframes_t frame = 0; frame < framecount; frame += AUDIO_CHUNK_SIZE)
+    _engine->begin_period(framecount / chunk_size);
+    for (jack_nframes_t frame = 0; frame < framecount; frame += chunk_size)
     {
         Time delta_time = std::chrono::microseconds((frame * 1'000'000) / _sample_rate);
-        process_audio(frame, AUDIO_CHUNK_SIZE, start_time + delta_time, current_frames + frame - _start_frame);
+        process_midi_input(frame, framecount);
+        process_audio(frame, chunk_size, start_time + delta_time, current_frames + frame - _start_frame);
+        process_midi_output(frame, framecount);
     }
+    _engine->end_period();
     return 0;
 }
 
@@ -337,19 +402,19 @@ void inline JackFrontend::process_audio(jack_nframes_t start_frame, jack_nframes
     for (size_t i = 0; i < _input_ports.size(); ++i)
     {
         float* in_data = static_cast<float*>(jack_port_get_buffer(_input_ports[i], framecount)) + start_frame;
-        std::copy(in_data, in_data + AUDIO_CHUNK_SIZE, _in_buffer.channel(i));
+        std::copy(in_data, in_data + _in_buffer.frame_count(), _in_buffer.channel(i));
     }
     for (int i = 0; i < _no_cv_input_ports; ++i)
     {
         float* in_data = static_cast<float*>(jack_port_get_buffer(_cv_input_ports[i], framecount)) + start_frame;
-        _in_controls.cv_values[i] = map_audio_to_cv(in_data[AUDIO_CHUNK_SIZE - 1]);
+        map_audio_to_cv_signal(in_data, _in_controls.cv_signals.channel(i));
     }
     _out_buffer.clear();
     _engine->process_chunk(&_in_buffer, &_out_buffer, &_in_controls, &_out_controls, timestamp, samplecount);
     for (size_t i = 0; i < _input_ports.size(); ++i)
     {
         float* out_data = static_cast<float*>(jack_port_get_buffer(_output_ports[i], framecount)) + start_frame;
-        std::copy(_out_buffer.channel(i), _out_buffer.channel(i) + AUDIO_CHUNK_SIZE, out_data);
+        std::copy(_out_buffer.channel(i), _out_buffer.channel(i) + _out_buffer.frame_count(), out_data);
     }
     /* The jack frontend both inputs and outputs cv in audio range [-1, 1] */
     for (int i = 0; i < _no_cv_output_ports; ++i)
@@ -359,6 +424,87 @@ void inline JackFrontend::process_audio(jack_nframes_t start_frame, jack_nframes
     }
 }
 
+void inline JackFrontend::process_midi_input(jack_nframes_t start_frame, jack_nframes_t framecount)
+{
+    /* Jack delivers the events of a period sorted by time, so events belonging to this
+     * chunk are dispatched until the first event of the next chunk is found */
+    const auto end_frame = start_frame + static_cast<jack_nframes_t>(audio_chunk_size());
+    for (int i = 0; i < _no_midi_input_ports; ++i)
+    {
+        void* port_buffer = jack_port_get_buffer(_midi_input_ports[i], framecount);
+        auto event_count = jack_midi_get_event_count(port_buffer);
+        auto& index = _midi_input_index[i];
+        jack_midi_event_t midi_event;
+        while (index < event_count && jack_midi_event_get(&midi_event, port_buffer, index) == 0)
+        {
+            if (midi_event.time >= end_frame)
+            {
+                break;
+            }
+            ++index;
+            /* System exclusive messages don't fit in a MidiDataByte */
+            if (midi_event.size > 0 && midi_event.size < sizeof(MidiDataByte))
+            {
+                auto data = midi::to_midi_data_byte(midi_event.buffer, static_cast<int>(midi_event.size));
+                int offset = std::max(0, static_cast<int>(midi_event.time) - static_cast<int>(start_frame));
+                _midi_dispatcher->send_midi_rt(i, data, offset);
+            }
+        }
+    }
+}
+
+void inline JackFrontend::process_midi_output(jack_nframes_t start_frame, jack_nframes_t framecount)
+{
+    if (_no_midi_output_ports == 0)
+    {
+        return;
+    }
+    /* Events from different tracks are not ordered by time in the queue, but Jack requires
+     * the events written to a port to be, so they are sorted by insertion first. Events with
+     * the same time keep their queue order */
+    std::array<midi_dispatcher::MidiOutputMessage, MAX_FRONTEND_MIDI_PORTS> messages;
+    int pending_count = 0;
+    RtEvent event;
+    while (_out_controls.midi_events.pop(event))
+    {
+        int count = _midi_dispatcher->encode_rt_event(event, messages.data(), messages.size());
+        for (int i = 0; i < count; ++i)
+        {
+            const auto& msg = messages[i];
+            int size = midi::decode_message_size(msg.data);
+            if (msg.output >= _no_midi_output_ports || size == 0)
+            {
+                continue;
+            }
+            if (pending_count == static_cast<int>(_pending_midi_output.size()))
+            {
+                _dropped_midi_output_events.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            PendingMidiOutput pending{start_frame + event.sample_offset(), msg.output, size, msg.data};
+            auto begin = _pending_midi_output.begin();
+            auto end = begin + pending_count;
+            auto pos = std::upper_bound(begin, end, pending, [](const auto& lhs, const auto& rhs)
+            {
+                return lhs.time < rhs.time;
+            });
+            std::move_backward(pos, end, end + 1);
+            *pos = pending;
+            ++pending_count;
+        }
+    }
+
+    for (int i = 0; i < pending_count; ++i)
+    {
+        const auto& pending = _pending_midi_output[i];
+        void* port_buffer = jack_port_get_buffer(_midi_output_ports[pending.output], framecount);
+        if (jack_midi_event_write(port_buffer, pending.time, pending.data.data(), pending.size) != 0)
+        {
+            _dropped_midi_output_events.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
 }; // end namespace audio_frontend
 }; // end namespace sushi
 #endif
@@ -369,7 +515,7 @@ void inline JackFrontend::process_audio(jack_nframes_t start_frame, jack_nframes
 namespace sushi {
 namespace audio_frontend {
 SUSHI_GET_LOGGER;
-JackFrontend::JackFrontend(engine::BaseEngine* engine) : BaseAudioFrontend(engine)
+JackFrontend::JackFrontend(engine::BaseEngine* engine, midi_dispatcher::MidiDispatcher*) : BaseAudioFrontend(engine)
 {
     /* The log print needs to be in a cpp file for initialisation order reasons */
     SUSHI_LOG_ERROR("Sushi was not built with Jack support!");
@@ -22,27 +22,36 @@
 #define SUSHI_JACK_FRONTEND_H
 #ifdef SUSHI_BUILD_WITH_JACK
 
+#include <array>
+#include <atomic>
 #include <string>
 #include <memory>
 
 #include <jack/jack.h>
 
 #include "base_audio_frontend.h"
+#include "engine/midi_dispatcher.h"
 
 namespace sushi {
 namespace audio_frontend {
 
+constexpr int MAX_FRONTEND_MIDI_PORTS = 8;
+
 struct JackFrontendConfiguration : public BaseAudioFrontendConfiguration
 {
     JackFrontendConfiguration(const std::string& client_name,
                               const std::string& server_name,
                               bool autoconnect_ports,
                               int cv_inputs,
-                              int cv_outputs) :
+                              int cv_outputs,
+                              int midi_inputs = 0,
+                              int midi_outputs = 0) :
             BaseAudioFrontendConfiguration(cv_inputs, cv_outputs),
             client_name(client_name),
             server_name(server_name),
-            autoconnect_ports(autoconnect_ports)
+            autoconnect_ports(autoconnect_ports),
+            midi_inputs(midi_inputs),
+            midi_outputs(midi_outputs)
     {}
 
     virtual ~JackFrontendConfiguration() = default;
@@ -50,12 +59,23 @@ struct JackFrontendConfiguration : public BaseAudioFrontendConfiguration
     std::string client_name;
     std::string server_name;
     bool autoconnect_ports;
+    int midi_inputs;
+    int midi_outputs;
 };
 
 class JackFrontend : public BaseAudioFrontend
 {
 public:
-    JackFrontend(engine::BaseEngine* engine) : BaseAudioFrontend(engine) {}
+    /**
+     * @brief Create a Jack frontend
+     * @param engine The engine to process audio with
+     * @param midi_dispatcher If not null, midi from Jack midi ports is dispatched through
+     *        this in the audio callback, and outgoing keyboard events are written to Jack
+     *        midi ports with sample accurate timing.
+     */
+    JackFrontend(engine::BaseEngine* engine,
+                 midi_dispatcher::MidiDispatcher* midi_dispatcher = nullptr) : BaseAudioFrontend(engine),
+                                                                              _midi_dispatcher(midi_dispatcher) {}
 
     virtual ~JackFrontend()
     {
@@ -113,6 +133,7 @@ private:
     AudioFrontendStatus setup_sample_rate();
     AudioFrontendStatus setup_ports();
     AudioFrontendStatus setup_cv_ports();
+    AudioFrontendStatus setup_midi_ports();
     /* Call after activation to connect the frontend ports to system ports */
     AudioFrontendStatus connect_ports();
 
@@ -123,6 +144,10 @@ private:
 
     void process_audio(jack_nframes_t start_frame, jack_nframes_t framecount, Time timestamp, int64_t samplecount);
 
+    /* Read and write midi for the chunk starting at start_frame */
+    void process_midi_input(jack_nframes_t start_frame, jack_nframes_t framecount);
+    void process_midi_output(jack_nframes_t start_frame, jack_nframes_t framecount);
+
     std::array<jack_port_t*, MAX_FRONTEND_CHANNELS> _input_ports;
     std::array<jack_port_t*, MAX_FRONTEND_CHANNELS> _output_ports;
     std::array<jack_port_t*, MAX_ENGINE_CV_IO_PORTS> _cv_input_ports;
@@ -131,6 +156,25 @@ private:
     int _no_cv_input_ports;
     int _no_cv_output_ports;
 
+    std::array<jack_port_t*, MAX_FRONTEND_MIDI_PORTS> _midi_input_ports;
+    std::array<jack_port_t*, MAX_FRONTEND_MIDI_PORTS> _midi_output_ports;
+    /* Index of the next unread event per midi input port in the current period */
+    std::array<uint32_t, MAX_FRONTEND_MIDI_PORTS> _midi_input_index{0};
+    int _no_midi_input_ports{0};
+    int _no_midi_output_ports{0};
+    midi_dispatcher::MidiDispatcher* _midi_dispatcher;
+
+    /* Outgoing midi of one chunk, sorted by time before being written to the ports */
+    struct PendingMidiOutput
+    {
+        jack_nframes_t time;
+        int output;
+        int size;
+        MidiDataByte data;
+    };
+    std::array<PendingMidiOutput, MAX_ENGINE_MIDI_EVENTS> _pending_midi_output;
+    std::atomic<int> _dropped_midi_output_events{0};
+
     jack_client_t* _client{nullptr};
     jack_nframes_t _sample_rate;
     jack_nframes_t _start_frame{0};
@@ -158,13 +202,14 @@ struct JackFrontendConfiguration : public BaseAudioFrontendConfiguration
 {
     JackFrontendConfiguration(const std::string&,
                               const std::string&,
-                              bool, int, int) : BaseAudioFrontendConfiguration(0, 0) {}
+                              bool, int, int,
+                              int = 0, int = 0) : BaseAudioFrontendConfiguration(0, 0) {}
 };
 
 class JackFrontend : public BaseAudioFrontend
 {
 public:
-    JackFrontend(engine::BaseEngine* engine);
+    JackFrontend(engine::BaseEngine* engine, midi_dispatcher::MidiDispatcher* midi_dispatcher = nullptr);
     AudioFrontendStatus init(BaseAudioFrontendConfiguration*) override
     {return AudioFrontendStatus::OK;}
     void cleanup() override {}
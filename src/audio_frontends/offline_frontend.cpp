@@ -18,8 +18,10 @@
 * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
 */
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <optional>
 #include <random>
 
 #include "logging.h"
@@ -34,13 +36,31 @@ SUSHI_GET_LOGGER_WITH_MODULE_NAME("offline audio");
 constexpr float INPUT_NOISE_LEVEL = powf(10, (-24.0f/20.0f)); // -24 dB input noise
 constexpr int   NOISE_SEED = 5; // Using a constant seed makes potential errors reproducible
 
+/* FNV-1a hash of the raw sample data, any difference in the output, however
+ * small, will give a different hash */
+constexpr uint64_t HASH_OFFSET_BASIS = 14695981039346656037u;
+constexpr uint64_t HASH_PRIME = 1099511628211u;
+
+uint64_t hash_buffer(const ChunkSampleBuffer& buffer, uint64_t hash = HASH_OFFSET_BASIS)
+{
+    for (int c = 0; c < buffer.channel_count(); ++c)
+    {
+        auto data = reinterpret_cast<const uint8_t*>(buffer.channel(c));
+        for (size_t i = 0; i < buffer.frame_count() * sizeof(float); ++i)
+        {
+            hash = (hash ^ data[i]) * HASH_PRIME;
+        }
+    }
+    return hash;
+}
+
 template<class random_device, class random_dist>
 void fill_buffer_with_noise(ChunkSampleBuffer& buffer, random_device& dev, random_dist& dist)
 {
     for (int c = 0; c < buffer.channel_count(); ++c)
     {
         float* channel = buffer.channel(c);
-        for (int i = 0; i < AUDIO_CHUNK_SIZE; ++i)
+        for (int i = 0; i < buffer.frame_count(); ++i)
         {
             channel[i] = dist(dev);
         }
@@ -50,9 +70,11 @@ void fill_buffer_with_noise(ChunkSampleBuffer& buffer, random_device& dev, rando
 template<class random_device, class random_dist>
 void fill_cv_buffer_with_noise(engine::ControlBuffer& buffer, random_device& dev, random_dist& dist)
 {
-    for (auto& cv : buffer.cv_values)
+    for (int i = 0; i < buffer.cv_signals.channel_count(); ++i)
     {
-        cv = map_audio_to_cv(dist(dev));
+        /* Noise is held over the chunk, as that is closer to typical cv signals */
+        float value = map_audio_to_cv(dist(dev));
+        std::fill(buffer.cv_signals.channel(i), buffer.cv_signals.channel(i) + buffer.cv_signals.frame_count(), value);
     }
 }
 
@@ -116,17 +138,84 @@ AudioFrontendStatus OfflineFrontend::init(BaseAudioFrontendConfiguration* config
     }
     _engine->set_output_latency(std::chrono::microseconds(0));
 
+    if (off_config->deterministic)
+    {
+        if (off_config->hash_filename.empty() == false)
+        {
+            _hash_file.open(off_config->hash_filename);
+            if (_hash_file.good() == false)
+            {
+                cleanup();
+                SUSHI_LOG_ERROR("Unable to open hash file {}", off_config->hash_filename);
+                return AudioFrontendStatus::INVALID_OUTPUT_FILE;
+            }
+        }
+        _engine->event_dispatcher()->set_synchronous_mode(true);
+        _deterministic = true;
+    }
     return ret_code;
 }
 
 void OfflineFrontend::add_sequencer_events(std::vector<Event*> events)
 {
-    // Sort events by reverse time
-    std::sort(events.begin(), events.end(), [](const Event* lhs, const Event* rhs)
-                                              {
-                                                  return lhs->time() >= rhs->time();
-                                              });
-    _event_queue = std::move(events);
+    for (auto event : events)
+    {
+        if (event->maps_to_rt_event())
+        {
+            auto sample = _time_to_sample(std::chrono::duration<double>(event->time()).count());
+            _rt_event_queue.push_back({sample, event->to_rt_event(0)});
+        }
+        else
+        {
+            SUSHI_LOG_WARNING("Sequenced event at {} us can not be run in offline mode", event->time().count());
+        }
+        delete event;
+    }
+    _sort_events();
+}
+
+bool OfflineFrontend::add_midi_events(const std::vector<midi_file::MidiFileEvent>& events, int midi_input)
+{
+    if (_midi_dispatcher == nullptr)
+    {
+        SUSHI_LOG_ERROR("No midi dispatcher, can't add midi events");
+        return false;
+    }
+    for (const auto& event : events)
+    {
+        _midi_event_queue.push_back({_time_to_sample(event.time), midi_input, event.data});
+    }
+    _sort_events();
+    return true;
+}
+
+bool OfflineFrontend::add_automation(const automation_file::AutomationData& automation)
+{
+    bool all_found = true;
+    std::vector<std::optional<std::pair<ObjectId, ObjectId>>> ids;
+    for (const auto& parameter : automation.parameters)
+    {
+        auto [processor_status, processor_id] = _engine->processor_id_from_name(parameter.processor);
+        auto [parameter_status, parameter_id] = _engine->parameter_id_from_name(parameter.processor, parameter.parameter);
+        if (processor_status != engine::EngineReturnStatus::OK || parameter_status != engine::EngineReturnStatus::OK)
+        {
+            SUSHI_LOG_WARNING("Automated parameter {} on {} not found", parameter.parameter, parameter.processor);
+            ids.push_back(std::nullopt);
+            all_found = false;
+            continue;
+        }
+        ids.push_back(std::make_pair(processor_id, parameter_id));
+    }
+    for (const auto& event : automation.events)
+    {
+        if (event.parameter < ids.size() && ids[event.parameter].has_value())
+        {
+            auto [processor_id, parameter_id] = ids[event.parameter].value();
+            _rt_event_queue.push_back({event.sample, RtEvent::make_parameter_change_event(processor_id, 0, parameter_id, event.value)});
+        }
+    }
+    _sort_events();
+    return all_found;
 }
 
 void OfflineFrontend::cleanup()
@@ -146,12 +235,35 @@ void OfflineFrontend::cleanup()
         sf_close(_output_file);
         _output_file = nullptr;
     }
+    if (_hash_file.is_open())
+    {
+        _hash_file.close();
+    }
+    if (_deterministic)
+    {
+        _engine->event_dispatcher()->set_synchronous_mode(false);
+        _deterministic = false;
+    }
 }
 
-int time_to_sample_offset(Time chunk_end_time, Time event_time, float samplerate)
+int64_t OfflineFrontend::_time_to_sample(double seconds) const
 {
-    Time chunktime = std::chrono::microseconds(static_cast<uint64_t>(1'000'000.f * AUDIO_CHUNK_SIZE / samplerate));
-    return AUDIO_CHUNK_SIZE - static_cast<int>((AUDIO_CHUNK_SIZE * (chunk_end_time - event_time) / chunktime));
+    return std::llround(seconds * _engine->sample_rate());
+}
+
+void OfflineFrontend::_sort_events()
+{
+    /* Stable sort so that events on the same sample keep the order they were added in */
+    std::stable_sort(_rt_event_queue.begin() + _rt_event_index, _rt_event_queue.end(),
+                     [](const SequencedRtEvent& lhs, const SequencedRtEvent& rhs)
+                     {
+                         return lhs.sample < rhs.sample;
+                     });
+    std::stable_sort(_midi_event_queue.begin() + _midi_event_index, _midi_event_queue.end(),
+                     [](const SequencedMidiEvent& lhs, const SequencedMidiEvent& rhs)
+                     {
+                         return lhs.sample < rhs.sample;
+                     });
 }
 
 void OfflineFrontend::run()
@@ -166,27 +278,52 @@ void OfflineFrontend::run()
     }
 }
 
-// Process all events up until end_time
-void OfflineFrontend::_process_events(Time end_time)
+void OfflineFrontend::_process_events(int64_t start_sample)
+{
+    int64_t end_sample = start_sample + _buffer.frame_count();
+    while (_rt_event_index < _rt_event_queue.size() && _rt_event_queue[_rt_event_index].sample < end_sample)
+    {
+        auto& next = _rt_event_queue[_rt_event_index++];
+        next.event.set_sample_offset(static_cast<int>(std::max(int64_t(0), next.sample - start_sample)));
+        _engine->send_rt_event(next.event);
+    }
+    while (_midi_event_index < _midi_event_queue.size() && _midi_event_queue[_midi_event_index].sample < end_sample)
+    {
+        const auto& next = _midi_event_queue[_midi_event_index++];
+        int offset = static_cast<int>(std::max(int64_t(0), next.sample - start_sample));
+        _midi_dispatcher->send_midi_rt(next.midi_input, next.data, offset);
+    }
+}
+
+void OfflineFrontend::_post_process(int64_t start_sample)
 {
-    while (!_event_queue.empty() && _event_queue.back()->time() < end_time)
+    if (_deterministic == false)
     {
-        auto next_event = _event_queue.back();
-        if (next_event->maps_to_rt_event())
+        return;
+    }
+    /* Hashed before any graph changes from the pending events, so only the tracks that
+     * rendered this chunk are included */
+    if (_hash_file.is_open())
+    {
+        for (const auto& track : _engine->all_tracks())
         {
-            int offset = time_to_sample_offset(end_time, next_event->time(), _engine->sample_rate());
-            auto rt_event = next_event->to_rt_event(offset);
-            _engine->send_rt_event(rt_event);
+            uint64_t hash = HASH_OFFSET_BASIS;
+            for (int c = 0; c < track->output_channels(); ++c)
+            {
+                hash = hash_buffer(track->output_channel(c), hash);
+            }
+            _hash_file << start_sample << " " << track->name() << " " << std::hex << hash << std::dec << "\n";
         }
-        _event_queue.pop_back();
-        delete next_event;
     }
+    /* Events sent from the engine and any responses to them are handled before the next
+     * chunk, instead of whenever the event thread happens to run */
+    _engine->event_dispatcher()->process_pending_events();
 }
 
 void OfflineFrontend::_process_dummy()
 {
     set_flush_denormals_to_zero();
-    int samplecount = 0;
+    int64_t samplecount = 0;
     double usec_time = 0.0f;
     Time start_time = std::chrono::microseconds(0);
 
@@ -198,15 +335,14 @@ void OfflineFrontend::_process_dummy()
     {
         auto process_time = start_time + std::chrono::microseconds(static_cast<uint64_t>(usec_time));
 
-        samplecount += AUDIO_CHUNK_SIZE;
-        usec_time += AUDIO_CHUNK_SIZE * 1'000'000.f / _engine->sample_rate();
-
-        Time chunk_end_time = start_time + std::chrono::microseconds(static_cast<uint64_t>(usec_time));
-        _process_events(chunk_end_time);
+        _process_events(samplecount);
+        samplecount += _buffer.frame_count();
+        usec_time += _buffer.frame_count() * 1'000'000.f / _engine->sample_rate();
 
         fill_buffer_with_noise(_buffer, rand_gen, normal_dist);
         fill_cv_buffer_with_noise(_control_buffer, rand_gen, normal_dist);
         _engine->process_chunk(&_buffer, &_buffer, &_control_buffer, &_control_buffer, process_time, samplecount);
+        _post_process(samplecount - _buffer.frame_count());
     }
 }
 
@@ -214,28 +350,26 @@ void OfflineFrontend::_run_blocking()
 {
     set_flush_denormals_to_zero();
     int readcount;
-    int samplecount = 0;
+    int64_t samplecount = 0;
     double usec_time = 0.0f;
     Time start_time = std::chrono::microseconds(0);
 
     float file_buffer[OFFLINE_FRONTEND_CHANNELS * AUDIO_CHUNK_SIZE];
     while ( (readcount = static_cast<int>(sf_readf_float(_input_file,
                                                          file_buffer,
-                                                         static_cast<sf_count_t>(AUDIO_CHUNK_SIZE)))) )
+                                                         static_cast<sf_count_t>(_buffer.frame_count())))) )
     {
         auto process_time = start_time + std::chrono::microseconds(static_cast<uint64_t>(usec_time));
 
+        _process_events(samplecount);
         samplecount += readcount;
         usec_time += readcount * 1'000'000.f / _engine->sample_rate();
 
-        Time chunk_end_time = start_time + std::chrono::microseconds(static_cast<uint64_t>(usec_time));
-        _process_events(chunk_end_time);
-
         _buffer.clear();
 
         if (_mono)
         {
-            std::copy(file_buffer, file_buffer + AUDIO_CHUNK_SIZE, _buffer.channel(0));
+            std::copy(file_buffer, file_buffer + _buffer.frame_count(), _buffer.channel(0));
         }
         else
         {
@@ -244,10 +378,11 @@ void OfflineFrontend::_run_blocking()
         }
         /* Gate and CV are ignored when using file frontend */
         _engine->process_chunk(&_buffer, &_buffer, &_control_buffer, &_control_buffer, process_time, samplecount);
+        _post_process(samplecount - readcount);
 
         if (_mono)
         {
-            std::copy(_buffer.channel(0), _buffer.channel(0) + AUDIO_CHUNK_SIZE, file_buffer );
+            std::copy(_buffer.channel(0), _buffer.channel(0) + _buffer.frame_count(), file_buffer );
         }
         else
         {
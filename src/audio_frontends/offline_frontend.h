@@ -24,12 +24,16 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <fstream>
 #include <thread>
 
 #include <sndfile.h>
 
 #include "base_audio_frontend.h"
 #include "library/rt_event.h"
+#include "library/midi_file.h"
+#include "library/automation_file.h"
+#include "engine/midi_dispatcher.h"
 
 namespace sushi {
 
@@ -45,26 +49,42 @@ struct OfflineFrontendConfiguration : public BaseAudioFrontendConfiguration
                                  const std::string output_filename,
                                  bool dummy_mode,
                                  int cv_inputs,
-                                 int cv_outputs) :
+                                 int cv_outputs,
+                                 bool deterministic = false,
+                                 const std::string hash_filename = "") :
             BaseAudioFrontendConfiguration(cv_inputs, cv_outputs),
             input_filename(input_filename),
             output_filename(output_filename),
-            dummy_mode(dummy_mode)
+            dummy_mode(dummy_mode),
+            deterministic(deterministic),
+            hash_filename(hash_filename)
     {}
 
     virtual ~OfflineFrontendConfiguration() = default;
     std::string input_filename;
     std::string output_filename;
     bool dummy_mode;
+    /* Process control events synchronously between chunks so that renders are reproducible */
+    bool deterministic;
+    /* If not empty, a hash of every track's output is written to this file for every chunk */
+    std::string hash_filename;
 };
 
 class OfflineFrontend : public BaseAudioFrontend
 {
 public:
-    OfflineFrontend(engine::BaseEngine* engine) : BaseAudioFrontend(engine),
-                                                  _input_file(nullptr),
-                                                  _output_file(nullptr),
-                                                  _running{true}
+    /**
+     * @brief Create an offline frontend
+     * @param engine The engine to process audio with
+     * @param midi_dispatcher Used for routing sequenced midi events, if null, midi
+     *        events can not be added.
+     */
+    OfflineFrontend(engine::BaseEngine* engine,
+                    midi_dispatcher::MidiDispatcher* midi_dispatcher = nullptr) : BaseAudioFrontend(engine),
+                                                                                 _input_file(nullptr),
+                                                                                 _output_file(nullptr),
+                                                                                 _running{true},
+                                                                                 _midi_dispatcher(midi_dispatcher)
     {
         _buffer.clear();
     }
@@ -77,17 +97,56 @@ public:
     AudioFrontendStatus init(BaseAudioFrontendConfiguration* config) override;
 
     /**
-     * @brief Add events that should be run during the processing
-     * @param An std::vector containing the timestamped events.
+     * @brief Add events that should be run during the processing. The events are
+     *        converted to RtEvents and delivered to the engine at their exact sample
+     *        position, independently of the processing speed. Events that have no
+     *        realtime representation are ignored. Call after the engine sample rate
+     *        is set.
+     * @param An std::vector containing the timestamped events, takes ownership of the events.
      */
     void add_sequencer_events(std::vector<Event*> events);
 
+    /**
+     * @brief Add midi events that should be run during the processing. The events are
+     *        routed through the midi dispatcher at their exact sample position.
+     * @param events Midi events, i.e. from a Standard Midi File.
+     * @param midi_input The midi input the events should appear to come from
+     * @return true if the events were added, false if there is no midi dispatcher
+     */
+    bool add_midi_events(const std::vector<midi_file::MidiFileEvent>& events, int midi_input = 0);
+
+    /**
+     * @brief Add parameter automation that should be run during the processing.
+     * @param automation Automation data, i.e. from an automation file.
+     * @return true if all parameters in the automation data were found, events
+     *         targeting unknown parameters are dropped.
+     */
+    bool add_automation(const automation_file::AutomationData& automation);
+
     void cleanup() override;
 
     void run() override;
 
 private:
-    void _process_events(Time end_time);
+    struct SequencedRtEvent
+    {
+        int64_t sample;
+        RtEvent event;
+    };
+
+    struct SequencedMidiEvent
+    {
+        int64_t sample;
+        int midi_input;
+        MidiDataByte data;
+    };
+
+    int64_t _time_to_sample(double seconds) const;
+    void _sort_events();
+    /* Deliver all events in the chunk starting at start_sample to the engine */
+    void _process_events(int64_t start_sample);
+    /* Called after processing each chunk */
+    void _post_process(int64_t start_sample);
     void _process_dummy();
     void _run_blocking();
 
@@ -102,7 +161,16 @@ private:
     SampleBuffer<AUDIO_CHUNK_SIZE> _buffer{DUMMY_FRONTEND_CHANNELS};
     engine::ControlBuffer _control_buffer;
 
-    std::vector<Event*> _event_queue;
+    midi_dispatcher::MidiDispatcher* _midi_dispatcher;
+
+    bool _deterministic{false};
+    std::ofstream _hash_file;
+
+    /* Sorted by sample position, the next event to deliver is at the read index */
+    std::vector<SequencedRtEvent> _rt_event_queue;
+    std::vector<SequencedMidiEvent> _midi_event_queue;
+    size_t _rt_event_index{0};
+    size_t _midi_event_index{0};
 };
 
 }; // end namespace audio_frontend
@@ -0,0 +1,418 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Headless frontend for load and soak testing
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "logging.h"
+#include "stress_frontend.h"
+#include "audio_frontend_internals.h"
+#include "library/midi_encoder.h"
+
+namespace sushi {
+namespace audio_frontend {
+
+SUSHI_GET_LOGGER_WITH_MODULE_NAME("stress frontend");
+
+constexpr float INPUT_NOISE_LEVEL = 0.063f; // Roughly -24 dB
+constexpr int   RANDOM_SEED = 5;            // Constant seeds make a run reproducible
+constexpr auto  CONTROL_PERIOD = std::chrono::milliseconds(1);
+constexpr int   MAX_HELD_NOTES = 16;
+constexpr int   MAX_ADDED_PROCESSORS = 8;
+constexpr auto  EDIT_PLUGIN_UID = "sushi.testing.passthrough";
+
+void LoadHistogram::add(float load)
+{
+    int bin = static_cast<int>(load * (BINS / MAX_LOAD));
+    bin = std::clamp(bin, 0, BINS - 1);
+    _bins[bin].fetch_add(1, std::memory_order_relaxed);
+}
+
+LoadHistogram::Counts LoadHistogram::counts() const
+{
+    Counts counts;
+    for (int i = 0; i < BINS; ++i)
+    {
+        counts[i] = _bins[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+float LoadHistogram::percentile(const Counts& counts, float percentile)
+{
+    uint64_t total = 0;
+    for (auto count : counts)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return 0.0f;
+    }
+    auto limit = static_cast<uint64_t>(std::ceil(total * percentile / 100.0f));
+    limit = std::max(limit, uint64_t(1));
+    uint64_t sum = 0;
+    for (int i = 0; i < BINS; ++i)
+    {
+        sum += counts[i];
+        if (sum >= limit)
+        {
+            return (i + 1) * (MAX_LOAD / BINS);
+        }
+    }
+    return MAX_LOAD;
+}
+
+AudioFrontendStatus StressFrontend::init(BaseAudioFrontendConfiguration* config)
+{
+    auto ret_code = BaseAudioFrontend::init(config);
+    if (ret_code != AudioFrontendStatus::OK)
+    {
+        return ret_code;
+    }
+    auto stress_config = static_cast<StressFrontendConfiguration*>(_config);
+    _paced = stress_config->paced;
+    _midi_rate = std::max(stress_config->midi_rate, 0.0f);
+    _parameter_rate = std::max(stress_config->parameter_rate, 0.0f);
+    _graph_edit_rate = std::max(stress_config->graph_edit_rate, 0.0f);
+    _report_interval = stress_config->report_interval;
+
+    _engine->set_audio_input_channels(STRESS_FRONTEND_CHANNELS);
+    _engine->set_audio_output_channels(STRESS_FRONTEND_CHANNELS);
+    auto status = _engine->set_cv_input_channels(stress_config->cv_inputs);
+    if (status != engine::EngineReturnStatus::OK)
+    {
+        SUSHI_LOG_ERROR("Setting {} cv inputs failed", stress_config->cv_inputs);
+        return AudioFrontendStatus::AUDIO_HW_ERROR;
+    }
+    status = _engine->set_cv_output_channels(stress_config->cv_outputs);
+    if (status != engine::EngineReturnStatus::OK)
+    {
+        SUSHI_LOG_ERROR("Setting {} cv outputs failed", stress_config->cv_outputs);
+        return AudioFrontendStatus::AUDIO_HW_ERROR;
+    }
+    _engine->set_output_latency(std::chrono::microseconds(0));
+    return ret_code;
+}
+
+void StressFrontend::cleanup()
+{
+    bool was_running = _running.exchange(false);
+    if (_control_thread.joinable())
+    {
+        _control_thread.join();
+    }
+    if (_audio_worker_pool)
+    {
+        _audio_worker_pool->wait_for_workers_idle();
+        _audio_worker_pool.reset();
+    }
+    if (_audio_thread.joinable())
+    {
+        _audio_thread.join();
+    }
+    if (was_running == false)
+    {
+        return;
+    }
+    _engine->enable_realtime(false);
+    if (_midi_dispatcher)
+    {
+        for (auto note : _held_notes)
+        {
+            _midi_dispatcher->send_midi(0, midi::encode_note_off(0, note, 0.0f), IMMEDIATE_PROCESS);
+        }
+    }
+    _held_notes.clear();
+    _report(_load.counts(), _read_counters(), _max_load.load(), "Total");
+}
+
+void StressFrontend::run()
+{
+    auto snapshot = _engine->graph_snapshot();
+    _parameter_targets.clear();
+    for (const auto& processor : snapshot->processors())
+    {
+        for (const auto& parameter : processor.second->all_parameters())
+        {
+            if (parameter->type() == ParameterType::FLOAT)
+            {
+                _parameter_targets.push_back({processor.second->id(), parameter->id()});
+            }
+        }
+    }
+    _tracks.clear();
+    for (const auto& node : snapshot->tracks())
+    {
+        _tracks.push_back(node.track->name());
+    }
+    SUSHI_LOG_INFO("Starting stress test, {} parameters and {} tracks", _parameter_targets.size(), _tracks.size());
+
+    _rand_gen.seed(RANDOM_SEED);
+    _engine->enable_realtime(true);
+    _start_time = std::chrono::steady_clock::now();
+    _running = true;
+    _audio_worker_pool = twine::WorkerPool::create_worker_pool(1);
+    if (_audio_worker_pool && _audio_worker_pool->add_worker(_audio_thread_function, this) == twine::WorkerPoolStatus::OK)
+    {
+        _audio_worker_pool->wakeup_workers();
+    }
+    else
+    {
+        _audio_worker_pool.reset();
+        SUSHI_LOG_WARNING("Failed to create a realtime audio thread, measurements will not reflect realtime scheduling");
+        std::cout << "Warning: No realtime audio thread, measurements will not reflect realtime scheduling" << std::endl;
+        _audio_thread = std::thread(&StressFrontend::_audio_loop, this);
+    }
+    _control_thread = std::thread(&StressFrontend::_control_loop, this);
+}
+
+void StressFrontend::_audio_thread_function(void* arg)
+{
+    static_cast<StressFrontend*>(arg)->_audio_loop();
+}
+
+void StressFrontend::_audio_loop()
+{
+    set_flush_denormals_to_zero();
+    std::ranlux24 rand_gen;
+    rand_gen.seed(RANDOM_SEED);
+    std::normal_distribution<float> normal_dist(0.0f, INPUT_NOISE_LEVEL);
+
+    auto chunk_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(_buffer.frame_count() / _engine->sample_rate()));
+    int64_t samplecount = 0;
+    auto deadline = std::chrono::steady_clock::now() + chunk_duration;
+
+    while (_running)
+    {
+        for (int c = 0; c < _buffer.channel_count(); ++c)
+        {
+            std::generate(_buffer.channel(c), _buffer.channel(c) + _buffer.frame_count(), [&]() {return normal_dist(rand_gen);});
+        }
+        auto process_time = std::chrono::duration_cast<Time>(std::chrono::duration<double>(samplecount / _engine->sample_rate()));
+
+        auto start = std::chrono::steady_clock::now();
+        _engine->process_chunk(&_buffer, &_buffer, &_control_buffer, &_control_buffer, process_time, samplecount);
+        auto stop = std::chrono::steady_clock::now();
+        samplecount += _buffer.frame_count();
+
+        float load = std::chrono::duration<float>(stop - start) / chunk_duration;
+        _load.add(load);
+        if (load > _max_load.load(std::memory_order_relaxed))
+        {
+            _max_load.store(load, std::memory_order_relaxed);
+        }
+        _chunks.fetch_add(1, std::memory_order_relaxed);
+
+        if (_paced)
+        {
+            /* The deadline is when the next chunk would have been requested by the hardware */
+            if (stop > deadline)
+            {
+                _deadline_misses.fetch_add(1, std::memory_order_relaxed);
+                if (stop > deadline + chunk_duration)
+                {
+                    /* A hardware driver would have dropped the buffer and restarted, do the
+                     * same instead of trying to catch up by processing several chunks back to back */
+                    deadline = stop;
+                }
+            }
+            std::this_thread::sleep_until(deadline);
+            deadline += chunk_duration;
+        }
+        else if (load > 1.0f)
+        {
+            _deadline_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void StressFrontend::_control_loop()
+{
+    float seconds_per_period = std::chrono::duration<float>(CONTROL_PERIOD).count();
+    float midi_acc = 0;
+    float parameter_acc = 0;
+    float graph_edit_acc = 0;
+    auto next_wakeup = std::chrono::steady_clock::now();
+    auto next_report = next_wakeup + _report_interval;
+    auto last_counts = _load.counts();
+    auto last_counters = _read_counters();
+
+    while (_running)
+    {
+        /* Fractional accumulators so that rates below and above the control
+         * rate both end up with the right average number of events */
+        midi_acc += _midi_rate * seconds_per_period;
+        parameter_acc += _parameter_rate * seconds_per_period;
+        graph_edit_acc += _graph_edit_rate * seconds_per_period;
+        for (; midi_acc >= 1.0f; midi_acc -= 1.0f)
+        {
+            _send_midi();
+        }
+        for (; parameter_acc >= 1.0f; parameter_acc -= 1.0f)
+        {
+            _send_parameter_change();
+        }
+        for (; graph_edit_acc >= 1.0f; graph_edit_acc -= 1.0f)
+        {
+            _send_graph_edit();
+        }
+
+        if (_report_interval.count() > 0 && std::chrono::steady_clock::now() >= next_report)
+        {
+            auto counts = _load.counts();
+            auto counters = _read_counters();
+            LoadHistogram::Counts interval_counts;
+            for (int i = 0; i < LoadHistogram::BINS; ++i)
+            {
+                interval_counts[i] = counts[i] - last_counts[i];
+            }
+            Counters interval_counters{counters.chunks - last_counters.chunks,
+                                       counters.deadline_misses - last_counters.deadline_misses,
+                                       counters.midi_messages - last_counters.midi_messages,
+                                       counters.parameter_changes - last_counters.parameter_changes,
+                                       counters.graph_edits - last_counters.graph_edits,
+                                       counters.dropped_events - last_counters.dropped_events,
+                                       counters.queue_overflows - last_counters.queue_overflows};
+            _report(interval_counts, interval_counters, LoadHistogram::percentile(interval_counts, 100.0f), "Interval");
+            last_counts = counts;
+            last_counters = counters;
+            next_report += _report_interval;
+        }
+        next_wakeup += CONTROL_PERIOD;
+        std::this_thread::sleep_until(next_wakeup);
+    }
+}
+
+void StressFrontend::_send_midi()
+{
+    if (_midi_dispatcher == nullptr)
+    {
+        return;
+    }
+    MidiDataByte data;
+    if (_held_notes.size() < MAX_HELD_NOTES && (_held_notes.empty() || _rand_gen() % 2 == 0))
+    {
+        int note = 36 + _rand_gen() % 60;
+        float velocity = 0.1f + (_rand_gen() % 90) / 100.0f;
+        _held_notes.push_back(note);
+        data = midi::encode_note_on(0, note, velocity);
+    }
+    else
+    {
+        int note = _held_notes.front();
+        _held_notes.erase(_held_notes.begin());
+        data = midi::encode_note_off(0, note, 0.0f);
+    }
+    _midi_dispatcher->send_midi(0, data, IMMEDIATE_PROCESS);
+    _midi_messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StressFrontend::_send_parameter_change()
+{
+    if (_parameter_targets.empty())
+    {
+        return;
+    }
+    std::uniform_real_distribution<float> value_dist(0.0f, 1.0f);
+    const auto& target = _parameter_targets[_rand_gen() % _parameter_targets.size()];
+    auto event = new ParameterChangeEvent(ParameterChangeEvent::Subtype::FLOAT_PARAMETER_CHANGE,
+                                          target.processor, target.parameter, value_dist(_rand_gen), IMMEDIATE_PROCESS);
+    event->set_completion_cb(_completion_callback, this);
+    _engine->event_dispatcher()->post_event(event);
+    _parameter_changes.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StressFrontend::_send_graph_edit()
+{
+    if (_tracks.empty())
+    {
+        return;
+    }
+    const auto& track = _tracks.front();
+    Event* event;
+    /* Alternate between growing and shrinking the graph so that it stays bounded */
+    if (_added_processors.size() < MAX_ADDED_PROCESSORS && (_edit_count % 2 == 0 || _added_processors.empty()))
+    {
+        auto name = "stress_edit_" + std::to_string(_edit_count);
+        event = new AddProcessorEvent(track, EDIT_PLUGIN_UID, name, "",
+                                      AddProcessorEvent::ProcessorType::INTERNAL, IMMEDIATE_PROCESS);
+        _added_processors.push_back(name);
+    }
+    else
+    {
+        event = new RemoveProcessorEvent(_added_processors.back(), track, IMMEDIATE_PROCESS);
+        _added_processors.pop_back();
+    }
+    _edit_count++;
+    event->set_completion_cb(_completion_callback, this);
+    _engine->event_dispatcher()->post_event(event);
+    _graph_edits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StressFrontend::_completion_callback(void* arg, Event* /*event*/, int status)
+{
+    auto instance = reinterpret_cast<StressFrontend*>(arg);
+    if (status != EventStatus::HANDLED_OK)
+    {
+        instance->_dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+StressFrontend::Counters StressFrontend::_read_counters() const
+{
+    return {_chunks.load(std::memory_order_relaxed),
+            _deadline_misses.load(std::memory_order_relaxed),
+            _midi_messages.load(std::memory_order_relaxed),
+            _parameter_changes.load(std::memory_order_relaxed),
+            _graph_edits.load(std::memory_order_relaxed),
+            _dropped_events.load(std::memory_order_relaxed),
+            _engine->rt_queue_overflows()};
+}
+
+void StressFrontend::_report(const LoadHistogram::Counts& counts, const Counters& counters,
+                             float max_load, const std::string& title)
+{
+    auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - _start_time).count();
+    /* Percentiles are the upper edges of the histogram bins, so can be slightly above the real max */
+    auto p50 = std::min(LoadHistogram::percentile(counts, 50.0f), max_load) * 100.0f;
+    auto p99 = std::min(LoadHistogram::percentile(counts, 99.0f), max_load) * 100.0f;
+    auto p999 = std::min(LoadHistogram::percentile(counts, 99.9f), max_load) * 100.0f;
+    auto max = max_load * 100.0f;
+
+    std::cout << title << " (" << elapsed << " s): chunks " << counters.chunks
+              << ", load p50 " << p50 << "%, p99 " << p99 << "%, p99.9 " << p999 << "%, max " << max << "%"
+              << ", deadline misses " << counters.deadline_misses
+              << ", midi " << counters.midi_messages
+              << ", parameter changes " << counters.parameter_changes
+              << ", graph edits " << counters.graph_edits
+              << ", dropped events " << counters.dropped_events
+              << ", queue overflows " << counters.queue_overflows << std::endl;
+
+    SUSHI_LOG_INFO("{}: chunks {}, load p50 {}%, p99 {}%, p99.9 {}%, max {}%, deadline misses {}, dropped events {}, queue overflows {}",
+                   title, counters.chunks, p50, p99, p999, max, counters.deadline_misses, counters.dropped_events,
+                   counters.queue_overflows);
+}
+
+} // end namespace audio_frontend
+} // end namespace sushi
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Headless frontend for load and soak testing, runs the engine without audio
+ *        hardware while injecting control traffic and measuring the processing load.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_STRESS_FRONTEND_H
+#define SUSHI_STRESS_FRONTEND_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "twine/twine.h"
+
+#include "base_audio_frontend.h"
+#include "engine/midi_dispatcher.h"
+
+namespace sushi {
+namespace audio_frontend {
+
+constexpr int STRESS_FRONTEND_CHANNELS = 2;
+
+struct StressFrontendConfiguration : public BaseAudioFrontendConfiguration
+{
+    StressFrontendConfiguration(bool paced,
+                                float midi_rate,
+                                float parameter_rate,
+                                float graph_edit_rate,
+                                std::chrono::seconds report_interval,
+                                int cv_inputs,
+                                int cv_outputs) :
+            BaseAudioFrontendConfiguration(cv_inputs, cv_outputs),
+            paced(paced),
+            midi_rate(midi_rate),
+            parameter_rate(parameter_rate),
+            graph_edit_rate(graph_edit_rate),
+            report_interval(report_interval)
+    {}
+
+    virtual ~StressFrontendConfiguration() = default;
+    bool paced;             // Process chunks at the pace of the wall clock, otherwise as fast as possible
+    float midi_rate;        // Midi messages per second
+    float parameter_rate;   // Parameter changes per second
+    float graph_edit_rate;  // Plugins added to or removed from the graph per second
+    std::chrono::seconds report_interval;
+};
+
+/**
+ * @brief Histogram of the time spent processing chunks, relative to the duration of a chunk.
+ *        Written to from the audio thread and read from other threads.
+ */
+class LoadHistogram
+{
+public:
+    static constexpr int BINS = 1000;
+    static constexpr float MAX_LOAD = 2.0f; // Loads above 200% end up in the last bin
+
+    using Counts = std::array<uint64_t, BINS>;
+
+    /**
+     * @brief Add a measurement, rt safe
+     * @param load Processing time divided by chunk duration
+     */
+    void add(float load);
+
+    /**
+     * @brief Get a copy of the current counts, for calculating percentiles
+     */
+    Counts counts() const;
+
+    /**
+     * @brief Calculate a load percentile from a set of counts
+     * @param counts The bin counts, i.e. from counts() or the difference of 2 calls to counts()
+     * @param percentile In the range [0, 100]
+     * @return The upper edge of the bin where the percentile falls, 0 if there are no counts
+     */
+    static float percentile(const Counts& counts, float percentile);
+
+private:
+    std::array<std::atomic<uint64_t>, BINS> _bins{};
+};
+
+class StressFrontend : public BaseAudioFrontend
+{
+public:
+    StressFrontend(engine::BaseEngine* engine,
+                   midi_dispatcher::MidiDispatcher* midi_dispatcher) : BaseAudioFrontend(engine),
+                                                                       _midi_dispatcher(midi_dispatcher) {}
+
+    virtual ~StressFrontend()
+    {
+        cleanup();
+    }
+
+    /**
+     * @brief Initialize frontend with the given configuration.
+     * @param config Should be of type StressFrontendConfiguration
+     * @return AudioFrontendStatus::OK if successful
+     */
+    AudioFrontendStatus init(BaseAudioFrontendConfiguration* config) override;
+
+    /**
+     * @brief Stop processing and log a report for the whole run
+     */
+    void cleanup() override;
+
+    /**
+     * @brief Start processing and generating control traffic, returns immediately.
+     *        Parameters and tracks that exist when run() is called are used as targets.
+     */
+    void run() override;
+
+private:
+    struct ParameterTarget
+    {
+        ObjectId processor;
+        ObjectId parameter;
+    };
+
+    struct Counters
+    {
+        uint64_t chunks{0};
+        uint64_t deadline_misses{0};
+        uint64_t midi_messages{0};
+        uint64_t parameter_changes{0};
+        uint64_t graph_edits{0};
+        uint64_t dropped_events{0};
+        uint64_t queue_overflows{0};
+    };
+
+    static void _audio_thread_function(void* arg);
+    void _audio_loop();
+    void _control_loop();
+    void _send_midi();
+    void _send_parameter_change();
+    void _send_graph_edit();
+    void _report(const LoadHistogram::Counts& counts, const Counters& counters,
+                 float max_load, const std::string& title);
+    Counters _read_counters() const;
+
+    static void _completion_callback(void* arg, Event* event, int status);
+
+    midi_dispatcher::MidiDispatcher* _midi_dispatcher;
+
+    bool _paced{false};
+    float _midi_rate{0};
+    float _parameter_rate{0};
+    float _graph_edit_rate{0};
+    std::chrono::seconds _report_interval{0};
+
+    SampleBuffer<AUDIO_CHUNK_SIZE> _buffer{STRESS_FRONTEND_CHANNELS};
+    engine::ControlBuffer _control_buffer;
+
+    std::atomic<bool> _running{false};
+    /* The audio loop runs in a realtime thread from a twine worker pool with a single worker,
+     * or in a normal thread if realtime threads can't be created */
+    std::unique_ptr<twine::WorkerPool> _audio_worker_pool;
+    std::thread _audio_thread;
+    std::thread _control_thread;
+    std::chrono::steady_clock::time_point _start_time;
+
+    LoadHistogram _load;
+    std::atomic<float> _max_load{0};
+    std::atomic<uint64_t> _chunks{0};
+    std::atomic<uint64_t> _deadline_misses{0};
+    std::atomic<uint64_t> _midi_messages{0};
+    std::atomic<uint64_t> _parameter_changes{0};
+    std::atomic<uint64_t> _graph_edits{0};
+    std::atomic<uint64_t> _dropped_events{0};
+
+    /* Only accessed from the control thread */
+    std::mt19937 _rand_gen;
+    std::vector<ParameterTarget> _parameter_targets;
+    std::vector<std::string> _tracks;
+    std::vector<int> _held_notes;
+    std::vector<std::string> _added_processors;
+    int _edit_count{0};
+};
+
+} // end namespace audio_frontend
+} // end namespace sushi
+
+#endif //SUSHI_STRESS_FRONTEND_H
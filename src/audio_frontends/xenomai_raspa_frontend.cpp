@@ -65,7 +65,7 @@ AudioFrontendStatus XenomaiRaspaFrontend::init(BaseAudioFrontendConfiguration* c
         debug_flags |= RASPA_DEBUG_SIGNAL_ON_MODE_SW;
     }
 
-    auto raspa_ret = raspa_open(AUDIO_CHUNK_SIZE, rt_process_callback, this, debug_flags);
+    auto raspa_ret = raspa_open(audio_chunk_size(), rt_process_callback, this, debug_flags);
     if (raspa_ret < 0)
     {
         SUSHI_LOG_ERROR("Error opening RASPA: {}", raspa_get_error_msg(-raspa_ret));
@@ -118,7 +118,8 @@ void XenomaiRaspaFrontend::_internal_process_callback(float* input, float* outpu
     ChunkSampleBuffer out_buffer = ChunkSampleBuffer::create_from_raw_pointer(output, 0, _audio_output_channels);
     for (int i = 0; i < _cv_input_channels; ++i)
     {
-        _in_controls.cv_values[i] = map_audio_to_cv(input[(_audio_input_channels + i + 1) * AUDIO_CHUNK_SIZE - 1] * CV_IN_CORR);
+        map_audio_to_cv_signal(input + (_audio_input_channels + i) * audio_chunk_size(),
+                               _in_controls.cv_signals.channel(i), CV_IN_CORR);
     }
     out_buffer.clear();
     _engine->process_chunk(&in_buffer, &out_buffer, &_in_controls, &_out_controls, timestamp, samplecount);
@@ -126,7 +127,7 @@ void XenomaiRaspaFrontend::_internal_process_callback(float* input, float* outpu
     /* Sika board outputs only positive cv */
     for (int i = 0; i < _cv_output_channels; ++i)
     {
-        float* out_data = output + (_audio_output_channels + i) * AUDIO_CHUNK_SIZE;
+        float* out_data = output + (_audio_output_channels + i) * audio_chunk_size();
         _cv_output_hist[i] = ramp_cv_output(out_data, _cv_output_hist[i], _out_controls.cv_values[i] * CV_OUT_CORR);
     }
 }
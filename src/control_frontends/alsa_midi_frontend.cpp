@@ -191,7 +191,11 @@ void AlsaMidiFrontend::_poll_function()
                     || (ev->type == SND_SEQ_EVENT_CHANPRESS)
                     || (ev->type == SND_SEQ_EVENT_KEYPRESS)
                     || (ev->type == SND_SEQ_EVENT_PGMCHANGE)
-                    || (ev->type == SND_SEQ_EVENT_PITCHBEND))
+                    || (ev->type == SND_SEQ_EVENT_PITCHBEND)
+                    || (ev->type == SND_SEQ_EVENT_CLOCK)
+                    || (ev->type == SND_SEQ_EVENT_START)
+                    || (ev->type == SND_SEQ_EVENT_CONTINUE)
+                    || (ev->type == SND_SEQ_EVENT_STOP))
                 {
                     auto byte_count = snd_midi_event_decode(_input_parser, data_buffer, sizeof(data_buffer), ev);
                     if (byte_count > 0)
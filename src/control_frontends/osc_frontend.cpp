@@ -19,8 +19,10 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <lo/lo_types.h>
+#include <lo/lo_lowlevel.h>
 
 #include "osc_utils.h"
 #include "osc_frontend.h"
@@ -32,6 +34,9 @@ namespace control_frontend {
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("osc frontend");
 
+constexpr std::string_view PARAMETER_PATH_PREFIX = "/parameter/";
+constexpr char OSC_WILDCARD_CHARS[] = "*?[]{}";
+
 namespace {
 
 static void osc_error(int num, const char* msg, const char* path)
@@ -42,31 +47,28 @@ static void osc_error(int num, const char* msg, const char* path)
     }
 }
 
-static int osc_send_parameter_change_event(const char* /*path*/,
-                                           const char* /*types*/,
-                                           lo_arg** argv,
-                                           int /*argc*/,
-                                           void* /*data*/,
-                                           void* user_data)
+static int osc_dispatch_parameter_message(const char* path,
+                                          const char* types,
+                                          lo_arg** argv,
+                                          int /*argc*/,
+                                          void* /*data*/,
+                                          void* user_data)
 {
-    auto connection = static_cast<OscConnection*>(user_data);
-    float value = argv[0]->f;
-    connection->controller->set_parameter_value(connection->processor, connection->parameter, value);
-    SUSHI_LOG_DEBUG("Sending parameter {} on processor {} change to {}.", connection->parameter, connection->processor, value);
+    auto instance = static_cast<OSCFrontend*>(user_data);
+    return instance->handle_parameter_message(path, types, argv);
+}
+
+static int osc_bundle_start(lo_timetag /*time*/, void* user_data)
+{
+    auto instance = static_cast<OSCFrontend*>(user_data);
+    instance->begin_bundle();
     return 0;
 }
 
-static int osc_send_string_parameter_change_event(const char* /*path*/,
-                                                  const char* /*types*/,
-                                                  lo_arg** argv,
-                                                  int /*argc*/,
-                                                  void* /*data*/,
-                                                  void* user_data)
+static int osc_bundle_end(void* user_data)
 {
-    auto connection = static_cast<OscConnection*>(user_data);
-    std::string value(&argv[0]->s);
-    connection->controller->set_string_property_value(connection->processor, connection->parameter, value);
-    SUSHI_LOG_DEBUG("Sending string property {} on processor {} change to {}.", connection->parameter, connection->processor, value);
+    auto instance = static_cast<OSCFrontend*>(user_data);
+    instance->end_bundle();
     return 0;
 }
 
@@ -352,6 +354,10 @@ ControlFrontendStatus OSCFrontend::init()
     std::stringstream send_port_stream;
     send_port_stream << _send_port;
     _osc_out_address = lo_address_new(nullptr, send_port_stream.str().c_str());
+    /* All parameter paths are handled by one method with a hash table lookup instead of
+     * registering one method per parameter, which liblo would search linearly */
+    lo_server_thread_add_method(_osc_server, nullptr, nullptr, osc_dispatch_parameter_message, this);
+    lo_server_add_bundle_handlers(lo_server_thread_get_server(_osc_server), osc_bundle_start, osc_bundle_end, this);
     _setup_engine_control();
     _event_dispatcher->subscribe_to_parameter_change_notifications(this);
     _event_dispatcher->subscribe_to_engine_notifications(this);
@@ -390,6 +396,7 @@ std::pair<OscConnection*, std::string> OSCFrontend::_create_parameter_connection
     connection->parameter = parameter_id;
     connection->instance = this;
     connection->controller = _controller;
+    connection->path = osc_path;
     return {connection, osc_path};
 }
 
@@ -401,7 +408,8 @@ bool OSCFrontend::connect_to_parameter(const std::string& processor_name,
     {
         return false;
     }
-    lo_server_thread_add_method(_osc_server, osc_path.c_str(), "f", osc_send_parameter_change_event, connection);
+    _connections.push_back(std::unique_ptr<OscConnection>(connection));
+    _incoming_parameters[connection->path] = {connection, false};
     SUSHI_LOG_INFO("Added osc callback {}", osc_path);
     return true;
 }
@@ -414,11 +422,122 @@ bool OSCFrontend::connect_to_string_parameter(const std::string& processor_name,
     {
         return false;
     }
-    lo_server_thread_add_method(_osc_server, osc_path.c_str(), "s", osc_send_string_parameter_change_event, connection);
+    _connections.push_back(std::unique_ptr<OscConnection>(connection));
+    _incoming_parameters[connection->path] = {connection, true};
     SUSHI_LOG_INFO("Added osc callback {}", osc_path);
     return true;
 }
 
+int OSCFrontend::handle_parameter_message(const char* path, const char* types, lo_arg** argv)
+{
+    std::string_view path_view(path);
+    if (path_view.substr(0, PARAMETER_PATH_PREFIX.size()) != PARAMETER_PATH_PREFIX)
+    {
+        /* Let liblo pass it on to the other registered methods */
+        return 1;
+    }
+    if (types == nullptr || std::strlen(types) != 1)
+    {
+        SUSHI_LOG_WARNING("Invalid arguments for parameter path {}", path);
+        return 0;
+    }
+    /* The method is registered without a typespec, so liblo doesn't convert numeric
+     * arguments to float as it did when every parameter path was registered as "f" */
+    lo_arg* value = argv[0];
+    lo_arg coerced_value;
+    auto type = static_cast<lo_type>(types[0]);
+    switch (type)
+    {
+        case LO_FLOAT:
+        case LO_STRING:
+            break;
+
+        case LO_INT32:
+        case LO_INT64:
+        case LO_DOUBLE:
+            lo_coerce(LO_FLOAT, &coerced_value, type, argv[0]);
+            value = &coerced_value;
+            break;
+
+        default:
+            SUSHI_LOG_WARNING("Invalid arguments for parameter path {}", path);
+            return 0;
+    }
+    bool string_property = type == LO_STRING;
+
+    if (path_view.find_first_of(OSC_WILDCARD_CHARS) == std::string_view::npos)
+    {
+        auto node = _incoming_parameters.find(path_view);
+        if (node != _incoming_parameters.end() && node->second.string_property == string_property)
+        {
+            _set_parameter(node->second.connection, value, string_property);
+        }
+        else
+        {
+            SUSHI_LOG_DEBUG("Unhandled parameter path {}", path);
+        }
+        return 0;
+    }
+
+    for (const auto& [candidate_path, parameter] : _incoming_parameters)
+    {
+        /* Keys point to null terminated strings so passing data() is safe */
+        if (parameter.string_property == string_property && lo_pattern_match(candidate_path.data(), path))
+        {
+            _set_parameter(parameter.connection, value, string_property);
+        }
+    }
+    return 0;
+}
+
+void OSCFrontend::begin_bundle()
+{
+    _bundle_depth++;
+}
+
+void OSCFrontend::end_bundle()
+{
+    if (--_bundle_depth > 0)
+    {
+        return;
+    }
+    _bundle_depth = 0;
+    for (const auto& change : _bundled_changes)
+    {
+        _controller->set_parameter_value(change.connection->processor, change.connection->parameter, change.value);
+    }
+    SUSHI_LOG_DEBUG("Applied {} parameter changes from bundle", _bundled_changes.size());
+    _bundled_changes.clear();
+}
+
+void OSCFrontend::_set_parameter(OscConnection* connection, lo_arg* value, bool string_property)
+{
+    if (string_property)
+    {
+        std::string string_value(&value->s);
+        _controller->set_string_property_value(connection->processor, connection->parameter, string_value);
+        SUSHI_LOG_DEBUG("Sending string property {} on processor {} change to {}.", connection->parameter, connection->processor, string_value);
+        return;
+    }
+    if (_bundle_depth > 0)
+    {
+        /* Only the last value of every parameter in a bundle is applied */
+        auto change = std::find_if(_bundled_changes.begin(), _bundled_changes.end(),
+                                   [&](const auto& c) {return c.connection == connection;});
+        if (change != _bundled_changes.end())
+        {
+            change->value = value->f;
+        }
+        else
+        {
+            _bundled_changes.push_back({connection, value->f});
+        }
+        return;
+    }
+    _controller->set_parameter_value(connection->processor, connection->parameter, value->f);
+    SUSHI_LOG_DEBUG("Sending parameter {} on processor {} change to {}.", connection->parameter, connection->processor, value->f);
+}
+
 bool OSCFrontend::connect_from_parameter(const std::string& processor_name, const std::string& parameter_name)
 {
     auto [processor_status, processor_id] = _controller->get_processor_id(processor_name);
@@ -433,7 +552,9 @@ bool OSCFrontend::connect_from_parameter(const std::string& processor_name, cons
     }
     std::string id_string = "/parameter/" + osc::make_safe_path(processor_name) + "/" +
                                             osc::make_safe_path(parameter_name);
-    _outgoing_connections[processor_id][parameter_id] = id_string;
+    std::lock_guard<std::mutex> lock(_outgoing_lock);
+    _outgoing_connections[_outgoing_key(processor_id, parameter_id)] = {id_string, 0.0f, false};
+    _pending_outgoing.reserve(_outgoing_connections.size());
     SUSHI_LOG_INFO("Added osc output from parameter {}/{}", processor_name, parameter_name);
     return true;
 }
@@ -580,32 +701,109 @@ int OSCFrontend::process(Event* event)
     if (event->is_parameter_change_notification())
     {
         auto typed_event = static_cast<ParameterChangeNotificationEvent*>(event);
-        const auto& node = _outgoing_connections.find(typed_event->processor_id());
-        if (node != _outgoing_connections.end())
+        std::lock_guard<std::mutex> lock(_outgoing_lock);
+        _queue_outgoing_parameter(typed_event->processor_id(), typed_event->parameter_id(), typed_event->float_value());
+        return EventStatus::HANDLED_OK;
+    }
+    if (event->is_parameter_notification_flush())
+    {
+        std::lock_guard<std::mutex> lock(_outgoing_lock);
+        _send_outgoing_parameters();
+        return EventStatus::HANDLED_OK;
+    }
+    if (event->is_engine_notification())
+    {
+        _send_engine_notification(static_cast<EngineNotificationEvent*>(event));
+    }
+    return EventStatus::NOT_HANDLED;
+}
+
+void OSCFrontend::_send_engine_notification(EngineNotificationEvent* event)
+{
+    switch (event->subtype())
+    {
+        case EngineNotificationEvent::Subtype::CLIPPING:
         {
-            const auto& param_node = node->second.find(typed_event->parameter_id());
-            if (param_node != node->second.end())
+            auto typed_event = static_cast<ClippingNotificationEvent*>(event);
+            if (typed_event->channel_type() == ClippingNotificationEvent::ClipChannelType::INPUT)
             {
-                lo_send(_osc_out_address, param_node->second.c_str(), "f", typed_event->float_value());
-                SUSHI_LOG_DEBUG("Sending parameter change from processor: {}, parameter: {}, value: {}", typed_event->processor_id(), typed_event->parameter_id(), typed_event->float_value());
+                lo_send(_osc_out_address, "/engine/input_clip_notification", "i", typed_event->channel());
             }
+            else if (typed_event->channel_type() == ClippingNotificationEvent::ClipChannelType::OUTPUT)
+            {
+                lo_send(_osc_out_address, "/engine/output_clip_notification", "i", typed_event->channel());
+            }
+            break;
+        }
+
+        case EngineNotificationEvent::Subtype::TEMPO:
+        {
+            auto typed_event = static_cast<TempoNotificationEvent*>(event);
+            lo_send(_osc_out_address, "/engine/tempo_notification", "f", typed_event->tempo());
+            break;
+        }
+
+        case EngineNotificationEvent::Subtype::PLAYING_MODE:
+        {
+            auto typed_event = static_cast<PlayingModeNotificationEvent*>(event);
+            const char* mode = typed_event->mode() == PlayingMode::STOPPED ? "stopped" : "playing";
+            lo_send(_osc_out_address, "/engine/playing_mode_notification", "s", mode);
+            break;
+        }
+
+        case EngineNotificationEvent::Subtype::LINK_PEERS:
+        {
+            auto typed_event = static_cast<LinkPeersNotificationEvent*>(event);
+            lo_send(_osc_out_address, "/engine/link_peers_notification", "i", typed_event->peers());
+            break;
         }
-        return EventStatus::HANDLED_OK;
     }
-    if (event->is_engine_notification())
+}
+
+void OSCFrontend::_queue_outgoing_parameter(ObjectId processor, ObjectId parameter, float value)
+{
+    auto node = _outgoing_connections.find(_outgoing_key(processor, parameter));
+    if (node != _outgoing_connections.end())
     {
-        // TODO - Currently the only engine notification event so direct casting works
-        auto typed_event = static_cast<ClippingNotificationEvent*>(event);
-        if (typed_event->channel_type() == ClippingNotificationEvent::ClipChannelType::INPUT)
+        auto& outgoing = node->second;
+        outgoing.value = value;
+        if (outgoing.pending == false)
         {
-            lo_send(_osc_out_address, "/engine/input_clip_notification", "i", typed_event->channel());
+            outgoing.pending = true;
+            _pending_outgoing.push_back(&outgoing);
         }
-        else if (typed_event->channel_type() == ClippingNotificationEvent::ClipChannelType::OUTPUT)
+    }
+}
+
+void OSCFrontend::_send_outgoing_parameters()
+{
+    lo_bundle bundle = nullptr;
+    int message_count = 0;
+    for (auto outgoing : _pending_outgoing)
+    {
+        if (bundle == nullptr)
         {
-            lo_send(_osc_out_address, "/engine/output_clip_notification", "i", typed_event->channel());
+            bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+        }
+        lo_message message = lo_message_new();
+        lo_message_add_float(message, outgoing->value);
+        lo_bundle_add_message(bundle, outgoing->path.c_str(), message);
+        outgoing->pending = false;
+        if (++message_count == OSC_MAX_BUNDLE_MESSAGES)
+        {
+            lo_send_bundle(_osc_out_address, bundle);
+            lo_bundle_free_recursive(bundle);
+            bundle = nullptr;
+            message_count = 0;
         }
     }
-    return EventStatus::NOT_HANDLED;
+    if (bundle)
+    {
+        lo_send_bundle(_osc_out_address, bundle);
+        lo_bundle_free_recursive(bundle);
+    }
+    SUSHI_LOG_DEBUG("Sent {} parameter changes", _pending_outgoing.size());
+    _pending_outgoing.clear();
 }
 
 void OSCFrontend::_completion_callback(Event* event, int return_status)
@@ -26,7 +26,9 @@
 #define SUSHI_OSC_FRONTEND_H_H
 
 #include <vector>
-#include <map>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 #include "lo/lo.h"
 
@@ -43,8 +45,12 @@ struct OscConnection
     ObjectId parameter;
     OSCFrontend* instance;
     ext::SushiControl* controller;
+    std::string path;
 };
 
+/* Max number of messages sent in one outgoing bundle, to keep packets reasonably sized */
+constexpr int OSC_MAX_BUNDLE_MESSAGES = 64;
+
 class OSCFrontend : public BaseControlFrontend
 {
 public:
@@ -132,6 +138,24 @@ public:
 
     int poster_id() override {return EventPosterId::OSC_FRONTEND;}
 
+    /**
+     * @brief Handle an incoming message to a /parameter/ path, called from the osc server thread.
+     *        Paths may contain OSC wildcards, in which case all matching parameters are set.
+     * @return 0 if the message was handled, 1 if it should be passed on to other handlers
+     */
+    int handle_parameter_message(const char* path, const char* types, lo_arg** argv);
+
+    /**
+     * @brief Called by the osc server thread when an incoming bundle starts. Parameter changes
+     *        are then held back and applied together when the bundle ends.
+     */
+    void begin_bundle();
+
+    /**
+     * @brief Called by the osc server thread when an incoming bundle ends.
+     */
+    void end_bundle();
+
 private:
     void _completion_callback(Event* event, int return_status) override;
 
@@ -147,6 +171,38 @@ private:
     std::pair<OscConnection*, std::string> _create_processor_connection(const std::string& processor_name,
                                                                        const std::string& osc_path_prefix);
 
+    void _set_parameter(OscConnection* connection, lo_arg* value, bool string_property);
+
+    void _queue_outgoing_parameter(ObjectId processor, ObjectId parameter, float value);
+
+    void _send_outgoing_parameters();
+
+    void _send_engine_notification(EngineNotificationEvent* event);
+
+    static uint64_t _outgoing_key(ObjectId processor, ObjectId parameter)
+    {
+        return (static_cast<uint64_t>(processor) << 32) | parameter;
+    }
+
+    struct IncomingParameter
+    {
+        OscConnection* connection;
+        bool string_property;
+    };
+
+    struct OutgoingParameter
+    {
+        std::string path;
+        float value;
+        bool pending;
+    };
+
+    struct BundledChange
+    {
+        OscConnection* connection;
+        float value;
+    };
+
     lo_server_thread _osc_server;
     int _server_port;
     int _send_port;
@@ -158,7 +214,17 @@ private:
 
     /* Currently only stored here so they can be deleted */
     std::vector<std::unique_ptr<OscConnection>> _connections;
-    std::map<ObjectId, std::map<ObjectId, std::string>> _outgoing_connections;
+
+    /* Keys are views into the path member of the connections, accessed from the osc thread only */
+    std::unordered_map<std::string_view, IncomingParameter> _incoming_parameters;
+    int _bundle_depth{0};
+    std::vector<BundledChange> _bundled_changes;
+
+    /* Filled by connect_from_parameter() and read from the event dispatcher thread,
+     * both under _outgoing_lock */
+    std::unordered_map<uint64_t, OutgoingParameter> _outgoing_connections;
+    std::vector<OutgoingParameter*> _pending_outgoing;
+    std::mutex _outgoing_lock;
 };
 
 }; // namespace control_frontend
@@ -35,12 +35,12 @@ static inline double exp10(double val)
 namespace dsp {
 namespace biquad {
 
-const int TIME_CONSTANTS_IN_SMOOTHING_FILTER = 3;
-
-inline float process_one_pole(const OnePoleCoefficients coefficients, const float input, float &z)
+inline float process_biquad(const Coefficients& coefficients, const float input, DelayRegisters& z)
 {
-    z = coefficients.b0 * input + coefficients.a0 * z;
-    return z;
+    float y = coefficients.b0 * input + z.z1;
+    z.z1 = coefficients.b1 * input - coefficients.a1 * y + z.z2;
+    z.z2 = coefficients.b2 * input - coefficients.a2 * y;
+    return y;
 }
 
 void calc_biquad_peak(Coefficients& filter, float samplerate, float frequency, float q, float gain)
@@ -81,6 +81,7 @@ BiquadFilter::BiquadFilter()
 }
 
 BiquadFilter::BiquadFilter(const Coefficients &coefficients) :
+        _coefficients(coefficients),
         _coefficient_targets(coefficients)
 {
 }
@@ -91,44 +92,60 @@ void BiquadFilter::reset()
      * put the filter in a default state */
     _delay_registers = {0.0, 0.0};
     _coefficients = _coefficient_targets;
-    std::fill(_smoothing_registers, _smoothing_registers + NUMBER_OF_BIQUAD_COEF, 0.0);
+    _smoothing_remaining = 0;
 }
 
 void BiquadFilter::set_smoothing(int buffer_size)
 {
-    /* Coefficient changes are smoothed through a one pole lowpass filter
-     * with a time constant set to match a fixed number of samples
-     * Since the frequency low and the actual cut off frequency not crucial,
-     * we can get by without a bilinear transformation and simply
-     * calculate a time constant from an analogue prototype filter instead. */
-
-    _smoothing_coefficients.b0 = std::exp(-2 * M_PI * (1.0f / buffer_size) * TIME_CONSTANTS_IN_SMOOTHING_FILTER);
-    _smoothing_coefficients.a0 = 1 - _smoothing_coefficients.b0;
+    /* Coefficient changes are ramped linearly over a fixed number of samples,
+     * the increments are only calculated when the targets change */
+    _smoothing_samples = std::max(buffer_size, 1);
 }
 
 void BiquadFilter::set_coefficients(const Coefficients &coefficients)
 {
+    if (coefficients == _coefficient_targets)
+    {
+        return;
+    }
     _coefficient_targets = coefficients;
+    float scale = 1.0f / _smoothing_samples;
+    _coefficient_increments.b0 = (coefficients.b0 - _coefficients.b0) * scale;
+    _coefficient_increments.b1 = (coefficients.b1 - _coefficients.b1) * scale;
+    _coefficient_increments.b2 = (coefficients.b2 - _coefficients.b2) * scale;
+    _coefficient_increments.a1 = (coefficients.a1 - _coefficients.a1) * scale;
+    _coefficient_increments.a2 = (coefficients.a2 - _coefficients.a2) * scale;
+    _smoothing_remaining = _smoothing_samples;
 }
 
 void BiquadFilter::process(const float *input, float *output, int samples)
 {
-    for (int n = 0; n < samples; n++)
+    int ramp_samples = std::min(samples, _smoothing_remaining);
+    int n = 0;
+    for (; n < ramp_samples; n++)
+    {
+        _coefficients.b0 += _coefficient_increments.b0;
+        _coefficients.b1 += _coefficient_increments.b1;
+        _coefficients.b2 += _coefficient_increments.b2;
+        _coefficients.a1 += _coefficient_increments.a1;
+        _coefficients.a2 += _coefficient_increments.a2;
+        output[n] = process_biquad(_coefficients, input[n], _delay_registers);
+    }
+    _smoothing_remaining -= ramp_samples;
+
+    if (_smoothing_remaining == 0)
     {
-        // Process the coefficients through a one pole smoothing filter
-        _coefficients.b0 = process_one_pole(_smoothing_coefficients, _coefficient_targets.b0, _smoothing_registers[0]);
-        _coefficients.b1 = process_one_pole(_smoothing_coefficients, _coefficient_targets.b1, _smoothing_registers[1]);
-        _coefficients.b2 = process_one_pole(_smoothing_coefficients, _coefficient_targets.b2, _smoothing_registers[2]);
-        _coefficients.a1 = process_one_pole(_smoothing_coefficients, _coefficient_targets.a1, _smoothing_registers[3]);
-        _coefficients.a2 = process_one_pole(_smoothing_coefficients, _coefficient_targets.a2, _smoothing_registers[4]);
-
-        // process actual filter data
-        float x = input[n];
-        float y = _coefficients.b0 * x + _delay_registers.z1;
-        _delay_registers.z1 = _coefficients.b1 * x - _coefficients.a1 * y + _delay_registers.z2;
-        _delay_registers.z2 = _coefficients.b2 * x - _coefficients.a2 * y;
-        output[n] = y;
+        /* Ramp finished, set the targets exactly to remove accumulated rounding errors
+         * and process the rest without touching the coefficients */
+        _coefficients = _coefficient_targets;
+        const Coefficients coefficients = _coefficients;
+        DelayRegisters registers = _delay_registers;
+        for (; n < samples; n++)
+        {
+            output[n] = process_biquad(coefficients, input[n], registers);
+        }
+        _delay_registers = registers;
     }
 }
 } // end namespace biquad
-} // end namespace dsp
\ No newline at end of file
+} // end namespace dsp
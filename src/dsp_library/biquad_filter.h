@@ -23,6 +23,12 @@
 #ifndef EQUALIZER_BIQUADFILTER_H
 #define EQUALIZER_BIQUADFILTER_H
 
+#include <array>
+#include <algorithm>
+#include <cassert>
+
+#include "library/sample_buffer.h"
+
 namespace dsp {
 namespace biquad {
 
@@ -37,18 +43,22 @@ struct Coefficients
     float a2;
 };
 
+inline bool operator==(const Coefficients& lhs, const Coefficients& rhs)
+{
+    return lhs.b0 == rhs.b0 && lhs.b1 == rhs.b1 && lhs.b2 == rhs.b2 && lhs.a1 == rhs.a1 && lhs.a2 == rhs.a2;
+}
+
+inline bool operator!=(const Coefficients& lhs, const Coefficients& rhs)
+{
+    return !(lhs == rhs);
+}
+
 struct DelayRegisters
 {
     float z1;
     float z2;
 };
 
-struct OnePoleCoefficients
-{
-    float b0;
-    float a0;
-};
-
 
 /*
  * Stand-alone functions for calculating coefficients
@@ -75,10 +85,14 @@ public:
     void reset();
 
     /*
-     * Sets the parameters for smoothing filter changes
+     * Sets the number of samples over which coefficient changes are ramped
      */
     void set_smoothing(int buffer_size);
 
+    /*
+     * Sets new target coefficients, setting the same coefficients again does not
+     * restart the ramp so this can be called on every chunk
+     */
     void set_coefficients(const Coefficients &coefficients);
 
     void process(const float* input, float* output, int samples);
@@ -86,9 +100,206 @@ public:
 private:
     Coefficients _coefficients{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
     Coefficients _coefficient_targets{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    Coefficients _coefficient_increments{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
     DelayRegisters _delay_registers{0.0f, 0.0f};
-    OnePoleCoefficients _smoothing_coefficients{0.0f, 0.0f};
-    float _smoothing_registers[NUMBER_OF_BIQUAD_COEF]{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    int _smoothing_samples{1};
+    int _smoothing_remaining{0};
+};
+
+/**
+ * @brief A cascade of biquad sections that processes several channels in parallel, one
+ *        channel per lane. Coefficients and delay registers are stored as structures of
+ *        arrays, like the accumulators in level_analysis.h, so that the loops over lanes
+ *        can be vectorised by the compiler without intrinsics.
+ *
+ *        Coefficient changes are ramped linearly over the next processed chunk, with the
+ *        increments calculated once per chunk. When all coefficients have reached their
+ *        targets the ramp is skipped entirely.
+ * @tparam sections The number of biquad sections processed in series
+ * @tparam lanes The max number of channels processed
+ */
+template <int sections, int lanes>
+class BiquadCascade
+{
+public:
+    using LaneValues = std::array<float, lanes>;
+
+    /**
+     * @brief Clear the processing state and jump directly to the target coefficients
+     */
+    void reset()
+    {
+        for (auto& registers : _registers)
+        {
+            registers.z1.fill(0.0f);
+            registers.z2.fill(0.0f);
+        }
+        _coefficients = _coefficient_targets;
+        _converged = true;
+    }
+
+    /**
+     * @brief Set the target coefficients of one section for all lanes. Setting the same
+     *        coefficients again does not restart the ramp.
+     * @param section The index of the section in the cascade
+     * @param coefficients The new coefficients
+     */
+    void set_coefficients(int section, const Coefficients& coefficients)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            set_coefficients(section, lane, coefficients);
+        }
+    }
+
+    /**
+     * @brief Set the target coefficients of one section for a single lane
+     * @param section The index of the section in the cascade
+     * @param lane The channel to set the coefficients for
+     * @param coefficients The new coefficients
+     */
+    void set_coefficients(int section, int lane, const Coefficients& coefficients)
+    {
+        assert(section < sections && lane < lanes);
+        auto& target = _coefficient_targets[section];
+        if (target.b0[lane] != coefficients.b0 || target.b1[lane] != coefficients.b1 ||
+            target.b2[lane] != coefficients.b2 || target.a1[lane] != coefficients.a1 ||
+            target.a2[lane] != coefficients.a2)
+        {
+            target.b0[lane] = coefficients.b0;
+            target.b1[lane] = coefficients.b1;
+            target.b2[lane] = coefficients.b2;
+            target.a1[lane] = coefficients.a1;
+            target.a2[lane] = coefficients.a2;
+            _converged = false;
+        }
+    }
+
+    /**
+     * @brief Process all channels of a buffer, channels beyond the number of lanes
+     *        are not touched. Input and output may refer to the same buffer.
+     * @param input The audio to filter
+     * @param output Buffer to write the filtered audio to
+     */
+    template <int size>
+    void process(const sushi::SampleBuffer<size>& input, sushi::SampleBuffer<size>& output)
+    {
+        assert(input.frame_count() == output.frame_count() && input.frame_count() <= size);
+        sushi::with_static_chunk_size(input.frame_count(), [&](auto frame_count)
+        {
+            _process_buffer(input, output, frame_count);
+        });
+    }
+
+private:
+    struct LaneCoefficients
+    {
+        LaneValues b0;
+        LaneValues b1;
+        LaneValues b2;
+        LaneValues a1;
+        LaneValues a2;
+    };
+
+    struct LaneDelayRegisters
+    {
+        LaneValues z1;
+        LaneValues z2;
+    };
+
+    template <int size, typename FrameCount>
+    void _process_buffer(const sushi::SampleBuffer<size>& input, sushi::SampleBuffer<size>& output,
+                         FrameCount frame_count)
+    {
+        int channels = std::min({lanes, input.channel_count(), output.channel_count()});
+        std::array<LaneValues, size> frames{};
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const float* in = input.channel(ch);
+            for (int n = 0; n < frame_count; ++n)
+            {
+                frames[n][ch] = in[n];
+            }
+        }
+
+        if (_converged)
+        {
+            _process<false>(frames, frame_count);
+        }
+        else
+        {
+            _process<true>(frames, frame_count);
+            /* Set the targets exactly to remove accumulated rounding errors */
+            _coefficients = _coefficient_targets;
+            _converged = true;
+        }
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            float* out = output.channel(ch);
+            for (int n = 0; n < frame_count; ++n)
+            {
+                out[n] = frames[n][ch];
+            }
+        }
+    }
+
+    template <bool ramp, size_t size, typename FrameCount>
+    void _process(std::array<LaneValues, size>& frames, FrameCount frame_count)
+    {
+        /* Work on local copies to let the compiler keep them in registers */
+        auto coefficients = _coefficients;
+        auto registers = _registers;
+        std::array<LaneCoefficients, sections> increments;
+        if constexpr (ramp)
+        {
+            const float scale = 1.0f / frame_count;
+            for (int s = 0; s < sections; ++s)
+            {
+                const auto& c = coefficients[s];
+                const auto& t = _coefficient_targets[s];
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    increments[s].b0[lane] = (t.b0[lane] - c.b0[lane]) * scale;
+                    increments[s].b1[lane] = (t.b1[lane] - c.b1[lane]) * scale;
+                    increments[s].b2[lane] = (t.b2[lane] - c.b2[lane]) * scale;
+                    increments[s].a1[lane] = (t.a1[lane] - c.a1[lane]) * scale;
+                    increments[s].a2[lane] = (t.a2[lane] - c.a2[lane]) * scale;
+                }
+            }
+        }
+
+        for (int n = 0; n < frame_count; ++n)
+        {
+            auto& x = frames[n];
+            for (int s = 0; s < sections; ++s)
+            {
+                auto& c = coefficients[s];
+                auto& z = registers[s];
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    if constexpr (ramp)
+                    {
+                        c.b0[lane] += increments[s].b0[lane];
+                        c.b1[lane] += increments[s].b1[lane];
+                        c.b2[lane] += increments[s].b2[lane];
+                        c.a1[lane] += increments[s].a1[lane];
+                        c.a2[lane] += increments[s].a2[lane];
+                    }
+                    float y = c.b0[lane] * x[lane] + z.z1[lane];
+                    z.z1[lane] = c.b1[lane] * x[lane] - c.a1[lane] * y + z.z2[lane];
+                    z.z2[lane] = c.b2[lane] * x[lane] - c.a2[lane] * y;
+                    x[lane] = y;
+                }
+            }
+        }
+        _registers = registers;
+    }
+
+    std::array<LaneCoefficients, sections> _coefficients{};
+    std::array<LaneCoefficients, sections> _coefficient_targets{};
+    std::array<LaneDelayRegisters, sections> _registers{};
+    bool _converged{true};
 };
 } // end namespace biquad
 } // end namespace dsp
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Single pass level analysis of audio buffers
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_LEVEL_ANALYSIS_H
+#define SUSHI_LEVEL_ANALYSIS_H
+
+#include <array>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "library/sample_buffer.h"
+
+namespace dsp {
+
+/* Number of independent accumulators. Keeping them in separate lanes removes the
+ * dependency between consecutive samples so that the compiler can vectorise the loop
+ * without relaxing floating point rules. 8 fills an AVX register or 2 NEON registers */
+constexpr int ANALYSIS_LANES = 8;
+
+struct LevelAnalysis
+{
+    float peak;          // Max absolute sample value
+    float mean_square;   // Mean of the squared sample values, sqrt() gives the rms
+    float dc_offset;     // Mean sample value
+    int clipped_samples; // Number of samples with an absolute value >= 1.0
+};
+
+/**
+ * @brief Calculate peak, mean square, dc offset and clip count of a signal in one pass.
+ * @param data The samples to analyse
+ * @param samples The number of samples, must be a multiple of ANALYSIS_LANES
+ * @return The analysis results
+ */
+template <typename SampleCount>
+inline LevelAnalysis analyse_levels(const float* data, SampleCount samples)
+{
+    assert(samples % ANALYSIS_LANES == 0);
+    std::array<float, ANALYSIS_LANES> peak{};
+    std::array<float, ANALYSIS_LANES> sum{};
+    std::array<float, ANALYSIS_LANES> square_sum{};
+    std::array<int, ANALYSIS_LANES> clipped{};
+
+    for (int i = 0; i < samples; i += ANALYSIS_LANES)
+    {
+        for (int lane = 0; lane < ANALYSIS_LANES; ++lane)
+        {
+            float sample = data[i + lane];
+            float abs_sample = std::abs(sample);
+            peak[lane] = abs_sample > peak[lane] ? abs_sample : peak[lane];
+            sum[lane] += sample;
+            square_sum[lane] += sample * sample;
+            clipped[lane] += abs_sample >= 1.0f;
+        }
+    }
+
+    LevelAnalysis result{0.0f, 0.0f, 0.0f, 0};
+    for (int lane = 0; lane < ANALYSIS_LANES; ++lane)
+    {
+        result.peak = std::max(result.peak, peak[lane]);
+        result.dc_offset += sum[lane];
+        result.mean_square += square_sum[lane];
+        result.clipped_samples += clipped[lane];
+    }
+    result.dc_offset /= samples;
+    result.mean_square /= samples;
+    return result;
+}
+
+/**
+ * @brief Analyse all channels of a buffer. The sample count is given as a compile
+ *        time constant for the common chunk sizes to allow full unrolling.
+ * @param buffer The audio buffer to analyse
+ * @param results Analysis results, one per channel. Only the first
+ *                min(results.size(), buffer.channel_count()) channels are analysed
+ */
+template <int size>
+inline void analyse_levels(const sushi::SampleBuffer<size>& buffer, std::vector<LevelAnalysis>& results)
+{
+    int channels = std::min(static_cast<int>(results.size()), buffer.channel_count());
+    sushi::with_static_chunk_size(buffer.frame_count(), [&](auto frames)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            results[ch] = analyse_levels(buffer.channel(ch), frames);
+        }
+    });
+}
+
+} // end namespace dsp
+
+#endif //SUSHI_LEVEL_ANALYSIS_H
@@ -18,28 +18,28 @@
  * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
  */
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <functional>
+#include <iterator>
+#include <climits>
+#include <unordered_set>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "twine/src/twine_internal.h"
 
 #include "audio_engine.h"
 #include "logging.h"
-#include "plugins/passthrough_plugin.h"
-#include "plugins/gain_plugin.h"
-#include "plugins/lfo_plugin.h"
-#include "plugins/equalizer_plugin.h"
-#include "plugins/arpeggiator_plugin.h"
-#include "plugins/sample_player_plugin.h"
-#include "plugins/peak_meter_plugin.h"
-#include "plugins/transposer_plugin.h"
-#include "plugins/step_sequencer_plugin.h"
-#include "plugins/cv_to_control_plugin.h"
-#include "plugins/control_to_cv_plugin.h"
+#include "library/internal_plugin_registry.h"
 #include "library/vst2x_wrapper.h"
 #include "library/vst3x_wrapper.h"
 #include "library/lv2/lv2_wrapper.h"
+#include "library/rt_safety.h"
 
 namespace sushi {
 namespace engine {
@@ -47,13 +47,36 @@ namespace engine {
 constexpr auto RT_EVENT_TIMEOUT = std::chrono::milliseconds(200);
 constexpr char TIMING_FILE_NAME[] = "timings.txt";
 constexpr auto CLIPPING_DETECTION_INTERVAL = std::chrono::milliseconds(500);
+/* Time for the peak meter to fall 20dB */
+constexpr float METER_PEAK_RELEASE_TIME = 1.5f;
+/* Integration time of rms and dc offset */
+constexpr float METER_SMOOTHING_TIME = 0.3f;
+/* Smallest change of a cv input that results in a parameter change event, ~12 bit resolution */
+constexpr float CV_CHANGE_THRESHOLD = 1.0f / 4096;
+/* Outside of the cv range so the first value is always sent */
+constexpr float CV_VALUE_UNSET = -1.0f;
+/* Parameters closer than this to their saved value are not updated on session restore */
+constexpr float SESSION_PARAMETER_THRESHOLD = 1.0e-6f;
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("engine");
 
+/* Multi chunk periods are only used with Jack, which doesn't run on Xenomai, so a
+ * plain Linux futex is used */
+void ChunkSync::_futex_wait(std::atomic<int>& word, int value)
+{
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free);
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+void ChunkSync::_futex_wake(std::atomic<int>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
 
 void ClipDetector::set_sample_rate(float samplerate)
 {
-    _interval = samplerate * CLIPPING_DETECTION_INTERVAL.count() / 1000 - AUDIO_CHUNK_SIZE;
+    _interval = samplerate * CLIPPING_DETECTION_INTERVAL.count() / 1000 - audio_chunk_size();
 }
 
 void ClipDetector::set_input_channels(int channels)
@@ -66,12 +89,13 @@ void ClipDetector::set_output_channels(int channels)
     _output_clip_count = std::vector<unsigned int>(channels, _interval);
 }
 
-void ClipDetector::detect_clipped_samples(const ChunkSampleBuffer& buffer, RtSafeRtEventFifo& queue, bool audio_input)
+void ClipDetector::detect_clipped_samples(const std::vector<dsp::LevelAnalysis>& levels, RtSafeRtEventFifo& queue, bool audio_input)
 {
     auto& counter = audio_input? _input_clip_count : _output_clip_count;
-    for (int i = 0; i < buffer.channel_count(); ++i)
+    int channels = std::min(levels.size(), counter.size());
+    for (int i = 0; i < channels; ++i)
     {
-        if (buffer.count_clipped_samples(i, 1) > 0 && counter[i] >= _interval)
+        if (levels[i].clipped_samples > 0 && counter[i] >= _interval)
         {
             queue.push(RtEvent::make_clip_notification_event(0, i, audio_input? ClipNotificationRtEvent::ClipChannelType::INPUT:
                                                                    ClipNotificationRtEvent::ClipChannelType::OUTPUT));
@@ -79,18 +103,67 @@ void ClipDetector::detect_clipped_samples(const ChunkSampleBuffer& buffer, RtSaf
         }
         else
         {
-            counter[i] += AUDIO_CHUNK_SIZE;
+            counter[i] += audio_chunk_size();
         }
     }
 }
 
+void LevelMeter::set_sample_rate(float sample_rate)
+{
+    float chunks_per_second = sample_rate / audio_chunk_size();
+    _peak_decay = std::pow(0.1f, 1.0f / (METER_PEAK_RELEASE_TIME * chunks_per_second));
+    _smoothing_coef = std::exp(-1.0f / (METER_SMOOTHING_TIME * chunks_per_second));
+}
+
+void LevelMeter::set_channels(int channels)
+{
+    _levels = std::make_unique<ChannelLevel[]>(channels);
+    _channels = channels;
+}
+
+void LevelMeter::update(const std::vector<dsp::LevelAnalysis>& levels)
+{
+    int channels = std::min(static_cast<int>(levels.size()), _channels);
+    for (int i = 0; i < channels; ++i)
+    {
+        /* Only the audio thread writes, so relaxed load-modify-store is enough */
+        auto& level = _levels[i];
+        const auto& analysis = levels[i];
+        float peak = std::max(analysis.peak, level.peak.load(std::memory_order_relaxed) * _peak_decay);
+        float mean_square = _smoothing_coef * level.mean_square.load(std::memory_order_relaxed) +
+                            (1.0f - _smoothing_coef) * analysis.mean_square;
+        float dc_offset = _smoothing_coef * level.dc_offset.load(std::memory_order_relaxed) +
+                          (1.0f - _smoothing_coef) * analysis.dc_offset;
+        level.peak.store(peak, std::memory_order_relaxed);
+        level.mean_square.store(mean_square, std::memory_order_relaxed);
+        level.dc_offset.store(dc_offset, std::memory_order_relaxed);
+    }
+}
+
+std::vector<ext::AudioLevel> LevelMeter::levels() const
+{
+    std::vector<ext::AudioLevel> levels;
+    levels.reserve(_channels);
+    for (int i = 0; i < _channels; ++i)
+    {
+        const auto& level = _levels[i];
+        levels.push_back({level.peak.load(std::memory_order_relaxed),
+                          std::sqrt(level.mean_square.load(std::memory_order_relaxed)),
+                          level.dc_offset.load(std::memory_order_relaxed)});
+    }
+    return levels;
+}
+
 AudioEngine::AudioEngine(float sample_rate, int rt_cpu_cores) : BaseEngine::BaseEngine(sample_rate),
                                                                 _multicore_processing(rt_cpu_cores > 1),
                                                                 _rt_cores(rt_cpu_cores),
                                                                 _transport(sample_rate),
-                                                                _clip_detector(sample_rate)
+                                                                _clip_detector(sample_rate),
+                                                                _input_meter(sample_rate),
+                                                                _output_meter(sample_rate)
 {
     this->set_sample_rate(sample_rate);
+    _transport.set_event_output(&_main_out_queue);
     _event_dispatcher.run();
     if (_multicore_processing)
     {
@@ -116,19 +189,25 @@ void AudioEngine::set_sample_rate(float sample_rate)
         node.second->configure(sample_rate);
     }
     _transport.set_sample_rate(sample_rate);
-    _process_timer.set_timing_period(sample_rate, AUDIO_CHUNK_SIZE);
+    _process_timer.set_timing_period(sample_rate, audio_chunk_size());
     _clip_detector.set_sample_rate(sample_rate);
+    _input_meter.set_sample_rate(sample_rate);
+    _output_meter.set_sample_rate(sample_rate);
 }
 
 void AudioEngine::set_audio_input_channels(int channels)
 {
     _clip_detector.set_input_channels(channels);
+    _input_meter.set_channels(channels);
+    _input_levels.resize(channels);
     BaseEngine::set_audio_input_channels(channels);
 }
 
 void AudioEngine::set_audio_output_channels(int channels)
 {
     _clip_detector.set_output_channels(channels);
+    _output_meter.set_channels(channels);
+    _output_levels.resize(channels);
     BaseEngine::set_audio_output_channels(channels);
 }
 
@@ -233,6 +312,8 @@ EngineReturnStatus AudioEngine::connect_cv_to_parameter(const std::string& proce
     con.processor_id = processor_node->second->id();
     con.parameter_id = param->id();
     con.cv_id = cv_input_id;
+    con.audio_rate = processor_node->second->supports_cv_signal(param->id());
+    con.last_value = CV_VALUE_UNSET;
     _cv_in_routes.push_back(con);
     SUSHI_LOG_INFO("Connected cv input {} to parameter {} on {}", cv_input_id, parameter_name, processor_name);
     return EngineReturnStatus::OK;
@@ -312,15 +393,29 @@ EngineReturnStatus AudioEngine::connect_gate_from_processor(const std::string& p
     return EngineReturnStatus::OK;
 }
 
-EngineReturnStatus AudioEngine::connect_gate_to_sync(int /*gate_input_id*/, int /*ppq_ticks*/)
+EngineReturnStatus AudioEngine::connect_gate_to_sync(int gate_input_id, int ppq_ticks)
 {
-    // TODO -  Needs implementing
+    if (gate_input_id < 0 || gate_input_id >= MAX_ENGINE_GATE_PORTS || ppq_ticks <= 0)
+    {
+        return EngineReturnStatus::ERROR;
+    }
+    _sync_gate_in.gate_id = gate_input_id;
+    _sync_gate_in.ppq_ticks = ppq_ticks;
+    SUSHI_LOG_INFO("Using gate input {} as sync input with {} ppq", gate_input_id, ppq_ticks);
     return EngineReturnStatus::OK;
 }
 
-EngineReturnStatus AudioEngine::connect_sync_to_gate(int /*gate_output_id*/, int /*ppq_ticks*/)
+EngineReturnStatus AudioEngine::connect_sync_to_gate(int gate_output_id, int ppq_ticks)
 {
-    // TODO -  Needs implementing
+    if (gate_output_id < 0 || gate_output_id >= MAX_ENGINE_GATE_PORTS || ppq_ticks <= 0)
+    {
+        return EngineReturnStatus::ERROR;
+    }
+    SyncGateConnection con;
+    con.gate_id = gate_output_id;
+    con.ppq_ticks = ppq_ticks;
+    _sync_gate_out_routes.push_back(con);
+    SUSHI_LOG_INFO("Sending sync pulses with {} ppq on gate output {}", ppq_ticks, gate_output_id);
     return EngineReturnStatus::OK;
 }
 
@@ -359,52 +454,7 @@ int AudioEngine::n_channels_in_track(int track)
 
 Processor* AudioEngine::_make_internal_plugin(const std::string& uid)
 {
-    Processor* instance = nullptr;
-    if (uid == "sushi.testing.passthrough")
-    {
-        instance = new passthrough_plugin::PassthroughPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.gain")
-    {
-        instance = new gain_plugin::GainPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.lfo")
-    {
-        instance = new lfo_plugin::LfoPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.equalizer")
-    {
-        instance = new equalizer_plugin::EqualizerPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.sampleplayer")
-    {
-        instance = new sample_player_plugin::SamplePlayerPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.arpeggiator")
-    {
-        instance = new arpeggiator_plugin::ArpeggiatorPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.peakmeter")
-    {
-        instance = new peak_meter_plugin::PeakMeterPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.transposer")
-    {
-        instance = new transposer_plugin::TransposerPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.step_sequencer")
-    {
-        instance = new step_sequencer_plugin::StepSequencerPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.cv_to_control")
-    {
-        instance = new cv_to_control_plugin::CvToControlPlugin(_host_control);
-    }
-    else if (uid == "sushi.testing.control_to_cv")
-    {
-        instance = new control_to_cv_plugin::ControlToCvPlugin(_host_control);
-    }
-    return instance;
+    return InternalPluginRegistry::create(uid, _host_control);
 }
 
 EngineReturnStatus AudioEngine::_register_processor(Processor* processor, const std::string& name)
@@ -420,7 +470,9 @@ EngineReturnStatus AudioEngine::_register_processor(Processor* processor, const
         return EngineReturnStatus::INVALID_PROCESSOR;
     }
     processor->set_name(name);
-    _processors[name] = std::move(std::unique_ptr<Processor>(processor));
+    processor->set_parameter_notification_buffer(_parameter_notifications.add(processor->id(),
+                                                                              processor->parameter_count()));
+    _processors[name] = std::shared_ptr<Processor>(processor);
     SUSHI_LOG_DEBUG("Succesfully registered processor {}.", name);
     return EngineReturnStatus::OK;
 }
@@ -432,6 +484,7 @@ EngineReturnStatus AudioEngine::_deregister_processor(const std::string &name)
     {
         return EngineReturnStatus::INVALID_PLUGIN_NAME;
     }
+    _parameter_notifications.remove(processor_node->second->id());
     _processors.erase(processor_node);
     return EngineReturnStatus::OK;
 }
@@ -496,6 +549,7 @@ void AudioEngine::process_chunk(SampleBuffer<AUDIO_CHUNK_SIZE>* in_buffer,
     auto engine_timestamp = _process_timer.start_timer();
 
     _transport.set_time(timestamp, samplecount);
+    out_controls->midi_events.clear();
 
     RtEvent in_event;
     while (_internal_control_queue.pop(in_event))
@@ -515,16 +569,28 @@ void AudioEngine::process_chunk(SampleBuffer<AUDIO_CHUNK_SIZE>* in_buffer,
     _event_dispatcher.set_time(_transport.current_process_time());
     auto state = _state.load();
 
+    dsp::analyse_levels(*in_buffer, _input_levels);
+    _input_meter.update(_input_levels);
     if (_input_clip_detection_enabled)
     {
-        _clip_detector.detect_clipped_samples(*in_buffer, _main_out_queue, true);
+        _clip_detector.detect_clipped_samples(_input_levels, _main_out_queue, true);
     }
     _copy_audio_to_tracks(in_buffer);
 
     if (_multicore_processing)
     {
-        _worker_pool->wakeup_workers();
-        _retrieve_events_from_tracks(*out_controls);
+        if (_multi_chunk_period)
+        {
+            _chunk_sync.publish_chunk();
+            _retrieve_events_from_tracks(*out_controls);
+            _chunk_sync.wait_for_rendered_chunk();
+        }
+        else
+        {
+            _worker_pool->wakeup_workers();
+            _retrieve_events_from_tracks(*out_controls);
+            _worker_pool->wait_for_workers_idle();
+        }
     }
     else
     {
@@ -534,23 +600,67 @@ void AudioEngine::process_chunk(SampleBuffer<AUDIO_CHUNK_SIZE>* in_buffer,
         }
         _process_outgoing_events(*out_controls, _processor_out_queue);
     }
-
-    if (_multicore_processing)
-    {
-        _worker_pool->wait_for_workers_idle();
-    }
+    _output_sync_gates(*out_controls);
 
     _main_out_queue.push(RtEvent::make_synchronisation_event(_transport.current_process_time()));
     _copy_audio_from_tracks(out_buffer);
     _state.store(update_state(state));
 
+    dsp::analyse_levels(*out_buffer, _output_levels);
+    _output_meter.update(_output_levels);
     if (_output_clip_detection_enabled)
     {
-        _clip_detector.detect_clipped_samples(*out_buffer, _main_out_queue, false);
+        _clip_detector.detect_clipped_samples(_output_levels, _main_out_queue, false);
     }
     _process_timer.stop_timer(engine_timestamp, ENGINE_TIMING_ID);
 }
 
+void AudioEngine::begin_period(int chunks)
+{
+    if (_multicore_processing && chunks > 1)
+    {
+        _chunk_sync.start(chunks, _track_worker_count.load());
+        _worker_pool->wakeup_workers();
+        _multi_chunk_period = true;
+    }
+}
+
+void AudioEngine::end_period()
+{
+    if (_multi_chunk_period)
+    {
+        _chunk_sync.finish();
+        _worker_pool->wait_for_workers_idle();
+        _chunk_sync.reset();
+        _multi_chunk_period = false;
+    }
+}
+
+void AudioEngine::_track_worker_function(void* arg)
+{
+    auto worker = static_cast<TrackWorker*>(arg);
+    auto& sync = *worker->sync;
+    if (sync.chunks() == 0)
+    {
+        worker->track->render();
+        return;
+    }
+    /* Workers added after the period started are not waited for */
+    if (worker->index >= sync.workers())
+    {
+        return;
+    }
+    for (int chunk = 0; chunk < sync.chunks(); ++chunk)
+    {
+        if (sync.wait_for_chunk(chunk) == false)
+        {
+            break;
+        }
+        worker->track->render();
+        sync.notify_rendered();
+    }
+}
+
 void AudioEngine::set_tempo(float tempo)
 {
     bool realtime_running = _state != RealtimeState::STOPPED;
@@ -612,6 +722,7 @@ EngineReturnStatus AudioEngine::send_rt_event(RtEvent& event)
         SUSHI_LOG_WARNING("Invalid processor id {}.", event.processor_id());
         return EngineReturnStatus::INVALID_PROCESSOR;
     }
+    rt_safety::ScopedProcessorMarker marker(processor_node->id());
     processor_node->process_event(event);
     return EngineReturnStatus::OK;
 }
@@ -627,25 +738,25 @@ EngineReturnStatus AudioEngine::send_async_event(RtEvent& event)
 }
 
 
-std::pair<EngineReturnStatus, ObjectId> AudioEngine::processor_id_from_name(const std::string& name)
+std::pair<EngineReturnStatus, ObjectId> AudioEngine::processor_id_from_name(std::string_view name)
 {
-    auto processor_node = _processors.find(name);
-    if (processor_node == _processors.end())
+    auto processor = graph_snapshot()->processor(name);
+    if (processor == nullptr)
     {
         return std::make_pair(EngineReturnStatus::INVALID_PROCESSOR, 0);
     }
-    return std::make_pair(EngineReturnStatus::OK, processor_node->second->id());
+    return std::make_pair(EngineReturnStatus::OK, processor->id());
 }
 
-std::pair<EngineReturnStatus, ObjectId> AudioEngine::parameter_id_from_name(const std::string& processor_name,
-                                                                            const std::string& parameter_name)
+std::pair<EngineReturnStatus, ObjectId> AudioEngine::parameter_id_from_name(std::string_view processor_name,
+                                                                            std::string_view parameter_name)
 {
-    auto processor_node = _processors.find(processor_name);
-    if (processor_node == _processors.end())
+    auto snapshot = graph_snapshot();
+    auto param = snapshot->parameter(processor_name, parameter_name);
+    if (param == nullptr && snapshot->processor(processor_name) == nullptr)
     {
         return std::make_pair(EngineReturnStatus::INVALID_PROCESSOR, 0);
     }
-    auto param = processor_node->second->parameter_from_name(parameter_name);
     if (param)
     {
         return std::make_pair(EngineReturnStatus::OK, param->id());
@@ -655,22 +766,24 @@ std::pair<EngineReturnStatus, ObjectId> AudioEngine::parameter_id_from_name(cons
 
 std::pair<EngineReturnStatus, const std::string> AudioEngine::processor_name_from_id(const ObjectId uid)
 {
-    if (!_processor_exists(uid))
+    auto processor = graph_snapshot()->processor(uid);
+    if (processor == nullptr)
     {
         return std::make_pair(EngineReturnStatus::INVALID_PROCESSOR, std::string(""));
     }
-    return std::make_pair(EngineReturnStatus::OK, _realtime_processors[uid]->name());
+    return std::make_pair(EngineReturnStatus::OK, processor->name());
 }
 
-std::pair<EngineReturnStatus, const std::string> AudioEngine::parameter_name_from_id(const std::string &processor_name,
+std::pair<EngineReturnStatus, const std::string> AudioEngine::parameter_name_from_id(std::string_view processor_name,
                                                                                      const ObjectId id)
 {
-    auto processor_node = _processors.find(processor_name);
-    if (processor_node == _processors.end())
+    auto snapshot = graph_snapshot();
+    auto processor = snapshot->processor(processor_name);
+    if (processor == nullptr)
     {
         return std::make_pair(EngineReturnStatus::INVALID_PROCESSOR, "");
     }
-    auto param = processor_node->second->parameter_from_id(id);
+    auto param = snapshot->parameter(processor->id(), id);
     if (param)
     {
         return std::make_pair(EngineReturnStatus::OK, param->name());
@@ -723,20 +836,24 @@ EngineReturnStatus AudioEngine::delete_track(const std::string &track_name)
         {
             SUSHI_LOG_ERROR("Failed to remove processor {} from processing part", track_name);
         }
-        return _deregister_processor(track_name);
+        auto status = _deregister_processor(track_name);
+        _publish_graph_snapshot();
+        return status;
     }
     else
     {
-        for (auto track_in_graph = _audio_graph.begin(); track_in_graph != _audio_graph.end(); ++track)
+        for (auto track_in_graph = _audio_graph.begin(); track_in_graph != _audio_graph.end(); ++track_in_graph)
         {
             if (*track_in_graph == track)
             {
                 _audio_graph.erase(track_in_graph);
                 _remove_processor_from_realtime_part(track->id());
-                return _deregister_processor(track_name);
+                auto status = _deregister_processor(track_name);
+                _publish_graph_snapshot();
+                return status;
             }
-            SUSHI_LOG_WARNING("Plugin track {} was not in the audio graph", track_name);
         }
+        SUSHI_LOG_WARNING("Plugin track {} was not in the audio graph", track_name);
         return EngineReturnStatus::INVALID_TRACK;
     }
 }
@@ -792,6 +909,7 @@ EngineReturnStatus AudioEngine::add_plugin_to_track(const std::string &track_nam
         delete plugin;
         return status;
     }
+    _plugin_info[plugin_name] = PluginInfo{plugin_uid, plugin_path, plugin_type};
     plugin->set_enabled(true);
     if (realtime())
     {
@@ -805,6 +923,7 @@ EngineReturnStatus AudioEngine::add_plugin_to_track(const std::string &track_nam
         if (!inserted || !added)
         {
             SUSHI_LOG_ERROR("Failed to insert/add processor {} to processing part", plugin_name);
+            _publish_graph_snapshot();
             return EngineReturnStatus::INVALID_PROCESSOR;
         }
     }
@@ -814,9 +933,11 @@ EngineReturnStatus AudioEngine::add_plugin_to_track(const std::string &track_nam
         _insert_processor_in_realtime_part(plugin);
         if (track->add(plugin) == false)
         {
+            _publish_graph_snapshot();
             return EngineReturnStatus::ERROR;
         }
     }
+    _publish_graph_snapshot();
     return EngineReturnStatus::OK;
 }
 
@@ -859,7 +980,495 @@ EngineReturnStatus AudioEngine::remove_plugin_from_track(const std::string &trac
         }
         _remove_processor_from_realtime_part(processor->id());
     }
-    return _deregister_processor(processor->name());
+    _plugin_info.erase(plugin_name);
+    auto status = _deregister_processor(processor->name());
+    _publish_graph_snapshot();
+    return status;
+}
+
+std::pair<EngineReturnStatus, std::vector<uint8_t>> AudioEngine::save_session()
+{
+    auto graph = graph_snapshot();
+    SessionSnapshot session;
+    for (const auto& node : graph->tracks())
+    {
+        auto& track = *node.track;
+        SessionSnapshot::TrackState track_state;
+        track_state.track = SessionSnapshot::capture_processor(track, PluginInfo{"", "", PluginType::INTERNAL});
+        track_state.channels = track.input_channels();
+        track_state.input_busses = track.input_busses();
+        track_state.output_busses = track.output_busses();
+        for (const auto& processor : node.processors)
+        {
+            auto info = _plugin_info.find(processor->name());
+            if (info == _plugin_info.end())
+            {
+                SUSHI_LOG_WARNING("No plugin info for processor {}, not saved", processor->name());
+                continue;
+            }
+            track_state.processors.push_back(SessionSnapshot::capture_processor(*processor, info->second));
+        }
+        session.tracks.push_back(std::move(track_state));
+    }
+    auto save_connections = [&graph](const std::vector<AudioConnection>& connections,
+                                     std::vector<SessionSnapshot::AudioConnection>& saved)
+    {
+        for (const auto& connection : connections)
+        {
+            auto track = graph->processor(connection.track);
+            if (track)
+            {
+                saved.push_back({connection.engine_channel, connection.track_channel, track->name()});
+            }
+        }
+    };
+    save_connections(_in_audio_connections, session.input_connections);
+    save_connections(_out_audio_connections, session.output_connections);
+    return {EngineReturnStatus::OK, session.serialize()};
+}
+
+EngineReturnStatus AudioEngine::restore_session(const std::vector<uint8_t>& data)
+{
+    auto [valid, session] = SessionSnapshot::deserialize(data);
+    if (!valid)
+    {
+        SUSHI_LOG_ERROR("Invalid session data");
+        return EngineReturnStatus::ERROR;
+    }
+    auto validation_status = _validate_session(session);
+    if (validation_status != EngineReturnStatus::OK)
+    {
+        return validation_status;
+    }
+
+    std::unordered_map<std::string_view, const SessionSnapshot::TrackState*> target_tracks;
+    std::unordered_map<std::string_view, const SessionSnapshot::ProcessorState*> target_processors;
+    for (const auto& track : session.tracks)
+    {
+        target_tracks[track.track.name] = &track;
+        for (const auto& processor : track.processors)
+        {
+            target_processors[processor.name] = &processor;
+        }
+    }
+    /* A loaded plugin is kept if the session has a processor with the same name and plugin */
+    auto reusable = [&](const std::string& name)
+    {
+        auto target = target_processors.find(name);
+        auto info = _plugin_info.find(name);
+        return target != target_processors.end() && info != _plugin_info.end() && info->second == target->second->plugin;
+    };
+    auto is_multibus = [](int input_busses, int output_busses)
+    {
+        return input_busses > 1 || output_busses > 1;
+    };
+
+    /* Tracks are kept if the session has a track with the same name and channel layout */
+    auto keep_track = [&](Track* track)
+    {
+        auto target = target_tracks.find(track->name());
+        if (target == target_tracks.end())
+        {
+            return false;
+        }
+        const auto& target_track = *target->second;
+        if (is_multibus(target_track.input_busses, target_track.output_busses))
+        {
+            return track->input_busses() == target_track.input_busses &&
+                   track->output_busses() == target_track.output_busses;
+        }
+        return !is_multibus(track->input_busses(), track->output_busses()) &&
+               track->input_channels() == target_track.channels;
+    };
+    std::vector<Track*> obsolete_tracks;
+    for (auto track : _audio_graph)
+    {
+        if (!keep_track(track))
+        {
+            obsolete_tracks.push_back(track);
+        }
+    }
+
+    /* Disconnect the tracks that will be deleted first, as the audio thread reads the
+     * connections by track id */
+    if (!obsolete_tracks.empty())
+    {
+        auto update = std::make_unique<RtSessionUpdate>();
+        auto obsolete = [&obsolete_tracks](const AudioConnection& connection)
+        {
+            return std::any_of(obsolete_tracks.begin(), obsolete_tracks.end(),
+                               [&](const Track* track) {return track->id() == connection.track;});
+        };
+        std::remove_copy_if(_in_audio_connections.begin(), _in_audio_connections.end(),
+                            std::back_inserter(update->in_connections), obsolete);
+        std::remove_copy_if(_out_audio_connections.begin(), _out_audio_connections.end(),
+                            std::back_inserter(update->out_connections), obsolete);
+        if (_apply_session_update(update.get()) == false)
+        {
+            SUSHI_LOG_ERROR("Failed to disconnect tracks in the audio thread");
+            _retire_session_update(std::move(update));
+            return EngineReturnStatus::ERROR;
+        }
+    }
+
+    /* Take apart the process chain of every track from the first position where it differs
+     * from the session. Reusable processors are only detached so they can be added back in
+     * their new place, all others are deleted along with obsolete tracks. */
+    auto live_tracks = _audio_graph;
+    for (auto track : live_tracks)
+    {
+        bool keep = keep_track(track);
+        auto chain = track->process_chain();
+        size_t kept = 0;
+        if (keep)
+        {
+            const auto& target_chain = target_tracks[track->name()]->processors;
+            while (kept < chain.size() && kept < target_chain.size() &&
+                   chain[kept]->name() == target_chain[kept].name && reusable(chain[kept]->name()))
+            {
+                kept++;
+            }
+        }
+        for (size_t i = chain.size(); i > kept; --i)
+        {
+            auto processor = chain[i - 1];
+            auto status = reusable(processor->name()) ? _detach_processor(processor, track) :
+                                                        remove_plugin_from_track(track->name(), processor->name());
+            if (status != EngineReturnStatus::OK)
+            {
+                SUSHI_LOG_ERROR("Failed to remove processor {} from track {}", processor->name(), track->name());
+                return status;
+            }
+        }
+        if (!keep)
+        {
+            std::string name = track->name();
+            auto status = delete_track(name);
+            if (status != EngineReturnStatus::OK)
+            {
+                SUSHI_LOG_ERROR("Failed to delete track {}", name);
+                return status;
+            }
+        }
+    }
+
+    /* Create missing tracks and complete the process chains */
+    for (const auto& target_track : session.tracks)
+    {
+        const auto& name = target_track.track.name;
+        if (_processors.count(name) == 0)
+        {
+            auto status = is_multibus(target_track.input_busses, target_track.output_busses) ?
+                          create_multibus_track(name, target_track.input_busses, target_track.output_busses) :
+                          create_track(name, target_track.channels);
+            if (status != EngineReturnStatus::OK)
+            {
+                SUSHI_LOG_ERROR("Failed to create track {}", name);
+                return status;
+            }
+        }
+        auto track = _track_from_name(name);
+        if (track == nullptr)
+        {
+            SUSHI_LOG_ERROR("Failed to restore track {}, name is used by a processor", name);
+            return EngineReturnStatus::INVALID_TRACK;
+        }
+        for (size_t i = track->process_chain().size(); i < target_track.processors.size(); ++i)
+        {
+            const auto& target = target_track.processors[i];
+            auto processor_node = _processors.find(target.name);
+            EngineReturnStatus status;
+            if (processor_node == _processors.end())
+            {
+                status = add_plugin_to_track(name, target.plugin.uid, target.name, target.plugin.path, target.plugin.type);
+            }
+            else if (reusable(target.name))
+            {
+                status = _attach_processor(processor_node->second.get(), track);
+            }
+            else
+            {
+                status = EngineReturnStatus::INVALID_PLUGIN_NAME;
+            }
+            if (status != EngineReturnStatus::OK)
+            {
+                SUSHI_LOG_ERROR("Failed to add processor {} to track {}", target.name, name);
+                return status;
+            }
+        }
+    }
+
+    /* Collect everything that should change in the rt part so it can be applied at once */
+    auto update = std::make_unique<RtSessionUpdate>();
+    auto restore_state = [&](Processor* processor, const SessionSnapshot::ProcessorState& state)
+    {
+        if (processor->bypassed() != state.bypassed)
+        {
+            processor->set_bypassed(state.bypassed);
+        }
+        bool program_changed = false;
+        if (state.has_program && processor->supports_programs() && processor->current_program() != state.program)
+        {
+            /* Instance swapping plugins apply parameter changes sent after this to the
+             * new instance as well, so the parameters below are not lost */
+            processor->set_program(state.program);
+            program_changed = true;
+        }
+        for (const auto& parameter : state.parameters)
+        {
+            auto descriptor = processor->parameter_from_name(parameter.name);
+            if (descriptor == nullptr)
+            {
+                continue;
+            }
+            auto [status, value] = processor->parameter_value(descriptor->id());
+            if (program_changed || status != ProcessorReturnCode::OK ||
+                std::abs(value - parameter.value) > SESSION_PARAMETER_THRESHOLD)
+            {
+                update->parameters.push_back({processor->id(), descriptor->id(), parameter.value});
+            }
+        }
+        /* Properties are set through the dispatcher as the plugin may need to do
+         * work in a non-rt thread to take them into use */
+        for (const auto& property : state.string_properties)
+        {
+            auto descriptor = processor->parameter_from_name(property.name);
+            if (descriptor == nullptr || descriptor->type() != ParameterType::STRING ||
+                processor->string_property_value(descriptor->id()) == std::make_pair(ProcessorReturnCode::OK, property.value))
+            {
+                continue;
+            }
+            _event_dispatcher.post_event(new StringPropertyChangeEvent(processor->id(), descriptor->id(),
+                                                                       property.value, IMMEDIATE_PROCESS));
+        }
+        for (const auto& property : state.data_properties)
+        {
+            auto descriptor = processor->parameter_from_name(property.name);
+            if (descriptor == nullptr || descriptor->type() != ParameterType::DATA ||
+                processor->data_property_value(descriptor->id()) == std::make_pair(ProcessorReturnCode::OK, property.value))
+            {
+                continue;
+            }
+            /* The receiving plugin takes ownership of the data */
+            BlobData blob{static_cast<int>(property.value.size()), new uint8_t[property.value.size()]};
+            std::copy(property.value.begin(), property.value.end(), blob.data);
+            _event_dispatcher.post_event(new DataPropertyChangeEvent(processor->id(), descriptor->id(),
+                                                                     blob, IMMEDIATE_PROCESS));
+        }
+    };
+    for (const auto& target_track : session.tracks)
+    {
+        auto track = _track_from_name(target_track.track.name);
+        restore_state(track, target_track.track);
+        for (const auto& target : target_track.processors)
+        {
+            restore_state(_processors.at(target.name).get(), target);
+        }
+    }
+
+    for (const auto& connection : session.input_connections)
+    {
+        auto track = _track_from_name(connection.track);
+        if (connection.engine_channel < _audio_inputs && connection.track_channel < track->input_channels())
+        {
+            update->in_connections.push_back({connection.engine_channel, connection.track_channel, track->id()});
+        }
+    }
+    for (const auto& connection : session.output_connections)
+    {
+        auto track = _track_from_name(connection.track);
+        if (connection.engine_channel < _audio_outputs && connection.track_channel < track->max_output_channels())
+        {
+            if (connection.track_channel >= track->output_channels())
+            {
+                track->set_output_channels(connection.track_channel + 1);
+            }
+            update->out_connections.push_back({connection.engine_channel, connection.track_channel, track->id()});
+        }
+    }
+
+    if (_apply_session_update(update.get()) == false)
+    {
+        SUSHI_LOG_ERROR("Failed to apply session update in the audio thread");
+        _retire_session_update(std::move(update));
+        return EngineReturnStatus::ERROR;
+    }
+
+    SUSHI_LOG_INFO("Restored session, {} parameters updated", update->parameters.size());
+    return EngineReturnStatus::OK;
+}
+
+EngineReturnStatus AudioEngine::_validate_session(const SessionSnapshot& session) const
+{
+    std::unordered_set<std::string_view> track_names;
+    std::unordered_map<std::string_view, const SessionSnapshot::ProcessorState*> processors;
+    for (const auto& track : session.tracks)
+    {
+        const auto& name = track.track.name;
+        if (name.empty() || track_names.insert(name).second == false || processors.count(name) > 0)
+        {
+            SUSHI_LOG_ERROR("Invalid session, duplicate or empty track name \"{}\"", name);
+            return EngineReturnStatus::INVALID_TRACK;
+        }
+        if (track.input_busses < 1 || track.input_busses > TRACK_MAX_BUSSES ||
+            track.output_busses < 1 || track.output_busses > TRACK_MAX_BUSSES)
+        {
+            SUSHI_LOG_ERROR("Invalid session, track {} has an invalid number of busses", name);
+            return EngineReturnStatus::INVALID_BUS;
+        }
+        if (track.input_busses == 1 && track.output_busses == 1 && (track.channels < 0 || track.channels > 2))
+        {
+            SUSHI_LOG_ERROR("Invalid session, track {} has an invalid number of channels", name);
+            return EngineReturnStatus::INVALID_N_CHANNELS;
+        }
+        for (const auto& processor : track.processors)
+        {
+            if (processor.name.empty() || track_names.count(processor.name) > 0 ||
+                processors.emplace(processor.name, &processor).second == false)
+            {
+                SUSHI_LOG_ERROR("Invalid session, duplicate or empty processor name \"{}\"", processor.name);
+                return EngineReturnStatus::INVALID_PLUGIN_NAME;
+            }
+        }
+    }
+
+    for (const auto* connections : {&session.input_connections, &session.output_connections})
+    {
+        for (const auto& connection : *connections)
+        {
+            if (connection.engine_channel < 0 || connection.track_channel < 0)
+            {
+                SUSHI_LOG_ERROR("Invalid session, negative channel in connection to track {}", connection.track);
+                return EngineReturnStatus::INVALID_CHANNEL;
+            }
+            if (track_names.count(connection.track) == 0)
+            {
+                SUSHI_LOG_ERROR("Invalid session, connection to unknown track {}", connection.track);
+                return EngineReturnStatus::INVALID_TRACK;
+            }
+        }
+    }
+
+    /* Processors that are not on any track are left alone by the restore, so they must
+     * not take the name of a session track or of a session processor of another kind */
+    std::unordered_set<const Processor*> in_graph;
+    for (auto track : _audio_graph)
+    {
+        in_graph.insert(track);
+        for (auto processor : track->process_chain())
+        {
+            in_graph.insert(processor);
+        }
+    }
+    for (const auto& [name, processor] : _processors)
+    {
+        if (in_graph.count(processor.get()) > 0)
+        {
+            continue;
+        }
+        if (track_names.count(name) > 0)
+        {
+            SUSHI_LOG_ERROR("Can't restore session, track name {} is used by a processor", name);
+            return EngineReturnStatus::INVALID_TRACK;
+        }
+        auto target = processors.find(name);
+        auto info = _plugin_info.find(name);
+        if (target != processors.end() && (info == _plugin_info.end() || info->second != target->second->plugin))
+        {
+            SUSHI_LOG_ERROR("Can't restore session, processor name {} is used by another plugin", name);
+            return EngineReturnStatus::INVALID_PLUGIN_NAME;
+        }
+    }
+    return EngineReturnStatus::OK;
+}
+
+Track* AudioEngine::_track_from_name(const std::string& name) const
+{
+    auto node = _processors.find(name);
+    if (node == _processors.end())
+    {
+        return nullptr;
+    }
+    auto track = std::find(_audio_graph.begin(), _audio_graph.end(), node->second.get());
+    return track != _audio_graph.end() ? *track : nullptr;
+}
+
+EngineReturnStatus AudioEngine::_attach_processor(Processor* processor, Track* track)
+{
+    if (realtime())
+    {
+        auto add_event = RtEvent::make_add_processor_to_track_event(processor->id(), track->id());
+        send_async_event(add_event);
+        if (!_event_receiver.wait_for_response(add_event.returnable_event()->event_id(), RT_EVENT_TIMEOUT))
+        {
+            _publish_graph_snapshot();
+            return EngineReturnStatus::INVALID_PROCESSOR;
+        }
+    }
+    else if (track->add(processor) == false)
+    {
+        _publish_graph_snapshot();
+        return EngineReturnStatus::ERROR;
+    }
+    _publish_graph_snapshot();
+    return EngineReturnStatus::OK;
+}
+
+EngineReturnStatus AudioEngine::_detach_processor(Processor* processor, Track* track)
+{
+    if (realtime())
+    {
+        auto remove_event = RtEvent::make_remove_processor_from_track_event(processor->id(), track->id());
+        send_async_event(remove_event);
+        if (!_event_receiver.wait_for_response(remove_event.returnable_event()->event_id(), RT_EVENT_TIMEOUT))
+        {
+            _publish_graph_snapshot();
+            return EngineReturnStatus::INVALID_PROCESSOR;
+        }
+    }
+    else if (track->remove(processor->id()) == false)
+    {
+        _publish_graph_snapshot();
+        return EngineReturnStatus::ERROR;
+    }
+    _publish_graph_snapshot();
+    return EngineReturnStatus::OK;
+}
+
+bool AudioEngine::_apply_session_update(RtSessionUpdate* update)
+{
+    if (realtime())
+    {
+        auto update_event = RtEvent::make_session_update_event(update);
+        send_async_event(update_event);
+        return _event_receiver.wait_for_response(update_event.returnable_event()->event_id(), RT_EVENT_TIMEOUT);
+    }
+    _commit_session_update(update);
+    return true;
+}
+
+void AudioEngine::_commit_session_update(RtSessionUpdate* update)
+{
+    _in_audio_connections.swap(update->in_connections);
+    _out_audio_connections.swap(update->out_connections);
+    for (const auto& parameter : update->parameters)
+    {
+        auto processor = _realtime_processors[parameter.processor];
+        if (processor)
+        {
+            auto event = RtEvent::make_parameter_change_event(parameter.processor, 0, parameter.parameter, parameter.value);
+            processor->process_event(event);
+        }
+    }
+    update->committed.store(true, std::memory_order_release);
+}
+
+void AudioEngine::_retire_session_update(std::unique_ptr<RtSessionUpdate> update)
+{
+    /* The audio thread might still access the update, so it can not be deleted until
+     * it has been committed */
+    std::scoped_lock lock(_retired_session_updates_lock);
+    _retired_session_updates.push_back(std::move(update));
 }
 
 const Processor* AudioEngine::processor(ObjectId processor_id) const
@@ -905,6 +1514,7 @@ EngineReturnStatus AudioEngine::_register_new_track(const std::string& name, Tra
         if (!inserted || !added)
         {
             SUSHI_LOG_ERROR("Failed to insert/add track {} to processing part", name);
+            _publish_graph_snapshot();
             return EngineReturnStatus::INVALID_PROCESSOR;
         }
     } else
@@ -914,12 +1524,72 @@ EngineReturnStatus AudioEngine::_register_new_track(const std::string& name, Tra
     }
     if (_multicore_processing)
     {
-        _worker_pool->add_worker(Track::ext_render_function, track);
+        int index = _track_worker_count.load();
+        _track_workers.push_back(std::make_unique<TrackWorker>(TrackWorker{track, &_chunk_sync, index}));
+        _worker_pool->add_worker(_track_worker_function, _track_workers.back().get());
+        _track_worker_count.store(index + 1);
     }
+    _publish_graph_snapshot();
     SUSHI_LOG_INFO("Track {} successfully added to engine", name);
     return EngineReturnStatus::OK;
 }
 
+void AudioEngine::_publish_graph_snapshot()
+{
+    /* Graph edits are serialised and any rt part of an edit has completed when this
+     * is called, so the track chains can be read safely from here */
+    auto snapshot = std::make_shared<GraphSnapshot>();
+    for (const auto& processor : _processors)
+    {
+        snapshot->add_processor(processor.second);
+    }
+    for (auto track : _audio_graph)
+    {
+        auto track_node = _processors.find(track->name());
+        if (track_node == _processors.end())
+        {
+            continue;
+        }
+        GraphSnapshot::TrackNode node{std::static_pointer_cast<Track>(track_node->second), {}};
+        for (auto processor : track->process_chain())
+        {
+            auto processor_node = _processors.find(processor->name());
+            if (processor_node != _processors.end())
+            {
+                node.processors.push_back(processor_node->second);
+            }
+        }
+        snapshot->add_track(std::move(node));
+    }
+#ifdef __cpp_lib_atomic_shared_ptr
+    auto retired = _graph_snapshot.exchange(std::move(snapshot), std::memory_order_acq_rel);
+#else
+    auto retired = std::atomic_exchange(&_graph_snapshot, std::shared_ptr<const GraphSnapshot>(std::move(snapshot)));
+#endif
+    std::scoped_lock lock(_retired_graph_snapshots_lock);
+    _retired_graph_snapshots.push_back(std::move(retired));
+}
+
+void AudioEngine::release_retired_graph_snapshots()
+{
+    /* A retired snapshot can not be loaded again, so once the list holds its only
+     * reference no other thread can get hold of it. Destroy them outside the lock
+     * as that can destroy processors too. */
+    std::vector<std::shared_ptr<const GraphSnapshot>> released;
+    {
+        std::scoped_lock lock(_retired_graph_snapshots_lock);
+        auto unused = std::stable_partition(_retired_graph_snapshots.begin(), _retired_graph_snapshots.end(),
+                                            [](const auto& snapshot) {return snapshot.use_count() > 1;});
+        std::move(unused, _retired_graph_snapshots.end(), std::back_inserter(released));
+        _retired_graph_snapshots.erase(unused, _retired_graph_snapshots.end());
+    }
+
+    std::scoped_lock lock(_retired_session_updates_lock);
+    _retired_session_updates.erase(std::remove_if(_retired_session_updates.begin(), _retired_session_updates.end(),
+                                                  [](const auto& update) {return update->committed.load(std::memory_order_acquire);}),
+                                   _retired_session_updates.end());
+}
+
 bool AudioEngine::_handle_internal_events(RtEvent& event)
 {
     switch (event.type())
@@ -1007,6 +1677,13 @@ bool AudioEngine::_handle_internal_events(RtEvent& event)
                 typed_event->set_handled(false);
             break;
         }
+        case RtEventType::SESSION_UPDATE:
+        {
+            auto typed_event = event.session_update_event();
+            _commit_session_update(typed_event->update());
+            typed_event->set_handled(true);
+            break;
+        }
         case RtEventType::TEMPO:
         case RtEventType::TIME_SIGNATURE:
         case RtEventType::PLAYING_MODE:
@@ -1015,6 +1692,12 @@ bool AudioEngine::_handle_internal_events(RtEvent& event)
             _transport.process_event(event);
             break;
         }
+        case RtEventType::SYNC_CLOCK:
+        {
+            /* Clock ticks arrive at a high rate and are not sent back to the non-rt domain */
+            _transport.process_event(event);
+            return true;
+        }
 
         default:
             return false;
@@ -1098,14 +1781,14 @@ void AudioEngine::print_timings_to_file(const std::string& filename)
         return;
     }
     file.setf(std::ios::left);
-    file << "Performance timings for all processors in percentages of audio buffer (100% = "<< 1000000.0 / _sample_rate * AUDIO_CHUNK_SIZE
+    file << "Performance timings for all processors in percentages of audio buffer (100% = "<< 1000000.0 / _sample_rate * audio_chunk_size()
          << "us)\n\n" << std::setw(24) << "" << std::setw(16) << "average(%)" << std::setw(16) << "minimum(%)"
          << std::setw(16) << "maximum(%)" << std::endl;
 
-    for (const auto& track : _audio_graph)
+    auto snapshot = graph_snapshot();
+    for (const auto& [track, processors] : snapshot->tracks())
     {
         file << std::setw(0) << "Track: " << track->name() << "\n";
-        auto processors = track->process_chain();
         for (auto& p : processors)
         {
             file << std::setw(8) << "" << std::setw(16) << p->name();
@@ -1123,16 +1806,37 @@ void AudioEngine::print_timings_to_file(const std::string& filename)
 
 void AudioEngine::_route_cv_gate_ins(ControlBuffer& buffer)
 {
-    for (const auto& r : _cv_in_routes)
+    for (auto& r : _cv_in_routes)
     {
-        float value = buffer.cv_values[r.cv_id];
-        auto ev = RtEvent::make_parameter_change_event(r.processor_id, 0, r.parameter_id, value);
-        send_rt_event(ev);
+        const float* signal = buffer.cv_signals.channel(r.cv_id);
+        if (r.audio_rate)
+        {
+            auto processor = _realtime_processors[r.processor_id];
+            if (processor)
+            {
+                processor->set_cv_signal(r.parameter_id, signal);
+            }
+            continue;
+        }
+        /* Processors without audio rate cv support only get an event when the value changes */
+        float value = signal[buffer.cv_signals.frame_count() - 1];
+        if (std::abs(value - r.last_value) >= CV_CHANGE_THRESHOLD)
+        {
+            auto ev = RtEvent::make_parameter_change_event(r.processor_id, 0, r.parameter_id, value);
+            send_rt_event(ev);
+            r.last_value = value;
+        }
     }
     // Get gate state changes by xor:ing with previous states
     auto gate_diffs = _prev_gate_values ^ buffer.gate_values;
     if (gate_diffs.any())
     {
+        if (_sync_gate_in.gate_id >= 0 && gate_diffs[_sync_gate_in.gate_id] && buffer.gate_values[_sync_gate_in.gate_id])
+        {
+            auto ev = RtEvent::make_sync_clock_event(0, SyncMode::GATE_INPUT, SyncClockRtEvent::ClockType::TICK,
+                                                     _sync_gate_in.ppq_ticks);
+            send_rt_event(ev);
+        }
         for (const auto& r : _gate_in_routes)
         {
             if (gate_diffs[r.gate_id])
@@ -1154,6 +1858,21 @@ void AudioEngine::_route_cv_gate_ins(ControlBuffer& buffer)
     _prev_gate_values = buffer.gate_values;
 }
 
+void AudioEngine::_output_sync_gates(ControlBuffer& buffer)
+{
+    for (const auto& r : _sync_gate_out_routes)
+    {
+        /* Pulses are high during the first half of every tick */
+        bool gate_high = false;
+        if (_transport.playing())
+        {
+            double ticks = _transport.current_beats() * r.ppq_ticks;
+            gate_high = ticks - std::floor(ticks) < 0.5;
+        }
+        buffer.gate_values[r.gate_id] = gate_high;
+    }
+}
+
 void AudioEngine::_process_outgoing_events(ControlBuffer& buffer, RtSafeRtEventFifo& source_queue)
 {
     RtEvent event;
@@ -1176,6 +1895,10 @@ void AudioEngine::_process_outgoing_events(ControlBuffer& buffer, RtSafeRtEventF
             }
 
             default:
+                if (is_keyboard_event(event))
+                {
+                    buffer.midi_events.push(event);
+                }
                 _main_out_queue.push(event);
         }
     }
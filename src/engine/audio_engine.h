@@ -23,9 +23,12 @@
 
 #include <memory>
 #include <map>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <mutex>
+#include <atomic>
 
 #include "twine/twine.h"
 
@@ -36,6 +39,7 @@
 #include "engine/transport.h"
 #include "engine/host_control.h"
 #include "engine/controller.h"
+#include "engine/session_snapshot.h"
 #include "library/time.h"
 #include "library/sample_buffer.h"
 #include "library/elk_allocator.h"
@@ -44,6 +48,7 @@
 #include "library/rt_event_fifo.h"
 #include "library/types.h"
 #include "library/performance_timer.h"
+#include "dsp_library/level_analysis.h"
 
 namespace sushi {
 namespace engine {
@@ -62,12 +67,12 @@ public:
 
     void set_output_channels(int channels);
     /**
-     * @brief Find clipped samples in a buffer and send notifications
-     * @param buffer The audio buffer to process
+     * @brief Find clipped samples in an analysed buffer and send notifications
+     * @param levels Level analysis of the audio buffer, one entry per channel
      * @param queue Endpoint for clipping notifications
      * @param audio_input Set to true if the audio buffer comes directly from the an audio inout (i.e. before any processing)
      */
-    void detect_clipped_samples(const ChunkSampleBuffer& buffer, RtSafeRtEventFifo& queue, bool audio_input);
+    void detect_clipped_samples(const std::vector<dsp::LevelAnalysis>& levels, RtSafeRtEventFifo& queue, bool audio_input);
 
 private:
 
@@ -76,9 +81,230 @@ private:
     std::vector<unsigned int> _output_clip_count;
 };
 
+/**
+ * @brief Level meter for the engine inputs or outputs with instant attack and slow
+ *        release of the peak value and smoothed rms and dc offset values. Updated
+ *        from the audio thread and safe to read from any thread.
+ */
+class LevelMeter
+{
+public:
+    LevelMeter(float sample_rate)
+    {
+        this->set_sample_rate(sample_rate);
+    }
+
+    void set_sample_rate(float sample_rate);
+
+    /**
+     * @brief Set the number of metered channels, not safe to call while audio is running.
+     * @param channels The number of channels
+     */
+    void set_channels(int channels);
+
+    /**
+     * @brief Update the meter with the levels of a new chunk. Called from the audio thread.
+     * @param levels Level analysis of the audio buffer, one entry per channel
+     */
+    void update(const std::vector<dsp::LevelAnalysis>& levels);
+
+    /**
+     * @brief Get the current levels of all channels. Values are linear, not in dB.
+     * @return One AudioLevel per metered channel
+     */
+    std::vector<ext::AudioLevel> levels() const;
+
+private:
+    struct ChannelLevel
+    {
+        std::atomic<float> peak{0.0f};
+        std::atomic<float> mean_square{0.0f};
+        std::atomic<float> dc_offset{0.0f};
+    };
+
+    std::unique_ptr<ChannelLevel[]> _levels;
+    int _channels{0};
+    float _peak_decay;
+    float _smoothing_coef;
+};
+
+/**
+ * @brief Synchronisation between the audio thread and the track workers that lets the
+ *        workers render several consecutive chunks per worker pool wakeup. The audio
+ *        thread publishes every chunk once its events and inputs are in place and then
+ *        waits for all workers to render it. Both sides spin on atomic counters for a
+ *        short while and then sleep on a futex, so a waiting thread never keeps a worker
+ *        sharing its cpu core from running. Only used for periods of more than one chunk,
+ *        single chunks are rendered with a plain worker pool wakeup.
+ */
+class ChunkSync
+{
+public:
+    /**
+     * @brief Prepare for a new period, called from the audio thread before the workers
+     *        are woken up.
+     * @param chunks The number of chunks the workers should render before returning
+     * @param workers The number of workers that will render
+     */
+    void start(int chunks, int workers)
+    {
+        _chunks = chunks;
+        _workers = workers;
+        _published.store(0, std::memory_order_relaxed);
+        _rendered.store(0, std::memory_order_relaxed);
+        _finished.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief End the period, after which workers render a single chunk per wakeup.
+     *        Called from the audio thread when all workers are idle.
+     */
+    void reset()
+    {
+        _chunks = 0;
+    }
+
+    /**
+     * @brief Let the workers render the next chunk. Called from the audio thread.
+     */
+    void publish_chunk()
+    {
+        _published.fetch_add(1, std::memory_order_release);
+        _sequence.fetch_add(1);
+        _wake(_sequence, _sequence_sleepers);
+    }
+
+    /**
+     * @brief Wait for all workers to render the last published chunk. Called from the audio thread.
+     */
+    void wait_for_rendered_chunk()
+    {
+        int target = _workers * _published.load(std::memory_order_relaxed);
+        _wait(_rendered, _rendered_sleepers, [&]() {return _rendered.load(std::memory_order_acquire) >= target;});
+    }
+
+    /**
+     * @brief Release workers waiting for chunks that will not be published. Called from
+     *        the audio thread at the end of the period.
+     */
+    void finish()
+    {
+        _finished.store(true, std::memory_order_release);
+        _sequence.fetch_add(1);
+        _wake(_sequence, _sequence_sleepers);
+    }
+
+    /**
+     * @return The number of chunks in the current period, or 0 if no multi chunk period
+     *         is in progress.
+     */
+    int chunks() const {return _chunks;}
+
+    int workers() const {return _workers;}
+
+    /**
+     * @brief Wait until a chunk is published. Called from the worker threads.
+     * @param chunk The index of the chunk in the current period
+     * @return true if the chunk should be rendered, false if the period ended before
+     *         the chunk was published.
+     */
+    bool wait_for_chunk(int chunk)
+    {
+        _wait(_sequence, _sequence_sleepers, [&]() {return _published.load(std::memory_order_acquire) > chunk ||
+                                                           _finished.load(std::memory_order_acquire);});
+        return _published.load(std::memory_order_acquire) > chunk;
+    }
+
+    /**
+     * @brief Signal that a worker has rendered the current chunk. Called from the worker threads.
+     */
+    void notify_rendered()
+    {
+        _rendered.fetch_add(1, std::memory_order_release);
+        _wake(_rendered, _rendered_sleepers);
+    }
+
+private:
+    /* Spin for a bounded time as the wait is normally short, then sleep until the futex
+     * word changes. Every change of the state a waiter depends on also changes the word */
+    template <typename Predicate>
+    static void _wait(std::atomic<int>& word, std::atomic<int>& sleepers, Predicate&& condition)
+    {
+        constexpr int SPINS_BEFORE_SLEEP = 1000;
+        for (int spins = 0; spins < SPINS_BEFORE_SLEEP; ++spins)
+        {
+            if (condition())
+            {
+                return;
+            }
+        }
+        while (true)
+        {
+            int value = word.load();
+            if (condition())
+            {
+                return;
+            }
+            sleepers.fetch_add(1);
+            _futex_wait(word, value);
+            sleepers.fetch_sub(1);
+        }
+    }
+
+    /* The sleeper count lets the waking side skip the system call when nobody sleeps */
+    static void _wake(std::atomic<int>& word, std::atomic<int>& sleepers)
+    {
+        if (sleepers.load() > 0)
+        {
+            _futex_wake(word);
+        }
+    }
+
+    static void _futex_wait(std::atomic<int>& word, int value);
+
+    static void _futex_wake(std::atomic<int>& word);
+
+    int _chunks{0};
+    int _workers{0};
+    std::atomic<int> _published{0};
+    std::atomic<int> _rendered{0};
+    std::atomic<bool> _finished{false};
+    /* Futex word for the workers, incremented on every publish and finish */
+    std::atomic<int> _sequence{0};
+    std::atomic<int> _sequence_sleepers{0};
+    std::atomic<int> _rendered_sleepers{0};
+};
 
 constexpr int MAX_RT_PROCESSOR_ID = 1000;
 
+struct AudioConnection
+{
+    int engine_channel;
+    int track_channel;
+    ObjectId track;
+};
+
+/**
+ * @brief Changes from a session restore that are applied by the audio thread in a single
+ *        chunk. The connection lists replace those of the engine and the replaced lists
+ *        are returned in the same object, so nothing is allocated or freed in the rt thread.
+ *        If the audio thread does not acknowledge an update in time, the update is retired
+ *        and destroyed from the worker thread once committed is set.
+ */
+struct RtSessionUpdate
+{
+    struct ParameterUpdate
+    {
+        ObjectId processor;
+        ObjectId parameter;
+        float value;
+    };
+    std::vector<ParameterUpdate> parameters;
+    std::vector<AudioConnection> in_connections;
+    std::vector<AudioConnection> out_connections;
+    std::atomic<bool> committed{false};
+};
+
 class AudioEngine : public BaseEngine
 {
 public:
@@ -291,6 +517,21 @@ public:
                        Time timestamp,
                        int64_t samplecount) override;
 
+    /**
+     * @brief Signal that the following calls to process_chunk() belong to the same audio
+     *        period. In multicore mode the track workers are then woken up only once and
+     *        render all chunks of the period, synchronising with the audio thread through
+     *        busy waiting, which is cheaper than a worker pool wakeup for every chunk.
+     *        Must be followed by exactly chunks calls to process_chunk() and end_period().
+     * @param chunks The number of chunks in the period
+     */
+    void begin_period(int chunks) override;
+
+    /**
+     * @brief End a period started with begin_period()
+     */
+    void end_period() override;
+
     /**
      * @brief Inform the engine of the current system latency
      * @param latency The output latency of the audio system
@@ -346,7 +587,7 @@ public:
      * @param unique_name The unique name of a processor
      * @return the unique id of the processor, only valid if status is EngineReturnStatus::OK
      */
-    std::pair<EngineReturnStatus, ObjectId> processor_id_from_name(const std::string& name) override;
+    std::pair<EngineReturnStatus, ObjectId> processor_id_from_name(std::string_view name) override;
 
     /**
      * @brief Get the unique (per processor) id of a parameter.
@@ -354,8 +595,8 @@ public:
      * @param The unique name of a parameter of the above processor
      * @return the unique id of the parameter, only valid if status is EngineReturnStatus::OK
      */
-    std::pair<EngineReturnStatus, ObjectId> parameter_id_from_name(const std::string& /*processor_name*/,
-                                                                   const std::string& /*parameter_name*/);
+    std::pair<EngineReturnStatus, ObjectId> parameter_id_from_name(std::string_view processor_name,
+                                                                   std::string_view parameter_name) override;
 
     /**
      * @brief Get the unique name of a processor of a known unique id
@@ -370,7 +611,7 @@ public:
      * @param id The unique id of the parameter to lookup.
      * @return The name of the processor, only valid if status is EngineReturnStatus::OK
      */
-    std::pair<EngineReturnStatus, const std::string> parameter_name_from_id(const std::string& processor_name,
+    std::pair<EngineReturnStatus, const std::string> parameter_name_from_id(std::string_view processor_name,
                                                                             const ObjectId id) override;
     /**
      * @brief Create an empty track
@@ -419,6 +660,24 @@ public:
     EngineReturnStatus remove_plugin_from_track(const std::string &track_name,
                                                 const std::string &plugin_name) override;
 
+    /**
+     * @brief Save the tracks, plugins, audio connections and the bypass, program and
+     *        parameter state of all processors.
+     * @return EngineReturnStatus::OK and a binary blob that can be passed to restore_session()
+     */
+    std::pair<EngineReturnStatus, std::vector<uint8_t>> save_session() override;
+
+    /**
+     * @brief Restore a session saved with save_session(). Only what differs from the
+     *        current state is changed. Processors with the same name and plugin as in the
+     *        saved session are kept and moved into place instead of being re-created, and
+     *        all parameter changes and audio connections are applied in the same chunk.
+     *        Not to be called concurrently with other graph edits.
+     * @param session A binary blob from save_session()
+     * @return EngineReturnStatus::OK in case of success, different error code otherwise
+     */
+    EngineReturnStatus restore_session(const std::vector<uint8_t>& session) override;
+
     /**
      * @brief Access a particular processor by its unique id for querying
      * @param processor_id The id of the processor
@@ -435,19 +694,18 @@ public:
     Processor* mutable_processor(ObjectId processor_id) override;
 
     /**
-     * @brief Return all processors. Potentially dangerous so use with care and eventually
-     *        there should be better and safer ways of accessing processors.
+     * @brief Return all processors. Not safe to use while the graph can be edited from
+     *        another thread, use graph_snapshot() for queries from outside the engine.
      * @return An std::map containing all registered processors.
      */
-    const std::map<std::string, std::unique_ptr<Processor>>& all_processors() override
+    const std::unordered_map<std::string, std::shared_ptr<Processor>>& all_processors() override
     {
         return _processors;
     };
 
     /**
-     * @brief Return all tracks. Potentially unsafe so use with care. Should
-     *        eventually be replaces with a better way of accessing tracks/processors
-     *        from outside the engine.
+     * @brief Return all tracks. Not safe to use while the graph can be edited from
+     *        another thread, use graph_snapshot() for queries from outside the engine.
      * @return An std::vector of containing all Tracks
      */
     const std::vector<Track*>& all_tracks() override
@@ -455,6 +713,31 @@ public:
         return _audio_graph;
     }
 
+    /**
+     * @brief Get the latest snapshot of the tracks and processors in the engine.
+     *        Safe to call from any non-rt thread, also while the graph is being edited.
+     *        Queries never wait for a graph edit to finish, but loading the snapshot is
+     *        not lock-free: the C++17 std::atomic_load overload for shared_ptr locks a
+     *        mutex from a global pool in libstdc++. With C++20 std::atomic<shared_ptr>
+     *        is used instead. In both cases it must not be called from the rt thread.
+     * @return A snapshot that is never modified, later edits publish new snapshots.
+     */
+    std::shared_ptr<const GraphSnapshot> graph_snapshot() override
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return _graph_snapshot.load(std::memory_order_acquire);
+#else
+        return std::atomic_load(&_graph_snapshot);
+#endif
+    }
+
+    /**
+     * @brief Destroy the snapshots replaced by graph edits that no other thread holds on
+     *        to anymore, together with any removed processors only they referenced, and
+     *        session updates the audio thread has committed after they timed out.
+     */
+    void release_retired_graph_snapshots() override;
+
     /**
      * @brief Enable audio clip detection on engine inputs
      * @param enabled Enable if true, disable if false
@@ -473,6 +756,24 @@ public:
         _output_clip_detection_enabled = enabled;
     }
 
+    /**
+     * @brief Get the current levels of the engine audio inputs
+     * @return One AudioLevel per input channel
+     */
+    std::vector<ext::AudioLevel> audio_input_levels() const override
+    {
+        return _input_meter.levels();
+    }
+
+    /**
+     * @brief Get the current levels of the engine audio outputs
+     * @return One AudioLevel per output channel
+     */
+    std::vector<ext::AudioLevel> audio_output_levels() const override
+    {
+        return _output_meter.levels();
+    }
+
     sushi::dispatcher::BaseEventDispatcher* event_dispatcher() override
     {
         return &_event_dispatcher;
@@ -498,9 +799,16 @@ public:
      */
     void print_timings_to_log() override;
 
+    uint64_t rt_queue_overflows() const override
+    {
+        return _internal_control_queue.failed_pushes() + _main_in_queue.failed_pushes() +
+               _processor_out_queue.failed_pushes() + _main_out_queue.failed_pushes() +
+               _control_queue_out.failed_pushes();
+    }
+
 private:
     /**
-     * @brief Instantiate a plugin instance of a given type
+     * @brief Instantiate an internal plugin from the InternalPluginRegistry
      * @param uid String unique id
      * @return Pointer to plugin instance if uid is valid, nullptr otherwise
      */
@@ -542,6 +850,65 @@ private:
      */
     EngineReturnStatus _register_new_track(const std::string& name, Track* track);
 
+    /**
+     * @brief Add an already registered processor to the end of a track
+     * @param processor The processor to add
+     * @param track The track to add it to
+     * @return OK if successful, error code otherwise
+     */
+    EngineReturnStatus _attach_processor(Processor* processor, Track* track);
+
+    /**
+     * @brief Remove a processor from a track without deleting it
+     * @param processor The processor to remove
+     * @param track The track to remove it from
+     * @return OK if successful, error code otherwise
+     */
+    EngineReturnStatus _detach_processor(Processor* processor, Track* track);
+
+    /**
+     * @brief Check that a session can be restored on top of the current engine state
+     *        before anything is changed: names must be unique, track layouts and audio
+     *        connections valid, and no processor outside of the tracks may block the
+     *        name of a session track or processor.
+     * @param session The session to check
+     * @return OK if the session can be restored, error code otherwise
+     */
+    EngineReturnStatus _validate_session(const SessionSnapshot& session) const;
+
+    /**
+     * @brief Look up a track by name
+     * @param name The name of the track
+     * @return A pointer to the track or nullptr if there is no track with that name
+     */
+    Track* _track_from_name(const std::string& name) const;
+
+    /**
+     * @brief Apply the changes from a session restore, from the rt thread if running
+     * @param update The changes to apply, holds the replaced connections on return
+     * @return true if the changes were applied
+     */
+    bool _apply_session_update(RtSessionUpdate* update);
+
+    /**
+     * @brief Swap in the audio connections and apply the parameter changes of a
+     *        session update, rt safe.
+     * @param update The changes to apply
+     */
+    void _commit_session_update(RtSessionUpdate* update);
+
+    /**
+     * @brief Keep a session update the audio thread did not acknowledge in time until
+     *        it has been committed, then it is destroyed from the worker thread.
+     */
+    void _retire_session_update(std::unique_ptr<RtSessionUpdate> update);
+
+    /**
+     * @brief Build a new snapshot of the current tracks and processors and make it
+     *        the one returned from graph_snapshot(). Call after every graph edit.
+     */
+    void _publish_graph_snapshot();
+
     /**
      * @brief Checks whether a processor exists in the engine.
      * @param processor_name The unique name of the processor.
@@ -574,6 +941,8 @@ private:
 
     void _route_cv_gate_ins(ControlBuffer& buffer);
 
+    void _output_sync_gates(ControlBuffer& buffer);
+
     void _process_outgoing_events(ControlBuffer& buffer, RtSafeRtEventFifo& source_queue);
 
     const bool _multicore_processing;
@@ -581,21 +950,47 @@ private:
 
     std::unique_ptr<twine::WorkerPool> _worker_pool;
 
+    struct TrackWorker
+    {
+        Track* track;
+        ChunkSync* sync;
+        int index;
+    };
+    static void _track_worker_function(void* arg);
+
+    std::vector<std::unique_ptr<TrackWorker>> _track_workers;
+    std::atomic<int> _track_worker_count{0};
+    ChunkSync _chunk_sync;
+    bool _multi_chunk_period{false};
+
     std::vector<Track*> _audio_graph;
 
     // All registered processors indexed by their unique name
-    std::map<std::string, std::unique_ptr<Processor>> _processors;
+    std::unordered_map<std::string, std::shared_ptr<Processor>> _processors;
+
+    // Latest published graph snapshot. Without std::atomic<shared_ptr> (C++20) it must
+    // only be accessed with std::atomic_load/exchange, which are mutex based
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const GraphSnapshot>> _graph_snapshot{std::make_shared<const GraphSnapshot>()};
+#else
+    std::shared_ptr<const GraphSnapshot> _graph_snapshot{std::make_shared<const GraphSnapshot>()};
+#endif
+
+    // Snapshots replaced by later ones, kept until released from the worker thread
+    std::vector<std::shared_ptr<const GraphSnapshot>> _retired_graph_snapshots;
+    std::mutex _retired_graph_snapshots_lock;
+
+    // Session updates that timed out, kept until committed by the rt thread
+    std::vector<std::unique_ptr<RtSessionUpdate>> _retired_session_updates;
+    std::mutex _retired_session_updates_lock;
 
     // Processors in the realtime part indexed by their unique 32 bit id
     // Only to be accessed from the process callback in rt mode.
     std::vector<Processor*> _realtime_processors{MAX_RT_PROCESSOR_ID, nullptr};
 
-    struct AudioConnection
-    {
-        int engine_channel;
-        int track_channel;
-        ObjectId track;
-    };
+    // What every plugin was created from, indexed by the plugin's unique name
+    std::unordered_map<std::string, PluginInfo> _plugin_info;
+
     std::vector<AudioConnection> _in_audio_connections;
     std::vector<AudioConnection> _out_audio_connections;
 
@@ -604,6 +999,8 @@ private:
         ObjectId processor_id;
         ObjectId parameter_id;
         int cv_id;
+        bool audio_rate;
+        float last_value;
     };
 
     struct GateConnection
@@ -614,8 +1011,16 @@ private:
         int channel;
     };
 
+    struct SyncGateConnection
+    {
+        int gate_id{-1};
+        int ppq_ticks{0};
+    };
+
     std::vector<CvConnection> _cv_in_routes;
     std::vector<GateConnection> _gate_in_routes;
+    SyncGateConnection _sync_gate_in;
+    std::vector<SyncGateConnection> _sync_gate_out_routes;
     BitSet32 _prev_gate_values{0};
     BitSet32 _outgoing_gate_values{0};
 
@@ -629,8 +1034,9 @@ private:
     std::mutex _in_queue_lock;
     receiver::AsynchronousEventReceiver _event_receiver{&_control_queue_out};
     Transport _transport;
+    ParameterNotificationArea _parameter_notifications;
 
-    dispatcher::EventDispatcher _event_dispatcher{this, &_main_out_queue, &_main_in_queue};
+    dispatcher::EventDispatcher _event_dispatcher{this, &_main_out_queue, &_main_in_queue, &_parameter_notifications};
     Controller _controller{this};
 
     HostControl _host_control{&_event_dispatcher, &_transport};
@@ -640,6 +1046,12 @@ private:
     bool _input_clip_detection_enabled{false};
     bool _output_clip_detection_enabled{false};
     ClipDetector _clip_detector;
+
+    /* Analysed once per chunk and shared by clip detection and metering */
+    std::vector<dsp::LevelAnalysis> _input_levels;
+    std::vector<dsp::LevelAnalysis> _output_levels;
+    LevelMeter _input_meter;
+    LevelMeter _output_meter;
 };
 
 /**
@@ -23,6 +23,8 @@
 
 #include <memory>
 #include <map>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <bitset>
@@ -31,10 +33,12 @@
 #include "library/constants.h"
 #include "base_event_dispatcher.h"
 #include "engine/track.h"
+#include "engine/graph_snapshot.h"
 #include "library/base_performance_timer.h"
 #include "library/time.h"
 #include "library/sample_buffer.h"
 #include "library/types.h"
+#include "library/rt_event_fifo.h"
 #include "control_interface.h"
 
 namespace sushi {
@@ -44,10 +48,15 @@ using BitSet32 = std::bitset<std::numeric_limits<uint32_t>::digits>;
 
 struct ControlBuffer
 {
-    ControlBuffer() : cv_values{0}, gate_values{0} {}
+    ControlBuffer() : cv_values{0}, cv_signals(MAX_ENGINE_CV_IO_PORTS), gate_values{0} {}
 
+    /* One value per cv port and chunk, used for cv outputs */
     std::array<float, MAX_ENGINE_CV_IO_PORTS> cv_values;
+    /* Audio rate signals in cv range [0, 1], one channel per cv port, used for cv inputs */
+    ChunkSampleBuffer cv_signals;
     BitSet32 gate_values;
+    /* Outgoing keyboard events from the current chunk, for frontends with sample accurate midi outputs */
+    RtEventFifo<MAX_ENGINE_MIDI_EVENTS> midi_events;
 };
 
 enum class EngineReturnStatus
@@ -216,6 +225,10 @@ public:
                                Time timestamp,
                                int64_t samplecount) = 0;
 
+    virtual void begin_period(int /*chunks*/) {}
+
+    virtual void end_period() {}
+
     virtual void set_output_latency(Time /*latency*/) = 0;
 
     virtual void set_tempo(float /*tempo*/) = 0;
@@ -230,13 +243,13 @@ public:
 
     virtual EngineReturnStatus send_async_event(RtEvent& event) = 0;
 
-    virtual std::pair<EngineReturnStatus, ObjectId> processor_id_from_name(const std::string& /*name*/)
+    virtual std::pair<EngineReturnStatus, ObjectId> processor_id_from_name(std::string_view /*name*/)
     {
         return std::make_pair(EngineReturnStatus::OK, 0);
     };
 
-    virtual std::pair<EngineReturnStatus, ObjectId> parameter_id_from_name(const std::string& /*processor_name*/,
-                                                                           const std::string& /*parameter_name*/)
+    virtual std::pair<EngineReturnStatus, ObjectId> parameter_id_from_name(std::string_view /*processor_name*/,
+                                                                           std::string_view /*parameter_name*/)
     {
         return std::make_pair(EngineReturnStatus::OK, 0);
     };
@@ -246,7 +259,7 @@ public:
         return std::make_pair(EngineReturnStatus::OK, "");
     };
 
-    virtual std::pair<EngineReturnStatus, const std::string> parameter_name_from_id(const std::string& /*processor_name*/,
+    virtual std::pair<EngineReturnStatus, const std::string> parameter_name_from_id(std::string_view /*processor_name*/,
                                                                                     const ObjectId /*id*/)
     {
         return std::make_pair(EngineReturnStatus::OK, "");
@@ -282,13 +295,23 @@ public:
         return EngineReturnStatus::OK;
     }
 
+    virtual std::pair<EngineReturnStatus, std::vector<uint8_t>> save_session()
+    {
+        return {EngineReturnStatus::OK, std::vector<uint8_t>()};
+    }
+
+    virtual EngineReturnStatus restore_session(const std::vector<uint8_t>& /*session*/)
+    {
+        return EngineReturnStatus::OK;
+    }
+
     virtual const Processor* processor(ObjectId /*processor_id*/) const {return nullptr;}
 
     virtual Processor* mutable_processor(ObjectId /*processor_id*/) {return nullptr;}
 
-    virtual const std::map<std::string, std::unique_ptr<Processor>>& all_processors()
+    virtual const std::unordered_map<std::string, std::shared_ptr<Processor>>& all_processors()
     {
-        static std::map<std::string, std::unique_ptr<Processor>> tmp;
+        static std::unordered_map<std::string, std::shared_ptr<Processor>> tmp;
         return tmp;
     }
 
@@ -298,6 +321,11 @@ public:
         return tmp;
     }
 
+    virtual std::shared_ptr<const GraphSnapshot> graph_snapshot()
+    {
+        return std::make_shared<const GraphSnapshot>();
+    }
+
     virtual dispatcher::BaseEventDispatcher* event_dispatcher()
     {
         return nullptr;
@@ -322,8 +350,26 @@ public:
 
     virtual void enable_output_clip_detection(bool /*enabled*/) {}
 
+    virtual std::vector<ext::AudioLevel> audio_input_levels() const {return {};}
+
+    virtual std::vector<ext::AudioLevel> audio_output_levels() const {return {};}
+
     virtual void print_timings_to_log() {}
 
+    /**
+     * @brief Destroy any state retired by graph edits that is no longer referenced from
+     *        another thread. Called periodically from the non-rt worker thread so that
+     *        removed processors are not destroyed on a random control thread.
+     */
+    virtual void release_retired_graph_snapshots() {}
+
+    /**
+     * @brief The number of events that didn't fit in the queues between the rt and the
+     *        non-rt parts of the engine. Events to the rt part are retried later, events
+     *        from it are lost.
+     */
+    virtual uint64_t rt_queue_overflows() const {return 0;}
+
 protected:
     float _sample_rate;
     int _audio_inputs{0};
@@ -59,6 +59,21 @@ public:
 
     virtual void set_sample_rate(float /*sample_rate*/) {}
     virtual void set_time(Time /*timestamp*/) {}
+
+    /**
+     * @brief In synchronous mode, events are not processed by the event thread but only
+     *        when process_pending_events() is called, which makes event delivery
+     *        independent of thread scheduling. Engine events, like graph changes, are
+     *        executed in the same call. Used for deterministic offline processing, where
+     *        the engine is not in realtime mode.
+     * @param enabled If true, the event thread is stopped, if false it is restarted.
+     */
+    virtual void set_synchronous_mode(bool /*enabled*/) {}
+
+    /**
+     * @brief Process all pending events in the calling thread. Only used in synchronous mode.
+     */
+    virtual void process_pending_events() {}
 };
 
 
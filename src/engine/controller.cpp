@@ -189,9 +189,9 @@ void Controller::set_timing_statistics_enabled(bool enabled)
 std::vector<ext::TrackInfo> Controller::get_tracks() const
 {
     SUSHI_LOG_DEBUG("get_tracks called");
-    auto& tracks = _engine->all_tracks();
+    auto snapshot = _engine->graph_snapshot();
     std::vector<ext::TrackInfo> returns;
-    for (const auto& t : tracks)
+    for (const auto& [t, processors] : snapshot->tracks())
     {
         ext::TrackInfo info;
         info.id = t->id();
@@ -201,7 +201,7 @@ std::vector<ext::TrackInfo> Controller::get_tracks() const
         info.input_channels = t->input_channels();
         info.output_busses = t->output_busses();
         info.output_channels = t->output_channels();
-        info.processor_count = static_cast<int>(t->process_chain().size());
+        info.processor_count = static_cast<int>(processors.size());
         returns.push_back(info);
     }
     return returns;
@@ -297,6 +297,18 @@ ext::ControlStatus Controller::reset_processor_timings(int processor_id)
     return reset_track_timings(processor_id);
 }
 
+std::pair<ext::ControlStatus, std::vector<ext::AudioLevel>> Controller::get_engine_input_levels() const
+{
+    SUSHI_LOG_DEBUG("get_engine_input_levels called");
+    return {ext::ControlStatus::OK, _engine->audio_input_levels()};
+}
+
+std::pair<ext::ControlStatus, std::vector<ext::AudioLevel>> Controller::get_engine_output_levels() const
+{
+    SUSHI_LOG_DEBUG("get_engine_output_levels called");
+    return {ext::ControlStatus::OK, _engine->audio_output_levels()};
+}
+
 std::pair<ext::ControlStatus, int> Controller::get_track_id(const std::string& track_name) const
 {
     SUSHI_LOG_DEBUG("get_track_id called with track {}", track_name);
@@ -307,77 +319,71 @@ std::pair<ext::ControlStatus, ext::TrackInfo> Controller::get_track_info(int tra
 {
     SUSHI_LOG_DEBUG("get_track_info called with track {}", track_id);
     ext::TrackInfo info;
-    const auto& tracks = _engine->all_tracks();
-    for (const auto& track : tracks)
+    auto snapshot = _engine->graph_snapshot();
+    auto node = snapshot->track(static_cast<ObjectId>(track_id));
+    if (node == nullptr)
     {
-        if (static_cast<int>(track->id()) == track_id)
-        {
-            info.label = track->label();
-            info.name = track->name();
-            info.id = track->id();
-            info.input_channels = track->input_channels();
-            info.input_busses = track->input_busses();
-            info.output_channels = track->output_channels();
-            info.output_busses = track->output_busses();
-            info.processor_count = static_cast<int>(track->process_chain().size());
-            return {ext::ControlStatus::OK, info};
-        }
+        return {ext::ControlStatus::NOT_FOUND, info};
     }
-    return {ext::ControlStatus::NOT_FOUND, info};
+    const auto& track = node->track;
+    info.label = track->label();
+    info.name = track->name();
+    info.id = track->id();
+    info.input_channels = track->input_channels();
+    info.input_busses = track->input_busses();
+    info.output_channels = track->output_channels();
+    info.output_busses = track->output_busses();
+    info.processor_count = static_cast<int>(node->processors.size());
+    return {ext::ControlStatus::OK, info};
 }
 
 std::pair<ext::ControlStatus, std::vector<ext::ProcessorInfo>> Controller::get_track_processors(int track_id) const
 {
     SUSHI_LOG_DEBUG("get_track_processors called for track: {}", track_id);
-    const auto& tracks = _engine->all_tracks();
-    for (const auto& track : tracks)
+    auto snapshot = _engine->graph_snapshot();
+    auto node = snapshot->track(static_cast<ObjectId>(track_id));
+    if (node == nullptr)
     {
-        if (static_cast<int>(track->id()) == track_id)
-        {
-            std::vector<ext::ProcessorInfo> infos;
-            const auto& procs = track->process_chain();
-            for (const auto& processor : procs)
-            {
-                ext::ProcessorInfo info;
-                info.label = processor->label();
-                info.name = processor->name();
-                info.id = processor->id();
-                info.parameter_count = processor->parameter_count();
-                info.program_count = processor->supports_programs()? processor->program_count() : 0;
-                infos.push_back(info);
-            }
-            return {ext::ControlStatus::OK, infos};
-        }
+        return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ProcessorInfo>()};
+    }
+    std::vector<ext::ProcessorInfo> infos;
+    for (const auto& processor : node->processors)
+    {
+        ext::ProcessorInfo info;
+        info.label = processor->label();
+        info.name = processor->name();
+        info.id = processor->id();
+        info.parameter_count = processor->parameter_count();
+        info.program_count = processor->supports_programs()? processor->program_count() : 0;
+        infos.push_back(info);
     }
-    return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ProcessorInfo>()};
+    return {ext::ControlStatus::OK, infos};
 }
 
 std::pair<ext::ControlStatus, std::vector<ext::ParameterInfo>> Controller::get_track_parameters(int track_id) const
 {
     SUSHI_LOG_DEBUG("get_track_parameters called for track: {}", track_id);
-    const auto& tracks = _engine->all_tracks();
-    for (const auto& track : tracks)
+    auto snapshot = _engine->graph_snapshot();
+    auto node = snapshot->track(static_cast<ObjectId>(track_id));
+    if (node == nullptr)
     {
-        if (static_cast<int>(track->id()) == track_id)
-        {
-            std::vector<ext::ParameterInfo> infos;
-            const auto& params = track->all_parameters();
-            for (const auto& param : params)
-            {
-                ext::ParameterInfo info;
-                info.label = param->label();
-                info.name = param->name();
-                info.unit = param->unit();
-                info.id = param->id();
-                info.type = ext::ParameterType::FLOAT;
-                info.min_domain_value = param->min_domain_value();
-                info.max_domain_value = param->max_domain_value();
-                infos.push_back(info);
-            }
-            return {ext::ControlStatus::OK, infos};
-        }
+        return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ParameterInfo>()};
     }
-    return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ParameterInfo>()};
+    std::vector<ext::ParameterInfo> infos;
+    const auto& params = node->track->all_parameters();
+    for (const auto& param : params)
+    {
+        ext::ParameterInfo info;
+        info.label = param->label();
+        info.name = param->name();
+        info.unit = param->unit();
+        info.id = param->id();
+        info.type = ext::ParameterType::FLOAT;
+        info.min_domain_value = param->min_domain_value();
+        info.max_domain_value = param->max_domain_value();
+        infos.push_back(info);
+    }
+    return {ext::ControlStatus::OK, infos};
 }
 
 std::pair<ext::ControlStatus, int> Controller::get_processor_id(const std::string& processor_name) const
@@ -395,7 +401,7 @@ std::pair<ext::ControlStatus, ext::ProcessorInfo> Controller::get_processor_info
 {
     SUSHI_LOG_DEBUG("get_processor_info called with processor {}", processor_id);
     ext::ProcessorInfo info;
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, info};
@@ -411,7 +417,7 @@ std::pair<ext::ControlStatus, ext::ProcessorInfo> Controller::get_processor_info
 std::pair<ext::ControlStatus, bool> Controller::get_processor_bypass_state(int processor_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_bypass_state called with processor {}", processor_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, false};
@@ -422,7 +428,7 @@ std::pair<ext::ControlStatus, bool> Controller::get_processor_bypass_state(int p
 ext::ControlStatus Controller::set_processor_bypass_state(int processor_id, bool bypass_enabled)
 {
     SUSHI_LOG_DEBUG("set_processor_bypass_state called with {} and processor {}", bypass_enabled, processor_id);
-    auto processor = _engine->mutable_processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return ext::ControlStatus::NOT_FOUND;
@@ -434,7 +440,7 @@ ext::ControlStatus Controller::set_processor_bypass_state(int processor_id, bool
 std::pair<ext::ControlStatus, int> Controller::get_processor_current_program(int processor_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_current_program called with processor {}", processor_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, 0};
@@ -449,7 +455,7 @@ std::pair<ext::ControlStatus, int> Controller::get_processor_current_program(int
 std::pair<ext::ControlStatus, std::string> Controller::get_processor_current_program_name(int processor_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_current_program_name called with processor {}", processor_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, ""};
@@ -464,7 +470,7 @@ std::pair<ext::ControlStatus, std::string> Controller::get_processor_current_pro
 std::pair<ext::ControlStatus, std::string> Controller::get_processor_program_name(int processor_id, int program_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_program_name called with processor {}", processor_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, ""};
@@ -484,7 +490,7 @@ std::pair<ext::ControlStatus, std::string> Controller::get_processor_program_nam
 std::pair<ext::ControlStatus, std::vector<std::string>> Controller::get_processor_programs(int processor_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_program_name called with processor {}", processor_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, std::vector<std::string>()};
@@ -513,35 +519,33 @@ std::pair<ext::ControlStatus, std::vector<ext::ParameterInfo>>
 Controller::get_processor_parameters(int processor_id) const
 {
     SUSHI_LOG_DEBUG("get_processor_parameters called with processor {}", processor_id);
-    const auto& procs = _engine->all_processors();
-    for (const auto& proc : procs)
+    auto snapshot = _engine->graph_snapshot();
+    auto processor = snapshot->processor(static_cast<ObjectId>(processor_id));
+    if (processor == nullptr)
     {
-        if (static_cast<int>(proc.second->id()) == processor_id)
-        {
-            std::vector<ext::ParameterInfo> infos;
-            const auto& params = proc.second->all_parameters();
-            for (const auto& param : params)
-            {
-                ext::ParameterInfo info;
-                info.label = param->label();
-                info.name = param->name();
-                info.unit = param->unit();
-                info.id = param->id();
-                info.type = ext::ParameterType::FLOAT;
-                info.min_domain_value = param->min_domain_value();
-                info.max_domain_value = param->max_domain_value();
-                infos.push_back(info);
-            }
-            return {ext::ControlStatus::OK, infos};
-        }
+        return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ParameterInfo>()};
     }
-    return {ext::ControlStatus::NOT_FOUND, std::vector<ext::ParameterInfo>()};
+    std::vector<ext::ParameterInfo> infos;
+    const auto& params = processor->all_parameters();
+    for (const auto& param : params)
+    {
+        ext::ParameterInfo info;
+        info.label = param->label();
+        info.name = param->name();
+        info.unit = param->unit();
+        info.id = param->id();
+        info.type = ext::ParameterType::FLOAT;
+        info.min_domain_value = param->min_domain_value();
+        info.max_domain_value = param->max_domain_value();
+        infos.push_back(info);
+    }
+    return {ext::ControlStatus::OK, infos};
 }
 
 std::pair<ext::ControlStatus, int> Controller::get_parameter_id(int processor_id, const std::string& parameter_name) const
 {
     SUSHI_LOG_DEBUG("get_parameter_id called with processor {} and parameter {}", processor_id, parameter_name);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor == nullptr)
     {
         return {ext::ControlStatus::NOT_FOUND, 0};
@@ -558,24 +562,21 @@ std::pair<ext::ControlStatus, ext::ParameterInfo> Controller::get_parameter_info
 {
     SUSHI_LOG_DEBUG("get_parameter_info called with processor {} and parameter {}", processor_id, parameter_id);
     ext::ParameterInfo info;
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
-    if (processor != nullptr)
+    auto snapshot = _engine->graph_snapshot();
+    auto descr = snapshot->parameter(static_cast<ObjectId>(processor_id), static_cast<ObjectId>(parameter_id));
+    if (descr != nullptr)
     {
-        auto descr = processor->parameter_from_id(static_cast<ObjectId>(parameter_id));
-        if (descr != nullptr)
-        {
-            info.id = descr->id();
-            info.label = descr->label();
-            info.name = descr->name();
-            info.unit = descr->unit();
-            info.type = to_external(descr->type());
-            info.min_domain_value = descr->min_domain_value();
-            info.max_domain_value = descr->max_domain_value();
-            info.automatable =  descr->type() == ParameterType::FLOAT || // TODO - this might not be the way we eventually want it
-                                descr->type() == ParameterType::INT   ||
-                                descr->type() == ParameterType::BOOL;
-            return {ext::ControlStatus::OK, info};
-        }
+        info.id = descr->id();
+        info.label = descr->label();
+        info.name = descr->name();
+        info.unit = descr->unit();
+        info.type = to_external(descr->type());
+        info.min_domain_value = descr->min_domain_value();
+        info.max_domain_value = descr->max_domain_value();
+        info.automatable =  descr->type() == ParameterType::FLOAT || // TODO - this might not be the way we eventually want it
+                            descr->type() == ParameterType::INT   ||
+                            descr->type() == ParameterType::BOOL;
+        return {ext::ControlStatus::OK, info};
     }
     return {ext::ControlStatus::NOT_FOUND, info};
 }
@@ -583,7 +584,7 @@ std::pair<ext::ControlStatus, ext::ParameterInfo> Controller::get_parameter_info
 std::pair<ext::ControlStatus, float> Controller::get_parameter_value(int processor_id, int parameter_id) const
 {
     SUSHI_LOG_DEBUG("get_parameter_value called with processor {} and parameter {}", processor_id, parameter_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor != nullptr)
     {
         auto[status, value] = processor->parameter_value(static_cast<ObjectId>(parameter_id));
@@ -598,7 +599,7 @@ std::pair<ext::ControlStatus, float> Controller::get_parameter_value(int process
 std::pair<ext::ControlStatus, float> Controller::get_parameter_value_in_domain(int processor_id, int parameter_id) const
 {
     SUSHI_LOG_DEBUG("get_parameter_value called with processor {} and parameter {}", processor_id, parameter_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor != nullptr)
     {
         auto[status, value] = processor->parameter_value_in_domain(static_cast<ObjectId>(parameter_id));
@@ -613,7 +614,7 @@ std::pair<ext::ControlStatus, float> Controller::get_parameter_value_in_domain(i
 std::pair<ext::ControlStatus, std::string> Controller::get_parameter_value_as_string(int processor_id, int parameter_id) const
 {
     SUSHI_LOG_DEBUG("get_parameter_value_as_string called with processor {} and parameter {}", processor_id, parameter_id);
-    auto processor = _engine->processor(static_cast<ObjectId>(processor_id));
+    auto processor = _engine->graph_snapshot()->processor(static_cast<ObjectId>(processor_id));
     if (processor != nullptr)
     {
         auto[status, value] = processor->parameter_value_formatted(static_cast<ObjectId>(parameter_id));
@@ -651,6 +652,28 @@ ext::ControlStatus Controller::set_string_property_value(int /*processor_id*/, i
     return ext::ControlStatus::UNSUPPORTED_OPERATION;
 }
 
+std::pair<ext::ControlStatus, std::vector<uint8_t>> Controller::save_session() const
+{
+    SUSHI_LOG_DEBUG("save_session called");
+    auto [status, session] = _engine->save_session();
+    if (status == engine::EngineReturnStatus::OK)
+    {
+        return {ext::ControlStatus::OK, std::move(session)};
+    }
+    return {ext::ControlStatus::ERROR, std::vector<uint8_t>()};
+}
+
+ext::ControlStatus Controller::restore_session(const std::vector<uint8_t>& session)
+{
+    SUSHI_LOG_DEBUG("restore_session called with {} bytes", session.size());
+    auto status = _engine->restore_session(session);
+    if (status == engine::EngineReturnStatus::OK)
+    {
+        return ext::ControlStatus::OK;
+    }
+    return ext::ControlStatus::ERROR;
+}
+
 std::pair<ext::ControlStatus, ext::CpuTimings> Controller::_get_timings(int node) const
 {
     if (_performance_timer->enabled())
@@ -64,6 +64,9 @@ public:
     ext::ControlStatus                                  reset_track_timings(int track_id) override;
     ext::ControlStatus                                  reset_processor_timings(int processor_id) override;
 
+    std::pair<ext::ControlStatus, std::vector<ext::AudioLevel>> get_engine_input_levels() const override;
+    std::pair<ext::ControlStatus, std::vector<ext::AudioLevel>> get_engine_output_levels() const override;
+
     std::pair<ext::ControlStatus, int>                  get_track_id(const std::string& track_name) const override;
     std::pair<ext::ControlStatus, ext::TrackInfo>       get_track_info(int track_id) const override;
     std::pair<ext::ControlStatus, std::vector<ext::ProcessorInfo>> get_track_processors(int track_id) const override;
@@ -89,6 +92,9 @@ public:
     ext::ControlStatus                                  set_parameter_value(int processor_id, int parameter_id, float value) override;
     ext::ControlStatus                                  set_string_property_value(int processor_id, int parameter_id, const std::string& value) override;
 
+    std::pair<ext::ControlStatus, std::vector<uint8_t>> save_session() const override;
+    ext::ControlStatus                                  restore_session(const std::vector<uint8_t>& session) override;
+
 protected:
     std::pair<ext::ControlStatus, ext::CpuTimings> _get_timings(int node) const;
 
@@ -31,10 +31,12 @@ SUSHI_GET_LOGGER_WITH_MODULE_NAME("event dispatcher");
 
 EventDispatcher::EventDispatcher(engine::BaseEngine* engine,
                                  RtSafeRtEventFifo* in_rt_queue,
-                                 RtSafeRtEventFifo* out_rt_queue) : _running{false},
+                                 RtSafeRtEventFifo* out_rt_queue,
+                                 ParameterNotificationArea* parameter_notifications) : _running{false},
                                                               _engine{engine},
                                                               _in_rt_queue{in_rt_queue},
                                                               _out_rt_queue{out_rt_queue},
+                                                              _parameter_notifications{parameter_notifications},
                                                               _worker{engine, this},
                                                               _event_timer{engine->sample_rate()}
 {
@@ -61,7 +63,10 @@ EventDispatcherStatus EventDispatcher::register_poster(EventPoster* poster)
 void EventDispatcher::run()
 {
     _running = true;
-    _event_thread = std::thread(&EventDispatcher::_event_loop, this);
+    if (_synchronous == false)
+    {
+        _event_thread = std::thread(&EventDispatcher::_event_loop, this);
+    }
     _worker.run();
 }
 
@@ -105,6 +110,37 @@ EventDispatcherStatus EventDispatcher::subscribe_to_engine_notifications(EventPo
     return EventDispatcherStatus::OK;
 }
 
+void EventDispatcher::set_synchronous_mode(bool enabled)
+{
+    if (enabled == _synchronous)
+    {
+        return;
+    }
+    bool running = _running;
+    if (running)
+    {
+        stop();
+    }
+    _synchronous = enabled;
+    _worker.set_synchronous_mode(enabled);
+    if (running)
+    {
+        run();
+    }
+}
+
+void EventDispatcher::process_pending_events()
+{
+    assert(_synchronous);
+    /* Asynchronous work is done directly when in synchronous mode, and
+     * its completion events are posted back to the incoming queue */
+    do
+    {
+        _process_events();
+    }
+    while (_in_queue.empty() == false);
+}
+
 int EventDispatcher::process(Event* event)
 {
     if (event->process_asynchronously())
@@ -138,40 +174,57 @@ void EventDispatcher::_event_loop()
     do
     {
         auto start_time = std::chrono::system_clock::now();
-
-        /* Handle incoming Events */
-        while (Event* event = _next_event())
-        {
-            assert(event->receiver() < static_cast<int>(_posters.size()));
-            EventPoster* receiver = _posters[event->receiver()];
-            int status = EventStatus::UNRECOGNIZED_RECEIVER;
-            if (receiver != nullptr)
-            {
-                status = _posters[event->receiver()]->process(event);
-            }
-            if (status == EventStatus::QUEUED_HANDLING)
-            {
-                /* Event has not finished processing, so dont call comp cb or delete it */
-                continue;
-            }
-            if (event->completion_cb() != nullptr)
-            {
-                event->completion_cb()(event->callback_arg(), event, status);
-            }
-            delete(event);
-        }
-        /* Handle incoming RtEvents */
-        while (!_in_rt_queue->empty())
-        {
-            RtEvent rt_event;
-            _in_rt_queue->pop(rt_event);
-            _process_rt_event(rt_event);
-        }
+        _process_events();
         std::this_thread::sleep_until(start_time + THREAD_PERIODICITY);
     }
     while (_running);
 }
 
+void EventDispatcher::_process_events()
+{
+    /* Handle incoming Events. Events that are not due yet are put back in the waiting
+     * list, so only the events waiting at the start are retried to avoid spinning on them */
+    for (auto waiting = _waiting_list.size(); waiting > 0; --waiting)
+    {
+        Event* event = _waiting_list.back();
+        _waiting_list.pop_back();
+        _dispatch_event(event);
+    }
+    while (_in_queue.empty() == false)
+    {
+        _dispatch_event(_in_queue.pop());
+    }
+    /* Handle incoming RtEvents */
+    while (!_in_rt_queue->empty())
+    {
+        RtEvent rt_event;
+        _in_rt_queue->pop(rt_event);
+        _process_rt_event(rt_event);
+    }
+    _flush_parameter_events();
+}
+
+void EventDispatcher::_dispatch_event(Event* event)
+{
+    assert(event->receiver() < static_cast<int>(_posters.size()));
+    EventPoster* receiver = _posters[event->receiver()];
+    int status = EventStatus::UNRECOGNIZED_RECEIVER;
+    if (receiver != nullptr)
+    {
+        status = _posters[event->receiver()]->process(event);
+    }
+    if (status == EventStatus::QUEUED_HANDLING)
+    {
+        /* Event has not finished processing, so dont call comp cb or delete it */
+        return;
+    }
+    if (event->completion_cb() != nullptr)
+    {
+        event->completion_cb()(event->callback_arg(), event, status);
+    }
+    delete(event);
+}
+
 int EventDispatcher::_process_rt_event(RtEvent &rt_event)
 {
     Time timestamp = _event_timer.real_time_from_sample_offset(rt_event.sample_offset());
@@ -184,6 +237,8 @@ int EventDispatcher::_process_rt_event(RtEvent &rt_event)
             {
                 auto typed_event = rt_event.syncronisation_event();
                 _event_timer.set_outgoing_time(typed_event->timestamp());
+                /* Sync events are sent once every chunk */
+                _publish_parameter_notifications(typed_event->timestamp());
                 return EventStatus::HANDLED_OK;
             }
             default:
@@ -211,21 +266,6 @@ int EventDispatcher::_process_rt_event(RtEvent &rt_event)
     return EventStatus::HANDLED_OK;
 }
 
-Event*EventDispatcher::_next_event()
-{
-    Event* event = nullptr;
-    if (!_waiting_list.empty())
-    {
-        event = _waiting_list.back();
-        _waiting_list.pop_back();
-    }
-    else if (!_in_queue.empty())
-    {
-        event = _in_queue.pop();
-    }
-    return event;
-}
-
 void EventDispatcher::_publish_keyboard_events(Event* event)
 {
     for (auto& listener : _keyboard_event_listeners)
@@ -240,6 +280,20 @@ void EventDispatcher::_publish_parameter_events(Event* event)
     {
         listener->process(event);
     }
+    _parameter_events_published = true;
+}
+
+void EventDispatcher::_flush_parameter_events()
+{
+    if (_parameter_events_published)
+    {
+        ParameterNotificationFlushEvent event(IMMEDIATE_PROCESS);
+        for (auto& listener : _parameter_change_listeners)
+        {
+            listener->process(&event);
+        }
+        _parameter_events_published = false;
+    }
 }
 
 void EventDispatcher::_publish_engine_notification_events(sushi::Event*event)
@@ -250,6 +304,20 @@ void EventDispatcher::_publish_engine_notification_events(sushi::Event*event)
     }
 }
 
+void EventDispatcher::_publish_parameter_notifications(Time timestamp)
+{
+    if (_parameter_notifications == nullptr)
+    {
+        return;
+    }
+    _parameter_notifications->consume([&](ObjectId processor_id, ObjectId parameter_id, float value)
+    {
+        ParameterChangeNotificationEvent event(ParameterChangeNotificationEvent::Subtype::FLOAT_PARAMETER_CHANGE_NOT,
+                                               processor_id, parameter_id, value, timestamp);
+        _publish_parameter_events(&event);
+    });
+}
+
 EventDispatcherStatus EventDispatcher::deregister_poster(EventPoster* poster)
 {
     if (_posters[poster->poster_id()] != nullptr)
@@ -316,6 +384,11 @@ void Worker::stop()
 
 int Worker::process(Event*event)
 {
+    if (_synchronous && (event->is_async_work_event() || event->is_engine_event()))
+    {
+        _handle_event(event);
+        return EventStatus::QUEUED_HANDLING;
+    }
     _queue.push(event);
     return EventStatus::QUEUED_HANDLING;
 }
@@ -328,41 +401,44 @@ void Worker::_worker()
         auto start_time = std::chrono::system_clock::now();
         while (!_queue.empty())
         {
-            int status = EventStatus::UNRECOGNIZED_EVENT;
-            Event* event = _queue.pop();
-
-            if (event->is_engine_event())
-            {
-                auto typed_event = static_cast<EngineEvent*>(event);
-                status = typed_event->execute(_engine);
-            }
-            if (event->is_async_work_event())
-            {
-                auto typed_event = static_cast<AsynchronousWorkEvent*>(event);
-                Event* response_event = typed_event->execute();
-                if (response_event != nullptr)
-                {
-                    _dispatcher->post_event(response_event);
-                }
-            }
-
-            if (event->completion_cb() != nullptr)
-            {
-                event->completion_cb()(event->callback_arg(), event, status);
-            }
-            delete (event);
+            _handle_event(_queue.pop());
         }
         if (start_time > print_timing_counter + PRINT_TIMING_INTERVAL)
         {
             print_timing_counter = start_time;
             _engine->print_timings_to_log();
         }
+        _engine->release_retired_graph_snapshots();
 
         std::this_thread::sleep_until(start_time + WORKER_THREAD_PERIODICITY);
     }
     while (_running);
 }
 
+void Worker::_handle_event(Event* event)
+{
+    int status = EventStatus::UNRECOGNIZED_EVENT;
+    if (event->is_engine_event())
+    {
+        auto typed_event = static_cast<EngineEvent*>(event);
+        status = typed_event->execute(_engine);
+    }
+    if (event->is_async_work_event())
+    {
+        auto typed_event = static_cast<AsynchronousWorkEvent*>(event);
+        Event* response_event = typed_event->execute();
+        if (response_event != nullptr)
+        {
+            _dispatcher->post_event(response_event);
+        }
+    }
+
+    if (event->completion_cb() != nullptr)
+    {
+        event->completion_cb()(event->callback_arg(), event, status);
+    }
+    delete (event);
+}
 
 } // end namespace dispatcher
 } // end namespace sushi
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include "library/synchronised_fifo.h"
 #include "library/rt_event_fifo.h"
 #include "library/event_interface.h"
+#include "library/parameter_notifications.h"
 
 namespace sushi {
 namespace engine {class BaseEngine;}
@@ -58,6 +59,14 @@ public:
     void run();
     void stop();
 
+    /**
+     * @brief In synchronous mode, asynchronous work and engine events are executed directly
+     *        in the thread that posts them, so graph changes happen between the same chunks
+     *        on every run. Engine events wait for the audio thread if the engine is in
+     *        realtime mode, so synchronous mode is only for engines that are not.
+     */
+    void set_synchronous_mode(bool enabled) {_synchronous = enabled;}
+
     int process(Event* event) override;
     int poster_id() override {return EventPosterId::WORKER;}
 
@@ -66,6 +75,8 @@ private:
     BaseEventDispatcher*        _dispatcher;
 
     void                        _worker();
+    void                        _handle_event(Event* event);
+    std::atomic<bool>           _synchronous{false};
     std::thread                 _worker_thread;
     std::atomic<bool>           _running;
 
@@ -75,7 +86,10 @@ private:
 class EventDispatcher : public BaseEventDispatcher
 {
 public:
-    EventDispatcher(engine::BaseEngine* engine, RtSafeRtEventFifo* in_rt_queue,  RtSafeRtEventFifo* out_rt_queue);
+    EventDispatcher(engine::BaseEngine* engine,
+                    RtSafeRtEventFifo* in_rt_queue,
+                    RtSafeRtEventFifo* out_rt_queue,
+                    ParameterNotificationArea* parameter_notifications = nullptr);
 
     virtual ~EventDispatcher() = default;
 
@@ -96,6 +110,9 @@ public:
     void set_sample_rate(float sample_rate) override {_event_timer.set_sample_rate(sample_rate);}
     void set_time(Time timestamp) override {_event_timer.set_incoming_time(timestamp);}
 
+    void set_synchronous_mode(bool enabled) override;
+    void process_pending_events() override;
+
     int process(Event* event) override;
     int poster_id() override {return AUDIO_ENGINE_ID;}
 
@@ -103,13 +120,17 @@ private:
 
     void _event_loop();
 
+    void _process_events();
+
     int _process_rt_event(RtEvent& rt_event);
 
-    Event* _next_event();
+    void _dispatch_event(Event* event);
 
     void _publish_keyboard_events(Event* event);
     void _publish_parameter_events(Event* event);
     void _publish_engine_notification_events(Event* event);
+    void _publish_parameter_notifications(Time timestamp);
+    void _flush_parameter_events();
 
     std::atomic<bool>           _running;
     std::thread                 _event_thread;
@@ -119,6 +140,7 @@ private:
     SynchronizedQueue<Event*>   _in_queue;
     RtSafeRtEventFifo*          _in_rt_queue;
     RtSafeRtEventFifo*          _out_rt_queue;
+    ParameterNotificationArea*  _parameter_notifications;
     std::deque<Event*>          _waiting_list;
 
     Worker                      _worker;
@@ -128,6 +150,8 @@ private:
     std::vector<EventPoster*> _keyboard_event_listeners;
     std::vector<EventPoster*> _parameter_change_listeners;
     std::vector<EventPoster*> _engine_notification_listeners;
+    bool _parameter_events_published{false};
+    bool _synchronous{false};
 };
 
 } // end namespace dispatcher
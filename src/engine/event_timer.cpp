@@ -22,7 +22,7 @@
 #include <cassert>
 
 #include "event_timer.h"
-#include "library/constants.h"
+#include "library/chunk_size.h"
 
 namespace sushi {
 namespace event_timer {
@@ -32,7 +32,7 @@ constexpr float MICROSECONDS = std::chrono::microseconds(1s).count();
 
 inline Time calc_chunk_time(float samplerate)
 {
-     return std::chrono::microseconds(static_cast<int64_t>(std::round(MICROSECONDS / samplerate * AUDIO_CHUNK_SIZE)));
+     return std::chrono::microseconds(static_cast<int64_t>(std::round(MICROSECONDS / samplerate * audio_chunk_size())));
 }
 
 EventTimer::EventTimer(float default_sample_rate) : _sample_rate{default_sample_rate},
@@ -46,7 +46,7 @@ std::pair<bool, int> EventTimer::sample_offset_from_realtime(Time timestamp)
     auto diff = timestamp - _incoming_chunk_time.load();
     if (diff < _chunk_time)
     {
-        int64_t offset = (AUDIO_CHUNK_SIZE * diff) / _chunk_time;
+        int64_t offset = (audio_chunk_size() * diff) / _chunk_time;
         return std::make_pair(true, static_cast<int>(std::max(int64_t{0}, offset)));
     }
     else
@@ -57,7 +57,7 @@ std::pair<bool, int> EventTimer::sample_offset_from_realtime(Time timestamp)
 
 Time EventTimer::real_time_from_sample_offset(int offset)
 {
-    return _outgoing_chunk_time + offset * _chunk_time / AUDIO_CHUNK_SIZE;
+    return _outgoing_chunk_time + offset * _chunk_time / audio_chunk_size();
 }
 
 void EventTimer::set_sample_rate(float sample_rate)
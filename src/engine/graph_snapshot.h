@@ -0,0 +1,170 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Immutable snapshot of the engine's tracks and processors for non-rt queries
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_GRAPH_SNAPSHOT_H
+#define SUSHI_GRAPH_SNAPSHOT_H
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "library/processor.h"
+#include "library/id_generator.h"
+#include "engine/track.h"
+
+namespace sushi {
+namespace engine {
+
+/**
+ * @brief The tracks and processors of the engine at one point in time. A new snapshot is
+ *        published every time the graph is edited and a snapshot is never modified once
+ *        published, so it can be read from any thread without locking. Holding on to a
+ *        snapshot keeps its processors alive even if they are removed from the engine.
+ *
+ *        All lookups are hashed and names are looked up with std::string_view keys that
+ *        refer to the names stored in the processors and parameters themselves, so a
+ *        lookup does not allocate.
+ */
+class GraphSnapshot
+{
+public:
+    struct TrackNode
+    {
+        std::shared_ptr<Track> track;
+        std::vector<std::shared_ptr<Processor>> processors; // In processing order
+    };
+
+    /**
+     * @brief Add a processor to the snapshot, only to be called before publishing it.
+     *        The name of the processor must not change after this.
+     * @param processor The processor to add, including tracks
+     */
+    void add_processor(std::shared_ptr<Processor> processor)
+    {
+        for (const auto& parameter : processor->all_parameters())
+        {
+            _parameters[_parameter_key(processor->id(), parameter->id())] = parameter;
+        }
+        _processors_by_id[processor->id()] = processor;
+        _processors.emplace(processor->name(), std::move(processor));
+    }
+
+    /**
+     * @brief Add a track to the snapshot, only to be called before publishing it.
+     *        Tracks are processed in the order they are added.
+     * @param track The track and its process chain
+     */
+    void add_track(TrackNode track)
+    {
+        _track_indices[track.track->id()] = _tracks.size();
+        _tracks.push_back(std::move(track));
+    }
+
+    /**
+     * @return All tracks in processing order
+     */
+    const std::vector<TrackNode>& tracks() const
+    {
+        return _tracks;
+    }
+
+    /**
+     * @return All processors, including tracks, indexed by name
+     */
+    const std::unordered_map<std::string_view, std::shared_ptr<Processor>>& processors() const
+    {
+        return _processors;
+    }
+
+    /**
+     * @brief Find a track in the snapshot
+     * @param track_id The id of the track
+     * @return A pointer to the track's node if found, nullptr otherwise
+     */
+    const TrackNode* track(ObjectId track_id) const
+    {
+        auto node = _track_indices.find(track_id);
+        return node != _track_indices.end() ? &_tracks[node->second] : nullptr;
+    }
+
+    /**
+     * @brief Find a processor in the snapshot
+     * @param processor_id The id of the processor
+     * @return The processor if found, an empty pointer otherwise
+     */
+    std::shared_ptr<Processor> processor(ObjectId processor_id) const
+    {
+        auto node = _processors_by_id.find(processor_id);
+        return node != _processors_by_id.end() ? node->second : nullptr;
+    }
+
+    /**
+     * @brief Find a processor in the snapshot
+     * @param name The unique name of the processor
+     * @return The processor if found, an empty pointer otherwise
+     */
+    std::shared_ptr<Processor> processor(std::string_view name) const
+    {
+        auto node = _processors.find(name);
+        return node != _processors.end() ? node->second : nullptr;
+    }
+
+    /**
+     * @brief Find a parameter of any processor in the snapshot
+     * @param processor_id The id of the processor
+     * @param parameter_id The id of the parameter
+     * @return The parameter descriptor if found, nullptr otherwise
+     */
+    const ParameterDescriptor* parameter(ObjectId processor_id, ObjectId parameter_id) const
+    {
+        auto node = _parameters.find(_parameter_key(processor_id, parameter_id));
+        return node != _parameters.end() ? node->second : nullptr;
+    }
+
+    /**
+     * @brief Find a parameter of any processor in the snapshot
+     * @param processor_name The unique name of the processor
+     * @param parameter_name The name of the parameter
+     * @return The parameter descriptor if found, nullptr otherwise
+     */
+    const ParameterDescriptor* parameter(std::string_view processor_name, std::string_view parameter_name) const
+    {
+        auto node = _processors.find(processor_name);
+        return node != _processors.end() ? node->second->parameter_from_name(parameter_name) : nullptr;
+    }
+
+private:
+    static uint64_t _parameter_key(ObjectId processor_id, ObjectId parameter_id)
+    {
+        return static_cast<uint64_t>(processor_id) << 32 | parameter_id;
+    }
+
+    std::vector<TrackNode> _tracks;
+    std::unordered_map<ObjectId, size_t> _track_indices;
+    std::unordered_map<std::string_view, std::shared_ptr<Processor>> _processors;
+    std::unordered_map<ObjectId, std::shared_ptr<Processor>> _processors_by_id;
+    std::unordered_map<uint64_t, const ParameterDescriptor*> _parameters;
+};
+
+} // end namespace engine
+} // end namespace sushi
+
+#endif //SUSHI_GRAPH_SNAPSHOT_H
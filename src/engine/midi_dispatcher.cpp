@@ -19,6 +19,7 @@
  */
 
 #include <algorithm>
+#include <type_traits>
 
 #include "engine/midi_dispatcher.h"
 #include "library/midi_encoder.h"
@@ -92,9 +93,7 @@ inline Event* make_wrapped_midi_event(const InputConnection &c,
     return new KeyboardEvent(KeyboardEvent::Subtype::WRAPPED_MIDI, c.target, midi_data, timestamp);
 }
 
-inline Event* make_param_change_event(InputConnection &c,
-                                      const midi::ControlChangeMessage &msg,
-                                      Time timestamp)
+inline float param_change_value(InputConnection &c, const midi::ControlChangeMessage &msg)
 {
     uint8_t abs_value = msg.value;
     // Maybe TODO: currently this is based on a virtual controller absolute value which is
@@ -116,7 +115,14 @@ inline Event* make_param_change_event(InputConnection &c,
         }
         c.virtual_abs_value = abs_value;
     }
-    float value = static_cast<float>(abs_value) / midi::MAX_VALUE * (c.max_range - c.min_range) + c.min_range;
+    return static_cast<float>(abs_value) / midi::MAX_VALUE * (c.max_range - c.min_range) + c.min_range;
+}
+
+inline Event* make_param_change_event(InputConnection &c,
+                                      const midi::ControlChangeMessage &msg,
+                                      Time timestamp)
+{
+    float value = param_change_value(c, msg);
     return new ParameterChangeEvent(ParameterChangeEvent::Subtype::FLOAT_PARAMETER_CHANGE, c.target, c.parameter, value, timestamp);
 }
 
@@ -127,6 +133,99 @@ inline Event* make_program_change_event(const InputConnection &c,
     return new ProgramChangeEvent(c.target, msg.program, timestamp);
 }
 
+inline SyncClockRtEvent::ClockType clock_type_from_message(midi::MessageType type)
+{
+    switch (type)
+    {
+        case midi::MessageType::START:      return SyncClockRtEvent::ClockType::START;
+        case midi::MessageType::CONTINUE:   return SyncClockRtEvent::ClockType::CONTINUE;
+        case midi::MessageType::STOP:       return SyncClockRtEvent::ClockType::STOP;
+        default:                            return SyncClockRtEvent::ClockType::TICK;
+    }
+}
+
+inline Event* make_sync_clock_event(midi::MessageType type, Time timestamp)
+{
+    return new SyncClockEvent(SyncMode::MIDI, clock_type_from_message(type), midi::CLOCK_TICKS_PER_QUARTER_NOTE, timestamp);
+}
+
+/* Realtime versions of the above, used when dispatching midi directly from the audio thread */
+inline RtEvent make_note_on_event(const InputConnection &c,
+                                  const midi::NoteOnMessage &msg,
+                                  int sample_offset)
+{
+    if (msg.velocity == 0)
+    {
+        return RtEvent::make_note_off_event(c.target, sample_offset, msg.channel, msg.note, 0.5f);
+    }
+    float velocity = msg.velocity / static_cast<float>(midi::MAX_VALUE);
+    return RtEvent::make_note_on_event(c.target, sample_offset, msg.channel, msg.note, velocity);
+}
+
+inline RtEvent make_note_off_event(const InputConnection &c,
+                                   const midi::NoteOffMessage &msg,
+                                   int sample_offset)
+{
+    float velocity = msg.velocity / static_cast<float>(midi::MAX_VALUE);
+    return RtEvent::make_note_off_event(c.target, sample_offset, msg.channel, msg.note, velocity);
+}
+
+inline RtEvent make_note_aftertouch_event(const InputConnection &c,
+                                          const midi::PolyKeyPressureMessage &msg,
+                                          int sample_offset)
+{
+    float pressure = msg.pressure / static_cast<float>(midi::MAX_VALUE);
+    return RtEvent::make_note_aftertouch_event(c.target, sample_offset, msg.channel, msg.note, pressure);
+}
+
+inline RtEvent make_aftertouch_event(const InputConnection &c,
+                                     const midi::ChannelPressureMessage &msg,
+                                     int sample_offset)
+{
+    float pressure = msg.pressure / static_cast<float>(midi::MAX_VALUE);
+    return RtEvent::make_aftertouch_event(c.target, sample_offset, msg.channel, pressure);
+}
+
+inline RtEvent make_modulation_event(const InputConnection &c,
+                                     const midi::ControlChangeMessage &msg,
+                                     int sample_offset)
+{
+    float value = msg.value / static_cast<float>(midi::MAX_VALUE);
+    return RtEvent::make_kb_modulation_event(c.target, sample_offset, msg.channel, value);
+}
+
+inline RtEvent make_pitch_bend_event(const InputConnection &c,
+                                     const midi::PitchBendMessage &msg,
+                                     int sample_offset)
+{
+    float value = (msg.value / static_cast<float>(midi::PITCH_BEND_MIDDLE)) - 1.0f;
+    return RtEvent::make_pitch_bend_event(c.target, sample_offset, msg.channel, value);
+}
+
+inline RtEvent make_wrapped_midi_event(const InputConnection &c,
+                                       const uint8_t* data,
+                                       size_t size,
+                                       int sample_offset)
+{
+    MidiDataByte midi_data{0};
+    std::copy(data, data + size, midi_data.data());
+    return RtEvent::make_wrapped_midi_event(c.target, sample_offset, midi_data);
+}
+
+inline RtEvent make_param_change_event(InputConnection &c,
+                                       const midi::ControlChangeMessage &msg,
+                                       int sample_offset)
+{
+    float value = param_change_value(c, msg);
+    return RtEvent::make_parameter_change_event(c.target, sample_offset, c.parameter, value);
+}
+
+inline RtEvent make_sync_clock_event(midi::MessageType type, int sample_offset)
+{
+    return RtEvent::make_sync_clock_event(sample_offset, SyncMode::MIDI, clock_type_from_message(type),
+                                          midi::CLOCK_TICKS_PER_QUARTER_NOTE);
+}
+
 
 MidiDispatcher::MidiDispatcher(engine::BaseEngine* engine) : _engine(engine),
                                                              _frontend(nullptr)
@@ -282,7 +381,8 @@ void MidiDispatcher::clear_connections()
     _kb_routes_in.clear();
 }
 
-void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
+template <typename TimeOrOffset, typename Poster>
+void MidiDispatcher::_dispatch_midi(int port, MidiDataByte data, TimeOrOffset timestamp, Poster&& post)
 {
     int channel = midi::decode_channel(data);
     int size = data.size();
@@ -293,11 +393,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
         {
             for (auto c : cons->second[midi::MidiChannel::OMNI])
             {
-                _event_dispatcher->post_event(make_wrapped_midi_event(c, data.data(), size, timestamp));
+                post(make_wrapped_midi_event(c, data.data(), size, timestamp));
             }
             for (auto c : cons->second[channel])
             {
-                _event_dispatcher->post_event(make_wrapped_midi_event(c, data.data(), size, timestamp));
+                post(make_wrapped_midi_event(c, data.data(), size, timestamp));
             }
         }
     }
@@ -314,11 +414,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto& c : cons->second[decoded_msg.controller][midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_param_change_event(c, decoded_msg, timestamp));
+                    post(make_param_change_event(c, decoded_msg, timestamp));
                 }
                 for (auto& c : cons->second[decoded_msg.controller][decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event(make_param_change_event(c, decoded_msg, timestamp));
+                    post(make_param_change_event(c, decoded_msg, timestamp));
                 }
             }
             if (decoded_msg.controller == midi::MOD_WHEEL_CONTROLLER_NO)
@@ -328,11 +428,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
                 {
                     for (auto c : cons->second[midi::MidiChannel::OMNI])
                     {
-                        _event_dispatcher->post_event(make_modulation_event(c, decoded_msg, timestamp));
+                        post(make_modulation_event(c, decoded_msg, timestamp));
                     }
                     for (auto c : cons->second[decoded_msg.channel])
                     {
-                        _event_dispatcher->post_event(make_modulation_event(c, decoded_msg, timestamp));
+                        post(make_modulation_event(c, decoded_msg, timestamp));
                     }
                 }
             }
@@ -347,11 +447,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto c : cons->second[midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_note_on_event(c, decoded_msg, timestamp));
+                    post(make_note_on_event(c, decoded_msg, timestamp));
                 }
                 for (auto c : cons->second[decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event(make_note_on_event(c, decoded_msg, timestamp));
+                    post(make_note_on_event(c, decoded_msg, timestamp));
                 }
             }
             break;
@@ -365,11 +465,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto c : cons->second[midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_note_off_event(c, decoded_msg, timestamp));
+                    post(make_note_off_event(c, decoded_msg, timestamp));
                 }
                 for (auto c : cons->second[decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event(make_note_off_event(c, decoded_msg, timestamp));
+                    post(make_note_off_event(c, decoded_msg, timestamp));
                 }
             }
             break;
@@ -383,11 +483,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto c : cons->second[midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_pitch_bend_event(c, decoded_msg, timestamp));
+                    post(make_pitch_bend_event(c, decoded_msg, timestamp));
                 }
                 for (auto c : cons->second[decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event(make_pitch_bend_event(c, decoded_msg, timestamp));
+                    post(make_pitch_bend_event(c, decoded_msg, timestamp));
                 }
             }
             break;
@@ -401,11 +501,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto c : cons->second[midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_note_aftertouch_event(c, decoded_msg, timestamp));
+                    post(make_note_aftertouch_event(c, decoded_msg, timestamp));
                 }
                 for (auto c : cons->second[decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event(make_note_aftertouch_event(c, decoded_msg, timestamp));
+                    post(make_note_aftertouch_event(c, decoded_msg, timestamp));
                 }
             }
             break;
@@ -419,11 +519,11 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
             {
                 for (auto c : cons->second[midi::MidiChannel::OMNI])
                 {
-                    _event_dispatcher->post_event(make_aftertouch_event(c, decoded_msg, timestamp));
+                    post(make_aftertouch_event(c, decoded_msg, timestamp));
                 }
                 for (auto c : cons->second[decoded_msg.channel])
                 {
-                    _event_dispatcher->post_event( make_aftertouch_event(c, decoded_msg, timestamp));
+                    post(make_aftertouch_event(c, decoded_msg, timestamp));
                 }
             }
             break;
@@ -431,27 +531,108 @@ void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
 
         case midi::MessageType::PROGRAM_CHANGE:
         {
-            midi::ProgramChangeMessage decoded_msg = midi::decode_program_change(data);
-            const auto& cons = _pc_routes.find(port);
-            if (cons != _pc_routes.end())
+            /* Program changes are not realtime safe and can only be dispatched as Events */
+            if constexpr (std::is_same_v<TimeOrOffset, Time>)
             {
-                for (auto c : cons->second[midi::MidiChannel::OMNI])
-                {
-                    _event_dispatcher->post_event(make_program_change_event(c, decoded_msg, timestamp));
-                }
-                for (auto c : cons->second[decoded_msg.channel])
+                midi::ProgramChangeMessage decoded_msg = midi::decode_program_change(data);
+                const auto& cons = _pc_routes.find(port);
+                if (cons != _pc_routes.end())
                 {
-                    _event_dispatcher->post_event(make_program_change_event(c, decoded_msg, timestamp));
+                    for (auto c : cons->second[midi::MidiChannel::OMNI])
+                    {
+                        post(make_program_change_event(c, decoded_msg, timestamp));
+                    }
+                    for (auto c : cons->second[decoded_msg.channel])
+                    {
+                        post(make_program_change_event(c, decoded_msg, timestamp));
+                    }
                 }
             }
             break;
         }
 
+        /* Clock messages are passed on to the transport regardless of channel and
+         * connections, the transport ignores them unless it is synced to midi */
+        case midi::MessageType::TIMING_CLOCK:
+        case midi::MessageType::START:
+        case midi::MessageType::CONTINUE:
+        case midi::MessageType::STOP:
+        {
+            post(make_sync_clock_event(type, timestamp));
+            break;
+        }
+
         default:
             break;
     }
 }
 
+void MidiDispatcher::send_midi(int port, MidiDataByte data, Time timestamp)
+{
+    _dispatch_midi(port, data, timestamp, [this](Event* event)
+    {
+        _event_dispatcher->post_event(event);
+    });
+}
+
+void MidiDispatcher::send_midi_rt(int port, MidiDataByte data, int sample_offset)
+{
+    _dispatch_midi(port, data, sample_offset, [this](RtEvent event)
+    {
+        _engine->send_rt_event(event);
+    });
+}
+
+int MidiDispatcher::encode_rt_event(const RtEvent& event, MidiOutputMessage* messages, int max_messages)
+{
+    if (is_keyboard_event(event) == false)
+    {
+        return 0;
+    }
+    const auto& cons = _kb_routes_out.find(event.processor_id());
+    if (cons == _kb_routes_out.end())
+    {
+        return 0;
+    }
+    int count = 0;
+    for (const OutputConnection& c : cons->second)
+    {
+        if (count >= max_messages)
+        {
+            break;
+        }
+        MidiDataByte midi_data;
+        switch (event.type())
+        {
+            case RtEventType::NOTE_ON:
+                midi_data = midi::encode_note_on(c.channel, event.keyboard_event()->note(), event.keyboard_event()->velocity());
+                break;
+            case RtEventType::NOTE_OFF:
+                midi_data = midi::encode_note_off(c.channel, event.keyboard_event()->note(), event.keyboard_event()->velocity());
+                break;
+            case RtEventType::NOTE_AFTERTOUCH:
+                midi_data = midi::encode_poly_key_pressure(c.channel, event.keyboard_event()->note(), event.keyboard_event()->velocity());
+                break;
+            case RtEventType::AFTERTOUCH:
+                midi_data = midi::encode_channel_pressure(c.channel, event.keyboard_common_event()->value());
+                break;
+            case RtEventType::PITCH_BEND:
+                midi_data = midi::encode_pitch_bend(c.channel, event.keyboard_common_event()->value());
+                break;
+            case RtEventType::MODULATION:
+                midi_data = midi::encode_control_change(c.channel, midi::MOD_WHEEL_CONTROLLER_NO, event.keyboard_common_event()->value());
+                break;
+            case RtEventType::WRAPPED_MIDI_EVENT:
+                midi_data = event.wrapped_midi_event()->midi_data();
+                break;
+            default:
+                continue;
+        }
+        messages[count++] = {c.output, midi_data};
+    }
+    return count;
+}
+
 int MidiDispatcher::process(Event* event)
 {
     if (event->is_keyboard_event())
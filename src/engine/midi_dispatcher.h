@@ -59,6 +59,12 @@ struct OutputConnection
     float max_range;
 };
 
+struct MidiOutputMessage
+{
+    int output;
+    MidiDataByte data;
+};
+
 enum class MidiDispatcherStatus
 {
     OK,
@@ -185,6 +191,29 @@ public:
      */
     void send_midi(int port, MidiDataByte data, Time timestamp) override;
 
+    /**
+     * @brief Realtime version of send_midi() for audio frontends that receive midi
+     *        in the audio callback. The decoded events are delivered directly to their
+     *        target processors with a sample accurate offset instead of being posted
+     *        through the event dispatcher. Must be called from the audio thread before
+     *        processing the chunk the events belong to. Program change messages are
+     *        not realtime safe and are ignored.
+     * @param port Index of the originating midi port.
+     * @param data The midi message.
+     * @param sample_offset Offset in samples from the start of the current chunk.
+     */
+    void send_midi_rt(int port, MidiDataByte data, int sample_offset);
+
+    /**
+     * @brief Encode an outgoing keyboard event from the audio thread according to the
+     *        connections made with connect_track_to_output(). Realtime safe.
+     * @param event The RtEvent to encode, non keyboard events are ignored.
+     * @param messages Array to write the encoded midi messages to.
+     * @param max_messages The capacity of messages.
+     * @return The number of midi messages written to messages.
+     */
+    int encode_rt_event(const RtEvent& event, MidiOutputMessage* messages, int max_messages);
+
     /* Inherited from EventPoster */
     int process(Event* /*event*/) override;
 
@@ -195,6 +224,8 @@ public:
     int poster_id() override {return EventPosterId::MIDI_DISPATCHER;}
 
 private:
+    template <typename TimeOrOffset, typename Poster>
+    void _dispatch_midi(int port, MidiDataByte data, TimeOrOffset timestamp, Poster&& post);
 
     std::map<int, std::array<std::vector<InputConnection>, midi::MidiChannel::OMNI + 1>> _kb_routes_in;
     std::map<ObjectId, std::vector<OutputConnection>>  _kb_routes_out;
@@ -0,0 +1,403 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Serialisable snapshot of a whole engine session
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <cstring>
+
+#include "session_snapshot.h"
+
+namespace sushi {
+namespace engine {
+
+/* "SSNP" followed by a format version, bump the version on any change to the layout */
+constexpr uint32_t SESSION_MAGIC = 0x534e5053;
+constexpr uint32_t SESSION_FORMAT_VERSION = 2;
+
+namespace {
+
+/* All values are written little endian regardless of platform */
+class Writer
+{
+public:
+    void write(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            _data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void write(int value)
+    {
+        write(static_cast<uint32_t>(value));
+    }
+
+    void write(bool value)
+    {
+        _data.push_back(value ? 1 : 0);
+    }
+
+    void write(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write(bits);
+    }
+
+    void write(const std::string& value)
+    {
+        write(static_cast<uint32_t>(value.size()));
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    void write(const std::vector<uint8_t>& value)
+    {
+        write(static_cast<uint32_t>(value.size()));
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    std::vector<uint8_t>& data() {return _data;}
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+/* Reads values written by Writer, once a read fails all following reads fail too */
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : _data(data) {}
+
+    bool read(uint32_t& value)
+    {
+        if (!_available(4))
+        {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            value |= static_cast<uint32_t>(_data[_pos++]) << (i * 8);
+        }
+        return true;
+    }
+
+    bool read(int& value)
+    {
+        uint32_t raw{0};
+        bool ok = read(raw);
+        value = static_cast<int>(raw);
+        return ok;
+    }
+
+    bool read(bool& value)
+    {
+        if (!_available(1))
+        {
+            return false;
+        }
+        value = _data[_pos++] != 0;
+        return true;
+    }
+
+    bool read(float& value)
+    {
+        uint32_t bits{0};
+        bool ok = read(bits);
+        std::memcpy(&value, &bits, sizeof(value));
+        return ok;
+    }
+
+    bool read(std::string& value)
+    {
+        uint32_t size;
+        if (!read(size) || !_available(size))
+        {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(_data.data() + _pos), size);
+        _pos += size;
+        return true;
+    }
+
+    bool read(std::vector<uint8_t>& value)
+    {
+        uint32_t size;
+        if (!read(size) || !_available(size))
+        {
+            return false;
+        }
+        value.assign(_data.begin() + _pos, _data.begin() + _pos + size);
+        _pos += size;
+        return true;
+    }
+
+    /* Read an element count, every element takes at least 1 byte so a count larger than
+     * the remaining data is invalid, checking this avoids huge allocations on bad data */
+    bool read_count(uint32_t& count)
+    {
+        return read(count) && _available(count);
+    }
+
+    bool at_end() const {return _pos == _data.size();}
+
+private:
+    bool _available(size_t bytes)
+    {
+        if (_failed || _data.size() - _pos < bytes)
+        {
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<uint8_t>& _data;
+    size_t _pos{0};
+    bool _failed{false};
+};
+
+void write_processor(Writer& writer, const SessionSnapshot::ProcessorState& processor)
+{
+    writer.write(processor.name);
+    writer.write(processor.plugin.uid);
+    writer.write(processor.plugin.path);
+    writer.write(static_cast<int>(processor.plugin.type));
+    writer.write(processor.bypassed);
+    writer.write(processor.has_program);
+    writer.write(processor.program);
+    writer.write(static_cast<uint32_t>(processor.parameters.size()));
+    for (const auto& parameter : processor.parameters)
+    {
+        writer.write(parameter.name);
+        writer.write(parameter.value);
+    }
+    writer.write(static_cast<uint32_t>(processor.string_properties.size()));
+    for (const auto& property : processor.string_properties)
+    {
+        writer.write(property.name);
+        writer.write(property.value);
+    }
+    writer.write(static_cast<uint32_t>(processor.data_properties.size()));
+    for (const auto& property : processor.data_properties)
+    {
+        writer.write(property.name);
+        writer.write(property.value);
+    }
+}
+
+bool read_processor(Reader& reader, SessionSnapshot::ProcessorState& processor)
+{
+    int type;
+    uint32_t parameter_count;
+    bool ok = reader.read(processor.name) &&
+              reader.read(processor.plugin.uid) &&
+              reader.read(processor.plugin.path) &&
+              reader.read(type) &&
+              reader.read(processor.bypassed) &&
+              reader.read(processor.has_program) &&
+              reader.read(processor.program) &&
+              reader.read_count(parameter_count);
+    if (!ok || type < static_cast<int>(PluginType::INTERNAL) || type > static_cast<int>(PluginType::LV2))
+    {
+        return false;
+    }
+    processor.plugin.type = static_cast<PluginType>(type);
+    processor.parameters.resize(parameter_count);
+    for (auto& parameter : processor.parameters)
+    {
+        if (!reader.read(parameter.name) || !reader.read(parameter.value))
+        {
+            return false;
+        }
+    }
+    uint32_t property_count;
+    if (!reader.read_count(property_count))
+    {
+        return false;
+    }
+    processor.string_properties.resize(property_count);
+    for (auto& property : processor.string_properties)
+    {
+        if (!reader.read(property.name) || !reader.read(property.value))
+        {
+            return false;
+        }
+    }
+    if (!reader.read_count(property_count))
+    {
+        return false;
+    }
+    processor.data_properties.resize(property_count);
+    for (auto& property : processor.data_properties)
+    {
+        if (!reader.read(property.name) || !reader.read(property.value))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void write_connections(Writer& writer, const std::vector<SessionSnapshot::AudioConnection>& connections)
+{
+    writer.write(static_cast<uint32_t>(connections.size()));
+    for (const auto& connection : connections)
+    {
+        writer.write(connection.engine_channel);
+        writer.write(connection.track_channel);
+        writer.write(connection.track);
+    }
+}
+
+bool read_connections(Reader& reader, std::vector<SessionSnapshot::AudioConnection>& connections)
+{
+    uint32_t count;
+    if (!reader.read_count(count))
+    {
+        return false;
+    }
+    connections.resize(count);
+    for (auto& connection : connections)
+    {
+        if (!reader.read(connection.engine_channel) ||
+            !reader.read(connection.track_channel) ||
+            !reader.read(connection.track))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> SessionSnapshot::serialize() const
+{
+    Writer writer;
+    writer.write(SESSION_MAGIC);
+    writer.write(SESSION_FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(tracks.size()));
+    for (const auto& track : tracks)
+    {
+        write_processor(writer, track.track);
+        writer.write(track.channels);
+        writer.write(track.input_busses);
+        writer.write(track.output_busses);
+        writer.write(static_cast<uint32_t>(track.processors.size()));
+        for (const auto& processor : track.processors)
+        {
+            write_processor(writer, processor);
+        }
+    }
+    write_connections(writer, input_connections);
+    write_connections(writer, output_connections);
+    return std::move(writer.data());
+}
+
+std::pair<bool, SessionSnapshot> SessionSnapshot::deserialize(const std::vector<uint8_t>& data)
+{
+    Reader reader(data);
+    SessionSnapshot session;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t track_count;
+    if (!reader.read(magic) || magic != SESSION_MAGIC ||
+        !reader.read(version) || version != SESSION_FORMAT_VERSION ||
+        !reader.read_count(track_count))
+    {
+        return {false, SessionSnapshot()};
+    }
+    session.tracks.resize(track_count);
+    for (auto& track : session.tracks)
+    {
+        uint32_t processor_count;
+        bool ok = read_processor(reader, track.track) &&
+                  reader.read(track.channels) &&
+                  reader.read(track.input_busses) &&
+                  reader.read(track.output_busses) &&
+                  reader.read_count(processor_count);
+        if (!ok)
+        {
+            return {false, SessionSnapshot()};
+        }
+        track.processors.resize(processor_count);
+        for (auto& processor : track.processors)
+        {
+            if (!read_processor(reader, processor))
+            {
+                return {false, SessionSnapshot()};
+            }
+        }
+    }
+    if (!read_connections(reader, session.input_connections) ||
+        !read_connections(reader, session.output_connections) ||
+        !reader.at_end())
+    {
+        return {false, SessionSnapshot()};
+    }
+    return {true, std::move(session)};
+}
+
+SessionSnapshot::ProcessorState SessionSnapshot::capture_processor(const Processor& processor,
+                                                                   const PluginInfo& plugin)
+{
+    ProcessorState state;
+    state.name = processor.name();
+    state.plugin = plugin;
+    state.bypassed = processor.bypassed();
+    state.has_program = processor.supports_programs();
+    state.program = state.has_program ? processor.current_program() : 0;
+    for (const auto& parameter : processor.all_parameters())
+    {
+        switch (parameter->type())
+        {
+            case ParameterType::STRING:
+            {
+                auto [status, value] = processor.string_property_value(parameter->id());
+                if (status == ProcessorReturnCode::OK)
+                {
+                    state.string_properties.push_back({parameter->name(), std::move(value)});
+                }
+                break;
+            }
+            case ParameterType::DATA:
+            {
+                auto [status, value] = processor.data_property_value(parameter->id());
+                if (status == ProcessorReturnCode::OK)
+                {
+                    state.data_properties.push_back({parameter->name(), std::move(value)});
+                }
+                break;
+            }
+            default:
+            {
+                auto [status, value] = processor.parameter_value(parameter->id());
+                if (status == ProcessorReturnCode::OK)
+                {
+                    state.parameters.push_back({parameter->name(), value});
+                }
+            }
+        }
+    }
+    return state;
+}
+
+} // end namespace engine
+} // end namespace sushi
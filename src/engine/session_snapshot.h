@@ -0,0 +1,134 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Serialisable snapshot of a whole engine session, used for saving and restoring
+ *        the graph and the state of all processors.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_SESSION_SNAPSHOT_H
+#define SUSHI_SESSION_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/base_engine.h"
+
+namespace sushi {
+namespace engine {
+
+/**
+ * @brief What a plugin was created from, needed to create it again on restore and
+ *        to tell if a loaded plugin with the same name can be reused.
+ */
+struct PluginInfo
+{
+    std::string uid;
+    std::string path;
+    PluginType type{PluginType::INTERNAL};
+
+    bool operator==(const PluginInfo& other) const
+    {
+        return uid == other.uid && path == other.path && type == other.type;
+    }
+    bool operator!=(const PluginInfo& other) const {return !(*this == other);}
+};
+
+/**
+ * @brief The tracks, processors and audio connections of the engine together with the
+ *        bypass, program, parameter and property state of every processor. Processors and parameters
+ *        are referred to by name so that a snapshot stays valid between sessions.
+ */
+struct SessionSnapshot
+{
+    struct ParameterState
+    {
+        std::string name;
+        float value;       // Normalised
+    };
+
+    struct StringPropertyState
+    {
+        std::string name;
+        std::string value;
+    };
+
+    struct DataPropertyState
+    {
+        std::string name;
+        std::vector<uint8_t> value;
+    };
+
+    struct ProcessorState
+    {
+        std::string name;
+        PluginInfo plugin;
+        bool bypassed{false};
+        bool has_program{false};
+        int program{0};
+        std::vector<ParameterState> parameters;
+        std::vector<StringPropertyState> string_properties;
+        std::vector<DataPropertyState> data_properties;
+    };
+
+    struct TrackState
+    {
+        ProcessorState track;   // The track's own parameters, plugin info is not used
+        int channels{2};
+        int input_busses{1};
+        int output_busses{1};
+        std::vector<ProcessorState> processors; // In processing order
+    };
+
+    struct AudioConnection
+    {
+        int engine_channel;
+        int track_channel;
+        std::string track;
+    };
+
+    std::vector<TrackState> tracks;
+    std::vector<AudioConnection> input_connections;
+    std::vector<AudioConnection> output_connections;
+
+    /**
+     * @brief Serialise the snapshot to a compact, versioned binary format
+     * @return The binary representation
+     */
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Read back a snapshot from a binary blob created by serialize()
+     * @param data The binary data
+     * @return true and the snapshot if the data was valid, false otherwise
+     */
+    static std::pair<bool, SessionSnapshot> deserialize(const std::vector<uint8_t>& data);
+
+    /**
+     * @brief Capture the bypass, program, parameter and property state of a processor
+     * @param processor The processor to capture
+     * @param plugin What the processor was created from
+     * @return The state of the processor
+     */
+    static ProcessorState capture_processor(const Processor& processor, const PluginInfo& plugin);
+};
+
+} // end namespace engine
+} // end namespace sushi
+
+#endif //SUSHI_SESSION_SNAPSHOT_H
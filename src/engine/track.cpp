@@ -22,6 +22,7 @@
 
 #include "track.h"
 #include "logging.h"
+#include "library/rt_safety.h"
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("track");
 
@@ -94,11 +95,11 @@ void Track::configure(float sample_rate)
 {
     for (auto& i : _pan_gain_smoothers_right)
     {
-        i.set_lag_time(PAN_GAIN_SMOOTHING_TIME, sample_rate / AUDIO_CHUNK_SIZE);
+        i.set_lag_time(PAN_GAIN_SMOOTHING_TIME, sample_rate / audio_chunk_size());
     }
     for (auto& i : _pan_gain_smoothers_left)
     {
-        i.set_lag_time(PAN_GAIN_SMOOTHING_TIME, sample_rate / AUDIO_CHUNK_SIZE);
+        i.set_lag_time(PAN_GAIN_SMOOTHING_TIME, sample_rate / audio_chunk_size());
     }
 }
 
@@ -143,6 +144,7 @@ void Track::render()
 void Track::process_audio(const ChunkSampleBuffer& /*in*/, ChunkSampleBuffer& out)
 {
     auto track_timestamp = _timer->start_timer();
+    rt_safety::ScopedProcessorMarker track_marker(this->id());
     /* For Tracks, process function is called from render() and the input audio data
      * should be copied to _input_buffer prior to this call.
      * We alias the buffers so we can swap them cheaply, without copying the underlying
@@ -154,6 +156,7 @@ void Track::process_audio(const ChunkSampleBuffer& /*in*/, ChunkSampleBuffer& ou
     for (auto &processor : _processors)
     {
         auto processor_timestamp = _timer->start_timer();
+        rt_safety::ScopedProcessorMarker processor_marker(processor->id());
         while (!_kb_event_buffer.empty())
         {
             RtEvent event;
@@ -200,6 +200,12 @@ public:
         _update_channel_config();
     }
 
+    /**
+     * @brief Get the processors on the track in processing order. The chain is modified
+     *        from the audio thread so only call when no edits can happen concurrently,
+     *        use the engine's graph snapshot for queries from other threads.
+     * @return A copy of the process chain
+     */
     const std::vector<Processor*> process_chain()
     {
         return _processors;
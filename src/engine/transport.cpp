@@ -18,13 +18,14 @@
  * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
 #include "link_include.h"
 
 #include "library/rt_event.h"
-#include "library/constants.h"
+#include "library/chunk_size.h"
 #include "transport.h"
 #include "logging.h"
 
@@ -33,10 +34,20 @@ namespace engine {
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("transport");
 
-void peer_callback([[maybe_unused]] size_t peers)
-{
-    SUSHI_LOG_INFO("Ableton link reports {} peers connected ", peers);
-}
+/* Bandwidth of the clock recovery loop in Hz. Lower values give a more stable tempo from
+ * a jittery clock, but make the transport follow tempo changes more slowly */
+constexpr double CLOCK_SYNC_BANDWIDTH = 1.0;
+/* Upper limit of the bandwidth relative to the tick rate, keeps the loop stable with
+ * clocks with few ticks per quarter note */
+constexpr double MAX_CLOCK_SYNC_BANDWIDTH_PER_TICK = 0.1;
+/* A tick interval differing more than this from the filtered period, relative to the
+ * period, is treated as a jump in tempo and the loop locks to the new tempo immediately */
+constexpr double CLOCK_SYNC_RELOCK_THRESHOLD = 0.25;
+/* The clock is considered lost if no tick arrives for this many tick periods */
+constexpr double CLOCK_SYNC_TIMEOUT_TICKS = 4.0;
+/* Minimum time in seconds between tempo notifications, a tempo that follows an external
+ * clock could otherwise change every chunk */
+constexpr double TEMPO_NOTIFICATION_INTERVAL = 0.25;
 
 void tempo_callback([[maybe_unused]] double tempo)
 {
@@ -52,7 +63,12 @@ void start_stop_callback([[maybe_unused]] bool playing)
 Transport::Transport(float sample_rate) : _samplerate(sample_rate),
                                           _link_controller(std::make_unique<ableton::Link>(DEFAULT_TEMPO))
 {
-    _link_controller->setNumPeersCallback(peer_callback);
+    /* Link calls this from its own thread, the rt thread picks up the new value in set_time() */
+    _link_controller->setNumPeersCallback([this](size_t peers)
+    {
+        SUSHI_LOG_INFO("Ableton link reports {} peers connected ", peers);
+        _link_peers.store(static_cast<int>(peers), std::memory_order_relaxed);
+    });
     _link_controller->setTempoCallback(tempo_callback);
     _link_controller->setStartStopCallback(start_stop_callback);
     _link_controller->enableStartStopSync(true);
@@ -71,18 +87,26 @@ void Transport::set_time(Time timestamp, int64_t samples)
 
     switch (_syncmode)
     {
-        case SyncMode::MIDI:       // Midi and Gate not implemented, so treat like internal
-        case SyncMode::GATE_INPUT:
         case SyncMode::INTERNAL:
             _update_internal_sync(samples - prev_samples);
             break;
 
+        case SyncMode::MIDI:
+        case SyncMode::GATE_INPUT:
+            _update_clock_sync();
+            break;
+
         case SyncMode::ABLETON_LINK:
         {
             _update_link_sync(_time);
             break;
         }
     }
+
+    if (_event_output)
+    {
+        _output_notifications();
+    }
 }
 
 void Transport::process_event(const RtEvent& event)
@@ -109,8 +133,20 @@ void Transport::process_event(const RtEvent& event)
                 _syncmode = SyncMode::INTERNAL;
             }
 #endif
+            _clock = ClockSync();
+            _link_join_pending = _syncmode == SyncMode::ABLETON_LINK;
             break;
 
+        case RtEventType::SYNC_CLOCK:
+        {
+            auto typed_event = event.sync_clock_event();
+            if (typed_event->source() == _syncmode)
+            {
+                _process_clock_event(typed_event);
+            }
+            break;
+        }
+
         default:
             break;
     }
@@ -131,23 +167,16 @@ void Transport::set_tempo(float tempo, bool update_via_event)
     if (update_via_event == false)
     {
         _set_tempo = tempo;
-        _tempo = tempo;
+        /* With Link, the new tempo is committed to the session from the rt thread */
+        if (_syncmode != SyncMode::ABLETON_LINK)
+        {
+            _tempo = tempo;
+        }
     }
-    _set_link_tempo(tempo);
 }
 
 void Transport::set_playing_mode(PlayingMode mode, bool update_via_event)
 {
-    bool playing = mode != PlayingMode::STOPPED;
-    bool update = this->playing() != playing;
-    if (update)
-    {
-        if (_link_controller->isEnabled())
-        {
-            _set_link_playing(playing);
-        }
-    }
-
     if (update_via_event == false)
     {
         _set_playmode = mode;
@@ -173,12 +202,13 @@ void Transport::set_sync_mode(SyncMode mode, bool update_via_event)
 
         case SyncMode::ABLETON_LINK:
             _link_controller->enable(true);
-            _set_link_playing(_set_playmode != PlayingMode::STOPPED);
             break;
     }
     if (update_via_event == false)
     {
         _syncmode = mode;
+        _clock = ClockSync();
+        _link_join_pending = _syncmode == SyncMode::ABLETON_LINK;
     }
 }
 
@@ -186,7 +216,7 @@ double Transport::current_bar_beats(int samples) const
 {
     if (_playmode != PlayingMode::STOPPED)
     {
-        double offset = _beats_per_chunk * static_cast<double>(samples) / AUDIO_CHUNK_SIZE;
+        double offset = _beats_per_chunk * static_cast<double>(samples) / audio_chunk_size();
         return std::fmod(_current_bar_beat_count + offset, _beats_per_bar);
     }
     return _current_bar_beat_count;
@@ -196,7 +226,7 @@ double Transport::current_beats(int samples) const
 {
     if (_playmode != PlayingMode::STOPPED)
     {
-        return _beat_count + _beats_per_chunk * static_cast<double>(samples) / AUDIO_CHUNK_SIZE;
+        return _beat_count + _beats_per_chunk * static_cast<double>(samples) / audio_chunk_size();
     }
     return _beat_count;
 }
@@ -211,36 +241,198 @@ void Transport::_update_internals()
                             static_cast<float>(_time_signature.denominator);
 }
 
-void Transport::_update_internal_sync(int64_t samples)
+void Transport::_update_play_state()
 {
-    /* Assume that if there are missed callbacks, the numbers of samples
-     * will still be a multiple of AUDIO_CHUNK_SIZE */
-    auto chunks_passed = samples / AUDIO_CHUNK_SIZE;
-
     if (_playmode != _set_playmode)
     {
         _state_change = _set_playmode == PlayingMode::STOPPED? PlayStateChange::STOPPING : PlayStateChange::STARTING;
         _playmode = _set_playmode;
     }
+}
 
-    _beats_per_chunk =  _set_tempo / 60.0 * static_cast<double>(AUDIO_CHUNK_SIZE) / _samplerate;
+void Transport::_advance_beats(double beats)
+{
+    _current_bar_beat_count += beats;
+    if (_current_bar_beat_count > _beats_per_bar)
+    {
+        _current_bar_beat_count = std::fmod(_current_bar_beat_count, _beats_per_bar);
+        _bar_start_beat_count += _beats_per_bar;
+    }
+    _beat_count += beats;
+}
+
+void Transport::_update_internal_sync(int64_t samples)
+{
+    /* Assume that if there are missed callbacks, the numbers of samples
+     * will still be a multiple of audio_chunk_size() */
+    auto chunks_passed = samples / audio_chunk_size();
+
+    _update_play_state();
+
+    _beats_per_chunk =  _set_tempo / 60.0 * static_cast<double>(audio_chunk_size()) / _samplerate;
     if (_playmode != PlayingMode::STOPPED)
     {
-        _current_bar_beat_count += chunks_passed * _beats_per_chunk;
-        if (_current_bar_beat_count > _beats_per_bar)
+        _advance_beats(chunks_passed * _beats_per_chunk);
+    }
+
+    _tempo = _set_tempo;
+}
+
+void Transport::_update_clock_sync()
+{
+    auto now = static_cast<double>(_sample_count);
+    if (_clock.ticks > 1 && now - _clock.last_tick_time > CLOCK_SYNC_TIMEOUT_TICKS * _clock.period)
+    {
+        /* The clock has stopped or was disconnected, keep the last tempo and hold the
+         * position until it is acquired again */
+        _clock.ticks = 0;
+    }
+
+    _update_play_state();
+
+    if (_clock.ticks > 1)
+    {
+        _tempo = static_cast<float>(60.0 * _samplerate / (_clock.period * _clock.ppq));
+        _set_tempo = _tempo;
+    }
+    _beats_per_chunk =  _tempo / 60.0 * static_cast<double>(audio_chunk_size()) / _samplerate;
+
+    if (_clock.restart)
+    {
+        /* A start message rewinds to the beginning, the first tick following it is beat 0 */
+        _rewind();
+    }
+    else if (_playmode != PlayingMode::STOPPED && _clock.ticks > 1)
+    {
+        /* Interpolate between ticks using the filtered tick times. The position never
+         * passes the next tick before it has arrived and never moves backwards, even
+         * if a tick arrives slightly later than predicted */
+        double phase = (now - _clock.tick_time) / (_clock.next_tick_time - _clock.tick_time);
+        double beats = _clock.tick_beats + std::clamp(phase, 0.0, 1.0) / _clock.ppq;
+        if (beats > _beat_count)
         {
-            _current_bar_beat_count = std::fmod(_current_bar_beat_count, _beats_per_bar);
-            _bar_start_beat_count += _beats_per_bar;
+            _advance_beats(beats - _beat_count);
         }
-        _beat_count += chunks_passed * _beats_per_chunk;
     }
+}
 
-    _tempo = _set_tempo;
+void Transport::_rewind()
+{
+    _beat_count = 0.0;
+    _current_bar_beat_count = 0.0;
+    _bar_start_beat_count = 0.0;
+}
+
+void Transport::_process_clock_event(const SyncClockRtEvent* event)
+{
+    switch (event->clock_type())
+    {
+        case SyncClockRtEvent::ClockType::TICK:
+            _process_clock_tick(static_cast<double>(_sample_count + event->sample_offset()), event->ppq_ticks());
+            break;
+
+        case SyncClockRtEvent::ClockType::START:
+            _set_playmode = PlayingMode::PLAYING;
+            _clock.restart = true;
+            break;
+
+        case SyncClockRtEvent::ClockType::CONTINUE:
+            _set_playmode = PlayingMode::PLAYING;
+            break;
+
+        case SyncClockRtEvent::ClockType::STOP:
+            _set_playmode = PlayingMode::STOPPED;
+            break;
+    }
+}
+
+void Transport::_process_clock_tick(double time, int ppq)
+{
+    if (ppq <= 0)
+    {
+        return;
+    }
+    if (ppq != _clock.ppq)
+    {
+        /* A start message may have arrived before the first tick at the new rate */
+        bool restart = _clock.restart;
+        _clock = ClockSync();
+        _clock.ppq = ppq;
+        _clock.restart = restart;
+    }
+
+    if (_clock.restart)
+    {
+        /* The start message may have arrived in the same chunk as this tick */
+        _rewind();
+        _clock.tick_beats = 0.0;
+        _clock.restart = false;
+    }
+    else if (_clock.ticks == 0)
+    {
+        /* Continue from the current position when the clock is acquired */
+        _clock.tick_beats = _beat_count;
+    }
+    else if (_set_playmode != PlayingMode::STOPPED)
+    {
+        _clock.tick_beats += 1.0 / ppq;
+    }
+
+    double interval = time - _clock.last_tick_time;
+    if (_clock.ticks > 0 && interval <= 0.0)
+    {
+        /* Ticks that are not timestamped may arrive several in the same chunk, these
+         * only advance the position */
+        return;
+    }
+    if (_clock.ticks < 2 || std::abs(interval - _clock.period) > CLOCK_SYNC_RELOCK_THRESHOLD * _clock.period)
+    {
+        _clock.period = interval;
+        _clock.tick_time = time;
+        _clock.next_tick_time = time + interval;
+    }
+    else
+    {
+        /* Second order delay locked loop with a damping factor of 1/sqrt(2) */
+        double omega = 2.0 * M_PI * std::min(CLOCK_SYNC_BANDWIDTH * _clock.period / _samplerate,
+                                             MAX_CLOCK_SYNC_BANDWIDTH_PER_TICK);
+        double error = time - _clock.next_tick_time;
+        _clock.tick_time = _clock.next_tick_time;
+        _clock.next_tick_time += M_SQRT2 * omega * error + _clock.period;
+        _clock.period += omega * omega * error;
+    }
+    _clock.last_tick_time = time;
+    _clock.ticks++;
 }
 
 void Transport::_update_link_sync(Time timestamp)
 {
+    /* All changes to the session are made here, using the Link functions that are safe to
+     * call from the rt thread. Tempo and playing mode changes requested from other threads
+     * arrive here as RtEvents, and are committed to the session on the next chunk */
     auto session = _link_controller->captureAudioSessionState();
+    bool commit = false;
+    if (_set_tempo != _tempo)
+    {
+        session.setTempo(_set_tempo, timestamp);
+        commit = true;
+    }
+    bool set_playing = _set_playmode != PlayingMode::STOPPED;
+    if (set_playing != this->playing() || (_link_join_pending && set_playing))
+    {
+        session.setIsPlaying(set_playing, timestamp);
+        if (set_playing)
+        {
+            session.requestBeatAtTime(_beat_count, timestamp, _beats_per_bar);
+        }
+        commit = true;
+    }
+    _link_join_pending = false;
+    if (commit)
+    {
+        _link_controller->commitAudioSessionState(session);
+    }
+
     _tempo = static_cast<float>(session.tempo());
     _set_tempo = _tempo;
 
@@ -252,43 +444,34 @@ void Transport::_update_link_sync(Time timestamp)
         _set_playmode = new_playmode;
     }
 
-    _beats_per_chunk =  _tempo / 60.0 * static_cast<double>(AUDIO_CHUNK_SIZE) / _samplerate;
+    _beats_per_chunk =  _tempo / 60.0 * static_cast<double>(audio_chunk_size()) / _samplerate;
     if (session.isPlaying())
     {
         _beat_count = session.beatAtTime(timestamp, _beats_per_bar);
         _current_bar_beat_count = session.phaseAtTime(timestamp, _beats_per_bar);
         _bar_start_beat_count = _beat_count - _current_bar_beat_count;
     }
-
-    /* Due to the nature of the Xenomai RT architecture we cannot commit changes to
-     * the session here as that would cause a mode switch. Instead all changes need
-     * to be made from the non rt thread */
 }
-#ifdef SUSHI_BUILD_WITH_ABLETON_LINK
-void Transport::_set_link_playing(bool playing)
+
+void Transport::_output_notifications()
 {
-    auto session = _link_controller->captureAppSessionState();
-    session.setIsPlaying(playing, _time);
-    if (playing)
+    if (_state_change != PlayStateChange::UNCHANGED)
     {
-        session.requestBeatAtTime(_beat_count, _time, _beats_per_bar);
+        _event_output->send_event(RtEvent::make_playing_mode_event(0, _playmode));
+    }
+    if (_tempo != _notified_tempo && _sample_count >= _next_tempo_notification)
+    {
+        _event_output->send_event(RtEvent::make_tempo_event(0, _tempo));
+        _notified_tempo = _tempo;
+        _next_tempo_notification = _sample_count + static_cast<int64_t>(TEMPO_NOTIFICATION_INTERVAL * _samplerate);
+    }
+    int link_peers = _link_peers.load(std::memory_order_relaxed);
+    if (link_peers != _notified_link_peers)
+    {
+        _event_output->send_event(RtEvent::make_link_peers_notification_event(0, link_peers));
+        _notified_link_peers = link_peers;
     }
-    _link_controller->commitAppSessionState(session);
-}
-
-void Transport::_set_link_tempo(float tempo)
-{
-    auto state = _link_controller->captureAppSessionState();
-    state.setTempo(tempo, this->current_process_time());
-    _link_controller->commitAudioSessionState(state);
 }
-#else
-void Transport::_set_link_playing(bool /*playing*/) {}
-void Transport::_set_link_tempo(float /*tempo*/) {}
-#endif
-
-
-
 
 } // namespace engine
 } // namespace sushi
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "library/time.h"
 #include "library/types.h"
 #include "library/rt_event.h"
+#include "library/rt_event_pipe.h"
 
 /* Forward declare Link, then we can include link.hpp from transport.cpp and
  * nowhere else, it pulls in a lot of dependencies that slow down compilation
@@ -73,6 +74,14 @@ public:
         _latency = output_latency;
     }
 
+    /**
+     * @brief Set where to send notifications of changes to the tempo, the playing mode and
+     *        the number of Link peers. These are sent as RtEvents from set_time(), i.e. from
+     *        the audio thread.
+     * @param output The RtEventPipe to send notifications to
+     */
+    void set_event_output(RtEventPipe* output) {_event_output = output;}
+
     /**
      * @brief Process a single realtime event that is to take place during the current audio
      * interrupt
@@ -209,11 +218,32 @@ public:
     PlayStateChange current_state_change() const {return _state_change;}
 
 private:
+    /* State of the clock recovery used when following an external clock. The time of
+     * each incoming tick is filtered through a delay locked loop, which gives a smoothed
+     * tick period and a prediction of when the next tick will arrive. All times are in
+     * samples */
+    struct ClockSync
+    {
+        int    ppq{0};
+        int    ticks{0};                /* Ticks received since the clock was last acquired */
+        bool   restart{false};          /* Waiting for the first tick after a start message */
+        double last_tick_time{0};       /* Actual time of the last tick */
+        double tick_time{0};            /* Filtered time of the last tick */
+        double next_tick_time{0};       /* Predicted time of the next tick */
+        double period{0};               /* Filtered tick period */
+        double tick_beats{0};           /* Position of the last tick in beats */
+    };
+
     void _update_internals();
+    void _update_play_state();
+    void _advance_beats(double beats);
     void _update_internal_sync(int64_t samples);
+    void _update_clock_sync();
+    void _rewind();
+    void _process_clock_event(const SyncClockRtEvent* event);
+    void _process_clock_tick(double time, int ppq);
     void _update_link_sync(Time timestamp);
-    void _set_link_playing(bool playing);
-    void _set_link_tempo(float tempo);
+    void _output_notifications();
 
     int64_t         _sample_count{0};
     Time            _time{0};
@@ -232,6 +262,16 @@ private:
     SyncMode        _syncmode{SyncMode::INTERNAL};
     TimeSignature   _time_signature{4, 4};
     PlayStateChange _state_change{PlayStateChange::STARTING};
+    ClockSync       _clock;
+    bool            _link_join_pending{false};
+
+    RtEventPipe*    _event_output{nullptr};
+    float           _notified_tempo{DEFAULT_TEMPO};
+    int64_t         _next_tempo_notification{0};
+    int             _notified_link_peers{0};
+
+    /* Written from Link's thread when peers connect or disconnect */
+    std::atomic<int> _link_peers{0};
 
     std::unique_ptr<ableton::Link>  _link_controller;
 };
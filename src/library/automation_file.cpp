@@ -0,0 +1,202 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Compact binary format for parameter automation used in offline mode
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "library/automation_file.h"
+#include "logging.h"
+
+namespace sushi {
+namespace automation_file {
+
+SUSHI_GET_LOGGER_WITH_MODULE_NAME("automation file");
+
+constexpr char MAGIC[] = {'S', 'U', 'S', 'H', 'I', 'A', 'U', 'T'};
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(uint32_t);
+constexpr size_t EVENT_SIZE = sizeof(int64_t) + sizeof(uint32_t) + sizeof(float);
+
+namespace {
+
+template <typename T>
+void write_value(std::vector<uint8_t>& data, T value)
+{
+    static_assert(sizeof(T) <= sizeof(uint64_t));
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        data.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void write_string(std::vector<uint8_t>& data, const std::string& string)
+{
+    write_value<uint16_t>(data, static_cast<uint16_t>(string.size()));
+    data.insert(data.end(), string.begin(), string.end());
+}
+
+/* Bounds checked little endian reader, any read past the end sets the error flag */
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : _data(data) {}
+
+    template <typename T>
+    T read()
+    {
+        if (sizeof(T) > _data.size() - _pos)
+        {
+            _error = true;
+            _pos = _data.size();
+            return T();
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            bits |= static_cast<uint64_t>(_data[_pos++]) << (8 * i);
+        }
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    std::string read_string()
+    {
+        auto length = read<uint16_t>();
+        if (length > _data.size() - _pos)
+        {
+            _error = true;
+            _pos = _data.size();
+            return std::string();
+        }
+        std::string string(_data.begin() + _pos, _data.begin() + _pos + length);
+        _pos += length;
+        return string;
+    }
+
+    size_t remaining() const {return _data.size() - _pos;}
+
+    bool error() const {return _error;}
+
+private:
+    const std::vector<uint8_t>& _data;
+    size_t _pos{0};
+    bool _error{false};
+};
+
+} // anonymous namespace
+
+std::pair<AutomationFileStatus, AutomationData> parse_automation_data(const std::vector<uint8_t>& data)
+{
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+    {
+        SUSHI_LOG_ERROR("Not an automation file");
+        return {AutomationFileStatus::INVALID_FORMAT, {}};
+    }
+    Reader reader(data);
+    reader.read<uint64_t>(); // Magic
+    auto version = reader.read<uint32_t>();
+    if (version != AUTOMATION_FILE_VERSION)
+    {
+        SUSHI_LOG_ERROR("Unsupported automation file version {}", version);
+        return {AutomationFileStatus::INVALID_FORMAT, {}};
+    }
+    auto parameter_count = reader.read<uint32_t>();
+    auto event_count = reader.read<uint32_t>();
+
+    AutomationData automation;
+    for (uint32_t i = 0; i < parameter_count && reader.error() == false; ++i)
+    {
+        auto processor = reader.read_string();
+        auto parameter = reader.read_string();
+        automation.parameters.push_back({std::move(processor), std::move(parameter)});
+    }
+    if (reader.error() || reader.remaining() != event_count * EVENT_SIZE)
+    {
+        SUSHI_LOG_ERROR("Automation file size does not match its header");
+        return {AutomationFileStatus::INVALID_FORMAT, {}};
+    }
+    automation.events.reserve(event_count);
+    for (uint32_t i = 0; i < event_count; ++i)
+    {
+        AutomationEvent event;
+        event.sample = reader.read<int64_t>();
+        event.parameter = reader.read<uint32_t>();
+        event.value = reader.read<float>();
+        if (event.parameter >= parameter_count)
+        {
+            SUSHI_LOG_ERROR("Invalid parameter index {} in automation file", event.parameter);
+            return {AutomationFileStatus::INVALID_FORMAT, {}};
+        }
+        automation.events.push_back(event);
+    }
+    return {AutomationFileStatus::OK, std::move(automation)};
+}
+
+std::vector<uint8_t> serialise_automation_data(const AutomationData& automation)
+{
+    std::vector<uint8_t> data(std::begin(MAGIC), std::end(MAGIC));
+    data.reserve(HEADER_SIZE + automation.events.size() * EVENT_SIZE);
+    write_value<uint32_t>(data, AUTOMATION_FILE_VERSION);
+    write_value<uint32_t>(data, static_cast<uint32_t>(automation.parameters.size()));
+    write_value<uint32_t>(data, static_cast<uint32_t>(automation.events.size()));
+    for (const auto& parameter : automation.parameters)
+    {
+        write_string(data, parameter.processor);
+        write_string(data, parameter.parameter);
+    }
+    for (const auto& event : automation.events)
+    {
+        write_value<int64_t>(data, event.sample);
+        write_value<uint32_t>(data, event.parameter);
+        write_value<float>(data, event.value);
+    }
+    return data;
+}
+
+std::pair<AutomationFileStatus, AutomationData> read_automation_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (file.good() == false)
+    {
+        SUSHI_LOG_ERROR("Unable to open automation file {}", filename);
+        return {AutomationFileStatus::INVALID_FILE, {}};
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parse_automation_data(data);
+}
+
+AutomationFileStatus write_automation_file(const std::string& filename, const AutomationData& automation)
+{
+    std::ofstream file(filename, std::ios::binary);
+    auto data = serialise_automation_data(automation);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (file.good() == false)
+    {
+        SUSHI_LOG_ERROR("Failed to write automation file {}", filename);
+        return AutomationFileStatus::INVALID_FILE;
+    }
+    return AutomationFileStatus::OK;
+}
+
+} // end namespace automation_file
+} // end namespace sushi
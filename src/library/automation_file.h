@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Compact binary format for parameter automation used in offline mode
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ *
+ * All values are little endian. A file consists of:
+ *   Header:     "SUSHIAUT" | uint32 version | uint32 parameter count | uint32 event count
+ *   Parameters: uint16 length | processor name | uint16 length | parameter name, for each parameter
+ *   Events:     int64 sample position | uint32 parameter index | float32 value, for each event
+ */
+
+#ifndef SUSHI_AUTOMATION_FILE_H
+#define SUSHI_AUTOMATION_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sushi {
+namespace automation_file {
+
+constexpr uint32_t AUTOMATION_FILE_VERSION = 1;
+
+enum class AutomationFileStatus
+{
+    OK,
+    INVALID_FILE,
+    INVALID_FORMAT
+};
+
+struct AutomationParameter
+{
+    std::string processor;
+    std::string parameter;
+};
+
+struct AutomationEvent
+{
+    int64_t sample;     // Position in samples from the start of processing
+    uint32_t parameter; // Index into the parameter table
+    float value;
+};
+
+struct AutomationData
+{
+    std::vector<AutomationParameter> parameters;
+    std::vector<AutomationEvent> events;
+};
+
+/**
+ * @brief Parse binary automation data
+ * @param data The contents of an automation file
+ * @return OK and the parsed automation data, or an error status
+ */
+std::pair<AutomationFileStatus, AutomationData> parse_automation_data(const std::vector<uint8_t>& data);
+
+/**
+ * @brief Convert automation data to its binary representation
+ * @param automation The automation data to serialise, all event parameter indexes must
+ *        refer to entries in the parameter table
+ * @return The binary representation
+ */
+std::vector<uint8_t> serialise_automation_data(const AutomationData& automation);
+
+/**
+ * @brief Read and parse an automation file
+ * @param filename Path to the automation file
+ * @return OK and the parsed automation data, or an error status
+ */
+std::pair<AutomationFileStatus, AutomationData> read_automation_file(const std::string& filename);
+
+/**
+ * @brief Write automation data to a file
+ * @param filename Path to the automation file
+ * @param automation The automation data to write
+ * @return OK if the file was successfully written, INVALID_FILE otherwise
+ */
+AutomationFileStatus write_automation_file(const std::string& filename, const AutomationData& automation);
+
+} // end namespace automation_file
+} // end namespace sushi
+
+#endif //SUSHI_AUTOMATION_FILE_H
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Runtime selectable audio chunk size
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_CHUNK_SIZE_H
+#define SUSHI_CHUNK_SIZE_H
+
+#include <utility>
+#include <type_traits>
+
+#include "constants.h"
+
+namespace sushi {
+
+namespace chunk_size_internal {
+inline int current_chunk_size{AUDIO_CHUNK_SIZE};
+}
+
+/**
+ * @brief Get the number of samples processed in one chunk. Always a power of 2 in the
+ *        range [MIN_AUDIO_CHUNK_SIZE, AUDIO_CHUNK_SIZE].
+ * @return The current audio chunk size in samples
+ */
+inline int audio_chunk_size()
+{
+    return chunk_size_internal::current_chunk_size;
+}
+
+/**
+ * @brief Check if a chunk size can be used for processing
+ * @param chunk_size The chunk size in samples
+ * @return true if chunk_size is a power of 2 in the range [MIN_AUDIO_CHUNK_SIZE, AUDIO_CHUNK_SIZE]
+ */
+constexpr bool valid_audio_chunk_size(int chunk_size)
+{
+    return chunk_size >= MIN_AUDIO_CHUNK_SIZE &&
+           chunk_size <= AUDIO_CHUNK_SIZE &&
+           (chunk_size & (chunk_size - 1)) == 0;
+}
+
+/**
+ * @brief Set the number of samples processed in one chunk. Must be called before creating
+ *        the engine, the audio frontends and any processors as buffers and processors
+ *        use the current chunk size when they are set up. Not thread safe.
+ * @param chunk_size The new chunk size in samples
+ * @return true if the chunk size was valid and set, false otherwise
+ */
+inline bool set_audio_chunk_size(int chunk_size)
+{
+    if (valid_audio_chunk_size(chunk_size) == false)
+    {
+        return false;
+    }
+    chunk_size_internal::current_chunk_size = chunk_size;
+    return true;
+}
+
+/**
+ * @brief Call a processing function with the number of samples to process given as a
+ *        compile time constant for the most common chunk sizes, and as a regular int
+ *        otherwise. Gives the compiler the chance to fully unroll and vectorise inner
+ *        loops of the most performance critical functions while still supporting any
+ *        chunk size selected at runtime.
+ * @param samples The number of samples to process
+ * @param function A callable taking the number of samples as its only argument, typically
+ *                 a generic lambda.
+ */
+template <typename Function>
+inline void with_static_chunk_size(int samples, Function&& function)
+{
+    switch (samples)
+    {
+        case 32:
+            function(std::integral_constant<int, 32>());
+            break;
+
+        case 64:
+            function(std::integral_constant<int, 64>());
+            break;
+
+        case 128:
+            function(std::integral_constant<int, 128>());
+            break;
+
+        default:
+            function(samples);
+    }
+}
+
+} // namespace sushi
+
+#endif //SUSHI_CHUNK_SIZE_H
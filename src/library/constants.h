@@ -21,17 +21,22 @@
 #ifndef SUSHI_CONSTANTS_H
 #define SUSHI_CONSTANTS_H
 
-/* The number of samples to process in one chunk. It is defined as a
-compile time constant to give more room for optimizations */
+/* The maximum number of samples to process in one chunk. It is defined as a
+compile time constant to give more room for optimizations. The actual number
+of samples processed per chunk can be lowered at runtime, see chunk_size.h */
 #ifdef SUSHI_CUSTOM_AUDIO_CHUNK_SIZE
 constexpr int AUDIO_CHUNK_SIZE = SUSHI_CUSTOM_AUDIO_CHUNK_SIZE;
 #else
 constexpr int AUDIO_CHUNK_SIZE = 64;
 #endif
 
+/* The smallest chunk size selectable at runtime */
+constexpr int MIN_AUDIO_CHUNK_SIZE = 8;
+
 constexpr int MAX_ENGINE_CV_IO_PORTS = 4;
 constexpr int MAX_ENGINE_GATE_PORTS = 8;
 constexpr int MAX_ENGINE_GATE_NOTE_NO = 127;
+constexpr int MAX_ENGINE_MIDI_EVENTS = 128;
 
 /* Use in class declaration to disallow copying of this class.
  * Note that this marks copy constructor and assignment operator
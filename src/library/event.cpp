@@ -145,6 +145,22 @@ Event* Event::from_rt_event(RtEvent& rt_event, Time timestamp)
                                                             ClippingNotificationEvent::ClipChannelType::OUTPUT;
             return new ClippingNotificationEvent(typed_ev->channel(), channel_type, timestamp);
         }
+        /* Transport events sent from the rt domain are notifications of changes */
+        case RtEventType::TEMPO:
+        {
+            auto typed_ev = rt_event.tempo_event();
+            return new TempoNotificationEvent(typed_ev->tempo(), timestamp);
+        }
+        case RtEventType::PLAYING_MODE:
+        {
+            auto typed_ev = rt_event.playing_mode_event();
+            return new PlayingModeNotificationEvent(typed_ev->mode(), timestamp);
+        }
+        case RtEventType::LINK_PEERS_NOTIFICATION:
+        {
+            auto typed_ev = rt_event.link_peers_notification_event();
+            return new LinkPeersNotificationEvent(typed_ev->peers(), timestamp);
+        }
         default:
             return nullptr;
 
@@ -202,6 +218,11 @@ RtEvent SetProcessorBypassEvent::to_rt_event(int /*sample_offset*/)
     return RtEvent::make_bypass_processor_event(this->processor_id(), this->bypass_enabled());
 }
 
+RtEvent SyncClockEvent::to_rt_event(int sample_offset)
+{
+    return RtEvent::make_sync_clock_event(sample_offset, _source, _clock_type, _ppq_ticks);
+}
+
 RtEvent StringPropertyChangeEvent::to_rt_event(int sample_offset)
 {
     /* String in RtEvent must be passed as a pointer allocated outside of the event */
@@ -88,6 +88,9 @@ public:
     /* Convertible to ParameterChangeNotification */
     virtual bool is_parameter_change_notification() {return false;}
 
+    /* Marks the end of a batch of ParameterChangeNotifications */
+    virtual bool is_parameter_notification_flush() {return false;}
+
     /* Convertible to EngineEvent */
     virtual bool is_engine_event() {return false;}
 
@@ -325,6 +328,19 @@ private:
     Subtype _subtype;
 };
 
+/**
+ * @brief Sent to parameter change listeners after each batch of parameter change
+ *        notifications so that listeners can buffer notifications and handle them
+ *        together, i.e. send them in one network packet.
+ */
+class ParameterNotificationFlushEvent : public Event
+{
+public:
+    explicit ParameterNotificationFlushEvent(Time timestamp) : Event(timestamp) {}
+
+    bool is_parameter_notification_flush() override {return true;}
+};
+
 class SetProcessorBypassEvent : public Event
 {
 public:
@@ -473,10 +489,24 @@ protected:
 class EngineNotificationEvent : public Event
 {
 public:
-     bool is_engine_notification() override {return true;}
+    enum class Subtype
+    {
+        CLIPPING,
+        TEMPO,
+        PLAYING_MODE,
+        LINK_PEERS
+    };
+
+    bool is_engine_notification() override {return true;}
+
+    Subtype subtype() const {return _subtype;}
 
 protected:
-    explicit EngineNotificationEvent(Time timestamp) : Event(timestamp) {}
+    EngineNotificationEvent(Subtype subtype, Time timestamp) : Event(timestamp),
+                                                               _subtype(subtype) {}
+
+private:
+    Subtype _subtype;
 };
 
 class ClippingNotificationEvent : public EngineNotificationEvent
@@ -487,7 +517,7 @@ public:
         INPUT,
         OUTPUT,
     };
-    ClippingNotificationEvent(int channel, ClipChannelType channel_type, Time timestamp) : EngineNotificationEvent(timestamp),
+    ClippingNotificationEvent(int channel, ClipChannelType channel_type, Time timestamp) : EngineNotificationEvent(Subtype::CLIPPING, timestamp),
                                                                                            _channel(channel),
                                                                                            _channel_type(channel_type) {}
     int channel() {return _channel;}
@@ -498,6 +528,39 @@ private:
     ClipChannelType _channel_type;
 };
 
+class TempoNotificationEvent : public EngineNotificationEvent
+{
+public:
+    TempoNotificationEvent(float tempo, Time timestamp) : EngineNotificationEvent(Subtype::TEMPO, timestamp),
+                                                          _tempo(tempo) {}
+    float tempo() {return _tempo;}
+
+private:
+    float _tempo;
+};
+
+class PlayingModeNotificationEvent : public EngineNotificationEvent
+{
+public:
+    PlayingModeNotificationEvent(PlayingMode mode, Time timestamp) : EngineNotificationEvent(Subtype::PLAYING_MODE, timestamp),
+                                                                     _mode(mode) {}
+    PlayingMode mode() {return _mode;}
+
+private:
+    PlayingMode _mode;
+};
+
+class LinkPeersNotificationEvent : public EngineNotificationEvent
+{
+public:
+    LinkPeersNotificationEvent(int peers, Time timestamp) : EngineNotificationEvent(Subtype::LINK_PEERS, timestamp),
+                                                            _peers(peers) {}
+    int peers() {return _peers;}
+
+private:
+    int _peers;
+};
+
 class AsynchronousWorkEvent : public Event
 {
 public:
@@ -613,6 +676,33 @@ public:
 private:
     SyncMode _mode;
 };
+
+/* Clock ticks and start/stop messages from an external sync source, these are passed
+ * directly to the rt part with sample accurate timing */
+class SyncClockEvent : public Event
+{
+public:
+    SyncClockEvent(SyncMode source,
+                   SyncClockRtEvent::ClockType clock_type,
+                   int ppq_ticks,
+                   Time timestamp) : Event(timestamp),
+                                     _source(source),
+                                     _clock_type(clock_type),
+                                     _ppq_ticks(ppq_ticks) {}
+
+    bool maps_to_rt_event() override {return true;}
+
+    RtEvent to_rt_event(int sample_offset) override;
+
+    SyncMode source() {return _source;}
+    SyncClockRtEvent::ClockType clock_type() {return _clock_type;}
+    int ppq_ticks() {return _ppq_ticks;}
+
+private:
+    SyncMode                    _source;
+    SyncClockRtEvent::ClockType _clock_type;
+    int                         _ppq_ticks;
+};
 } // end namespace sushi
 
 #endif //SUSHI_CONTROL_EVENT_H
@@ -38,13 +38,10 @@ FloatParameterValue* InternalPlugin::register_float_parameter(const std::string&
                                                               float default_value,
                                                               float min_value,
                                                               float max_value,
-                                                              FloatParameterPreProcessor* pre_proc)
+                                                              ParameterPreProcessor<float>* pre_proc)
 {
-    if (pre_proc == nullptr)
-    {
-        pre_proc = new FloatParameterPreProcessor(min_value, max_value);
-    }
-
+    /* Plain linear parameters don't need a preprocessor object once registered */
+    FloatParameterPreProcessor linear_pre_proc(min_value, max_value);
     auto param = new FloatParameterDescriptor(id, label, unit, min_value, max_value, pre_proc);
 
     if (this->register_parameter(param) == false)
@@ -52,10 +49,8 @@ FloatParameterValue* InternalPlugin::register_float_parameter(const std::string&
         return nullptr;
     }
 
-    auto value = ParameterStorage::make_float_parameter_storage(param, default_value, pre_proc);
-    /* The parameter id must match the value storage index*/
-    assert(param->id() == _parameter_values.size());
-    _parameter_values.push_back(value);
+    int index = _parameter_block.add_parameter(param, default_value, pre_proc ? pre_proc : &linear_pre_proc);
+    _add_parameter_storage(param, index);
 
     return _parameter_values.back().float_parameter_value();
 }
@@ -66,13 +61,9 @@ IntParameterValue* InternalPlugin::register_int_parameter(const std::string& id,
                                                           int default_value,
                                                           int min_value,
                                                           int max_value,
-                                                          IntParameterPreProcessor* pre_proc)
+                                                          ParameterPreProcessor<int>* pre_proc)
 {
-    if (pre_proc == nullptr)
-    {
-         pre_proc = new IntParameterPreProcessor(min_value, max_value);
-    }
-
+    IntParameterPreProcessor linear_pre_proc(min_value, max_value);
     auto param = new IntParameterDescriptor(id, label, unit, min_value, max_value, pre_proc);
 
     if (this->register_parameter(param) == false)
@@ -80,10 +71,8 @@ IntParameterValue* InternalPlugin::register_int_parameter(const std::string& id,
         return nullptr;
     }
 
-    auto value = ParameterStorage::make_int_parameter_storage(param, default_value, pre_proc);
-    /* The parameter id must match the value storage index*/
-    assert(param->id() == _parameter_values.size());
-    _parameter_values.push_back(value);
+    int index = _parameter_block.add_parameter(param, default_value, pre_proc ? pre_proc : &linear_pre_proc);
+    _add_parameter_storage(param, index);
 
     return _parameter_values.back().int_parameter_value();
 }
@@ -100,10 +89,8 @@ BoolParameterValue* InternalPlugin::register_bool_parameter(const std::string& i
         return nullptr;
     }
 
-    ParameterStorage value_storage = ParameterStorage::make_bool_parameter_storage(param, default_value);
-    /* The parameter id must match the value storage index*/
-    assert(param->id() == _parameter_values.size());
-    _parameter_values.push_back(value_storage);
+    int index = _parameter_block.add_bool_parameter(param, default_value);
+    _add_parameter_storage(param, index);
 
     return _parameter_values.back().bool_parameter_value();
 }
@@ -120,9 +107,10 @@ bool InternalPlugin::register_string_property(const std::string &id,
         return false;
     }
 
-    /* We don't provide a string value class but must push a dummy container here for ids to match */
-    ParameterStorage value_storage = ParameterStorage::make_bool_parameter_storage(param, false);
-    _parameter_values.push_back(value_storage);
+    /* We don't provide a string value class but must add a dummy value here for ids to match */
+    int index = _parameter_block.add_bool_parameter(param, false);
+    _add_parameter_storage(param, index);
+    set_string_property_value(param->id(), "");
     return true;
 }
 
@@ -137,9 +125,10 @@ bool InternalPlugin::register_data_property(const std::string &id,
     {
         return false;
     }
-    /* We don't provide a data value class but must push a dummy container here for ids to match */
-    ParameterStorage value_storage = ParameterStorage::make_bool_parameter_storage(param, false);
-    _parameter_values.push_back(value_storage);
+    /* We don't provide a data value class but must add a dummy value here for ids to match */
+    int index = _parameter_block.add_bool_parameter(param, false);
+    _add_parameter_storage(param, index);
+    set_data_property_value(param->id(), BlobData{0, nullptr});
     return true;
 }
 
@@ -156,33 +145,11 @@ void InternalPlugin::process_event(const RtEvent& event)
              * implementation for handling these and setting parameter values */
             auto typed_event = event.parameter_change_event();
 
-            if (typed_event->param_id() >= _parameter_values.size())
+            if (typed_event->param_id() >= static_cast<ObjectId>(_parameter_block.size()))
             {
                 break;
             }
-
-            auto storage = &_parameter_values[typed_event->param_id()];
-
-            switch (storage->type())
-            {
-                case ParameterType::FLOAT:
-                {
-                    storage->float_parameter_value()->set(typed_event->value());
-                    break;
-                }
-                case ParameterType::INT:
-                {
-                    storage->int_parameter_value()->set(typed_event->value());
-                    break;
-                }
-                case ParameterType::BOOL:
-                {
-                    storage->bool_parameter_value()->set_values(typed_event->value(), typed_event->value());
-                    break;
-                }
-                default:
-                    break;
-            }
+            _parameter_block.set_normalized(typed_event->param_id(), typed_event->value());
             break;
         }
 
@@ -197,101 +164,128 @@ void InternalPlugin::set_parameter_and_notify(FloatParameterValue* storage, floa
 
     if (maybe_output_cv_value(storage->descriptor()->id(), new_value) == false)
     {
-        auto e = RtEvent::make_parameter_change_event(this->id(), 0, storage->descriptor()->id(),
-                                                      storage->processed_value());
-        output_event(e);
+        output_parameter_notification(storage->descriptor()->id(), storage->processed_value());
     }
 }
 
 void InternalPlugin::set_parameter_and_notify(IntParameterValue* storage, int new_value)
 {
     storage->set(new_value);
-    auto e = RtEvent::make_parameter_change_event(this->id(), 0, storage->descriptor()->id(), storage->processed_value());
-    output_event(e);
+    output_parameter_notification(storage->descriptor()->id(), storage->processed_value());
 }
 
 void InternalPlugin::set_parameter_and_notify(BoolParameterValue* storage, bool new_value)
 {
     storage->set(new_value);
-    auto e = RtEvent::make_parameter_change_event(this->id(), 0, storage->descriptor()->id(), storage->processed_value());
-    output_event(e);
+    output_parameter_notification(storage->descriptor()->id(), storage->processed_value());
 }
 
 std::pair<ProcessorReturnCode, float> InternalPlugin::parameter_value(ObjectId parameter_id) const
 {
-    if (parameter_id >= _parameter_values.size())
+    if (parameter_id >= static_cast<ObjectId>(_parameter_block.size()))
     {
         return {ProcessorReturnCode::PARAMETER_NOT_FOUND, 0.0f};
     }
 
-    const auto& value_storage = _parameter_values[parameter_id];
-
-    if (value_storage.type() == ParameterType::FLOAT)
+    switch (_parameter_block.type(parameter_id))
     {
-        float norm_value = value_storage.float_parameter_value()->normalized_value();
-        return {ProcessorReturnCode::OK, norm_value};
-    }
-    else if (value_storage.type() == ParameterType::INT)
-    {
-        float norm_value = value_storage.int_parameter_value()->normalized_value();
-        return {ProcessorReturnCode::OK, norm_value};
-    }
-    else if (value_storage.type() == ParameterType::BOOL)
-    {
-        return {ProcessorReturnCode::OK, value_storage.bool_parameter_value()->domain_value() ? 1.0f : 0.0f};
-    }
+        case ParameterType::FLOAT:
+        case ParameterType::INT:
+            return {ProcessorReturnCode::OK, _parameter_block.normalized_value(parameter_id)};
+
+        case ParameterType::BOOL:
+            return {ProcessorReturnCode::OK, _parameter_block.processed_value(parameter_id)};
 
-    return {ProcessorReturnCode::PARAMETER_ERROR, 0.0f};
+        default:
+            return {ProcessorReturnCode::PARAMETER_ERROR, 0.0f};
+    }
 }
 
 std::pair<ProcessorReturnCode, float> InternalPlugin::parameter_value_in_domain(ObjectId parameter_id) const
 {
-    if (parameter_id >= _parameter_values.size())
+    if (parameter_id >= static_cast<ObjectId>(_parameter_block.size()))
     {
         return {ProcessorReturnCode::PARAMETER_NOT_FOUND, 0.0f};
     }
 
-    const auto& value_storage = _parameter_values[parameter_id];
-
-    if (value_storage.type() == ParameterType::FLOAT)
-    {
-        return {ProcessorReturnCode::OK, value_storage.float_parameter_value()->domain_value()};
-    }
-    else if (value_storage.type() == ParameterType::INT)
-    {
-        return {ProcessorReturnCode::OK, value_storage.int_parameter_value()->domain_value()};
-    }
-    else if (value_storage.type() == ParameterType::BOOL)
+    switch (_parameter_block.type(parameter_id))
     {
-        return {ProcessorReturnCode::OK, value_storage.bool_parameter_value()->domain_value() ? 1.0f : 0.0f};
-    }
+        case ParameterType::FLOAT:
+            return {ProcessorReturnCode::OK, _parameter_block.domain_value<float>(parameter_id)};
+
+        case ParameterType::INT:
+            return {ProcessorReturnCode::OK, _parameter_block.domain_value<int>(parameter_id)};
 
-    return {ProcessorReturnCode::PARAMETER_ERROR, 0};
+        case ParameterType::BOOL:
+            return {ProcessorReturnCode::OK, _parameter_block.processed_value(parameter_id)};
+
+        default:
+            return {ProcessorReturnCode::PARAMETER_ERROR, 0};
+    }
 }
 
 std::pair<ProcessorReturnCode, std::string> InternalPlugin::parameter_value_formatted(ObjectId parameter_id) const
 {
-    if (parameter_id >= _parameter_values.size())
+    if (parameter_id >= static_cast<ObjectId>(_parameter_block.size()))
     {
         return {ProcessorReturnCode::PARAMETER_NOT_FOUND, ""};
     }
 
-    const auto& value_storage = _parameter_values[parameter_id];
-
-    if (value_storage.type() == ParameterType::FLOAT)
+    switch (_parameter_block.type(parameter_id))
     {
-        return {ProcessorReturnCode::OK, std::to_string(value_storage.float_parameter_value()->domain_value())};
+        case ParameterType::FLOAT:
+            return {ProcessorReturnCode::OK, std::to_string(_parameter_block.domain_value<float>(parameter_id))};
+
+        case ParameterType::INT:
+            return {ProcessorReturnCode::OK, std::to_string(_parameter_block.domain_value<int>(parameter_id))};
+
+        case ParameterType::BOOL:
+            return {ProcessorReturnCode::OK, _parameter_block.processed_value(parameter_id) != 0.0f ? "True" : "False"};
+
+        default:
+            return {ProcessorReturnCode::PARAMETER_ERROR, ""};
     }
-    else if (value_storage.type() == ParameterType::INT)
+}
+
+std::pair<ProcessorReturnCode, std::string> InternalPlugin::string_property_value(ObjectId property_id) const
+{
+    std::scoped_lock lock(_property_lock);
+    auto value = _string_property_values.find(property_id);
+    if (value == _string_property_values.end())
     {
-        return {ProcessorReturnCode::OK, std::to_string(value_storage.int_parameter_value()->domain_value())};
+        return {ProcessorReturnCode::PARAMETER_NOT_FOUND, ""};
     }
-    else if (value_storage.type() == ParameterType::BOOL)
+    return {ProcessorReturnCode::OK, value->second};
+}
+
+std::pair<ProcessorReturnCode, std::vector<uint8_t>> InternalPlugin::data_property_value(ObjectId property_id) const
+{
+    std::scoped_lock lock(_property_lock);
+    auto value = _data_property_values.find(property_id);
+    if (value == _data_property_values.end())
     {
-        return {ProcessorReturnCode::OK, value_storage.bool_parameter_value()->processed_value() ? "True" : "False"};
+        return {ProcessorReturnCode::PARAMETER_NOT_FOUND, {}};
     }
+    return {ProcessorReturnCode::OK, value->second};
+}
 
-    return {ProcessorReturnCode::PARAMETER_ERROR, ""};
+void InternalPlugin::set_string_property_value(ObjectId property_id, const std::string& value)
+{
+    std::scoped_lock lock(_property_lock);
+    _string_property_values[property_id] = value;
+}
+
+void InternalPlugin::set_data_property_value(ObjectId property_id, const BlobData& value)
+{
+    std::scoped_lock lock(_property_lock);
+    _data_property_values[property_id].assign(value.data, value.data + value.size);
+}
+
+void InternalPlugin::_add_parameter_storage([[maybe_unused]] ParameterDescriptor* descriptor, int index)
+{
+    /* The parameter id must match the value storage index*/
+    assert(descriptor->id() == static_cast<ObjectId>(index));
+    _parameter_values.push_back(ParameterStorage::make_parameter_storage(&_parameter_block, index));
 }
 
 } // end namespace sushi
\ No newline at end of file
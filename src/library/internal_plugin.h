@@ -22,6 +22,8 @@
 #define SUSHI_INTERNAL_PLUGIN_H
 
 #include <deque>
+#include <map>
+#include <mutex>
 
 #include "library/processor.h"
 #include "library/plugin_parameters.h"
@@ -49,6 +51,10 @@ public:
 
     std::pair<ProcessorReturnCode, std::string> parameter_value_formatted(ObjectId parameter_id) const override;
 
+    std::pair<ProcessorReturnCode, std::string> string_property_value(ObjectId property_id) const override;
+
+    std::pair<ProcessorReturnCode, std::vector<uint8_t>> data_property_value(ObjectId property_id) const override;
+
     /**
      * @brief Register a float typed parameter and return a pointer to a value
      *        storage object that will hold the value and set automatically when
@@ -68,7 +74,7 @@ public:
                                                   float default_value,
                                                   float min_value,
                                                   float max_value,
-                                                  FloatParameterPreProcessor* pre_proc = nullptr);
+                                                  ParameterPreProcessor<float>* pre_proc = nullptr);
 
     /**
      * @brief Register an int typed parameter and return a pointer to a value
@@ -89,7 +95,7 @@ public:
                                               int default_value,
                                               int min_value,
                                               int max_value,
-                                              IntParameterPreProcessor* pre_proc = nullptr);
+                                              ParameterPreProcessor<int>* pre_proc = nullptr);
 
     /**
      * @brief Register a bool typed parameter and return a pointer to a value
@@ -153,11 +159,39 @@ protected:
      */
     void set_parameter_and_notify(BoolParameterValue*storage, bool new_value);
 
+    /**
+     * @brief Store the value of a string property once the plugin has taken it into use,
+     *        so that it can be read back with string_property_value(). Must not be called
+     *        from the rt thread.
+     * @param property_id The id of the property
+     * @param value The new value
+     */
+    void set_string_property_value(ObjectId property_id, const std::string& value);
+
+    /**
+     * @brief Store a copy of the data of a data property once the plugin has taken it into
+     *        use, so that it can be read back with data_property_value(). Must not be called
+     *        from the rt thread.
+     * @param property_id The id of the property
+     * @param value The new data
+     */
+    void set_data_property_value(ObjectId property_id, const BlobData& value);
+
 private:
-    /* TODO - consider container type to use here. Deque has the very desirable property
-     * that iterators are never invalidated by adding to the containers.
-     * For arrays or std::vectors we need to know the maximum capacity for that to work. */
+    void _add_parameter_storage(ParameterDescriptor* descriptor, int index);
+
+    /* All parameter values, indexed by parameter id. This is what is accessed during
+     * processing and when handling parameter change events */
+    ParameterBlock _parameter_block;
+
+    /* Handles into _parameter_block that are returned from the register functions. Deque is
+     * used as it never invalidates pointers to its elements when adding to it. */
     std::deque<ParameterStorage> _parameter_values;
+
+    /* The values of string and data properties, indexed by property id */
+    mutable std::mutex _property_lock;
+    std::map<ObjectId, std::string> _string_property_values;
+    std::map<ObjectId, std::vector<uint8_t>> _data_property_values;
 };
 
 } // end namespace sushi
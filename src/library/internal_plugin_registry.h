@@ -0,0 +1,168 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Registry of internal plugins, for creating plugin instances from their uid
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_INTERNAL_PLUGIN_REGISTRY_H
+#define SUSHI_INTERNAL_PLUGIN_REGISTRY_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "library/processor.h"
+
+namespace sushi {
+
+/**
+ * @brief 32 bit FNV-1a hash of a plugin uid, usable at compile time
+ */
+constexpr uint32_t plugin_uid_hash(std::string_view uid)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : uid)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Maps the uids of internal plugins to functions creating instances of them.
+ *        Plugins add themselves from their own compilation unit with
+ *        SUSHI_REGISTER_INTERNAL_PLUGIN, so the engine does not need to know about them.
+ *        The table is a fixed size, open addressed hash table that is constant initialised,
+ *        so it is safe to add to during static initialisation.
+ */
+class InternalPluginRegistry
+{
+public:
+    using Factory = Processor* (*)(HostControl host_control);
+
+    static constexpr int MAX_PLUGINS = 64;
+
+    /**
+     * @brief Add a plugin to the registry, normally through SUSHI_REGISTER_INTERNAL_PLUGIN
+     * @param uid The unique id of the plugin, must outlive the registry
+     * @param hash The hash of the uid, as calculated by plugin_uid_hash()
+     * @param factory Function to create an instance of the plugin
+     * @return true if added, false if the uid was already registered or the registry is full
+     */
+    static bool add(std::string_view uid, uint32_t hash, Factory factory)
+    {
+        for (int i = 0; i < MAX_PLUGINS; ++i)
+        {
+            auto& entry = _entries[(hash + i) % MAX_PLUGINS];
+            if (entry.factory == nullptr)
+            {
+                entry = {uid, hash, factory};
+                return true;
+            }
+            if (entry.hash == hash && entry.uid == uid)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Create a new instance of a plugin
+     * @param uid The unique id of the plugin
+     * @param host_control HostControl object passed to the plugin
+     * @return The new instance, owned by the caller, or nullptr if the uid is not registered
+     */
+    static Processor* create(std::string_view uid, HostControl host_control)
+    {
+        auto hash = plugin_uid_hash(uid);
+        for (int i = 0; i < MAX_PLUGINS; ++i)
+        {
+            const auto& entry = _entries[(hash + i) % MAX_PLUGINS];
+            if (entry.factory == nullptr)
+            {
+                break;
+            }
+            if (entry.hash == hash && entry.uid == uid)
+            {
+                return entry.factory(host_control);
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @return The uids of all registered plugins, in no particular order
+     */
+    static std::vector<std::string_view> uids()
+    {
+        std::vector<std::string_view> uids;
+        for (const auto& entry : _entries)
+        {
+            if (entry.factory)
+            {
+                uids.push_back(entry.uid);
+            }
+        }
+        return uids;
+    }
+
+private:
+    struct Entry
+    {
+        std::string_view uid;
+        uint32_t hash{0};
+        Factory factory{nullptr};
+    };
+
+    static std::array<Entry, MAX_PLUGINS> _entries;
+};
+
+inline std::array<InternalPluginRegistry::Entry, InternalPluginRegistry::MAX_PLUGINS> InternalPluginRegistry::_entries{};
+
+/**
+ * @brief Adds a plugin type to the registry when constructed, use through
+ *        SUSHI_REGISTER_INTERNAL_PLUGIN.
+ */
+template <typename Plugin>
+class InternalPluginRegistrar
+{
+public:
+    InternalPluginRegistrar(std::string_view uid, uint32_t hash)
+    {
+        [[maybe_unused]] bool added = InternalPluginRegistry::add(uid, hash, &_create);
+        assert(added);
+    }
+
+private:
+    static Processor* _create(HostControl host_control)
+    {
+        return new Plugin(host_control);
+    }
+};
+
+} // end namespace sushi
+
+/* Register an internal plugin under a given uid, place in the plugin's .cpp file */
+#define SUSHI_REGISTER_INTERNAL_PLUGIN(plugin_class, uid) \
+    static const sushi::InternalPluginRegistrar<plugin_class> plugin_class##_registrar(uid, \
+            std::integral_constant<uint32_t, sushi::plugin_uid_hash(uid)>::value)
+
+#endif //SUSHI_INTERNAL_PLUGIN_REGISTRY_H
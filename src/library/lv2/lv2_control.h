@@ -47,6 +47,7 @@ class ControlID
 public:
     ~ControlID() = default;
 
+    /* These query the shared lilv world and must be called with World::lilv_mutex() held */
     static ControlID new_port_control(Port* port, Model* model, uint32_t index);
     static ControlID new_property_control(Model* model, const LilvNode* property);
 
@@ -43,7 +43,14 @@ namespace lv2 {
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("lv2");
 
-Model::Model(float sample_rate, LV2_Wrapper* wrapper): _sample_rate(sample_rate), _wrapper(wrapper)
+namespace {
+
+std::mutex world_instance_lock;
+std::weak_ptr<World> world_instance;
+
+} // anonymous namespace
+
+World::World()
 {
     _world = lilv_world_new();
     _nodes = std::make_unique<HostNodes>(_world);
@@ -54,9 +61,158 @@ Model::Model(float sample_rate, LV2_Wrapper* wrapper): _sample_rate(sample_rate)
     // Find all installed plugins.
     lilv_world_load_all(_world);
 
+    _symap = lv2_host::symap_new();
+    _initialize_urids();
+}
+
+World::~World()
+{
+    // Explicitly setting to nullptr, so that destructor is invoked before world is freed.
+    _nodes = nullptr;
+
+    lilv_world_free(_world);
+    symap_free(_symap);
+}
+
+std::shared_ptr<World> World::instance()
+{
+    std::lock_guard<std::mutex> lock(world_instance_lock);
+    auto world = world_instance.lock();
+    if (world == nullptr)
+    {
+        world.reset(new World());
+        world_instance = world;
+    }
+    return world;
+}
+
+LV2_URID World::map(const char* uri)
+{
+    std::unique_lock<std::mutex> lock(_symap_lock);
+    return symap_map(_symap, uri);
+}
+
+const char* World::unmap(LV2_URID urid)
+{
+    std::unique_lock<std::mutex> lock(_symap_lock);
+    const char* uri = symap_unmap(_symap, urid);
+
+    return uri;
+}
+
+const LilvPlugin* World::plugin(const std::string& plugin_uri)
+{
+    if (plugin_uri.empty())
+    {
+        SUSHI_LOG_ERROR("Empty library path");
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_lilv_lock);
+    if (auto cached = _plugins.find(plugin_uri); cached != _plugins.end())
+    {
+        return cached->second;
+    }
+
+    auto plugins = lilv_world_get_all_plugins(_world);
+    auto uri_node = lilv_new_uri(_world, plugin_uri.c_str());
+
+    if (uri_node == nullptr)
+    {
+        SUSHI_LOG_ERROR("Missing plugin URI, try lv2ls to list plugins.");
+        return nullptr;
+    }
+
+    /* Find plugin */
+    SUSHI_LOG_INFO("Plugin: {}", lilv_node_as_string(uri_node));
+    const auto plugin  = lilv_plugins_get_by_uri(plugins, uri_node);
+    lilv_node_free(uri_node);
+
+    if (plugin == nullptr)
+    {
+        SUSHI_LOG_ERROR("Failed to find LV2 plugin.");
+        return nullptr;
+    }
+
+    _plugins[plugin_uri] = plugin;
+    return plugin;
+}
+
+void World::load_presets(const LilvPlugin* plugin)
+{
+    if (_preset_users[lilv_node_as_string(lilv_plugin_get_uri(plugin))]++ > 0)
+    {
+        return;
+    }
+
+    auto presets = lilv_plugin_get_related(plugin, _nodes->pset_Preset);
+    LILV_FOREACH(nodes, i, presets)
+    {
+        lilv_world_load_resource(_world, lilv_nodes_get(presets, i));
+    }
+    lilv_nodes_free(presets);
+}
+
+void World::unload_presets(const LilvPlugin* plugin)
+{
+    auto users = _preset_users.find(lilv_node_as_string(lilv_plugin_get_uri(plugin)));
+    if (users == _preset_users.end() || --users->second > 0)
+    {
+        return;
+    }
+    _preset_users.erase(users);
+
+    auto presets = lilv_plugin_get_related(plugin, _nodes->pset_Preset);
+    LILV_FOREACH(nodes, i, presets)
+    {
+        lilv_world_unload_resource(_world, lilv_nodes_get(presets, i));
+    }
+    lilv_nodes_free(presets);
+}
+
+void World::_initialize_urids()
+{
+    _urids.atom_Float = symap_map(_symap, LV2_ATOM__Float);
+    _urids.atom_Int = symap_map(_symap, LV2_ATOM__Int);
+    _urids.atom_Object = symap_map(_symap, LV2_ATOM__Object);
+    _urids.atom_Path = symap_map(_symap, LV2_ATOM__Path);
+    _urids.atom_String = symap_map(_symap, LV2_ATOM__String);
+    _urids.atom_eventTransfer = symap_map(_symap, LV2_ATOM__eventTransfer);
+    _urids.bufsz_maxBlockLength = symap_map(_symap, LV2_BUF_SIZE__maxBlockLength);
+    _urids.bufsz_minBlockLength = symap_map(_symap, LV2_BUF_SIZE__minBlockLength);
+    _urids.bufsz_sequenceSize = symap_map(_symap, LV2_BUF_SIZE__sequenceSize);
+    _urids.log_Error = symap_map(_symap, LV2_LOG__Error);
+    _urids.log_Trace = symap_map(_symap, LV2_LOG__Trace);
+    _urids.log_Warning = symap_map(_symap, LV2_LOG__Warning);
+    _urids.log_Entry = symap_map(_symap, LV2_LOG__Entry);
+    _urids.log_Note = symap_map(_symap, LV2_LOG__Note);
+    _urids.log_log = symap_map(_symap, LV2_LOG__log);
+    _urids.midi_MidiEvent = symap_map(_symap, LV2_MIDI__MidiEvent);
+    _urids.param_sampleRate = symap_map(_symap, LV2_PARAMETERS__sampleRate);
+    _urids.patch_Get = symap_map(_symap, LV2_PATCH__Get);
+    _urids.patch_Put = symap_map(_symap, LV2_PATCH__Put);
+    _urids.patch_Set = symap_map(_symap, LV2_PATCH__Set);
+    _urids.patch_body = symap_map(_symap, LV2_PATCH__body);
+    _urids.patch_property = symap_map(_symap, LV2_PATCH__property);
+    _urids.patch_value = symap_map(_symap, LV2_PATCH__value);
+    _urids.time_Position = symap_map(_symap, LV2_TIME__Position);
+    _urids.time_bar = symap_map(_symap, LV2_TIME__bar);
+    _urids.time_barBeat = symap_map(_symap, LV2_TIME__barBeat);
+    _urids.time_beatUnit = symap_map(_symap, LV2_TIME__beatUnit);
+    _urids.time_beatsPerBar = symap_map(_symap, LV2_TIME__beatsPerBar);
+    _urids.time_beatsPerMinute = symap_map(_symap, LV2_TIME__beatsPerMinute);
+    _urids.time_frame = symap_map(_symap, LV2_TIME__frame);
+    _urids.time_speed = symap_map(_symap, LV2_TIME__speed);
+    _urids.ui_updateRate = symap_map(_symap, LV2_UI__updateRate);
+}
+
+Model::Model(float sample_rate, LV2_Wrapper* wrapper): _world(World::instance()),
+                                                       _sample_rate(sample_rate),
+                                                       _wrapper(wrapper)
+{
     _initialize_map_feature();
     _initialize_unmap_feature();
-    _initialize_urid_symap();
+    _initialize_forge();
     _initialize_log_feature();
     _initialize_make_path_feature();
 
@@ -67,6 +223,7 @@ Model::Model(float sample_rate, LV2_Wrapper* wrapper): _sample_rate(sample_rate)
 
 Model::~Model()
 {
+    std::lock_guard<std::mutex> lock(_world->lilv_mutex());
     if (_plugin_instance)
     {
         lilv_instance_deactivate(_plugin_instance);
@@ -91,15 +248,17 @@ Model::~Model()
         }
 
         _plugin_instance = nullptr;
+    }
 
+    if (_lv2_state)
+    {
         _lv2_state->unload_programs();
     }
+}
 
-    // Explicitly setting to nullptr, so that destructor is invoked before world is freed.
-    _nodes = nullptr;
-
-    lilv_world_free(_world);
-    symap_free(_symap);
+World* Model::world()
+{
+    return _world.get();
 }
 
 void Model::_initialize_host_feature_list()
@@ -160,6 +319,8 @@ ProcessorReturnCode Model::load_plugin(const LilvPlugin* plugin_handle, double s
         return ProcessorReturnCode::PLUGIN_INIT_ERROR;
     }
 
+    std::lock_guard<std::mutex> lock(_world->lilv_mutex());
+
     if (_check_for_required_features(plugin_handle) == false)
     {
         return ProcessorReturnCode::PLUGIN_INIT_ERROR;
@@ -176,7 +337,7 @@ ProcessorReturnCode Model::load_plugin(const LilvPlugin* plugin_handle, double s
     _features.ext_data.data_access = lilv_instance_get_descriptor(_plugin_instance)->extension_data;
 
     /* Create workers if necessary */
-    if (lilv_plugin_has_extension_data(plugin_handle, _nodes->work_interface))
+    if (lilv_plugin_has_extension_data(plugin_handle, nodes()->work_interface))
     {
         const void* iface_raw = lilv_instance_get_extension_data(_plugin_instance, LV2_WORKER__interface);
         auto iface = static_cast<const LV2_Worker_Interface*>(iface_raw);
@@ -188,7 +349,7 @@ ProcessorReturnCode Model::load_plugin(const LilvPlugin* plugin_handle, double s
         }
     }
 
-    auto state_threadSafeRestore = lilv_new_uri(_world, LV2_STATE__threadSafeRestore);
+    auto state_threadSafeRestore = lilv_new_uri(lilv_world(), LV2_STATE__threadSafeRestore);
     if (lilv_plugin_has_feature(plugin_handle, state_threadSafeRestore))
     {
         _safe_restore = true;
@@ -205,7 +366,7 @@ ProcessorReturnCode Model::load_plugin(const LilvPlugin* plugin_handle, double s
 
     _lv2_state->populate_program_list();
 
-    auto state = lilv_state_new_from_world(_world,
+    auto state = lilv_state_new_from_world(lilv_world(),
                                            &get_map(),
                                            lilv_plugin_get_uri(plugin_handle));
 
@@ -304,12 +465,12 @@ Port Model::_create_port(const LilvPlugin* plugin, int port_index, float default
 void Model::_create_controls(bool writable)
 {
     const auto uri_node = lilv_plugin_get_uri(_plugin_class);
-    auto patch_writable = lilv_new_uri(_world, LV2_PATCH__writable);
-    auto patch_readable = lilv_new_uri(_world, LV2_PATCH__readable);
+    auto patch_writable = lilv_new_uri(lilv_world(), LV2_PATCH__writable);
+    auto patch_readable = lilv_new_uri(lilv_world(), LV2_PATCH__readable);
     const std::string uri_as_string = lilv_node_as_string(uri_node);
 
     auto properties = lilv_world_find_nodes(
-            _world,
+            lilv_world(),
             uri_node,
             writable ? patch_writable : patch_readable,
             nullptr);
@@ -319,7 +480,7 @@ void Model::_create_controls(bool writable)
         const auto property = lilv_nodes_get(properties, p);
 
         bool found = false;
-        if ((writable == false) && lilv_world_ask(_world,
+        if ((writable == false) && lilv_world_ask(lilv_world(),
                                                   uri_node,
                                                   patch_writable,
                                                   property))
@@ -368,42 +529,9 @@ void Model::_create_controls(bool writable)
     lilv_node_free(patch_writable);
 }
 
-void Model::_initialize_urid_symap()
+void Model::_initialize_forge()
 {
     lv2_atom_forge_init(&this->_forge, &_map);
-
-    this->_urids.atom_Float = symap_map(this->_symap, LV2_ATOM__Float);
-    this->_urids.atom_Int = symap_map(this->_symap, LV2_ATOM__Int);
-    this->_urids.atom_Object = symap_map(this->_symap, LV2_ATOM__Object);
-    this->_urids.atom_Path = symap_map(this->_symap, LV2_ATOM__Path);
-    this->_urids.atom_String = symap_map(this->_symap, LV2_ATOM__String);
-    this->_urids.atom_eventTransfer = symap_map(this->_symap, LV2_ATOM__eventTransfer);
-    this->_urids.bufsz_maxBlockLength = symap_map(this->_symap, LV2_BUF_SIZE__maxBlockLength);
-    this->_urids.bufsz_minBlockLength = symap_map(this->_symap, LV2_BUF_SIZE__minBlockLength);
-    this->_urids.bufsz_sequenceSize = symap_map(this->_symap, LV2_BUF_SIZE__sequenceSize);
-    this->_urids.log_Error = symap_map(this->_symap, LV2_LOG__Error);
-    this->_urids.log_Trace = symap_map(this->_symap, LV2_LOG__Trace);
-    this->_urids.log_Warning = symap_map(this->_symap, LV2_LOG__Warning);
-    this->_urids.log_Entry = symap_map(this->_symap, LV2_LOG__Entry);
-    this->_urids.log_Note = symap_map(this->_symap, LV2_LOG__Note);
-    this->_urids.log_log = symap_map(this->_symap, LV2_LOG__log);
-    this->_urids.midi_MidiEvent = symap_map(this->_symap, LV2_MIDI__MidiEvent);
-    this->_urids.param_sampleRate = symap_map(this->_symap, LV2_PARAMETERS__sampleRate);
-    this->_urids.patch_Get = symap_map(this->_symap, LV2_PATCH__Get);
-    this->_urids.patch_Put = symap_map(this->_symap, LV2_PATCH__Put);
-    this->_urids.patch_Set = symap_map(this->_symap, LV2_PATCH__Set);
-    this->_urids.patch_body = symap_map(this->_symap, LV2_PATCH__body);
-    this->_urids.patch_property = symap_map(this->_symap, LV2_PATCH__property);
-    this->_urids.patch_value = symap_map(this->_symap, LV2_PATCH__value);
-    this->_urids.time_Position = symap_map(this->_symap, LV2_TIME__Position);
-    this->_urids.time_bar = symap_map(this->_symap, LV2_TIME__bar);
-    this->_urids.time_barBeat = symap_map(this->_symap, LV2_TIME__barBeat);
-    this->_urids.time_beatUnit = symap_map(this->_symap, LV2_TIME__beatUnit);
-    this->_urids.time_beatsPerBar = symap_map(this->_symap, LV2_TIME__beatsPerBar);
-    this->_urids.time_beatsPerMinute = symap_map(this->_symap, LV2_TIME__beatsPerMinute);
-    this->_urids.time_frame = symap_map(this->_symap, LV2_TIME__frame);
-    this->_urids.time_speed = symap_map(this->_symap, LV2_TIME__speed);
-    this->_urids.ui_updateRate = symap_map(this->_symap, LV2_UI__updateRate);
 }
 
 void Model::_initialize_log_feature()
@@ -416,7 +544,6 @@ void Model::_initialize_log_feature()
 
 void Model::_initialize_map_feature()
 {
-    this->_symap = lv2_host::symap_new();
     this->_map.handle = this;
     this->_map.map = map_uri;
     init_feature(&this->_features.map_feature, LV2_URID__map, &this->_map);
@@ -470,11 +597,11 @@ void Model::_initialize_options_feature()
 {
     /* Build options array to pass to plugin */
     const LV2_Options_Option options[6] = {
-            { LV2_OPTIONS_INSTANCE, 0, _urids.param_sampleRate, sizeof(float), _urids.atom_Float, &_sample_rate },
-            { LV2_OPTIONS_INSTANCE, 0, _urids.bufsz_minBlockLength, sizeof(int32_t), _urids.atom_Int, &_buffer_size },
-            { LV2_OPTIONS_INSTANCE, 0, _urids.bufsz_maxBlockLength, sizeof(int32_t), _urids.atom_Int, &_buffer_size },
-            { LV2_OPTIONS_INSTANCE, 0, _urids.bufsz_sequenceSize, sizeof(int32_t), _urids.atom_Int, &_midi_buffer_size },
-            { LV2_OPTIONS_INSTANCE, 0, _urids.ui_updateRate, sizeof(float), _urids.atom_Float, &_ui_update_hz },
+            { LV2_OPTIONS_INSTANCE, 0, urids().param_sampleRate, sizeof(float), urids().atom_Float, &_sample_rate },
+            { LV2_OPTIONS_INSTANCE, 0, urids().bufsz_minBlockLength, sizeof(int32_t), urids().atom_Int, &_buffer_size },
+            { LV2_OPTIONS_INSTANCE, 0, urids().bufsz_maxBlockLength, sizeof(int32_t), urids().atom_Int, &_buffer_size },
+            { LV2_OPTIONS_INSTANCE, 0, urids().bufsz_sequenceSize, sizeof(int32_t), urids().atom_Int, &_midi_buffer_size },
+            { LV2_OPTIONS_INSTANCE, 0, urids().ui_updateRate, sizeof(float), urids().atom_Float, &_ui_update_hz },
             { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, NULL }
     };
 
@@ -514,7 +641,7 @@ std::array<const LV2_Feature*, FEATURE_LIST_SIZE>* Model::host_feature_list()
 
 LilvWorld* Model::lilv_world()
 {
-    return _world;
+    return _world->lilv_world();
 }
 
 LilvInstance* Model::plugin_instance()
@@ -554,12 +681,12 @@ int Model::port_count()
 
 const HostNodes* Model::nodes()
 {
-    return _nodes.get();
+    return _world->nodes();
 }
 
 const LV2_URIDs& Model::urids()
 {
-    return _urids;
+    return _world->urids();
 }
 
 LV2_URID_Map& Model::get_map()
@@ -574,16 +701,12 @@ LV2_URID_Unmap& Model::get_unmap()
 
 LV2_URID Model::map(const char* uri)
 {
-    std::unique_lock<std::mutex> lock(_symap_lock);
-    return symap_map(_symap, uri);
+    return _world->map(uri);
 }
 
 const char* Model::unmap(LV2_URID urid)
 {
-    std::unique_lock<std::mutex> lock(_symap_lock);
-    const char* uri = symap_unmap(_symap, urid);
-
-    return uri;
+    return _world->unmap(urid);
 }
 
 LV2_Atom_Forge& Model::forge()
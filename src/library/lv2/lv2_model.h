@@ -24,6 +24,7 @@
 #ifdef SUSHI_BUILD_WITH_LV2
 
 #include <map>
+#include <memory>
 #include <mutex>
 
 #include <lv2/log/log.h>
@@ -126,6 +127,82 @@ struct HostFeatures
 
 constexpr int FEATURE_LIST_SIZE = 11;
 
+/**
+ * @brief State shared by all LV2 plugin instances: the lilv world with all installed
+ *        plugins loaded, the host nodes, the URID map and the plugins that have been
+ *        looked up. It is created with the first instance and freed with the last one,
+ *        so that every other instance only pays for instantiating the plugin.
+ */
+class World
+{
+public:
+    SUSHI_DECLARE_NON_COPYABLE(World);
+
+    ~World();
+
+    /**
+     * @brief Get the shared world, creating it if there is none. Not safe to call
+     *        from the rt thread.
+     */
+    static std::shared_ptr<World> instance();
+
+    LilvWorld* lilv_world() {return _world;}
+
+    const HostNodes* nodes() {return _nodes.get();}
+
+    const LV2_URIDs& urids() {return _urids;}
+
+    /* The URID map is shared so that all instances map uris to the same ids */
+    LV2_URID map(const char* uri);
+    const char* unmap(LV2_URID urid);
+
+    /**
+     * @brief Find an installed plugin
+     * @param plugin_uri The uri of the plugin
+     * @return The plugin descriptor or nullptr if not found
+     */
+    const LilvPlugin* plugin(const std::string& plugin_uri);
+
+    /**
+     * @brief Lilv worlds are not thread safe, lock this around every access to
+     *        lilv_world() and anything created from it.
+     */
+    std::mutex& lilv_mutex() {return _lilv_lock;}
+
+    /**
+     * @brief Load the presets of a plugin into the world. Presets are shared by all
+     *        instances of the plugin, so they are only loaded by the first caller.
+     *        Must be called with lilv_mutex() held.
+     * @param plugin The plugin whose presets to load
+     */
+    void load_presets(const LilvPlugin* plugin);
+
+    /**
+     * @brief Release presets loaded with load_presets(). They are unloaded from the
+     *        world when the last instance of the plugin releases them.
+     *        Must be called with lilv_mutex() held.
+     * @param plugin The plugin whose presets to release
+     */
+    void unload_presets(const LilvPlugin* plugin);
+
+private:
+    World();
+
+    void _initialize_urids();
+
+    LilvWorld* _world{nullptr};
+    std::unique_ptr<HostNodes> _nodes{nullptr};
+
+    lv2_host::Symap* _symap;
+    std::mutex _symap_lock;
+
+    LV2_URIDs _urids;
+
+    std::map<std::string, const LilvPlugin*> _plugins;
+    std::map<std::string, int> _preset_users;
+    std::mutex _lilv_lock;
+};
+
 /**
  * @brief LV2 depends on a "GOD" struct/class per plugin instance,
  * which it passes around with pointers in the various callbacks.
@@ -139,6 +216,8 @@ public:
     Model(float sample_rate, LV2_Wrapper* wrapper);
     ~Model();
 
+    World* world();
+
     ProcessorReturnCode load_plugin(const LilvPlugin* plugin_handle,
                                     double sample_rate);
 
@@ -225,7 +304,7 @@ private:
     void _initialize_map_feature();
     void _initialize_unmap_feature();
     void _initialize_log_feature();
-    void _initialize_urid_symap();
+    void _initialize_forge();
 
     void _initialize_make_path_feature();
 
@@ -242,6 +321,9 @@ private:
     /** Return true iff Sushi supports the given feature. */
     bool _feature_is_supported(const std::string& uri);
 
+    /* Declared first so that it is released after everything that refers to the world */
+    std::shared_ptr<World> _world;
+
     std::vector<ControlID> _controls;
 
     bool _buf_size_set{false};
@@ -264,18 +346,10 @@ private:
     LV2_URID_Map _map;
     LV2_URID_Unmap _unmap;
 
-    lv2_host::Symap* _symap;
-    std::mutex _symap_lock;
-
-    LV2_URIDs _urids;
-
-    LilvWorld* _world{nullptr};
-    std::unique_ptr<HostNodes> _nodes{nullptr};
-
     std::vector<Port> _ports;
 
     float _sample_rate;
-    const int _buffer_size{AUDIO_CHUNK_SIZE};
+    const int _buffer_size{audio_chunk_size()};
     int _midi_buffer_size{4096};
 
     int _ui_update_hz{30};
@@ -15,6 +15,8 @@
 
 #include "lv2_state.h"
 
+#include <mutex>
+
 #include <lilv-0/lilv/lilv.h>
 
 #include "logging.h"
@@ -81,6 +83,7 @@ void State::save(const char* dir)
 {
     _model->set_save_dir(std::string(dir) + "/");
 
+    std::lock_guard<std::mutex> lock(_model->world()->lilv_mutex());
     auto state = lilv_state_new_from_instance(
             _model->plugin_class(), _model->plugin_instance(), &_model->get_map(),
             _model->temp_dir().c_str(), dir, dir, dir,
@@ -94,14 +97,20 @@ void State::save(const char* dir)
     _model->set_save_dir(std::string(""));
 }
 
+// Called from Model::load_plugin(), which holds the lilv world lock
 void State::_load_programs(PresetSink sink, void* data)
 {
+   if (_programs_loaded == false)
+   {
+       _model->world()->load_presets(_model->plugin_class());
+       _programs_loaded = true;
+   }
+
    auto presets = lilv_plugin_get_related(_model->plugin_class(), _model->nodes()->pset_Preset);
 
    LILV_FOREACH(nodes, i, presets)
    {
        auto preset = lilv_nodes_get(presets, i);
-       lilv_world_load_resource(_model->lilv_world(), preset);
 
        if (sink == nullptr)
        {
@@ -127,15 +136,11 @@ void State::_load_programs(PresetSink sink, void* data)
 
 void State::unload_programs()
 {
-    auto presets = lilv_plugin_get_related(_model->plugin_class(), _model->nodes()->pset_Preset);
-
-    LILV_FOREACH(nodes, i, presets)
+    if (_programs_loaded)
     {
-        auto preset = lilv_nodes_get(presets, i);
-        lilv_world_unload_resource(_model->lilv_world(), preset);
+        _model->world()->unload_presets(_model->plugin_class());
+        _programs_loaded = false;
     }
-
-    lilv_nodes_free(presets);
 }
 
 void State::apply_state(LilvState* state)
@@ -162,9 +167,15 @@ bool State::apply_program(const int program_index)
 {
     if (program_index < number_of_programs())
     {
-        auto presetNode = lilv_new_uri(_model->lilv_world(), _program_names[program_index].c_str());
-        apply_program(presetNode);
-        lilv_node_free(presetNode);
+        LilvState* preset;
+        {
+            std::lock_guard<std::mutex> lock(_model->world()->lilv_mutex());
+            auto presetNode = lilv_new_uri(_model->lilv_world(), _program_names[program_index].c_str());
+            preset = lilv_state_new_from_world(_model->lilv_world(), &_model->get_map(), presetNode);
+            lilv_node_free(presetNode);
+        }
+        _set_preset(preset);
+        apply_state(_preset);
 
         _current_program_index = program_index;
 
@@ -176,7 +187,12 @@ bool State::apply_program(const int program_index)
 
 void State::apply_program(const LilvNode* preset)
 {
-    _set_preset(lilv_state_new_from_world(_model->lilv_world(), &_model->get_map(), preset));
+    LilvState* new_preset;
+    {
+        std::lock_guard<std::mutex> lock(_model->world()->lilv_mutex());
+        new_preset = lilv_state_new_from_world(_model->lilv_world(), &_model->get_map(), preset);
+    }
+    _set_preset(new_preset);
     apply_state(_preset);
 }
 
@@ -192,6 +208,7 @@ void State::_set_preset(LilvState* new_preset)
 
 int State::save_program(const char* dir, const char* uri, const char* label, const char* filename)
 {
+   std::lock_guard<std::mutex> lock(_model->world()->lilv_mutex());
    auto state = lilv_state_new_from_instance(
             _model->plugin_class(), _model->plugin_instance(), &_model->get_map(),
             _model->temp_dir().c_str(), dir, dir, dir,
@@ -217,6 +234,7 @@ bool State::delete_current_program()
        return false;
    }
 
+   std::lock_guard<std::mutex> lock(_model->world()->lilv_mutex());
    lilv_world_unload_resource(_model->lilv_world(), lilv_state_get_uri(_preset));
    lilv_state_delete(_model->lilv_world(), _preset);
     _set_preset(nullptr);
@@ -40,6 +40,10 @@ public:
 
     void save(const char *dir);
 
+    /**
+     * @brief Release the presets loaded by populate_program_list() from the shared
+     *        world. Must be called with the world's lilv_mutex() held.
+     */
     void unload_programs();
 
     void apply_state(LilvState* state);
@@ -71,6 +75,7 @@ private:
 
     std::vector<std::string> _program_names;
     int _current_program_index{0};
+    bool _programs_loaded{false};
 
     LilvState* _preset {nullptr}; // Naked pointer because Lilv manages lifetime.
 
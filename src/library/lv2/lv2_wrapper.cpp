@@ -22,8 +22,10 @@
 
 #include "lv2_wrapper.h"
 
+#include <algorithm>
 #include <exception>
 #include <cmath>
+#include <limits>
 
 #include <twine/twine.h>
 
@@ -61,7 +63,7 @@ ProcessorReturnCode LV2_Wrapper::init(float sample_rate)
 
     _lv2_pos = reinterpret_cast<LV2_Atom*>(pos_buf);
 
-    auto library_handle = _plugin_handle_from_URI(_plugin_path.c_str());
+    auto library_handle = _model->world()->plugin(_plugin_path);
 
     if (library_handle == nullptr)
     {
@@ -91,6 +93,9 @@ ProcessorReturnCode LV2_Wrapper::init(float sample_rate)
     }
 
     _model->set_play_state(PlayState::RUNNING);
+    _current_program = _model->state()->current_program_index();
+    _control_values_during_swap.assign(_model->port_count(), std::numeric_limits<float>::quiet_NaN());
+    _published_model.store(_model.get(), std::memory_order_release);
 
     return ProcessorReturnCode::OK;
 }
@@ -138,10 +143,12 @@ std::pair<ProcessorReturnCode, float> LV2_Wrapper::parameter_value(ObjectId para
     }
 
     const int index = static_cast<int>(parameter_id);
+    std::scoped_lock lock(_model_lock);
+    auto model = _published_model.load(std::memory_order_acquire);
 
-    if (index < _model->port_count())
+    if (index < model->port_count())
     {
-        auto port = _model->get_port(index);
+        auto port = model->get_port(index);
 
         if (port != nullptr)
         {
@@ -162,10 +169,12 @@ std::pair<ProcessorReturnCode, float> LV2_Wrapper::parameter_value_in_domain(Obj
 {
     float value = 0.0;
     const int index = static_cast<int>(parameter_id);
+    std::scoped_lock lock(_model_lock);
+    auto model = _published_model.load(std::memory_order_acquire);
 
-    if (index < _model->port_count())
+    if (index < model->port_count())
     {
-        auto port = _model->get_port(index);
+        auto port = model->get_port(index);
 
         if (port != nullptr)
         {
@@ -192,19 +201,21 @@ std::pair<ProcessorReturnCode, std::string> LV2_Wrapper::parameter_value_formatt
 
 bool LV2_Wrapper::supports_programs() const
 {
-    return _model->state()->number_of_programs() > 0;
+    return program_count() > 0;
 }
 
 int LV2_Wrapper::program_count() const
 {
-    return _model->state()->number_of_programs();
+    std::scoped_lock lock(_model_lock);
+    return _published_model.load(std::memory_order_acquire)->state()->number_of_programs();
 }
 
 int LV2_Wrapper::current_program() const
 {
     if (this->supports_programs())
     {
-        return _model->state()->current_program_index();
+        /* Tracked here as the instance with the new program may not be swapped in yet */
+        return _current_program.load();
     }
 
     return 0;
@@ -212,18 +223,17 @@ int LV2_Wrapper::current_program() const
 
 std::string LV2_Wrapper::current_program_name() const
 {
-   return _model->state()->current_program_name();
+    return program_name(current_program()).second;
 }
 
 std::pair<ProcessorReturnCode, std::string> LV2_Wrapper::program_name(int program) const
 {
-    if (this->supports_programs())
+    std::scoped_lock lock(_model_lock);
+    auto state = _published_model.load(std::memory_order_acquire)->state();
+    if (program >= 0 && program < state->number_of_programs())
     {
-        if (program < _model->state()->number_of_programs())
-        {
-            std::string name = _model->state()->program_name(program);
-            return {ProcessorReturnCode::OK, name};
-        }
+        std::string name = state->program_name(program);
+        return {ProcessorReturnCode::OK, name};
     }
 
     return {ProcessorReturnCode::ERROR, ""};
@@ -231,25 +241,97 @@ std::pair<ProcessorReturnCode, std::string> LV2_Wrapper::program_name(int progra
 
 std::pair<ProcessorReturnCode, std::vector<std::string>> LV2_Wrapper::all_program_names() const
 {
-    if (this->supports_programs() == false)
+    std::scoped_lock lock(_model_lock);
+    auto state = _published_model.load(std::memory_order_acquire)->state();
+    if (state->number_of_programs() == 0)
     {
         return {ProcessorReturnCode::UNSUPPORTED_OPERATION, std::vector<std::string>()};
     }
 
-    std::vector<std::string> programs(_model->state()->program_names().begin(),
-                                      _model->state()->program_names().end());
+    std::vector<std::string> programs(state->program_names().begin(),
+                                      state->program_names().end());
 
     return {ProcessorReturnCode::OK, programs};
 }
 
+ProcessorReturnCode LV2_Wrapper::_set_program_on_new_instance(int program)
+{
+    /* From here on the rt thread records control changes, as they could otherwise be
+     * lost between copying the control values and the new model being swapped in */
+    _preparing_model = true;
+    auto current = _published_model.load();
+    auto status = _prepare_model_with_program(current, program);
+    _preparing_model = false;
+    return status;
+}
+
+ProcessorReturnCode LV2_Wrapper::_prepare_model_with_program(Model* current, int program)
+{
+    float sample_rate = current->sample_rate();
+    auto model = std::make_unique<Model>(sample_rate, this);
+    auto library_handle = model->world()->plugin(_plugin_path);
+    if (library_handle == nullptr)
+    {
+        return ProcessorReturnCode::SHARED_LIBRARY_OPENING_ERROR;
+    }
+
+    auto status = model->load_plugin(library_handle, sample_rate);
+    if (status != ProcessorReturnCode::OK)
+    {
+        return status;
+    }
+
+    /* Carry over the current control values and apply the program on top of them,
+     * as it would have been applied to the running instance */
+    for (int p = 0; p < current->port_count() && p < model->port_count(); ++p)
+    {
+        auto port = current->get_port(p);
+        if (port->type() == PortType::TYPE_CONTROL && port->flow() == PortFlow::FLOW_INPUT)
+        {
+            model->get_port(p)->set_control_value(port->control_value());
+        }
+    }
+
+    /* The new instance is not processing yet, so the program is applied directly */
+    if (model->state()->apply_program(program) == false)
+    {
+        return ProcessorReturnCode::ERROR;
+    }
+    if (enabled())
+    {
+        lilv_instance_activate(model->plugin_instance());
+    }
+    model->set_play_state(PlayState::RUNNING);
+
+    /* Replaces any instance the rt thread has not picked up yet */
+    delete _pending_model.exchange(model.release(), std::memory_order_acq_rel);
+    return ProcessorReturnCode::OK;
+}
+
 ProcessorReturnCode LV2_Wrapper::set_program(int program)
 {
-    if (this->supports_programs() && program < _model->state()->number_of_programs())
+    std::scoped_lock lock(_model_lock);
+    auto model = _published_model.load(std::memory_order_acquire);
+    if (program >= 0 && program < model->state()->number_of_programs())
     {
-        bool succeeded = _model->state()->apply_program(program);
+        /* Plugins without thread safe restore would otherwise have to be paused,
+         * and hence muted, while the program is restored */
+        if (model->safe_restore() == false && model->play_state() == PlayState::RUNNING)
+        {
+            auto status = _set_program_on_new_instance(program);
+            if (status == ProcessorReturnCode::OK)
+            {
+                _current_program = program;
+                return status;
+            }
+            SUSHI_LOG_WARNING("Failed to prepare a new instance for the program change, pausing instead");
+        }
+
+        bool succeeded = model->state()->apply_program(program);
 
         if (succeeded)
         {
+            _current_program = program;
             return ProcessorReturnCode::OK;
         }
         else
@@ -336,6 +418,7 @@ void LV2_Wrapper::process_event(const RtEvent& event)
 
         auto value_in_domain = _to_domain(value, min, max);
         port->set_control_value(value_in_domain);
+        _record_control_value_during_swap(portIndex, value_in_domain);
     }
     else if (is_keyboard_event(event))
     {
@@ -362,7 +445,7 @@ void LV2_Wrapper::_update_transport()
     const int beat_type = ts.denominator;
     const double current_bar_beats = transport->current_bar_beats();
     const int32_t bar = transport->current_bar_start_beats() / current_bar_beats;
-    const uint32_t frame = transport->current_samples() / AUDIO_CHUNK_SIZE;
+    const uint32_t frame = transport->current_samples() / audio_chunk_size();
 
     // If transport state is not as expected, then something has changed.
     _xport_changed = (rolling != _model->rolling() ||
@@ -399,17 +482,23 @@ void LV2_Wrapper::_update_transport()
     }
 
     // Update model transport state to expected values for next cycle.
-    _model->set_position(rolling ? frame + AUDIO_CHUNK_SIZE : frame);
+    _model->set_position(rolling ? frame + audio_chunk_size() : frame);
     _model->set_bpm(beats_per_minute);
     _model->set_rolling(rolling);
 }
 
 void LV2_Wrapper::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer)
 {
+    _swap_in_pending_model();
+
     if (_bypass_manager.should_process() == false)
     {
          bypass_process(in_buffer, out_buffer);
         _flush_event_queue();
+        if (_fading_model)
+        {
+            _retire_fading_model();
+        }
     }
     else
     {
@@ -438,7 +527,7 @@ void LV2_Wrapper::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleB
 
         _deliver_inputs_to_plugin();
 
-        lilv_instance_run(_model->plugin_instance(), AUDIO_CHUNK_SIZE);
+        lilv_instance_run(_model->plugin_instance(), audio_chunk_size());
 
         /* Process any worker replies. */
         if(_model->state_worker() != nullptr)
@@ -450,6 +539,11 @@ void LV2_Wrapper::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleB
 
         _deliver_outputs_from_plugin(false);
 
+        if (_fading_model)
+        {
+            _crossfade_from_fading_model(in_buffer, out_buffer);
+        }
+
         if (_bypass_manager.should_ramp())
         {
             _bypass_manager.crossfade_output(in_buffer, out_buffer, _current_input_channels, _current_output_channels);
@@ -462,39 +556,135 @@ void LV2_Wrapper::_restore_state_callback(EventId)
     /* Note that this doesn't handle multiple requests at once.
      * Currently for the Pause functionality it is fine,
      * but if extended to support other use it may note be. */
-    if(_model->state_to_set() != nullptr)
+    std::scoped_lock lock(_model_lock);
+    auto model = _published_model.load(std::memory_order_acquire);
+    if(model->state_to_set() != nullptr)
     {
-        auto feature_list = _model->host_feature_list();
+        auto feature_list = model->host_feature_list();
 
-        lilv_state_restore(_model->state_to_set(),
-                           _model->plugin_instance(),
+        lilv_state_restore(model->state_to_set(),
+                           model->plugin_instance(),
                            set_port_value,
-                           _model.get(),
+                           model,
                            0,
                            feature_list->data());
 
-        _model->set_state_to_set(nullptr);
+        model->set_state_to_set(nullptr);
 
-        _model->request_update();
-        _model->set_play_state(PlayState::RUNNING);
+        model->request_update();
+        model->set_play_state(PlayState::RUNNING);
     }
 }
 
+void LV2_Wrapper::_retire_model_callback(EventId)
+{
+    /* Non-rt calls may still be using the model if they started before the swap */
+    std::scoped_lock lock(_model_lock);
+    delete _retired_model.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void LV2_Wrapper::_swap_in_pending_model()
+{
+    if (_pending_model.load(std::memory_order_relaxed) == nullptr)
+    {
+        return;
+    }
+    /* Wait until the previously replaced instance is gone, so that there are
+     * never more than 2 instances processing */
+    if (_fading_model || _retired_model.load(std::memory_order_acquire) != nullptr)
+    {
+        return;
+    }
+    auto model = _pending_model.exchange(nullptr, std::memory_order_acq_rel);
+    _fading_model = std::move(_model);
+    _model.reset(model);
+    _published_model.store(model);
+    for (int p = 0; p < static_cast<int>(_control_values_during_swap.size()) && p < _model->port_count(); ++p)
+    {
+        if (std::isnan(_control_values_during_swap[p]) == false)
+        {
+            _model->get_port(p)->set_control_value(_control_values_during_swap[p]);
+        }
+    }
+    /* If another model is being prepared it might have copied the values from the
+     * replaced model, so they are kept until that one is swapped in as well */
+    if (_preparing_model == false)
+    {
+        std::fill(_control_values_during_swap.begin(), _control_values_during_swap.end(),
+                  std::numeric_limits<float>::quiet_NaN());
+    }
+    _program_crossfade.reset(true);
+    _program_crossfade.set_bypass(false, _model->sample_rate());
+}
+
+void LV2_Wrapper::_record_control_value_during_swap(int port_index, float value)
+{
+    if (_preparing_model || _pending_model.load() != nullptr)
+    {
+        _control_values_during_swap[port_index] = value;
+    }
+}
+
+void LV2_Wrapper::_crossfade_from_fading_model(const ChunkSampleBuffer& in_buffer, ChunkSampleBuffer& out_buffer)
+{
+    auto instance = _fading_model->plugin_instance();
+    _map_audio_buffers(in_buffer, _crossfade_buffer);
+
+    for (int p = 0, i = 0, o = 0; p < _fading_model->port_count(); ++p)
+    {
+        auto current_port = _fading_model->get_port(p);
+        if (current_port->type() == PortType::TYPE_AUDIO)
+        {
+            if (current_port->flow() == PortFlow::FLOW_INPUT)
+                lilv_instance_connect_port(instance, p, _process_inputs[i++]);
+            else
+                lilv_instance_connect_port(instance, p, _process_outputs[o++]);
+        }
+        else if (current_port->type() == PortType::TYPE_EVENT)
+        {
+            /* The old instance gets no new events and is only left to ring out */
+            if (current_port->flow() == PortFlow::FLOW_INPUT)
+                current_port->reset_input_buffer();
+            else
+                current_port->reset_output_buffer();
+        }
+    }
+
+    lilv_instance_run(instance, audio_chunk_size());
+
+    /* The old instance's output is the "bypassed" signal that is faded out */
+    _program_crossfade.crossfade_output(_crossfade_buffer, out_buffer,
+                                        _current_output_channels, _current_output_channels);
+    if (_program_crossfade.should_ramp() == false)
+    {
+        _retire_fading_model();
+    }
+}
+
+void LV2_Wrapper::_retire_fading_model()
+{
+    _retired_model.store(_fading_model.release(), std::memory_order_release);
+    output_event(RtEvent::make_async_work_event(&LV2_Wrapper::retire_model_callback, this->id(), this));
+}
+
 void LV2_Wrapper::_worker_callback(EventId)
 {
-    _model->worker()->worker_func();
+    std::scoped_lock lock(_model_lock);
+    _published_model.load(std::memory_order_acquire)->worker()->worker_func();
 }
 
 void LV2_Wrapper::set_enabled(bool enabled)
 {
     Processor::set_enabled(enabled);
+    std::scoped_lock lock(_model_lock);
+    auto model = _published_model.load(std::memory_order_acquire);
     if (enabled)
     {
-        lilv_instance_activate(_model->plugin_instance());
+        lilv_instance_activate(model->plugin_instance());
     }
     else
     {
-        lilv_instance_deactivate(_model->plugin_instance());
+        lilv_instance_deactivate(model->plugin_instance());
     }
 }
 
@@ -862,38 +1052,6 @@ void LV2_Wrapper::_resume_audio_processing()
     _model->set_play_state(_previous_play_state);
 }
 
-const LilvPlugin* LV2_Wrapper::_plugin_handle_from_URI(const std::string& plugin_URI_string)
-{
-    if (plugin_URI_string.empty())
-    {
-        SUSHI_LOG_ERROR("Empty library path");
-        return nullptr; // Calling dlopen with an empty string returns a handle to the calling
-        // program, which can cause an infinite loop.
-    }
-
-    auto plugins = lilv_world_get_all_plugins(_model->lilv_world());
-    auto plugin_uri = lilv_new_uri(_model->lilv_world(), plugin_URI_string.c_str());
-
-    if (plugin_uri == nullptr)
-    {
-        SUSHI_LOG_ERROR("Missing plugin URI, try lv2ls to list plugins.");
-        return nullptr;
-    }
-
-    /* Find plugin */
-    SUSHI_LOG_INFO("Plugin: {}", lilv_node_as_string(plugin_uri));
-    const auto plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
-    lilv_node_free(plugin_uri);
-
-    if (plugin == nullptr)
-    {
-        SUSHI_LOG_ERROR("Failed to find LV2 plugin.");
-        return nullptr;
-    }
-
-    return plugin;
-}
-
 } // namespace lv2
 } // namespace sushi
 
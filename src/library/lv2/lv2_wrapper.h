@@ -41,7 +41,10 @@
 
 #ifdef SUSHI_BUILD_WITH_LV2
 
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include "engine/base_event_dispatcher.h"
 #include "library/processor.h"
@@ -70,7 +73,11 @@ public:
      */
     LV2_Wrapper(HostControl host_control, const std::string& lv2_plugin_uri);
 
-    virtual ~LV2_Wrapper() = default;
+    virtual ~LV2_Wrapper()
+    {
+        delete _pending_model.exchange(nullptr);
+        delete _retired_model.exchange(nullptr);
+    }
 
     ProcessorReturnCode init(float sample_rate) override;
 
@@ -121,15 +128,53 @@ public:
         return 1;
     }
 
+    static int retire_model_callback(void* data, EventId id)
+    {
+        reinterpret_cast<LV2_Wrapper *>(data)->_retire_model_callback(id);
+        return 1;
+    }
+
     void output_worker_event(const RtEvent& event);
 
 private:
-    const LilvPlugin* _plugin_handle_from_URI(const std::string& plugin_URI_string);
-
     void _worker_callback(EventId);
 
     void _restore_state_callback(EventId);
 
+    void _retire_model_callback(EventId);
+
+    /**
+     * @brief For plugins that can not restore state while processing. Loads a new instance
+     *        of the plugin and applies the program to it off the rt thread. The new instance
+     *        then replaces the current one in process_audio() with a crossfade.
+     * @param program The index of the program to set
+     * @return ProcessorReturnCode::OK if the new instance was prepared successfully
+     */
+    ProcessorReturnCode _set_program_on_new_instance(int program);
+
+    ProcessorReturnCode _prepare_model_with_program(Model* current, int program);
+
+    /**
+     * @brief Switch to a new instance prepared by _set_program_on_new_instance(), called
+     *        from the rt thread at the start of each chunk
+     */
+    void _swap_in_pending_model();
+
+    /**
+     * @brief Keep track of a control value set while a new instance is prepared or
+     *        waiting to be swapped in, so that it can be applied to the new instance too.
+     *        Called from the rt thread.
+     */
+    void _record_control_value_during_swap(int port_index, float value);
+
+    /**
+     * @brief Run the replaced instance and crossfade its output to the output of the new
+     *        instance, when the crossfade is done the old instance is sent off to be deleted
+     */
+    void _crossfade_from_fading_model(const ChunkSampleBuffer& in_buffer, ChunkSampleBuffer& out_buffer);
+
+    void _retire_fading_model();
+
     void _update_transport();
     uint8_t pos_buf[256];
     LV2_Atom* _lv2_pos{nullptr};
@@ -181,6 +226,27 @@ private:
 
     std::unique_ptr<Model> _model{nullptr};
 
+    /* Only the rt thread replaces _model once the plugin is initialised, non-rt code
+     * must instead use _published_model while holding _model_lock. Replaced models are
+     * only deleted with the lock held. */
+    std::atomic<Model*> _published_model{nullptr};
+    mutable std::mutex _model_lock;
+    std::atomic<int> _current_program{0};
+
+    /* Instances with a new program applied are handed over to the rt thread through
+     * _pending_model. The replaced instance is run in parallel during the crossfade and
+     * then handed back through _retired_model to be deleted by a worker thread */
+    std::atomic<Model*> _pending_model{nullptr};
+    std::unique_ptr<Model> _fading_model{nullptr};
+    std::atomic<Model*> _retired_model{nullptr};
+    BypassManager _program_crossfade{false};
+
+    /* Control values set by the rt thread after the current values were copied to a
+     * new instance, NaN for ports that were not changed. Preallocated in init() */
+    std::atomic<bool> _preparing_model{false};
+    std::vector<float> _control_values_during_swap;
+    ChunkSampleBuffer _crossfade_buffer{LV2_WRAPPER_MAX_N_CHANNELS};
+
     // These are not used for other than the Unit tests,
     // to simulate how the wrapper behaves if multi-threaded.
     PlayState _previous_play_state {PlayState::PAUSED};
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Read only, memory mapped files that are shared between all users of the same file
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "library/mapped_blob.h"
+#include "library/shared_instance_cache.h"
+#include "logging.h"
+
+namespace sushi {
+
+SUSHI_GET_LOGGER_WITH_MODULE_NAME("mapped_blob");
+
+namespace {
+
+/* Identifies a file and the version of it, so that a modified file is not shared with
+ * users of the old contents */
+using FileKey = std::tuple<dev_t, ino_t, off_t, time_t, long>;
+
+SharedInstanceCache<FileKey, const MappedBlob> blob_cache;
+
+size_t page_size()
+{
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // anonymous namespace
+
+MappedBlob::~MappedBlob()
+{
+    munmap(_data, _mapped_size);
+    close(_fd);
+}
+
+std::shared_ptr<const MappedBlob> MappedBlob::map(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        SUSHI_LOG_ERROR("Failed to open file {}", path);
+        return nullptr;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || S_ISREG(file_stat.st_mode) == false || file_stat.st_size <= 0)
+    {
+        SUSHI_LOG_ERROR("File {} is not a regular, non-empty file", path);
+        close(fd);
+        return nullptr;
+    }
+    FileKey key(file_stat.st_dev, file_stat.st_ino, file_stat.st_size,
+                file_stat.st_mtim.tv_sec, file_stat.st_mtim.tv_nsec);
+    auto size = static_cast<size_t>(file_stat.st_size);
+
+    auto blob = blob_cache.get(key, [&]() -> std::shared_ptr<const MappedBlob>
+    {
+        /* Reserve room for the file and the padding with an anonymous mapping, which is
+         * zero filled, then map the file over the start of it. The end of the last page
+         * of the file is also zero filled by the kernel */
+        size_t mapped_size = (size + PADDING_BYTES + page_size() - 1) / page_size() * page_size();
+        void* region = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED)
+        {
+            SUSHI_LOG_ERROR("Failed to reserve {} bytes for mapping {}", mapped_size, path);
+            return nullptr;
+        }
+        void* file_region = mmap(region, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+        if (file_region == MAP_FAILED)
+        {
+            SUSHI_LOG_ERROR("Failed to map file {}", path);
+            munmap(region, mapped_size);
+            return nullptr;
+        }
+        SUSHI_LOG_INFO("Mapped {} bytes from {}", size, path);
+        /* The blob keeps the file open, so that it can be read without the mapping */
+        int blob_fd = dup(fd);
+        if (blob_fd < 0)
+        {
+            SUSHI_LOG_ERROR("Failed to keep file {} open", path);
+            munmap(region, mapped_size);
+            return nullptr;
+        }
+        return std::shared_ptr<const MappedBlob>(new MappedBlob(static_cast<uint8_t*>(file_region),
+                                                                size, mapped_size, blob_fd));
+    });
+    close(fd);
+    return blob;
+}
+
+void MappedBlob::prefetch(size_t offset, size_t bytes) const
+{
+    if (offset >= _mapped_size || bytes == 0)
+    {
+        return;
+    }
+    size_t start = offset / page_size() * page_size();
+    size_t end = std::min(offset + bytes, _mapped_size);
+    madvise(_data + start, end - start, MADV_WILLNEED);
+}
+
+bool MappedBlob::lock(size_t offset, size_t bytes) const
+{
+    if (offset >= _mapped_size || bytes == 0)
+    {
+        return false;
+    }
+    size_t start = offset / page_size() * page_size();
+    size_t end = std::min(offset + bytes, _mapped_size);
+    return mlock(_data + start, end - start) == 0;
+}
+
+size_t MappedBlob::read(size_t offset, uint8_t* destination, size_t bytes) const
+{
+    size_t count = 0;
+    while (count < bytes)
+    {
+        auto res = pread(_fd, destination + count, bytes - count, static_cast<off_t>(offset + count));
+        if (res < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (res <= 0)
+        {
+            break;
+        }
+        count += static_cast<size_t>(res);
+    }
+    return count;
+}
+
+} // end namespace sushi
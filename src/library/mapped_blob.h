@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Read only, memory mapped files that are shared between all users of the same file
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_MAPPED_BLOB_H
+#define SUSHI_MAPPED_BLOB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "library/constants.h"
+
+namespace sushi {
+
+/**
+ * @brief The contents of a file mapped read only into memory. Mapping a file does not
+ *        read it, pages are read from disk when first accessed, so touching data that
+ *        is not locked may block and should not be done from the rt thread.
+ *        All users of the same file share one mapping, which is unmapped when the last
+ *        reference to it is released. As that is a system call, the last reference
+ *        should be released from a non-rt thread.
+ *        A mapped file must not be modified or truncated while it is loaded, touching
+ *        a page that is no longer backed by the file raises SIGBUS. Only small, locked
+ *        ranges should be accessed through data(), larger ones should be copied with
+ *        read(), where a truncated file only results in a short read.
+ */
+class MappedBlob
+{
+    SUSHI_DECLARE_NON_COPYABLE(MappedBlob);
+public:
+    /* Number of bytes after the end of the file that are always readable and set to 0 */
+    static constexpr size_t PADDING_BYTES = 64;
+
+    ~MappedBlob();
+
+    /**
+     * @brief Map a file, or return the existing mapping if the same file is already mapped.
+     *        A file that was modified since it was mapped is mapped again.
+     * @param path Path to a regular, non-empty file
+     * @return The mapped file or nullptr on error
+     */
+    static std::shared_ptr<const MappedBlob> map(const std::string& path);
+
+    const uint8_t* data() const {return _data;}
+
+    /**
+     * @return The size of the file in bytes, not counting the padding
+     */
+    size_t size() const {return _size;}
+
+    /**
+     * @brief Start reading a range of the file into memory in the background
+     * @param offset Start of the range in bytes
+     * @param bytes Size of the range in bytes
+     */
+    void prefetch(size_t offset, size_t bytes) const;
+
+    /**
+     * @brief Read a range of the file into memory and keep it there, so that it can be
+     *        accessed from the rt thread. Best effort, this may fail if the process is
+     *        not allowed to lock enough memory. The pages are unlocked when unmapped.
+     * @param offset Start of the range in bytes
+     * @param bytes Size of the range in bytes
+     * @return true if the range was locked
+     */
+    bool lock(size_t offset, size_t bytes) const;
+
+    /**
+     * @brief Copy a range of the file from disk instead of through the mapping. Not
+     *        safe to call from the rt thread.
+     * @param offset Start of the range in bytes
+     * @param destination Buffer to copy the range to
+     * @param bytes Size of the range in bytes
+     * @return The number of bytes copied, less than bytes if the range extends past
+     *         the end of the file or the file was truncated since it was mapped
+     */
+    size_t read(size_t offset, uint8_t* destination, size_t bytes) const;
+
+private:
+    MappedBlob(uint8_t* data, size_t size, size_t mapped_size, int fd) : _data(data),
+                                                                         _size(size),
+                                                                         _mapped_size(mapped_size),
+                                                                         _fd(fd) {}
+
+    uint8_t* _data;
+    size_t   _size;
+    size_t   _mapped_size;
+    int      _fd;
+};
+
+} // end namespace sushi
+
+#endif //SUSHI_MAPPED_BLOB_H
@@ -220,6 +220,34 @@ MessageType decode_message_type(MidiDataByte data)
     }
 }
 
+int decode_message_size(MidiDataByte data)
+{
+    switch (decode_message_type(data))
+    {
+        case MessageType::PROGRAM_CHANGE:
+        case MessageType::CHANNEL_PRESSURE:
+        case MessageType::TIME_CODE:
+        case MessageType::SONG_SELECT:
+            return 2;
+
+        case MessageType::TUNE_REQUEST:
+        case MessageType::END_OF_EXCLUSIVE:
+        case MessageType::TIMING_CLOCK:
+        case MessageType::START:
+        case MessageType::CONTINUE:
+        case MessageType::STOP:
+        case MessageType::ACTIVE_SENSING:
+        case MessageType::RESET:
+            return 1;
+
+        case MessageType::SYSTEM_EXCLUSIVE:
+        case MessageType::UNKNOWN:
+            return 0;
+
+        default:
+            return 3;
+    }
+}
 
 NoteOffMessage decode_note_off(MidiDataByte data)
 {
@@ -43,6 +43,8 @@ constexpr int PITCH_BEND_MIDDLE = 8192;
 constexpr int MAX_CONTROLLER_NO = 119;
 /* Modulation wheel controller number */
 constexpr int MOD_WHEEL_CONTROLLER_NO = 1;
+/* Number of timing clock messages per quarter note */
+constexpr int CLOCK_TICKS_PER_QUARTER_NOTE = 24;
 
 /**
  * @brief Convert midi data passed in C-array style to internal representation
@@ -196,6 +198,14 @@ struct SongSelectMessage
  */
 MessageType decode_message_type(MidiDataByte data);
 
+/**
+ * @brief Get the length in bytes of a midi message from its status byte.
+ * @param data Midi data.
+ * @return The number of bytes in the message, or 0 if the message can not
+ *         be represented as a MidiDataByte, i.e. system exclusive messages.
+ */
+int decode_message_size(MidiDataByte data);
+
 /**
  * @brief Decode the channel number of a channel mode message.
  *        I.e. when the decoded message type is between
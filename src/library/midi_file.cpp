@@ -0,0 +1,300 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Reading of Standard Midi Files for sequencing midi in offline mode
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "library/midi_file.h"
+#include "logging.h"
+
+namespace sushi {
+namespace midi_file {
+
+SUSHI_GET_LOGGER_WITH_MODULE_NAME("midi file");
+
+constexpr int DEFAULT_TEMPO = 500'000; // Microseconds per quarter note, i.e. 120 bpm
+constexpr uint8_t META_EVENT = 0xFF;
+constexpr uint8_t META_TEMPO = 0x51;
+constexpr uint8_t META_END_OF_TRACK = 0x2F;
+constexpr uint8_t SYSEX_START = 0xF0;
+constexpr uint8_t SYSEX_ESCAPE = 0xF7;
+
+namespace {
+
+/* Bounds checked big endian reader, any read past the end sets the error flag */
+class Reader
+{
+public:
+    Reader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+    uint32_t read(int bytes)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+        {
+            value = (value << 8u) | read_byte();
+        }
+        return value;
+    }
+
+    uint8_t read_byte()
+    {
+        if (_pos >= _size)
+        {
+            _error = true;
+            return 0;
+        }
+        return _data[_pos++];
+    }
+
+    uint8_t peek_byte() const
+    {
+        return _pos < _size ? _data[_pos] : 0;
+    }
+
+    uint32_t read_variable_length()
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint8_t byte = read_byte();
+            value = (value << 7u) | (byte & 0x7Fu);
+            if ((byte & 0x80u) == 0)
+            {
+                return value;
+            }
+        }
+        _error = true;
+        return value;
+    }
+
+    void skip(size_t bytes)
+    {
+        if (bytes > _size - _pos)
+        {
+            _error = true;
+            _pos = _size;
+            return;
+        }
+        _pos += bytes;
+    }
+
+    bool at_end() const {return _pos >= _size;}
+
+    bool error() const {return _error;}
+
+    size_t position() const {return _pos;}
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _pos{0};
+    bool _error{false};
+};
+
+struct TickEvent
+{
+    uint64_t tick;
+    int track;
+    bool tempo_change;
+    uint32_t tempo;
+    MidiDataByte data;
+};
+
+/* Number of data bytes following a channel message status byte */
+int channel_message_length(uint8_t status)
+{
+    switch (status & 0xF0u)
+    {
+        case 0xC0:
+        case 0xD0:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+bool parse_track(Reader& reader, int track, std::vector<TickEvent>& events)
+{
+    uint64_t tick = 0;
+    uint8_t running_status = 0;
+    while (reader.at_end() == false && reader.error() == false)
+    {
+        tick += reader.read_variable_length();
+        uint8_t status = reader.peek_byte();
+        if (status & 0x80u)
+        {
+            reader.read_byte();
+        }
+        else if (running_status != 0)
+        {
+            status = running_status;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (status == META_EVENT)
+        {
+            running_status = 0;
+            uint8_t type = reader.read_byte();
+            uint32_t length = reader.read_variable_length();
+            if (type == META_TEMPO && length == 3)
+            {
+                events.push_back({tick, track, true, reader.read(3), {0}});
+            }
+            else
+            {
+                reader.skip(length);
+            }
+            if (type == META_END_OF_TRACK)
+            {
+                break;
+            }
+        }
+        else if (status == SYSEX_START || status == SYSEX_ESCAPE)
+        {
+            reader.skip(reader.read_variable_length());
+            running_status = 0;
+        }
+        else if (status >= 0xF0u)
+        {
+            /* Other system messages are not allowed in midi files */
+            return false;
+        }
+        else
+        {
+            running_status = status;
+            MidiDataByte data{status, 0, 0, 0};
+            for (int i = 0; i < channel_message_length(status); ++i)
+            {
+                data[i + 1] = reader.read_byte();
+            }
+            events.push_back({tick, track, false, 0, data});
+        }
+    }
+    return reader.error() == false;
+}
+
+} // anonymous namespace
+
+std::pair<MidiFileStatus, std::vector<MidiFileEvent>> parse_midi_file(const std::vector<uint8_t>& data)
+{
+    Reader reader(data.data(), data.size());
+    if (reader.read(4) != 0x4D546864 /* "MThd" */)
+    {
+        SUSHI_LOG_ERROR("Not a midi file, header chunk missing");
+        return {MidiFileStatus::INVALID_FORMAT, {}};
+    }
+    uint32_t header_length = reader.read(4);
+    [[maybe_unused]] uint32_t format = reader.read(2);
+    uint32_t tracks = reader.read(2);
+    uint32_t division = reader.read(2);
+    reader.skip(header_length - std::min(header_length, 6u));
+    if (reader.error() || division == 0)
+    {
+        SUSHI_LOG_ERROR("Invalid midi file header");
+        return {MidiFileStatus::INVALID_FORMAT, {}};
+    }
+
+    std::vector<TickEvent> tick_events;
+    for (int track = 0; track < static_cast<int>(tracks) && reader.at_end() == false; ++track)
+    {
+        uint32_t chunk_type = reader.read(4);
+        uint32_t chunk_length = reader.read(4);
+        if (reader.error() || chunk_length > data.size() - reader.position())
+        {
+            SUSHI_LOG_ERROR("Truncated midi file");
+            return {MidiFileStatus::INVALID_FORMAT, {}};
+        }
+        if (chunk_type != 0x4D54726B /* "MTrk" */)
+        {
+            /* Unknown chunks should be ignored according to the specification */
+            reader.skip(chunk_length);
+            --track;
+            continue;
+        }
+        Reader track_reader(data.data() + reader.position(), chunk_length);
+        if (parse_track(track_reader, track, tick_events) == false)
+        {
+            SUSHI_LOG_ERROR("Invalid data in midi track {}", track);
+            return {MidiFileStatus::INVALID_FORMAT, {}};
+        }
+        reader.skip(chunk_length);
+    }
+
+    /* Tempo changes apply to all tracks, so the events are merged before converting
+     * ticks to seconds. Tempo changes go first when on the same tick as other events */
+    std::stable_sort(tick_events.begin(), tick_events.end(), [](const TickEvent& lhs, const TickEvent& rhs)
+    {
+        return lhs.tick < rhs.tick || (lhs.tick == rhs.tick && lhs.tempo_change && !rhs.tempo_change);
+    });
+
+    bool smpte = division & 0x8000u;
+    double smpte_tick_time = 0.0;
+    if (smpte)
+    {
+        int frames_per_second = -static_cast<int8_t>(division >> 8u);
+        int ticks_per_frame = division & 0xFFu;
+        /* 29 means 29.97 fps drop frame */
+        double fps = frames_per_second == 29 ? 29.97 : frames_per_second;
+        smpte_tick_time = 1.0 / (fps * std::max(ticks_per_frame, 1));
+    }
+
+    std::vector<MidiFileEvent> events;
+    events.reserve(tick_events.size());
+    double seconds_per_tick = smpte ? smpte_tick_time : DEFAULT_TEMPO / (1'000'000.0 * division);
+    double time = 0.0;
+    uint64_t last_tick = 0;
+    for (const auto& event : tick_events)
+    {
+        time += (event.tick - last_tick) * seconds_per_tick;
+        last_tick = event.tick;
+        if (event.tempo_change)
+        {
+            if (smpte == false)
+            {
+                seconds_per_tick = event.tempo / (1'000'000.0 * division);
+            }
+        }
+        else
+        {
+            events.push_back({time, event.track, event.data});
+        }
+    }
+    return {MidiFileStatus::OK, std::move(events)};
+}
+
+std::pair<MidiFileStatus, std::vector<MidiFileEvent>> read_midi_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (file.good() == false)
+    {
+        SUSHI_LOG_ERROR("Unable to open midi file {}", filename);
+        return {MidiFileStatus::INVALID_FILE, {}};
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parse_midi_file(data);
+}
+
+} // end namespace midi_file
+} // end namespace sushi
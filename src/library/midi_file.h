@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Reading of Standard Midi Files for sequencing midi in offline mode
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_MIDI_FILE_H
+#define SUSHI_MIDI_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "library/types.h"
+
+namespace sushi {
+namespace midi_file {
+
+enum class MidiFileStatus
+{
+    OK,
+    INVALID_FILE,
+    INVALID_FORMAT
+};
+
+struct MidiFileEvent
+{
+    double time;        // Time from the start of the file in seconds
+    int track;          // Index of the track in the file
+    MidiDataByte data;
+};
+
+/**
+ * @brief Parse Standard Midi File data. Tempo changes and both metrical and SMPTE
+ *        time divisions are taken into account when converting event times to seconds.
+ *        Meta events and system exclusive messages are not returned.
+ * @param data The contents of a midi file
+ * @return OK and the channel messages of all tracks sorted by time, or an error status
+ */
+std::pair<MidiFileStatus, std::vector<MidiFileEvent>> parse_midi_file(const std::vector<uint8_t>& data);
+
+/**
+ * @brief Read and parse a Standard Midi File
+ * @param filename Path to the midi file
+ * @return OK and the channel messages of all tracks sorted by time, or an error status
+ */
+std::pair<MidiFileStatus, std::vector<MidiFileEvent>> read_midi_file(const std::string& filename);
+
+} // end namespace midi_file
+} // end namespace sushi
+
+#endif //SUSHI_MIDI_FILE_H
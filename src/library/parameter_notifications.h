@@ -0,0 +1,186 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Lock free transfer of parameter change notifications from processors in the
+ *        realtime thread to the event dispatcher. Instead of sending one event per
+ *        parameter write, processors mark the parameter as dirty and store its latest
+ *        value. The dispatcher collects all dirty parameters once per audio chunk, so
+ *        notification traffic scales with the number of changed parameters and not
+ *        with the number of writes, and notifications are never dropped.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_PARAMETER_NOTIFICATIONS_H
+#define SUSHI_PARAMETER_NOTIFICATIONS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "library/id_generator.h"
+
+namespace sushi {
+
+/**
+ * @brief Dirty parameter bitset and value snapshot for one processor. set() is called
+ *        from the realtime thread and consume() from a single non-realtime thread.
+ */
+class ParameterNotificationBuffer
+{
+public:
+    explicit ParameterNotificationBuffer(int parameter_count) : _values(parameter_count),
+                                                                _dirty_words((parameter_count + BITS_PER_WORD - 1) / BITS_PER_WORD)
+    {
+        for (auto& word : _dirty_words)
+        {
+            word.store(0);
+        }
+    }
+
+    /**
+     * @brief Store a new value and mark the parameter as changed. Realtime safe.
+     * @param parameter_id The id (index) of the parameter
+     * @param value The new value
+     * @return false if parameter_id is out of range, true otherwise
+     */
+    bool set(ObjectId parameter_id, float value)
+    {
+        if (parameter_id >= _values.size())
+        {
+            return false;
+        }
+        _values[parameter_id].store(value, std::memory_order_relaxed);
+        _dirty_words[parameter_id / BITS_PER_WORD].fetch_or(uint64_t(1) << (parameter_id % BITS_PER_WORD),
+                                                            std::memory_order_release);
+        _dirty.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @return true if there are parameter changes that have not been consumed
+     */
+    bool dirty() const
+    {
+        return _dirty.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Call function once for every parameter that changed since the last call,
+     *        with the latest value of that parameter, and clear the changes.
+     * @param function Callable with signature void(ObjectId parameter_id, float value)
+     * @return The number of changed parameters
+     */
+    template <typename Function>
+    int consume(Function&& function)
+    {
+        if (_dirty.exchange(false, std::memory_order_acquire) == false)
+        {
+            return 0;
+        }
+        int count = 0;
+        for (size_t w = 0; w < _dirty_words.size(); ++w)
+        {
+            uint64_t bits = _dirty_words[w].exchange(0, std::memory_order_acquire);
+            while (bits)
+            {
+                int bit = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                auto id = static_cast<ObjectId>(w * BITS_PER_WORD + bit);
+                function(id, _values[id].load(std::memory_order_relaxed));
+                count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    static constexpr int BITS_PER_WORD = 64;
+
+    std::vector<std::atomic<float>>    _values;
+    std::vector<std::atomic<uint64_t>> _dirty_words;
+    std::atomic<bool>                  _dirty{false};
+};
+
+/**
+ * @brief Shared area holding the notification buffers of all processors. Buffers are
+ *        added and removed from the non-realtime thread that creates and deletes the
+ *        processors, and consumed by the event dispatcher. The realtime thread only
+ *        accesses the buffers directly and never takes the lock.
+ */
+class ParameterNotificationArea
+{
+public:
+    /**
+     * @brief Create a notification buffer for a processor. Not realtime safe.
+     * @param processor_id The id of the processor
+     * @param parameter_count The number of parameters of the processor
+     * @return A pointer to the buffer, valid until remove() is called for the processor
+     */
+    ParameterNotificationBuffer* add(ObjectId processor_id, int parameter_count)
+    {
+        std::scoped_lock lock(_buffer_lock);
+        auto& buffer = _buffers[processor_id];
+        buffer = std::make_unique<ParameterNotificationBuffer>(parameter_count);
+        return buffer.get();
+    }
+
+    /**
+     * @brief Delete the notification buffer of a processor. Must not be called while the
+     *        processor is still processing in the realtime thread.
+     * @param processor_id The id of the processor
+     */
+    void remove(ObjectId processor_id)
+    {
+        std::scoped_lock lock(_buffer_lock);
+        _buffers.erase(processor_id);
+    }
+
+    /**
+     * @brief Call function for every parameter of every processor that changed since
+     *        the last call.
+     * @param function Callable with signature void(ObjectId processor_id, ObjectId parameter_id, float value)
+     * @return The number of changed parameters
+     */
+    template <typename Function>
+    int consume(Function&& function)
+    {
+        std::scoped_lock lock(_buffer_lock);
+        int count = 0;
+        for (auto& [processor_id, buffer] : _buffers)
+        {
+            if (buffer->dirty())
+            {
+                ObjectId id = processor_id;
+                count += buffer->consume([&](ObjectId parameter_id, float value)
+                                         {
+                                             function(id, parameter_id, value);
+                                         });
+            }
+        }
+        return count;
+    }
+
+private:
+    std::mutex _buffer_lock;
+    std::map<ObjectId, std::unique_ptr<ParameterNotificationBuffer>> _buffers;
+};
+
+} // end namespace sushi
+
+#endif //SUSHI_PARAMETER_NOTIFICATIONS_H
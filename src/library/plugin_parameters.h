@@ -25,6 +25,8 @@
 #include <cmath>
 #include <string>
 #include <cassert>
+#include <type_traits>
+#include <vector>
 
 #include "library/constants.h"
 #include "library/id_generator.h"
@@ -111,15 +113,30 @@ protected:
 };
 
 
+/**
+ * @brief The kinds of mappings a parameter preprocessor can do. Known kinds are applied
+ *        inline by ParameterBlock, only CUSTOM preprocessors are called through their
+ *        virtual functions.
+ */
+enum class PreProcessorKind : uint8_t
+{
+    LINEAR,
+    DB_TO_LIN,
+    LIN_TO_DB,
+    CUSTOM
+};
+
 /**
  * @brief Parameter preprocessor for scaling or non-linear mapping. This basic,
- * templated base class with no processing implemented.
+ * templated base class with no processing implemented. Derived classes must pass
+ * their kind to the base class, PreProcessorKind::CUSTOM unless they implement one
+ * of the known kinds. Use LinearParameterPreProcessor for plain linear parameters.
  */
 template<typename T>
 class ParameterPreProcessor
 {
 public:
-    ParameterPreProcessor(T min, T max): _min_domain_value(min), _max_domain_value(max) {}
+    virtual ~ParameterPreProcessor() = default;
 
     virtual T process_to_plugin(T value)
     {
@@ -141,14 +158,36 @@ public:
         return _max_normalized + (_min_normalized - _max_normalized) / (_min_domain_value - _max_domain_value) * (value - _max_domain_value);
     }
 
+    PreProcessorKind kind() const {return _kind;}
+
+    T min_domain_value() const {return _min_domain_value;}
+
+    T max_domain_value() const {return _max_domain_value;}
+
 protected:
+    ParameterPreProcessor(T min, T max, PreProcessorKind kind): _min_domain_value(min),
+                                                                _max_domain_value(max),
+                                                                _kind(kind) {}
+
     T _min_domain_value;
     T _max_domain_value;
+    PreProcessorKind _kind;
 
     static constexpr float _min_normalized{0.0f};
     static constexpr float _max_normalized{1.0f};
 };
 
+/**
+ * @brief Linear mapping between the normalized and domain range. Final, as a derived
+ * class overriding the processing functions would otherwise be taken to be linear.
+ */
+template<typename T>
+class LinearParameterPreProcessor final : public ParameterPreProcessor<T>
+{
+public:
+    LinearParameterPreProcessor(T min, T max): ParameterPreProcessor<T>(min, max, PreProcessorKind::LINEAR) {}
+};
+
 /**
  * @brief Formatter used to format the parameter value to a string
  */
@@ -248,9 +287,9 @@ public:
  * Instead, the typedefs below provide direct access to the right
  * type combinations.
  */
-typedef ParameterPreProcessor<float> FloatParameterPreProcessor;
-typedef ParameterPreProcessor<int>   IntParameterPreProcessor;
-typedef ParameterPreProcessor<bool>  BoolParameterPreProcessor;
+typedef LinearParameterPreProcessor<float> FloatParameterPreProcessor;
+typedef LinearParameterPreProcessor<int>   IntParameterPreProcessor;
+typedef LinearParameterPreProcessor<bool>  BoolParameterPreProcessor;
 
 typedef TypedParameterDescriptor<float, ParameterType::FLOAT>         FloatParameterDescriptor;
 typedef TypedParameterDescriptor<int, ParameterType::INT>             IntParameterDescriptor;
@@ -262,10 +301,10 @@ typedef TypedParameterDescriptor<BlobData, ParameterType::DATA>       DataProper
 /**
  * @brief Preprocessor example to map from decibels to linear gain.
  */
-class dBToLinPreProcessor : public FloatParameterPreProcessor
+class dBToLinPreProcessor : public ParameterPreProcessor<float>
 {
 public:
-    dBToLinPreProcessor(float min, float max): FloatParameterPreProcessor(min, max) {}
+    dBToLinPreProcessor(float min, float max): ParameterPreProcessor<float>(min, max, PreProcessorKind::DB_TO_LIN) {}
 
     float process_to_plugin(float value) override
     {
@@ -281,10 +320,10 @@ public:
 /**
  * @brief Preprocessor example to map from linear gain to decibels.
  */
-class LinTodBPreProcessor : public FloatParameterPreProcessor
+class LinTodBPreProcessor : public ParameterPreProcessor<float>
 {
 public:
-    LinTodBPreProcessor(float min, float max): FloatParameterPreProcessor(min, max) {}
+    LinTodBPreProcessor(float min, float max): ParameterPreProcessor<float>(min, max, PreProcessorKind::LIN_TO_DB) {}
 
     float process_to_plugin(float value) override
     {
@@ -297,44 +336,245 @@ public:
     }
 };
 
-template<typename T, ParameterType enumerated_type>
-class ParameterValue
+/**
+ * @brief Flat storage for the parameter values of one processor. The values are kept in
+ *        separate arrays indexed by parameter id, so reading the processed values of many
+ *        parameters touches only a few cache lines. Int and bool values are stored as
+ *        floats, which is exact for the ranges that parameters use. Parameters are added
+ *        from the non-rt thread before the processor is used, after that only values change.
+ */
+class ParameterBlock
 {
 public:
-    ParameterValue(ParameterPreProcessor<T>* pre_processor,
-                   T value, ParameterDescriptor* descriptor) : _descriptor(descriptor),
-                                                               _pre_processor(pre_processor),
-                                                               _processed_value(pre_processor->process_to_plugin(value)),
-                                                               _normalized_value(pre_processor->to_normalized(value)) {}
+    /**
+     * @brief Add a float or int parameter
+     * @param descriptor The descriptor of the parameter
+     * @param default_value The default value, in the parameter's domain
+     * @param pre_processor Gives the range and mapping of the parameter. Only kept after
+     *        this call if it is of kind CUSTOM, in which case it must outlive the block.
+     * @return The index of the new parameter
+     */
+    template <typename T>
+    int add_parameter(ParameterDescriptor* descriptor, T default_value, ParameterPreProcessor<T>* pre_processor)
+    {
+        static_assert(std::is_same_v<T, float> || std::is_same_v<T, int>);
+        Info info;
+        info.descriptor = descriptor;
+        info.type = std::is_same_v<T, float> ? ParameterType::FLOAT : ParameterType::INT;
+        info.kind = pre_processor->kind();
+        info.min = static_cast<float>(pre_processor->min_domain_value());
+        info.max = static_cast<float>(pre_processor->max_domain_value());
+        if constexpr (std::is_same_v<T, float>)
+        {
+            info.float_pre_processor = pre_processor;
+        }
+        else
+        {
+            info.int_pre_processor = pre_processor;
+        }
+        _info.push_back(info);
+        _processed.push_back(static_cast<float>(_to_plugin<T>(info, default_value)));
+        _normalized.push_back(_to_normalized(info, default_value));
+        return static_cast<int>(_info.size()) - 1;
+    }
 
-    ParameterType type() const {return _type;}
+    /**
+     * @brief Add a bool parameter, these have no preprocessor
+     * @param descriptor The descriptor of the parameter
+     * @param default_value The default value
+     * @return The index of the new parameter
+     */
+    int add_bool_parameter(ParameterDescriptor* descriptor, bool default_value)
+    {
+        Info info;
+        info.descriptor = descriptor;
+        info.type = ParameterType::BOOL;
+        _info.push_back(info);
+        _processed.push_back(default_value ? 1.0f : 0.0f);
+        _normalized.push_back(default_value ? 1.0f : 0.0f);
+        return static_cast<int>(_info.size()) - 1;
+    }
+
+    int size() const {return static_cast<int>(_info.size());}
 
-    T processed_value() const {return _processed_value;}
+    ParameterType type(int index) const {return _info[index].type;}
+
+    ParameterDescriptor* descriptor(int index) const {return _info[index].descriptor;}
+
+    float processed_value(int index) const {return _processed[index];}
+
+    float normalized_value(int index) const {return _normalized[index];}
+
+    template <typename T>
+    T domain_value(int index) const
+    {
+        const auto& info = _info[index];
+        return _from_plugin<T>(info, _to_domain<T>(info, _normalized[index]));
+    }
 
-    T domain_value() const {return _pre_processor->process_from_plugin(_pre_processor->to_domain(_normalized_value));}
+    /* Get the processed value for a normalised value without changing the parameter */
+    template <typename T>
+    T process_normalized(int index, float value_normalized) const
+    {
+        const auto& info = _info[index];
+        return _to_plugin<T>(info, _to_domain<T>(info, value_normalized));
+    }
 
-    float normalized_value() const { return _normalized_value; }
+    template <typename T>
+    void set(int index, float value_normalized)
+    {
+        _normalized[index] = value_normalized;
+        _processed[index] = static_cast<float>(process_normalized<T>(index, value_normalized));
+    }
 
-    ParameterDescriptor* descriptor() const {return _descriptor;}
+    template <typename T>
+    void set_processed(int index, float value_processed)
+    {
+        const auto& info = _info[index];
+        T value = static_cast<T>(value_processed);
+        _processed[index] = static_cast<float>(value);
+        _normalized[index] = _to_normalized(info, _from_plugin<T>(info, value));
+    }
 
-    void set(float value_normalized)
+    void set_bool(int index, bool value)
     {
-        _normalized_value = value_normalized;
-        _processed_value = _pre_processor->process_to_plugin(_pre_processor->to_domain(value_normalized));
+        _processed[index] = value ? 1.0f : 0.0f;
+        _normalized[index] = _processed[index];
     }
 
-    void set_processed(float value_processed)
+    /**
+     * @brief Set any type of parameter from a normalised value, as received in parameter
+     *        change events.
+     */
+    void set_normalized(int index, float value_normalized)
     {
-        _processed_value = value_processed;
-        _normalized_value = _pre_processor->to_normalized(_pre_processor->process_from_plugin(value_processed));
+        switch (_info[index].type)
+        {
+            case ParameterType::FLOAT:
+                set<float>(index, value_normalized);
+                break;
+
+            case ParameterType::INT:
+                set<int>(index, value_normalized);
+                break;
+
+            case ParameterType::BOOL:
+                set_bool(index, static_cast<bool>(value_normalized));
+                break;
+
+            default:
+                break;
+        }
     }
 
 private:
-    ParameterType _type{enumerated_type};
-    ParameterDescriptor* _descriptor{nullptr};
-    ParameterPreProcessor<T>* _pre_processor{nullptr};
-    T _processed_value;
-    float _normalized_value; // Always not processed, but raw as set from the outside.
+    /* Everything except the values, only touched when a value is set or converted */
+    struct Info
+    {
+        ParameterDescriptor* descriptor{nullptr};
+        ParameterType type{ParameterType::BOOL};
+        PreProcessorKind kind{PreProcessorKind::LINEAR};
+        float min{0.0f};
+        float max{1.0f};
+        union
+        {
+            ParameterPreProcessor<float>* float_pre_processor{nullptr};
+            ParameterPreProcessor<int>*   int_pre_processor;
+        };
+    };
+
+    template <typename T>
+    static ParameterPreProcessor<T>* _pre_processor(const Info& info)
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return info.float_pre_processor;
+        }
+        else
+        {
+            return info.int_pre_processor;
+        }
+    }
+
+    /* Same mappings as ParameterPreProcessor and the derived preprocessors above */
+    template <typename T>
+    static T _to_domain(const Info& info, float value_normalized)
+    {
+        return static_cast<T>(info.max + (info.min - info.max) / (MIN_NORMALIZED - MAX_NORMALIZED) * (value_normalized - MAX_NORMALIZED));
+    }
+
+    template <typename T>
+    static float _to_normalized(const Info& info, T value)
+    {
+        return MAX_NORMALIZED + (MIN_NORMALIZED - MAX_NORMALIZED) / (info.min - info.max) * (static_cast<float>(value) - info.max);
+    }
+
+    template <typename T>
+    static T _to_plugin(const Info& info, T value)
+    {
+        switch (info.kind)
+        {
+            case PreProcessorKind::DB_TO_LIN:
+                return static_cast<T>(powf(10.0f, value / 20.0f));
+
+            case PreProcessorKind::LIN_TO_DB:
+                return static_cast<T>(20.0f * log10(value));
+
+            case PreProcessorKind::CUSTOM:
+                return _pre_processor<T>(info)->process_to_plugin(value);
+
+            default:
+                return value;
+        }
+    }
+
+    template <typename T>
+    static T _from_plugin(const Info& info, T value)
+    {
+        if (info.kind == PreProcessorKind::CUSTOM)
+        {
+            return _pre_processor<T>(info)->process_from_plugin(value);
+        }
+        return value;
+    }
+
+    static constexpr float MIN_NORMALIZED = 0.0f;
+    static constexpr float MAX_NORMALIZED = 1.0f;
+
+    std::vector<float> _processed;
+    std::vector<float> _normalized;
+    std::vector<Info>  _info;
+};
+
+/**
+ * @brief Typed handle to a parameter value in a ParameterBlock
+ */
+template<typename T, ParameterType enumerated_type>
+class ParameterValue
+{
+public:
+    ParameterValue(ParameterBlock* block, int index) : _block(block), _index(index) {}
+
+    ParameterType type() const {return enumerated_type;}
+
+    T processed_value() const {return static_cast<T>(_block->processed_value(_index));}
+
+    T domain_value() const {return _block->domain_value<T>(_index);}
+
+    float normalized_value() const {return _block->normalized_value(_index);}
+
+    ParameterDescriptor* descriptor() const {return _block->descriptor(_index);}
+
+    /* Get the processed value for a normalised value without changing the parameter */
+    T process_normalized(float value_normalized) const {return _block->process_normalized<T>(_index, value_normalized);}
+
+    void set(float value_normalized) {_block->set<T>(_index, value_normalized);}
+
+    void set_processed(float value_processed) {_block->set_processed<T>(_index, value_processed);}
+
+private:
+    ParameterBlock* _block;
+    int _index;
 };
 
 /* Specialization for bool values, lack a pre_processor */
@@ -342,99 +582,91 @@ template<>
 class ParameterValue<bool, ParameterType::BOOL>
 {
 public:
-    ParameterValue(bool value, ParameterDescriptor* descriptor) : _descriptor(descriptor),
-                                                                  _processed_value(value) {}
+    ParameterValue(ParameterBlock* block, int index) : _block(block), _index(index) {}
 
-    ParameterType type() const {return _type;}
-    bool processed_value() const {return _processed_value;}
-    bool domain_value() const {return _processed_value;}
-    ParameterDescriptor* descriptor() const {return _descriptor;}
+    ParameterType type() const {return ParameterType::BOOL;}
+    bool processed_value() const {return _block->processed_value(_index) != 0.0f;}
+    bool domain_value() const {return processed_value();}
+    ParameterDescriptor* descriptor() const {return _block->descriptor(_index);}
 
-    void set_values(bool value, bool raw_value) { _processed_value = value; _processed_value = raw_value;}
-    void set(bool value) { _processed_value = value;}
+    void set_values(bool /*value*/, bool raw_value) {_block->set_bool(_index, raw_value);}
+    void set(bool value) {_block->set_bool(_index, value);}
 
 private:
-    ParameterType _type{ParameterType::BOOL};
-    ParameterDescriptor* _descriptor{nullptr};
-    bool _processed_value;
+    ParameterBlock* _block;
+    int _index;
 };
 
 typedef ParameterValue<bool, ParameterType::BOOL> BoolParameterValue;
 typedef ParameterValue<int, ParameterType::INT> IntParameterValue;
 typedef ParameterValue<float, ParameterType::FLOAT> FloatParameterValue;
 
+/**
+ * @brief Holds a handle of any type to a parameter in a ParameterBlock
+ */
 class ParameterStorage
 {
 public:
     BoolParameterValue* bool_parameter_value()
     {
-        assert(_bool_value.type() == ParameterType::BOOL);
+        assert(_type == ParameterType::BOOL);
         return &_bool_value;
     }
 
     IntParameterValue* int_parameter_value()
     {
-        assert(_int_value.type() == ParameterType::INT);
+        assert(_type == ParameterType::INT);
         return &_int_value;
     }
 
     FloatParameterValue* float_parameter_value()
     {
-        assert(_float_value.type() == ParameterType::FLOAT);
+        assert(_type == ParameterType::FLOAT);
         return &_float_value;
     }
 
     const BoolParameterValue* bool_parameter_value() const
     {
-        assert(_bool_value.type() == ParameterType::BOOL);
+        assert(_type == ParameterType::BOOL);
         return &_bool_value;
     }
 
     const IntParameterValue* int_parameter_value() const
     {
-        assert(_int_value.type() == ParameterType::INT);
+        assert(_type == ParameterType::INT);
         return &_int_value;
     }
 
     const FloatParameterValue* float_parameter_value() const
     {
-        assert(_float_value.type() == ParameterType::FLOAT);
+        assert(_type == ParameterType::FLOAT);
         return &_float_value;
     }
 
-    ParameterType type() const {return _float_value.type();}
-
-    ObjectId id() const {return _bool_value.descriptor()->id();}
+    ParameterType type() const {return _type;}
 
-    /* Factory functions for construction */
-    static ParameterStorage make_bool_parameter_storage(ParameterDescriptor* descriptor,
-                                                        bool default_value)
+    /* Factory function for construction, the type is taken from the block */
+    static ParameterStorage make_parameter_storage(ParameterBlock* block, int index)
     {
-        BoolParameterValue value(default_value, descriptor);
-        return ParameterStorage(value);
-    }
+        switch (block->type(index))
+        {
+            case ParameterType::FLOAT:
+                return ParameterStorage(FloatParameterValue(block, index));
 
-    static ParameterStorage make_int_parameter_storage(ParameterDescriptor* descriptor,
-                                                       int default_value,
-                                                       IntParameterPreProcessor* pre_processor)
-    {
-        IntParameterValue value(pre_processor, default_value, descriptor);
-        return ParameterStorage(value);
-    }
+            case ParameterType::INT:
+                return ParameterStorage(IntParameterValue(block, index));
 
-    static ParameterStorage make_float_parameter_storage(ParameterDescriptor* descriptor,
-                                                         float default_value,
-                                                         FloatParameterPreProcessor* pre_processor)
-    {
-        FloatParameterValue value(pre_processor, default_value, descriptor);
-        return ParameterStorage(value);
+            default:
+                return ParameterStorage(BoolParameterValue(block, index));
+        }
     }
 
 private:
-    ParameterStorage(BoolParameterValue value) : _bool_value(value) {}
-    ParameterStorage(IntParameterValue value) : _int_value(value) {}
-    ParameterStorage(FloatParameterValue value) : _float_value(value) {}
+    ParameterStorage(BoolParameterValue value) : _type(ParameterType::BOOL), _bool_value(value) {}
+    ParameterStorage(IntParameterValue value) : _type(ParameterType::INT), _int_value(value) {}
+    ParameterStorage(FloatParameterValue value) : _type(ParameterType::FLOAT), _float_value(value) {}
 
+    ParameterType _type;
     union
     {
         BoolParameterValue  _bool_value;
@@ -56,7 +56,7 @@ bool Processor::register_parameter(ParameterDescriptor* parameter, ObjectId id)
         if (p->id() == id) return false; // Don't allow duplicate parameter id:s
     }
     bool inserted = true;
-    std::tie(std::ignore, inserted) = _parameters.insert(std::pair<std::string, std::unique_ptr<ParameterDescriptor>>(parameter->name(), std::unique_ptr<ParameterDescriptor>(parameter)));
+    std::tie(std::ignore, inserted) = _parameters.emplace(std::string_view(parameter->name()), std::unique_ptr<ParameterDescriptor>(parameter));
     if (!inserted)
     {
         return false;
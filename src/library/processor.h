@@ -23,6 +23,7 @@
 #define SUSHI_PROCESSOR_H
 
 #include <map>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -31,6 +32,7 @@
 #include "library/rt_event_pipe.h"
 #include "library/id_generator.h"
 #include "library/plugin_parameters.h"
+#include "library/parameter_notifications.h"
 #include "engine/host_control.h"
 
 namespace sushi {
@@ -128,6 +130,18 @@ public:
         _output_pipe = pipe;
     }
 
+    /**
+     * @brief Set a buffer for parameter change notifications. If set, parameter changes
+     *        from output_parameter_notification() are written here instead of being
+     *        sent as events. Not safe to call while the processor is processing.
+     * @param buffer A notification buffer with room for all parameters of this processor,
+     *        or nullptr to send notifications as events.
+     */
+    void set_parameter_notification_buffer(ParameterNotificationBuffer* buffer)
+    {
+        _parameter_notifications = buffer;
+    }
+
     /**
      * @brief Get the number of parameters of this processor.
      * @return The number of registered parameters for this processor.
@@ -140,7 +154,7 @@ public:
      * @return A pointer to the parameter descriptor or a null pointer
      *         if there is no processor with that name
      */
-    const ParameterDescriptor* parameter_from_name(const std::string& name) const
+    const ParameterDescriptor* parameter_from_name(std::string_view name) const
     {
         auto p = _parameters.find(name);
         return (p != _parameters.end()) ? p->second.get() : nullptr;
@@ -250,6 +264,26 @@ public:
         return {ProcessorReturnCode::PARAMETER_NOT_FOUND, ""};
     };
 
+    /**
+     * @brief Get the last value set for a string property, safe to call from a non rt-thread
+     * @param property_id The Id of the requested property
+     * @return The current value of the property, if the return code is OK
+     */
+    virtual std::pair<ProcessorReturnCode, std::string> string_property_value(ObjectId /*property_id*/) const
+    {
+        return {ProcessorReturnCode::UNSUPPORTED_OPERATION, ""};
+    };
+
+    /**
+     * @brief Get the last value set for a data property, safe to call from a non rt-thread
+     * @param property_id The Id of the requested property
+     * @return A copy of the current data of the property, if the return code is OK
+     */
+    virtual std::pair<ProcessorReturnCode, std::vector<uint8_t>> data_property_value(ObjectId /*property_id*/) const
+    {
+        return {ProcessorReturnCode::UNSUPPORTED_OPERATION, {}};
+    };
+
     /**
      * @brief Whether or not the processor supports programs/presets
      * @return True if the processor supports programs, false otherwise
@@ -311,6 +345,25 @@ public:
      * @return ProcessorReturnCode::OK on success, error code on failure
      */
     virtual ProcessorReturnCode connect_cv_from_parameter(ObjectId parameter_id, int cv_output_id);
+
+    /**
+     * @brief Query if the processor can use an audio rate cv signal as modulation source
+     *        for a parameter. If not, cv inputs connected to the parameter are sent as
+     *        parameter change events when their value change.
+     * @param parameter_id The id of the parameter
+     * @return true if set_cv_signal() is supported for this parameter
+     */
+    virtual bool supports_cv_signal(ObjectId /*parameter_id*/) const {return false;}
+
+    /**
+     * @brief Set the audio rate cv signal that modulates a parameter. Called from the audio
+     *        thread before every chunk is processed.
+     * @param parameter_id The id of the parameter
+     * @param signal audio_chunk_size() values in the normalised range [0, 1], only valid
+     *               for the duration of the current chunk.
+     */
+    virtual void set_cv_signal(ObjectId /*parameter_id*/, const float* /*signal*/) {}
+
     /**
      * @brief Connect note on and off events with a particular channel and note number
      *        from this processor to a gate output.
@@ -355,6 +408,20 @@ protected:
             _output_pipe->send_event(event);
     }
 
+    /**
+     * @brief Notify the host that a parameter changed. Repeated notifications for the same
+     *        parameter within a chunk are coalesced if a notification buffer is set.
+     * @param parameter_id The id of the parameter
+     * @param value The new value of the parameter
+     */
+    void output_parameter_notification(ObjectId parameter_id, float value)
+    {
+        if (_parameter_notifications == nullptr || _parameter_notifications->set(parameter_id, value) == false)
+        {
+            output_event(RtEvent::make_parameter_change_event(this->id(), 0, parameter_id, value));
+        }
+    }
+
     /**
      * @brief Handle parameter updates if connected to cv outputs and send cv output event if
      *        the parameter is connected to a cv output
@@ -403,13 +470,15 @@ protected:
 
 private:
     RtEventPipe* _output_pipe{nullptr};
+    ParameterNotificationBuffer* _parameter_notifications{nullptr};
     /* Automatically generated unique id for identifying this processor */
     ObjectId _id{ProcessorIdGenerator::new_id()};
 
     std::string _unique_name{""};
     std::string _label{""};
 
-    std::map<std::string, std::unique_ptr<ParameterDescriptor>> _parameters;
+    /* Keys refer to the names stored in the descriptors, so lookups by name never allocate */
+    std::unordered_map<std::string_view, std::unique_ptr<ParameterDescriptor>> _parameters;
     std::vector<ParameterDescriptor*> _parameters_by_index;
 
     struct CvOutConnection
@@ -439,7 +508,7 @@ constexpr std::chrono::duration<float, std::ratio<1,1>> BYPASS_RAMP_TIME = std::
 
 static int chunks_to_ramp(float sample_rate)
 {
-    return static_cast<int>(std::floor(std::max(1.0f, (sample_rate * BYPASS_RAMP_TIME.count() / AUDIO_CHUNK_SIZE))));
+    return static_cast<int>(std::floor(std::max(1.0f, (sample_rate * BYPASS_RAMP_TIME.count() / audio_chunk_size()))));
 }
 
 /**
@@ -482,6 +551,16 @@ public:
         }
     }
 
+    /**
+     * @brief Set the bypass state directly without ramping, i.e. to start a new crossfade
+     *        from a known state
+     * @param bypass_enabled If true, sets bypass enabled, if false, turns off bypass
+     */
+    void reset(bool bypass_enabled)
+    {
+        _state = bypass_enabled ? BypassState::BYPASSED : BypassState::NOT_BYPASSED;
+    }
+
     /**
      * @return true if the processors processing functions needs to be called, false otherwise
      */
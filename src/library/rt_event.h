@@ -65,6 +65,7 @@ enum class RtEventType
     TIME_SIGNATURE,
     PLAYING_MODE,
     SYNC_MODE,
+    SYNC_CLOCK,
     /* Processor add/delete/reorder events */
     INSERT_PROCESSOR,
     REMOVE_PROCESSOR,
@@ -72,6 +73,7 @@ enum class RtEventType
     REMOVE_PROCESSOR_FROM_TRACK,
     ADD_TRACK,
     REMOVE_TRACK,
+    SESSION_UPDATE,
     ASYNC_WORK,
     ASYNC_WORK_NOTIFICATION,
     /* Delete object event */
@@ -82,6 +84,7 @@ enum class RtEventType
     SYNC,
     /* Engine notification events */
     CLIP_NOTIFICATION,
+    LINK_PEERS_NOTIFICATION,
 };
 
 class BaseRtEvent
@@ -106,6 +109,13 @@ public:
      */
     int sample_offset() const {return _sample_offset;}
 
+    /**
+     * @brief Reschedule the event, used when an event is created ahead of time
+     *        and the chunk it will be delivered in is not known in advance.
+     * @param offset The new sample offset
+     */
+    void set_sample_offset(int offset) {_sample_offset = offset;}
+
 protected:
     BaseRtEvent(RtEventType type, ObjectId target, int offset) : _type(type),
                                                                  _processor_id(target),
@@ -394,6 +404,21 @@ private:
     ObjectId _track;
 };
 
+namespace engine {struct RtSessionUpdate;}
+
+/* Carries a set of changes from a session restore that the engine applies in a single
+ * chunk. The update is owned by the sender and must be kept alive until the event has
+ * been returned. */
+class SessionUpdateRtEvent : public ReturnableRtEvent
+{
+public:
+    SessionUpdateRtEvent(engine::RtSessionUpdate* update) : ReturnableRtEvent(RtEventType::SESSION_UPDATE, 0),
+                                                            _update{update} {}
+    engine::RtSessionUpdate* update() const {return _update;}
+private:
+    engine::RtSessionUpdate* _update;
+};
+
 typedef int (*AsyncWorkCallback)(void* data, EventId id);
 
 class AsyncWorkRtEvent: public ReturnableRtEvent
@@ -506,6 +531,34 @@ protected:
     SyncMode _mode;
 };
 
+/* RtEvent for passing clock ticks and start/stop messages from an external sync source */
+class SyncClockRtEvent : public BaseRtEvent
+{
+public:
+    enum class ClockType
+    {
+        TICK,
+        START,
+        CONTINUE,
+        STOP
+    };
+    SyncClockRtEvent(int offset, SyncMode source, ClockType clock_type, int ppq_ticks) : BaseRtEvent(RtEventType::SYNC_CLOCK,
+                                                                                                     0,
+                                                                                                     offset),
+                                                                                         _source(source),
+                                                                                         _clock_type(clock_type),
+                                                                                         _ppq_ticks(ppq_ticks) {}
+
+    SyncMode source() const {return _source;}
+    ClockType clock_type() const {return _clock_type;}
+    int ppq_ticks() const {return _ppq_ticks;}
+
+protected:
+    SyncMode  _source;
+    ClockType _clock_type;
+    int       _ppq_ticks;
+};
+
 /* RtEvent for notifing the engine of audio clipping in the realtime */
 class ClipNotificationRtEvent : public BaseRtEvent
 {
@@ -529,6 +582,19 @@ private:
     ClipChannelType _channel_type;
 };
 
+/* RtEvent for notifying the engine of a change in the number of connected Link peers */
+class LinkPeersNotificationRtEvent : public BaseRtEvent
+{
+public:
+    LinkPeersNotificationRtEvent(int offset, int peers) : BaseRtEvent(RtEventType::LINK_PEERS_NOTIFICATION, 0, offset),
+                                                          _peers(peers) {}
+
+    int peers() const {return _peers;}
+
+private:
+    int _peers;
+};
+
 /**
  * @brief Container class for rt events. Functionally this take the role of a
  *        baseclass for events, from which you can access the derived event
@@ -546,6 +612,8 @@ public:
 
     int sample_offset() const {return _base_event.sample_offset();}
 
+    void set_sample_offset(int offset) {_base_event.set_sample_offset(offset);}
+
     /* Access functions protected by asserts */
     const KeyboardRtEvent* keyboard_event() const
     {
@@ -652,6 +720,18 @@ public:
         return &_processor_reorder_event;
     }
 
+    const SessionUpdateRtEvent* session_update_event() const
+    {
+        assert(_session_update_event.type() == RtEventType::SESSION_UPDATE);
+        return &_session_update_event;
+    }
+
+    SessionUpdateRtEvent* session_update_event()
+    {
+        assert(_session_update_event.type() == RtEventType::SESSION_UPDATE);
+        return &_session_update_event;
+    }
+
     const AsyncWorkRtEvent* async_work_event() const
     {
         assert(_async_work_event.type() == RtEventType::ASYNC_WORK);
@@ -709,12 +789,24 @@ public:
         return &_sync_mode_event;
     }
 
+    const SyncClockRtEvent* sync_clock_event() const
+    {
+        assert(_sync_clock_event.type() == RtEventType::SYNC_CLOCK);
+        return &_sync_clock_event;
+    }
+
     const ClipNotificationRtEvent* clip_notification_event() const
     {
         assert(_clip_notification_event.type() == RtEventType::CLIP_NOTIFICATION);
         return &_clip_notification_event;
     }
 
+    const LinkPeersNotificationRtEvent* link_peers_notification_event() const
+    {
+        assert(_link_peers_notification_event.type() == RtEventType::LINK_PEERS_NOTIFICATION);
+        return &_link_peers_notification_event;
+    }
+
 
     /* Factory functions for constructing events */
     static RtEvent make_note_on_event(ObjectId target, int offset, int channel, int note, float velocity)
@@ -843,6 +935,12 @@ public:
         return RtEvent(typed_event);
     }
 
+    static RtEvent make_session_update_event(engine::RtSessionUpdate* update)
+    {
+        SessionUpdateRtEvent typed_event(update);
+        return RtEvent(typed_event);
+    }
+
     static RtEvent make_async_work_event(AsyncWorkCallback callback, ObjectId processor, void* data)
     {
         AsyncWorkRtEvent typed_event(callback, processor, data);
@@ -903,12 +1001,24 @@ public:
         return typed_event;
     }
 
+    static RtEvent make_sync_clock_event(int offset, SyncMode source, SyncClockRtEvent::ClockType clock_type, int ppq_ticks)
+    {
+        SyncClockRtEvent typed_event(offset, source, clock_type, ppq_ticks);
+        return typed_event;
+    }
+
     static RtEvent make_clip_notification_event(int offset, int channel, ClipNotificationRtEvent::ClipChannelType type)
     {
         ClipNotificationRtEvent typed_event(offset, channel, type);
         return typed_event;
     }
 
+    static RtEvent make_link_peers_notification_event(int offset, int peers)
+    {
+        LinkPeersNotificationRtEvent typed_event(offset, peers);
+        return typed_event;
+    }
+
 
 private:
     /* Private constructors that are invoked automatically when using the make_xxx_event functions */
@@ -924,6 +1034,7 @@ private:
     RtEvent(const ReturnableRtEvent& e) : _returnable_event(e) {}
     RtEvent(const ProcessorOperationRtEvent& e) : _processor_operation_event(e) {}
     RtEvent(const ProcessorReorderRtEvent& e) : _processor_reorder_event(e) {}
+    RtEvent(const SessionUpdateRtEvent& e) : _session_update_event(e) {}
     RtEvent(const AsyncWorkRtEvent& e) : _async_work_event(e) {}
     RtEvent(const AsyncWorkRtCompletionEvent& e) : _async_work_completion_event(e) {}
     RtEvent(const DataPayloadRtEvent& e) : _data_payload_event(e) {}
@@ -932,7 +1043,9 @@ private:
     RtEvent(const TimeSignatureRtEvent& e) : _time_signature_event(e) {}
     RtEvent(const PlayingModeRtEvent& e) : _playing_mode_event(e) {}
     RtEvent(const SyncModeRtEvent& e) : _sync_mode_event(e) {}
+    RtEvent(const SyncClockRtEvent& e) : _sync_clock_event(e) {}
     RtEvent(const ClipNotificationRtEvent& e) : _clip_notification_event(e) {}
+    RtEvent(const LinkPeersNotificationRtEvent& e) : _link_peers_notification_event(e) {}
     /* Data storage */
     union
     {
@@ -949,6 +1062,7 @@ private:
         ReturnableRtEvent             _returnable_event;
         ProcessorOperationRtEvent     _processor_operation_event;
         ProcessorReorderRtEvent       _processor_reorder_event;
+        SessionUpdateRtEvent          _session_update_event;
         AsyncWorkRtEvent              _async_work_event;
         AsyncWorkRtCompletionEvent    _async_work_completion_event;
         DataPayloadRtEvent            _data_payload_event;
@@ -957,7 +1071,9 @@ private:
         TimeSignatureRtEvent          _time_signature_event;
         PlayingModeRtEvent            _playing_mode_event;
         SyncModeRtEvent               _sync_mode_event;
+        SyncClockRtEvent              _sync_clock_event;
         ClipNotificationRtEvent       _clip_notification_event;
+        LinkPeersNotificationRtEvent  _link_peers_notification_event;
     };
 };
 
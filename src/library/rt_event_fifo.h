@@ -21,6 +21,8 @@
 #ifndef SUSHI_REALTIME_FIFO_H
 #define SUSHI_REALTIME_FIFO_H
 
+#include <atomic>
+
 #include "fifo/circularfifo_memory_relaxed_aquire_release.h"
 #include "library/simple_fifo.h"
 #include "library/rt_event.h"
@@ -37,7 +39,15 @@ class RtSafeRtEventFifo : public RtEventPipe
 {
 public:
 
-    inline bool push(const RtEvent& event) {return _fifo.push(event);}
+    inline bool push(const RtEvent& event)
+    {
+        if (_fifo.push(event))
+        {
+            return true;
+        }
+        _failed_pushes.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
 
     inline bool pop(RtEvent& event)
     {
@@ -48,8 +58,14 @@ public:
 
     void send_event(const RtEvent &event) override {push(event);}
 
+    /**
+     * @brief The number of events that could not be pushed because the queue was full
+     */
+    uint64_t failed_pushes() const {return _failed_pushes.load(std::memory_order_relaxed);}
+
 private:
     memory_relaxed_aquire_release::CircularFifo<RtEvent, MAX_EVENTS_IN_QUEUE> _fifo;
+    std::atomic<uint64_t> _failed_pushes{0};
 };
 
 /**
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Debug tool for detecting memory allocations and mutex locks made from
+ *        realtime threads.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include "library/rt_safety.h"
+
+#ifdef SUSHI_BUILD_WITH_RT_SAFETY_CHECKS
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "twine/twine.h"
+
+/* The glibc implementations, used by the interposed functions */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void* ptr);
+}
+
+namespace sushi {
+namespace rt_safety {
+
+namespace {
+
+constexpr int MAX_STACK_DEPTH = 32;
+
+thread_local ObjectId current_processor_id = NO_PROCESSOR;
+/* Set while handling a violation, or when checking is explicitly suspended, to
+ * avoid reporting allocations made by the handler itself */
+thread_local bool suspended = false;
+
+std::atomic<int> violations{0};
+
+typedef int (*MutexLockFunction)(pthread_mutex_t*);
+MutexLockFunction real_mutex_lock = nullptr;
+
+void default_handler(ViolationType type, ObjectId processor_id)
+{
+    char message[128];
+    int length;
+    if (processor_id == NO_PROCESSOR)
+    {
+        length = snprintf(message, sizeof(message), "RT safety violation: %s outside of processor\n",
+                          to_string(type));
+    }
+    else
+    {
+        length = snprintf(message, sizeof(message), "RT safety violation: %s in processor %u\n",
+                          to_string(type), processor_id);
+    }
+    [[maybe_unused]] auto res = write(STDERR_FILENO, message, std::min<size_t>(length, sizeof(message) - 1));
+    void* stack[MAX_STACK_DEPTH];
+    int depth = backtrace(stack, MAX_STACK_DEPTH);
+    backtrace_symbols_fd(stack, depth, STDERR_FILENO);
+}
+
+std::atomic<ViolationHandler> violation_handler{default_handler};
+
+inline void check(ViolationType type)
+{
+    if (suspended == false && twine::is_current_thread_realtime())
+    {
+        suspended = true;
+        violations.fetch_add(1);
+        violation_handler.load()(type, current_processor_id);
+        suspended = false;
+    }
+}
+
+/* Resolve symbols and make sure backtrace() has loaded its dependencies before main,
+ * since neither is safe to do for the first time from inside malloc */
+__attribute__((constructor)) void init_rt_safety_checks()
+{
+    real_mutex_lock = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    void* stack[1];
+    backtrace(stack, 1);
+}
+
+} // anonymous namespace
+
+void set_current_processor(ObjectId processor_id)
+{
+    current_processor_id = processor_id;
+}
+
+ObjectId current_processor()
+{
+    return current_processor_id;
+}
+
+ViolationHandler set_violation_handler(ViolationHandler handler)
+{
+    return violation_handler.exchange(handler ? handler : default_handler);
+}
+
+int violation_count()
+{
+    return violations.load();
+}
+
+ScopedSuspend::ScopedSuspend() : _previous(suspended)
+{
+    suspended = true;
+}
+
+ScopedSuspend::~ScopedSuspend()
+{
+    suspended = _previous;
+}
+
+} // end namespace rt_safety
+} // end namespace sushi
+
+using sushi::rt_safety::check;
+using sushi::rt_safety::ViolationType;
+using sushi::rt_safety::MutexLockFunction;
+using sushi::rt_safety::real_mutex_lock;
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    check(ViolationType::ALLOCATION);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    check(ViolationType::ALLOCATION);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    check(ViolationType::ALLOCATION);
+    return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    check(ViolationType::ALLOCATION);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    check(ViolationType::ALLOCATION);
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    void* mem = __libc_memalign(alignment, size);
+    if (mem == nullptr)
+    {
+        return ENOMEM;
+    }
+    *ptr = mem;
+    return 0;
+}
+
+void free(void* ptr)
+{
+    if (ptr != nullptr)
+    {
+        check(ViolationType::DEALLOCATION);
+    }
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    check(ViolationType::LOCK);
+    if (real_mutex_lock == nullptr)
+    {
+        real_mutex_lock = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    }
+    return real_mutex_lock(mutex);
+}
+
+} // extern "C"
+
+#endif // SUSHI_BUILD_WITH_RT_SAFETY_CHECKS
+
+namespace sushi {
+namespace rt_safety {
+
+const char* to_string(ViolationType type)
+{
+    switch (type)
+    {
+        case ViolationType::ALLOCATION:     return "memory allocation";
+        case ViolationType::DEALLOCATION:   return "memory deallocation";
+        case ViolationType::LOCK:           return "mutex lock";
+        default:                            return "unknown";
+    }
+}
+
+} // end namespace rt_safety
+} // end namespace sushi
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Debug tool for detecting memory allocations and mutex locks made from
+ *        realtime threads. When built with SUSHI_BUILD_WITH_RT_SAFETY_CHECKS, malloc,
+ *        free and friends, as well as pthread_mutex_lock, are interposed and any call
+ *        made while twine::is_current_thread_realtime() is true is reported together
+ *        with a stack trace and the id of the processor currently being processed.
+ *        Without the build flag, all functions here are no-ops.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_RT_SAFETY_H
+#define SUSHI_RT_SAFETY_H
+
+#include "library/id_generator.h"
+
+namespace sushi {
+namespace rt_safety {
+
+/* Used as processor id when no processor is being processed */
+constexpr ObjectId NO_PROCESSOR = static_cast<ObjectId>(-1);
+
+enum class ViolationType
+{
+    ALLOCATION,
+    DEALLOCATION,
+    LOCK
+};
+
+/**
+ * @brief Function called for every detected violation. Called from the offending
+ *        thread, with checking temporarily disabled for that thread, so it may
+ *        allocate and lock.
+ */
+typedef void (*ViolationHandler)(ViolationType type, ObjectId processor_id);
+
+const char* to_string(ViolationType type);
+
+#ifdef SUSHI_BUILD_WITH_RT_SAFETY_CHECKS
+
+/**
+ * @brief Mark that the calling thread is processing the given processor, used to
+ *        attribute violations. Pass NO_PROCESSOR when done.
+ * @param processor_id The id of the processor.
+ */
+void set_current_processor(ObjectId processor_id);
+
+/**
+ * @return The id of the processor the calling thread is processing, or NO_PROCESSOR
+ */
+ObjectId current_processor();
+
+/**
+ * @brief Replace the violation handler. The default handler prints the violation and
+ *        a stack trace to stderr.
+ * @param handler The new handler, or nullptr to restore the default handler.
+ * @return The previous handler
+ */
+ViolationHandler set_violation_handler(ViolationHandler handler);
+
+/**
+ * @return The total number of violations detected since program start
+ */
+int violation_count();
+
+/**
+ * @brief Suspend checking on the calling thread for the lifetime of the object. For
+ *        code that is known to allocate or lock in a realtime context on purpose.
+ */
+class ScopedSuspend
+{
+public:
+    ScopedSuspend();
+    ~ScopedSuspend();
+private:
+    bool _previous;
+};
+
+#else
+
+inline void set_current_processor(ObjectId /*processor_id*/) {}
+
+inline ObjectId current_processor() {return NO_PROCESSOR;}
+
+inline ViolationHandler set_violation_handler(ViolationHandler /*handler*/) {return nullptr;}
+
+inline int violation_count() {return 0;}
+
+class ScopedSuspend {};
+
+#endif
+
+/**
+ * @brief Sets the current processor for the lifetime of the object and restores the
+ *        previous one when destroyed, so that markers can be nested.
+ */
+class ScopedProcessorMarker
+{
+public:
+    explicit ScopedProcessorMarker(ObjectId processor_id) : _previous(current_processor())
+    {
+        set_current_processor(processor_id);
+    }
+
+    ~ScopedProcessorMarker()
+    {
+        set_current_processor(_previous);
+    }
+
+private:
+    ObjectId _previous;
+};
+
+} // end namespace rt_safety
+} // end namespace sushi
+
+#endif //SUSHI_RT_SAFETY_H
@@ -25,12 +25,19 @@
 #include <cassert>
 
 #include "constants.h"
+#include "chunk_size.h"
 
 namespace sushi {
 
 constexpr int LEFT_CHANNEL_INDEX = 0;
 constexpr int RIGHT_CHANNEL_INDEX = 1;
 
+/**
+ * @brief Multichannel, non-interleaved audio buffer. The template parameter sets the
+ *        maximum number of samples per channel while the number of samples actually
+ *        stored and processed per channel is the runtime audio chunk size in effect
+ *        when the buffer was created, see chunk_size.h.
+ */
 template<int size>
 class SampleBuffer
 {
@@ -39,8 +46,9 @@ public:
      * @brief Construct a zeroed buffer with specified number of channels
      */
     explicit SampleBuffer(int channel_count) : _channel_count(channel_count),
+                                               _frames(_default_frame_count()),
                                                _own_buffer(true),
-                                               _buffer(new float[size * channel_count])
+                                               _buffer(new float[_frames * channel_count])
     {
         clear();
     }
@@ -49,6 +57,7 @@ public:
      * @brief Construct an empty buffer object with 0 channels.
      */
     SampleBuffer() noexcept : _channel_count(0),
+                              _frames(_default_frame_count()),
                               _own_buffer(true),
                               _buffer(nullptr)
     {}
@@ -58,12 +67,13 @@ public:
      * @brief Copy constructor.
      */
     SampleBuffer(const SampleBuffer &o) : _channel_count(o._channel_count),
+                                          _frames(o._frames),
                                           _own_buffer(o._own_buffer)
     {
         if (o._own_buffer)
         {
-            _buffer = new float[size * o._channel_count];
-            std::copy(o._buffer, o._buffer + (size * o._channel_count), _buffer);
+            _buffer = new float[_frames * o._channel_count];
+            std::copy(o._buffer, o._buffer + (_frames * o._channel_count), _buffer);
         } else
         {
             _buffer = o._buffer;
@@ -75,6 +85,7 @@ public:
      * @brief Move constructor.
      */
     SampleBuffer(SampleBuffer &&o) noexcept : _channel_count(o._channel_count),
+                                              _frames(o._frames),
                                               _own_buffer(o._own_buffer),
                                               _buffer(o._buffer)
     {
@@ -103,11 +114,12 @@ public:
         {
             if (_own_buffer && o._own_buffer)
             {
-                if (_channel_count != o._channel_count)
+                if (_channel_count != o._channel_count || _frames != o._frames)
                 {
                     delete[] _buffer;
-                    _buffer = (o._channel_count > 0)? (new float[size * o._channel_count]) : nullptr;
+                    _buffer = (o._channel_count > 0)? (new float[o._frames * o._channel_count]) : nullptr;
                     _channel_count = o._channel_count;
+                    _frames = o._frames;
                 }
             }
             else
@@ -123,9 +135,9 @@ public:
                  * connection to the SampleBuffer that originally owned the data.
                  * Both of which will have unexpected, and most likely unwanted, side
                  * effects. */
-                assert(_channel_count == o._channel_count);
+                assert(_channel_count == o._channel_count && _frames == o._frames);
             }
-            std::copy(o._buffer, o._buffer + (size * o._channel_count), _buffer);
+            std::copy(o._buffer, o._buffer + (_frames * o._channel_count), _buffer);
         }
         return *this;
     }
@@ -143,6 +155,7 @@ public:
                 delete[] _buffer;
             }
             _channel_count = o._channel_count;
+            _frames = o._frames;
             _own_buffer = o._own_buffer;
             _buffer = o._buffer;
             o._buffer = nullptr;
@@ -169,7 +182,8 @@ public:
         SampleBuffer buffer;
         buffer._own_buffer = false;
         buffer._channel_count = number_of_channels;
-        buffer._buffer = source._buffer + size * start_channel;
+        buffer._frames = source._frames;
+        buffer._buffer = source._buffer + source._frames * start_channel;
         return buffer;
     }
 
@@ -199,7 +213,7 @@ public:
         SampleBuffer buffer;
         buffer._own_buffer = false;
         buffer._channel_count = number_of_channels;
-        buffer._buffer = data + size * start_channel;
+        buffer._buffer = data + buffer._frames * start_channel;
         buffer._buffer = data;
         return buffer;
     }
@@ -209,7 +223,7 @@ public:
      */
     void clear()
     {
-        std::fill(_buffer, _buffer + (size * _channel_count), 0.0f);
+        std::fill(_buffer, _buffer + (_frames * _channel_count), 0.0f);
     }
 
     /**
@@ -217,7 +231,7 @@ public:
     */
     float* channel(int channel)
     {
-        return _buffer + channel * size;
+        return _buffer + channel * _frames;
     }
 
     /**
@@ -225,7 +239,7 @@ public:
     */
     const float* channel(int channel) const
     {
-        return _buffer + channel * size;
+        return _buffer + channel * _frames;
     }
 
     /**
@@ -236,6 +250,14 @@ public:
         return _channel_count;
     }
 
+    /**
+     * @brief Gets the number of samples per channel in the buffer.
+     */
+    int frame_count() const
+    {
+        return _frames;
+    }
+
     /**
      * @brief Copy interleaved audio data from interleaved_buf to this buffer.
      */
@@ -246,8 +268,8 @@ public:
             case 2:  // Most common case, others are mostly included for future compatibility
             {
                 float* l_in = _buffer;
-                float* r_in = _buffer + size;
-                for (int n = 0; n < size; ++n)
+                float* r_in = _buffer + _frames;
+                for (int n = 0; n < _frames; ++n)
                 {
                     *l_in++ = *interleaved_buf++;
                     *r_in++ = *interleaved_buf++;
@@ -256,16 +278,16 @@ public:
             }
             case 1:
             {
-                std::copy(interleaved_buf, interleaved_buf + size, _buffer);
+                std::copy(interleaved_buf, interleaved_buf + _frames, _buffer);
                 break;
             }
             default:
             {
-                for (int n = 0; n < size; ++n)
+                for (int n = 0; n < _frames; ++n)
                 {
                     for (int c = 0; c < _channel_count; ++c)
                     {
-                        _buffer[n + c * _channel_count] = *interleaved_buf++;
+                        _buffer[n + c * _frames] = *interleaved_buf++;
                     }
                 }
             }
@@ -282,8 +304,8 @@ public:
             case 2:  // Most common case, others are mostly included for future compatibility
             {
                 float* l_out = _buffer;
-                float* r_out = _buffer + size;
-                for (int n = 0; n < size; ++n)
+                float* r_out = _buffer + _frames;
+                for (int n = 0; n < _frames; ++n)
                 {
                     *interleaved_buf++ = *l_out++;
                     *interleaved_buf++ = *r_out++;
@@ -292,16 +314,16 @@ public:
             }
             case 1:
             {
-                std::copy(_buffer, _buffer + size, interleaved_buf);
+                std::copy(_buffer, _buffer + _frames, interleaved_buf);
                 break;
             }
             default:
             {
-                for (int n = 0; n < size; ++n)
+                for (int n = 0; n < _frames; ++n)
                 {
                     for (int c = 0; c < _channel_count; ++c)
                     {
-                        *interleaved_buf++ = _buffer[n + c * size];
+                        *interleaved_buf++ = _buffer[n + c * _frames];
                     }
                 }
             }
@@ -313,10 +335,13 @@ public:
      */
     void apply_gain(float gain)
     {
-        for (int i = 0; i < size * _channel_count; ++i)
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            _buffer[i] *= gain;
-        }
+            for (int i = 0; i < frames * _channel_count; ++i)
+            {
+                _buffer[i] *= gain;
+            }
+        });
     }
 
     /**
@@ -324,11 +349,14 @@ public:
     */
     void apply_gain(float gain, int channel)
     {
-        float* data = _buffer + size * channel;
-        for (int i = 0; i < size; ++i)
+        float* data = _buffer + _frames * channel;
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            data[i] *= gain;
-        }
+            for (int i = 0; i < frames; ++i)
+            {
+                data[i] *= gain;
+            }
+        });
     }
 
     /**
@@ -339,17 +367,18 @@ public:
     void replace(const SampleBuffer &source)
     {
         assert(source.channel_count() == 1 || source.channel_count() == this->channel_count());
+        assert(source._frames == _frames);
 
         if (source.channel_count() == 1) // mono input, copy to all dest channels
         {
             for (int channel = 0; channel < _channel_count; ++channel)
             {
-                std::copy(source._buffer, source._buffer + size, _buffer + channel * size);
+                std::copy(source._buffer, source._buffer + _frames, _buffer + channel * _frames);
             }
         }
         else
         {
-            std::copy(source._buffer, source._buffer + _channel_count * size, _buffer);
+            std::copy(source._buffer, source._buffer + _channel_count * _frames, _buffer);
         }
     }
 
@@ -360,8 +389,8 @@ public:
     {
         assert(source_channel < source.channel_count() && dest_channel < this->channel_count());
         std::copy(source.channel(source_channel),
-                  source.channel(source_channel) + size,
-                  _buffer + (dest_channel * size));
+                  source.channel(source_channel) + _frames,
+                  _buffer + (dest_channel * _frames));
     }
 
     /**
@@ -372,24 +401,28 @@ public:
     void add(const SampleBuffer &source)
     {
         assert(source.channel_count() == 1 || source.channel_count() == this->channel_count());
+        assert(source._frames == _frames);
 
-        if (source.channel_count() == 1) // mono input, add to all dest channels
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            for (int channel = 0; channel < _channel_count; ++channel)
+            if (source.channel_count() == 1) // mono input, add to all dest channels
             {
-                float* dest = _buffer + size * channel;
-                for (int i = 0; i < size; ++i)
+                for (int channel = 0; channel < _channel_count; ++channel)
                 {
-                    dest[i] += source._buffer[i];
+                    float* dest = _buffer + frames * channel;
+                    for (int i = 0; i < frames; ++i)
+                    {
+                        dest[i] += source._buffer[i];
+                    }
                 }
-            }
-        } else if (source.channel_count() == _channel_count)
-        {
-            for (int i = 0; i < size * _channel_count; ++i)
+            } else if (source.channel_count() == _channel_count)
             {
-                _buffer[i] += source._buffer[i];
+                for (int i = 0; i < frames * _channel_count; ++i)
+                {
+                    _buffer[i] += source._buffer[i];
+                }
             }
-        }
+        });
     }
 
     /**
@@ -397,12 +430,15 @@ public:
      */
     void add(int dest_channel, int source_channel, const SampleBuffer& source)
     {
-        float* source_data = source._buffer + size * source_channel;
-        float* dest_data = _buffer + size * dest_channel;
-        for (int i = 0; i < size; ++i)
+        float* source_data = source._buffer + _frames * source_channel;
+        float* dest_data = _buffer + _frames * dest_channel;
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            dest_data[i] += source_data[i];
-        }
+            for (int i = 0; i < frames; ++i)
+            {
+                dest_data[i] += source_data[i];
+            }
+        });
     }
 
     /**
@@ -414,24 +450,28 @@ public:
     void add_with_gain(const SampleBuffer &source, float gain)
     {
         assert(source.channel_count() == 1 || source.channel_count() == this->channel_count());
+        assert(source._frames == _frames);
 
-        if (source.channel_count() == 1)
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            for (int channel = 0; channel < _channel_count; ++channel)
+            if (source.channel_count() == 1)
             {
-                float* dest = _buffer + size * channel;
-                for (int i = 0; i < size; ++i)
+                for (int channel = 0; channel < _channel_count; ++channel)
                 {
-                    dest[i] += source._buffer[i] * gain;
+                    float* dest = _buffer + frames * channel;
+                    for (int i = 0; i < frames; ++i)
+                    {
+                        dest[i] += source._buffer[i] * gain;
+                    }
                 }
-            }
-        } else if (source.channel_count() == _channel_count)
-        {
-            for (int i = 0; i < size * _channel_count; ++i)
+            } else if (source.channel_count() == _channel_count)
             {
-                _buffer[i] += source._buffer[i] * gain;
+                for (int i = 0; i < frames * _channel_count; ++i)
+                {
+                    _buffer[i] += source._buffer[i] * gain;
+                }
             }
-        }
+        });
     }
 
     /**
@@ -439,12 +479,15 @@ public:
      */
     void add_with_gain(int dest_channel, int source_channel, const SampleBuffer& source, float gain)
     {
-        float* source_data = source._buffer + size * source_channel;
-        float* dest_data = _buffer + size * dest_channel;
-        for (int i = 0; i < size; ++i)
+        float* source_data = source._buffer + _frames * source_channel;
+        float* dest_data = _buffer + _frames * dest_channel;
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            dest_data[i] += source_data[i] * gain;
-        }
+            for (int i = 0; i < frames; ++i)
+            {
+                dest_data[i] += source_data[i] * gain;
+            }
+        });
     }
 
     /**
@@ -459,30 +502,21 @@ public:
     void add_with_ramp(const SampleBuffer &source, float start, float end)
     {
         assert(source.channel_count() == 1 || source.channel_count() == _channel_count);
+        assert(source._frames == _frames);
 
-        float inc = (end - start) / (size - 1);
-        if (source.channel_count() == 1)
+        float inc = (end - start) / (_frames - 1);
+        with_static_chunk_size(_frames, [&](auto frames)
         {
             for (int channel = 0; channel < _channel_count; ++channel)
             {
-                float* dest = _buffer + size * channel;
-                for (int i = 0; i < size; ++i)
-                {
-                    dest[i] += source._buffer[i] * (start + i * inc);
-                }
-            }
-        } else if (source.channel_count() == _channel_count)
-        {
-            for (int channel = 0; channel < _channel_count; ++channel)
-            {
-                float* source_data = _buffer + size * channel;
-                float* dest_data = _buffer + size * channel;
-                for (int i = 0; i < size; ++i)
+                const float* source_data = source._buffer + (source.channel_count() == 1 ? 0 : frames * channel);
+                float* dest_data = _buffer + frames * channel;
+                for (int i = 0; i < frames; ++i)
                 {
                     dest_data[i] += source_data[i] * (start + i * inc);
                 }
             }
-        }
+        });
     }
 
     /**
@@ -491,13 +525,16 @@ public:
     */
     void add_with_ramp(int dest_channel, int source_channel, const SampleBuffer& source, float start, float end)
     {
-        float inc = (end - start) / (size - 1);
-        float* source_data = source._buffer + size * source_channel;
-        float* dest_data = _buffer + size * dest_channel;
-        for (int i = 0; i < size; ++i)
+        float inc = (end - start) / (_frames - 1);
+        float* source_data = source._buffer + _frames * source_channel;
+        float* dest_data = _buffer + _frames * dest_channel;
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            dest_data[i] += source_data[i] * (start + i * inc);
-        }
+            for (int i = 0; i < frames; ++i)
+            {
+                dest_data[i] += source_data[i] * (start + i * inc);
+            }
+        });
     }
 
     /**
@@ -507,15 +544,18 @@ public:
      */
     void ramp(float start, float end)
     {
-        float inc = (end - start) / (size - 1);
-        for (int channel = 0; channel < _channel_count; ++channel)
+        float inc = (end - start) / (_frames - 1);
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            float* data = _buffer + size * channel;
-            for (int i = 0; i < size; ++i)
+            for (int channel = 0; channel < _channel_count; ++channel)
             {
-                data[i] *= start + i * inc;
+                float* data = _buffer + frames * channel;
+                for (int i = 0; i < frames; ++i)
+                {
+                    data[i] *= start + i * inc;
+                }
             }
-        }
+        });
     }
 
     /**
@@ -545,13 +585,16 @@ public:
     {
         assert(number_of_channels + start_channel <= _channel_count);
         int clipcount = 0;
-        const float* data = _buffer + size * start_channel;
-        for (int i = 0 ; i < size * number_of_channels; ++i)
+        const float* data = _buffer + _frames * start_channel;
+        with_static_chunk_size(_frames, [&](auto frames)
         {
-            /* std::abs() is more efficient than testing for upper and lower bound separately
-               And GCC can compile this to vectorised, branchless code */
-            clipcount += std::abs(data[i]) >= 1.0f;
-        }
+            for (int i = 0 ; i < frames * number_of_channels; ++i)
+            {
+                /* std::abs() is more efficient than testing for upper and lower bound separately
+                   And GCC can compile this to vectorised, branchless code */
+                clipcount += std::abs(data[i]) >= 1.0f;
+            }
+        });
         return clipcount;
     }
 
@@ -565,7 +608,13 @@ public:
     }
 
 private:
+    static int _default_frame_count()
+    {
+        return std::min(audio_chunk_size(), size);
+    }
+
     int _channel_count;
+    int _frames;
     bool _own_buffer;
     float* _buffer;
 };
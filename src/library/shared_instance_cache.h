@@ -0,0 +1,94 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Cache for sharing expensive to create objects, like plugin libraries, between users
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_SHARED_INSTANCE_CACHE_H
+#define SUSHI_SHARED_INSTANCE_CACHE_H
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace sushi {
+
+/**
+ * @brief Hands out shared instances of objects, creating an object the first time its key
+ *        is requested. The cache only keeps weak references, so an object is destroyed
+ *        when the last user releases it and created again on the next request.
+ *        Objects are created with the cache locked, so that concurrent requests for the
+ *        same key never create more than one object. Not for use from the rt thread.
+ */
+template <typename Key, typename T>
+class SharedInstanceCache
+{
+public:
+    /**
+     * @brief Get the object for a key, creating it if needed
+     * @param key The key of the object
+     * @param create Callable returning a std::shared_ptr<T> to a new object, or nullptr on
+     *        error. Only called if there is no live object for the key.
+     * @return The object, or nullptr if it did not exist and creating it failed
+     */
+    template <typename Factory>
+    std::shared_ptr<T> get(const Key& key, Factory&& create)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _remove_expired();
+        if (auto cached = _instances.find(key); cached != _instances.end())
+        {
+            if (auto instance = cached->second.lock(); instance)
+            {
+                return instance;
+            }
+        }
+        std::shared_ptr<T> instance = create();
+        if (instance)
+        {
+            _instances[key] = instance;
+        }
+        return instance;
+    }
+
+    /**
+     * @return The number of objects currently alive
+     */
+    int size()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _remove_expired();
+        return static_cast<int>(_instances.size());
+    }
+
+private:
+    void _remove_expired()
+    {
+        for (auto i = _instances.begin(); i != _instances.end();)
+        {
+            i = i->second.expired() ? _instances.erase(i) : std::next(i);
+        }
+    }
+
+    std::mutex _mutex;
+    std::map<Key, std::weak_ptr<T>> _instances;
+};
+
+} // end namespace sushi
+
+#endif //SUSHI_SHARED_INSTANCE_CACHE_H
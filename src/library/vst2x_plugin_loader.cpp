@@ -48,6 +48,7 @@
 
 #include "library/vst2x_plugin_loader.h"
 #include "library/vst2x_host_callback.h"
+#include "library/shared_instance_cache.h"
 
 #include "logging.h"
 
@@ -59,26 +60,11 @@ SUSHI_GET_LOGGER_WITH_MODULE_NAME("vst2");
 // TODO: this is POSIX specific and the Linux-way to do it.
 // Works with Mac OS X as well, but can only load VSTs compiled in a POSIX way.
 
-LibraryHandle PluginLoader::get_library_handle_for_plugin(const std::string &plugin_absolute_path)
-{
-    if (plugin_absolute_path.empty())
-    {
-        SUSHI_LOG_ERROR("Empty library path");
-        return nullptr; // Calling dlopen with an empty string returns a handle to the calling
-                        // program, which can cause an infinite loop.
-    }
-    void *libraryHandle = dlopen(plugin_absolute_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+namespace {
 
-    if (libraryHandle == nullptr)
-    {
-        SUSHI_LOG_ERROR("Could not open library, {}", dlerror());
-        return nullptr;
-    }
+SharedInstanceCache<std::string, PluginLibrary> library_cache;
 
-    return libraryHandle;
-}
-
-AEffect* PluginLoader::load_plugin(LibraryHandle library_handle)
+plugin_entry_proc find_entry_point(void* library_handle)
 {
     // Somewhat cheap hack to avoid a tricky compiler warning. Casting from void*
     // to a proper function pointer will cause GCC to warn that "ISO C++ forbids
@@ -97,27 +83,58 @@ AEffect* PluginLoader::load_plugin(LibraryHandle library_handle)
     if (entryPoint.entryPointVoidPtr == nullptr)
     {
         entryPoint.entryPointVoidPtr = dlsym(library_handle, "main");
-        if (entryPoint.entryPointVoidPtr == nullptr)
+    }
+    return entryPoint.entryPointFuncPtr;
+}
+
+} // anonymous namespace
+
+PluginLibrary::~PluginLibrary()
+{
+    if (dlclose(_handle) != 0)
+    {
+        SUSHI_LOG_WARNING("Could not safely close plugin, possible resource leak");
+    }
+}
+
+LibraryHandle PluginLoader::get_library_handle_for_plugin(const std::string &plugin_absolute_path)
+{
+    if (plugin_absolute_path.empty())
+    {
+        SUSHI_LOG_ERROR("Empty library path");
+        return nullptr; // Calling dlopen with an empty string returns a handle to the calling
+                        // program, which can cause an infinite loop.
+    }
+    return library_cache.get(plugin_absolute_path, [&]() -> LibraryHandle
+    {
+        void *libraryHandle = dlopen(plugin_absolute_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+        if (libraryHandle == nullptr)
         {
-              SUSHI_LOG_ERROR("Couldn't get a pointer to plugin's main()");
-              return nullptr;
+            SUSHI_LOG_ERROR("Could not open library, {}", dlerror());
+            return nullptr;
         }
-    }
+        return std::make_shared<PluginLibrary>(libraryHandle, find_entry_point(libraryHandle));
+    });
+}
 
-    plugin_entry_proc mainEntryPoint = entryPoint.entryPointFuncPtr;
+AEffect* PluginLoader::load_plugin(const LibraryHandle& library_handle)
+{
+    plugin_entry_proc mainEntryPoint = library_handle->entry_point();
+    if (mainEntryPoint == nullptr)
+    {
+          SUSHI_LOG_ERROR("Couldn't get a pointer to plugin's main()");
+          return nullptr;
+    }
     AEffect *plugin = mainEntryPoint(host_callback);
     return plugin;
 
 }
 
-void PluginLoader::close_library_handle(LibraryHandle library_handle)
+void PluginLoader::close_library_handle(LibraryHandle& library_handle)
 {
-    if (dlclose(library_handle) != 0)
-    {
-        SUSHI_LOG_WARNING("Could not safely close plugin, possible resource leak");
-    }
+    library_handle.reset();
 }
 
 } // namespace vst2
 } // namespace sushi
-
@@ -48,6 +48,7 @@
 #ifndef SUSHI_VST2X_PLUGIN_LOADER_H
 #define SUSHI_VST2X_PLUGIN_LOADER_H
 
+#include <memory>
 #include <string>
 
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -57,25 +58,57 @@
 
 #include <dlfcn.h>
 
+#include "library/constants.h"
+
 namespace sushi {
 namespace vst2 {
 
-typedef void* LibraryHandle;
+/**
+ * @brief An opened plugin library and its entry point. Shared by all plugin instances
+ *        created from the library, the library is closed when the last one is released.
+ */
+class PluginLibrary
+{
+public:
+    SUSHI_DECLARE_NON_COPYABLE(PluginLibrary);
+
+    PluginLibrary(void* handle, plugin_entry_proc entry_point) : _handle(handle),
+                                                                 _entry_point(entry_point) {}
+    ~PluginLibrary();
+
+    /**
+     * @return The plugin's main function, nullptr if the library doesn't have one
+     */
+    plugin_entry_proc entry_point() const {return _entry_point;}
+
+private:
+    void* _handle;
+    plugin_entry_proc _entry_point;
+};
+
+typedef std::shared_ptr<PluginLibrary> LibraryHandle;
 
 // TODO:
-//      this class is stateless atm (basically a namespace),
+//      this class is stateless apart from the library cache (basically a namespace),
 //      but it should probably grow into the access point to plugins stored in the
-//      system, with features like directory scanning, caching, easier handling
-//      of library handles, etc.
+//      system, with features like directory scanning, easier handling of library handles, etc.
 
 class PluginLoader
 {
 public:
+    /**
+     * @brief Open a plugin library, or get the already opened library if there are other
+     *        instances of plugins from it, so that only the first instance pays for
+     *        opening the library and looking up its entry point.
+     */
     static LibraryHandle get_library_handle_for_plugin(const std::string& plugin_absolute_path);
 
-    static AEffect* load_plugin(LibraryHandle library_handle);
+    static AEffect* load_plugin(const LibraryHandle& library_handle);
 
-    static void close_library_handle(LibraryHandle library_handle);
+    /**
+     * @brief Release a library handle, the library is closed when all handles to it are released
+     */
+    static void close_library_handle(LibraryHandle& library_handle);
 
 };
 
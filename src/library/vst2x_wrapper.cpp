@@ -20,6 +20,10 @@
 
 #ifdef SUSHI_BUILD_WITH_VST2
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "twine/twine.h"
 
 #include "library/vst2x_wrapper.h"
@@ -54,17 +58,18 @@ ProcessorReturnCode Vst2xWrapper::init(float sample_rate)
         _cleanup();
         return ProcessorReturnCode::SHARED_LIBRARY_OPENING_ERROR;
     }
-    _plugin_handle = PluginLoader::load_plugin(_library_handle);
-    if (_plugin_handle == nullptr)
+    auto instance = PluginLoader::load_plugin(_library_handle);
+    if (instance == nullptr)
     {
         _cleanup();
         return ProcessorReturnCode::PLUGIN_ENTRY_POINT_NOT_FOUND;
     }
+    _plugin_handle.store(instance);
 
     // Check plugin's magic number
     // If incorrect, then the file either was not loaded properly, is not a
     // real VST2 plugin, or is otherwise corrupt.
-    if(_plugin_handle->magic != kEffectMagic)
+    if(instance->magic != kEffectMagic)
     {
         _cleanup();
         return ProcessorReturnCode::PLUGIN_LOAD_ERROR;
@@ -82,20 +87,21 @@ ProcessorReturnCode Vst2xWrapper::init(float sample_rate)
     // Get plugin can do:s
     int bypass = _vst_dispatcher(effCanDo, 0, 0, canDoBypass, 0);
     _can_do_soft_bypass = (bypass == 1);
-    _number_of_programs = _plugin_handle->numPrograms;
+    _number_of_programs = instance->numPrograms;
 
     SUSHI_LOG_INFO_IF(bypass, "Plugin supports soft bypass");
 
     // Channel setup
-    _max_input_channels = _plugin_handle->numInputs;
+    _max_input_channels = instance->numInputs;
     _current_input_channels = _max_input_channels;
-    _max_output_channels = _plugin_handle->numOutputs;
+    _max_output_channels = instance->numOutputs;
     _current_output_channels = _max_output_channels;
 
     // Initialize internal plugin
     _vst_dispatcher(effOpen, 0, 0, 0, 0);
     _vst_dispatcher(effSetSampleRate, 0, 0, 0, _sample_rate);
-    _vst_dispatcher(effSetBlockSize, 0, AUDIO_CHUNK_SIZE, 0, 0);
+    _vst_dispatcher(effSetBlockSize, 0, audio_chunk_size(), 0, 0);
+    _current_program = _vst_dispatcher(effGetProgram, 0, 0, nullptr, 0);
 
     // Register internal parameters
     if (!_register_parameters())
@@ -103,9 +109,10 @@ ProcessorReturnCode Vst2xWrapper::init(float sample_rate)
         _cleanup();
         return ProcessorReturnCode::PARAMETER_ERROR;
     }
+    _parameters_during_swap.assign(instance->numParams, std::numeric_limits<float>::quiet_NaN());
 
     // Register yourself
-    _plugin_handle->user = this;
+    instance->user = this;
     return ProcessorReturnCode::OK;
 }
 
@@ -117,7 +124,10 @@ void Vst2xWrapper::configure(float sample_rate)
     {
         set_enabled(false);
     }
-    _vst_dispatcher(effSetSampleRate, 0, 0, 0, _sample_rate);
+    {
+        std::scoped_lock lock(_instance_lock);
+        _vst_dispatcher(effSetSampleRate, 0, 0, 0, _sample_rate);
+    }
     if (reset_enabled)
     {
         set_enabled(true);
@@ -128,14 +138,16 @@ void Vst2xWrapper::configure(float sample_rate)
 void Vst2xWrapper::set_input_channels(int channels)
 {
     Processor::set_input_channels(channels);
-    bool valid_arr = _update_speaker_arrangements(_current_input_channels, _current_output_channels);
+    std::scoped_lock lock(_instance_lock);
+    bool valid_arr = _update_speaker_arrangements(_plugin_handle.load(), _current_input_channels, _current_output_channels);
     _update_mono_mode(valid_arr);
 }
 
 void Vst2xWrapper::set_output_channels(int channels)
 {
     Processor::set_output_channels(channels);
-    bool valid_arr = _update_speaker_arrangements(_current_input_channels, _current_output_channels);
+    std::scoped_lock lock(_instance_lock);
+    bool valid_arr = _update_speaker_arrangements(_plugin_handle.load(), _current_input_channels, _current_output_channels);
     _update_mono_mode(valid_arr);
 }
 
@@ -143,6 +155,7 @@ void Vst2xWrapper::set_output_channels(int channels)
 void Vst2xWrapper::set_enabled(bool enabled)
 {
     Processor::set_enabled(enabled);
+    std::scoped_lock lock(_instance_lock);
     if (enabled)
     {
         _vst_dispatcher(effMainsChanged, 0, 1, NULL, 0.0f);
@@ -163,9 +176,11 @@ void Vst2xWrapper::set_bypassed(bool bypassed)
 
 std::pair<ProcessorReturnCode, float> Vst2xWrapper::parameter_value(ObjectId parameter_id) const
 {
-    if (static_cast<int>(parameter_id) < _plugin_handle->numParams)
+    std::scoped_lock lock(_instance_lock);
+    auto instance = _plugin_handle.load(std::memory_order_acquire);
+    if (static_cast<int>(parameter_id) < instance->numParams)
     {
-        float value  = _plugin_handle->getParameter(_plugin_handle, static_cast<VstInt32>(parameter_id));
+        float value  = instance->getParameter(instance, static_cast<VstInt32>(parameter_id));
         return {ProcessorReturnCode::OK, value};
     }
 
@@ -179,7 +194,8 @@ std::pair<ProcessorReturnCode, float> Vst2xWrapper::parameter_value_in_domain(Ob
 
 std::pair<ProcessorReturnCode, std::string> Vst2xWrapper::parameter_value_formatted(ObjectId parameter_id) const
 {
-    if (static_cast<int>(parameter_id) < _plugin_handle->numParams)
+    std::scoped_lock lock(_instance_lock);
+    if (static_cast<int>(parameter_id) < _plugin_handle.load(std::memory_order_acquire)->numParams)
     {
         // Many plugins don't respect the kVstMaxParamStrLen limit, so better use a larger buffer
         char buffer[VST_STRING_BUFFER_SIZE] = "";
@@ -194,7 +210,8 @@ int Vst2xWrapper::current_program() const
 {
     if (this->supports_programs())
     {
-        return _vst_dispatcher(effGetProgram, 0, 0, nullptr, 0);
+        /* Tracked here as the instance with the new program may not be swapped in yet */
+        return _current_program.load();
     }
     return 0;
 }
@@ -203,10 +220,7 @@ std::string Vst2xWrapper::current_program_name() const
 {
     if (this->supports_programs())
     {
-        char buffer[VST_STRING_BUFFER_SIZE] = "";
-        _vst_dispatcher(effGetProgramName, 0, 0, buffer, 0);
-        buffer[VST_STRING_BUFFER_SIZE-1] = 0;
-        return std::string(buffer);
+        return program_name(current_program()).second;
     }
     return "";
 }
@@ -215,6 +229,7 @@ std::pair<ProcessorReturnCode, std::string> Vst2xWrapper::program_name(int progr
 {
     if (this->supports_programs())
     {
+        std::scoped_lock lock(_instance_lock);
         char buffer[VST_STRING_BUFFER_SIZE] = "";
         auto success = _vst_dispatcher(effGetProgramNameIndexed, program, 0, buffer, 0);
         buffer[VST_STRING_BUFFER_SIZE-1] = 0;
@@ -229,6 +244,7 @@ std::pair<ProcessorReturnCode, std::vector<std::string>> Vst2xWrapper::all_progr
     {
         return {ProcessorReturnCode::UNSUPPORTED_OPERATION, std::vector<std::string>()};
     }
+    std::scoped_lock lock(_instance_lock);
     std::vector<std::string> programs;
     for (int i = 0; i < _number_of_programs; ++i)
     {
@@ -242,19 +258,162 @@ std::pair<ProcessorReturnCode, std::vector<std::string>> Vst2xWrapper::all_progr
 
 ProcessorReturnCode Vst2xWrapper::set_program(int program)
 {
-    if (this->supports_programs() && program < _number_of_programs)
+    if (this->supports_programs() && program >= 0 && program < _number_of_programs)
     {
+        std::scoped_lock lock(_instance_lock);
+        /* Setting the program on the running instance is not thread safe and
+         * interrupts the audio of many plugins */
+        if (enabled())
+        {
+            auto status = _set_program_on_new_instance(program);
+            if (status == ProcessorReturnCode::OK)
+            {
+                _current_program = program;
+                return status;
+            }
+            SUSHI_LOG_WARNING("Failed to prepare a new instance for the program change, setting it directly");
+        }
         _vst_dispatcher(effBeginSetProgram, 0, 0, nullptr, 0);
         /* Vst2 lacks a mechanism for signaling that the program change was successful */
         _vst_dispatcher(effSetProgram, 0, program, nullptr, 0);
         _vst_dispatcher(effEndSetProgram, 0, 0, nullptr, 0);
+        _current_program = program;
         return ProcessorReturnCode::OK;
     }
     return ProcessorReturnCode::UNSUPPORTED_OPERATION;
 }
 
+ProcessorReturnCode Vst2xWrapper::_set_program_on_new_instance(int program)
+{
+    auto instance = PluginLoader::load_plugin(_library_handle);
+    if (instance == nullptr)
+    {
+        return ProcessorReturnCode::PLUGIN_ENTRY_POINT_NOT_FOUND;
+    }
+    /* From here on the rt thread records parameter changes, as they could otherwise be
+     * lost between copying the parameters below and the new instance being swapped in */
+    _preparing_instance = true;
+
+    _dispatch(instance, effOpen, 0, 0, 0, 0);
+    _dispatch(instance, effSetSampleRate, 0, 0, 0, _sample_rate);
+    _dispatch(instance, effSetBlockSize, 0, audio_chunk_size(), 0, 0);
+    _update_speaker_arrangements(instance, _current_input_channels, _current_output_channels);
+
+    /* Carry over the current parameter values and set the program on top of them,
+     * as it would have been set on the running instance */
+    auto current = _plugin_handle.load();
+    for (VstInt32 i = 0; i < current->numParams; ++i)
+    {
+        instance->setParameter(instance, i, current->getParameter(current, i));
+    }
+
+    _dispatch(instance, effBeginSetProgram, 0, 0, nullptr, 0);
+    _dispatch(instance, effSetProgram, 0, program, nullptr, 0);
+    _dispatch(instance, effEndSetProgram, 0, 0, nullptr, 0);
+
+    if (enabled())
+    {
+        _dispatch(instance, effMainsChanged, 0, 1, nullptr, 0.0f);
+        _dispatch(instance, effStartProcess, 0, 0, nullptr, 0.0f);
+    }
+    instance->user = this;
+
+    /* Replaces any instance the rt thread has not picked up yet */
+    _close_instance(_pending_plugin_handle.exchange(instance, std::memory_order_acq_rel));
+    _preparing_instance = false;
+    return ProcessorReturnCode::OK;
+}
+
+void Vst2xWrapper::_swap_in_pending_instance()
+{
+    if (_pending_plugin_handle.load(std::memory_order_relaxed) == nullptr)
+    {
+        return;
+    }
+    /* Wait until the previously replaced instance is closed, so that there are
+     * never more than 2 instances processing */
+    if (_fading_plugin_handle || _retired_plugin_handle.load(std::memory_order_acquire) != nullptr)
+    {
+        return;
+    }
+    auto instance = _pending_plugin_handle.exchange(nullptr, std::memory_order_acq_rel);
+    _fading_plugin_handle = _plugin_handle.load(std::memory_order_relaxed);
+    _plugin_handle.store(instance);
+    for (VstInt32 i = 0; i < static_cast<VstInt32>(_parameters_during_swap.size()); ++i)
+    {
+        if (std::isnan(_parameters_during_swap[i]) == false)
+        {
+            instance->setParameter(instance, i, _parameters_during_swap[i]);
+        }
+    }
+    /* If another instance is being prepared it might have copied the values from the
+     * replaced instance, so they are kept until that one is swapped in as well */
+    if (_preparing_instance == false)
+    {
+        std::fill(_parameters_during_swap.begin(), _parameters_during_swap.end(),
+                  std::numeric_limits<float>::quiet_NaN());
+    }
+    if (_can_do_soft_bypass && _bypass_manager.bypassed())
+    {
+        _vst_dispatcher(effSetBypass, 0, 1, nullptr, 0.0f);
+    }
+    _program_crossfade.reset(true);
+    _program_crossfade.set_bypass(false, _sample_rate);
+}
+
+void Vst2xWrapper::_record_parameter_during_swap(VstInt32 index, float value)
+{
+    if (_preparing_instance || _pending_plugin_handle.load() != nullptr)
+    {
+        _parameters_during_swap[index] = value;
+    }
+}
+
+void Vst2xWrapper::_crossfade_from_fading_instance(const ChunkSampleBuffer& in_buffer, ChunkSampleBuffer& out_buffer)
+{
+    /* The old instance gets no new midi events and is only left to ring out */
+    _map_audio_buffers(in_buffer, _crossfade_buffer);
+    _fading_plugin_handle->processReplacing(_fading_plugin_handle, _process_inputs, _process_outputs, audio_chunk_size());
+
+    /* The old instance's output is the "bypassed" signal that is faded out */
+    _program_crossfade.crossfade_output(_crossfade_buffer, out_buffer,
+                                        _current_output_channels, _current_output_channels);
+    if (_program_crossfade.should_ramp() == false)
+    {
+        _retire_fading_instance();
+    }
+}
+
+void Vst2xWrapper::_retire_fading_instance()
+{
+    _retired_plugin_handle.store(_fading_plugin_handle, std::memory_order_release);
+    _fading_plugin_handle = nullptr;
+    output_event(RtEvent::make_async_work_event(&Vst2xWrapper::retire_instance_callback, this->id(), this));
+}
+
+void Vst2xWrapper::_retire_instance_callback(EventId)
+{
+    /* Non-rt calls may still be using the instance if they started before the swap */
+    std::scoped_lock lock(_instance_lock);
+    _close_instance(_retired_plugin_handle.exchange(nullptr, std::memory_order_acq_rel));
+}
+
+void Vst2xWrapper::_close_instance(AEffect* instance)
+{
+    if (instance != nullptr)
+    {
+        _dispatch(instance, effMainsChanged, 0, 0, nullptr, 0.0f);
+        _dispatch(instance, effStopProcess, 0, 0, nullptr, 0.0f);
+        _dispatch(instance, effClose, 0, 0, 0, 0);
+    }
+}
+
 void Vst2xWrapper::_cleanup()
 {
+    _close_instance(_pending_plugin_handle.exchange(nullptr));
+    _close_instance(_fading_plugin_handle);
+    _fading_plugin_handle = nullptr;
+    _close_instance(_retired_plugin_handle.exchange(nullptr));
     if (_plugin_handle != nullptr)
     {
         // Tell plugin to stop and shutdown
@@ -275,7 +434,7 @@ bool Vst2xWrapper::_register_parameters()
 
     VstInt32 idx = 0;
     bool param_inserted_ok = true;
-    while (param_inserted_ok && (idx < _plugin_handle->numParams) )
+    while (param_inserted_ok && (idx < _plugin_handle.load()->numParams) )
     {
         _vst_dispatcher(effGetParamName, idx, 0, param_name, 0);
         _vst_dispatcher(effGetParamLabel, idx, 0, param_unit, 0);
@@ -303,8 +462,10 @@ void Vst2xWrapper::process_event(const RtEvent& event)
     {
         auto typed_event = event.parameter_change_event();
         auto id = typed_event->param_id();
-        assert(static_cast<VstInt32>(id) < _plugin_handle->numParams);
-        _plugin_handle->setParameter(_plugin_handle, static_cast<VstInt32>(id), typed_event->value());
+        auto instance = _plugin_handle.load(std::memory_order_relaxed);
+        assert(static_cast<VstInt32>(id) < instance->numParams);
+        instance->setParameter(instance, static_cast<VstInt32>(id), typed_event->value());
+        _record_parameter_during_swap(static_cast<VstInt32>(id), typed_event->value());
     }
     else if (is_keyboard_event(event))
     {
@@ -331,16 +492,27 @@ void Vst2xWrapper::process_event(const RtEvent& event)
 
 void Vst2xWrapper::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer)
 {
+    _swap_in_pending_instance();
+
     if (_can_do_soft_bypass == false && _bypass_manager.should_process() == false)
     {
         bypass_process(in_buffer, out_buffer);
         _vst_midi_events_fifo.flush();
+        if (_fading_plugin_handle)
+        {
+            _retire_fading_instance();
+        }
     }
     else
     {
         _vst_dispatcher(effProcessEvents, 0, 0, _vst_midi_events_fifo.flush(), 0.0f);
         _map_audio_buffers(in_buffer, out_buffer);
-        _plugin_handle->processReplacing(_plugin_handle, _process_inputs, _process_outputs, AUDIO_CHUNK_SIZE);
+        auto instance = _plugin_handle.load(std::memory_order_relaxed);
+        instance->processReplacing(instance, _process_inputs, _process_outputs, audio_chunk_size());
+        if (_fading_plugin_handle)
+        {
+            _crossfade_from_fading_instance(in_buffer, out_buffer);
+        }
         if (_can_do_soft_bypass == false && _bypass_manager.should_ramp())
         {
             _bypass_manager.crossfade_output(in_buffer, out_buffer, _current_input_channels, _current_output_channels);
@@ -359,8 +531,7 @@ void Vst2xWrapper::notify_parameter_change_rt(VstInt32 parameter_index, float va
     }
     if (maybe_output_cv_value(parameter_index, value) == false)
     {
-        auto e = RtEvent::make_parameter_change_event(this->id(), 0, static_cast<ObjectId>(parameter_index), value);
-        output_event(e);
+        output_parameter_notification(static_cast<ObjectId>(parameter_index), value);
     }
 }
 
@@ -374,7 +545,7 @@ void Vst2xWrapper::notify_parameter_change(VstInt32 parameter_index, float value
     _host_control.post_event(e);
 }
 
-bool Vst2xWrapper::_update_speaker_arrangements(int inputs, int outputs)
+bool Vst2xWrapper::_update_speaker_arrangements(AEffect* instance, int inputs, int outputs)
 {
     VstSpeakerArrangement in_arr;
     VstSpeakerArrangement out_arr;
@@ -382,7 +553,7 @@ bool Vst2xWrapper::_update_speaker_arrangements(int inputs, int outputs)
     in_arr.type = arrangement_from_channels(inputs);
     out_arr.numChannels = outputs;
     out_arr.type = arrangement_from_channels(outputs);
-    int res = _vst_dispatcher(effSetSpeakerArrangement, 0, (VstIntPtr)&in_arr, &out_arr, 0);
+    int res = _dispatch(instance, effSetSpeakerArrangement, 0, (VstIntPtr)&in_arr, &out_arr, 0);
     return res == 1;
 }
 
@@ -23,7 +23,10 @@
 
 #ifdef SUSHI_BUILD_WITH_VST2
 
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include "library/processor.h"
 #include "library/vst2x_plugin_loader.h"
@@ -113,6 +116,12 @@ public:
      */
     VstTimeInfo* time_info();
 
+    static int retire_instance_callback(void* data, EventId id)
+    {
+        reinterpret_cast<Vst2xWrapper*>(data)->_retire_instance_callback(id);
+        return 1;
+    }
+
 private:
     friend VstIntPtr VSTCALLBACK host_callback(AEffect* effect,
                                                VstInt32 opcode, VstInt32 index,
@@ -151,9 +160,48 @@ private:
      */
     int _vst_dispatcher(VstInt32 opcode, VstInt32 index, VstIntPtr value, void* ptr, float opt) const
     {
-        return static_cast<int>(_plugin_handle->dispatcher(_plugin_handle, opcode, index, value, ptr, opt));
+        return _dispatch(_plugin_handle.load(std::memory_order_acquire), opcode, index, value, ptr, opt);
+    }
+
+    static int _dispatch(AEffect* instance, VstInt32 opcode, VstInt32 index, VstIntPtr value, void* ptr, float opt)
+    {
+        return static_cast<int>(instance->dispatcher(instance, opcode, index, value, ptr, opt));
     }
 
+    /**
+     * @brief Loads a new instance of the plugin and sets the program on it off the rt
+     *        thread. The new instance then replaces the current one in process_audio()
+     *        with a crossfade, so that program changes do not interrupt the audio.
+     * @param program The index of the program to set
+     * @return ProcessorReturnCode::OK if the new instance was prepared successfully
+     */
+    ProcessorReturnCode _set_program_on_new_instance(int program);
+
+    /**
+     * @brief Switch to a new instance prepared by _set_program_on_new_instance(), called
+     *        from the rt thread at the start of each chunk
+     */
+    void _swap_in_pending_instance();
+
+    /**
+     * @brief Keep track of a parameter change made while a new instance is prepared or
+     *        waiting to be swapped in, so that it can be applied to the new instance too.
+     *        Called from the rt thread.
+     */
+    void _record_parameter_during_swap(VstInt32 index, float value);
+
+    /**
+     * @brief Run the replaced instance and crossfade its output to the output of the new
+     *        instance, when the crossfade is done the old instance is sent off to be closed
+     */
+    void _crossfade_from_fading_instance(const ChunkSampleBuffer& in_buffer, ChunkSampleBuffer& out_buffer);
+
+    void _retire_fading_instance();
+
+    void _retire_instance_callback(EventId);
+
+    static void _close_instance(AEffect* instance);
+
     /**
      * @brief Iterate over VsT parameters and register internal FloatParameterDescriptor
      *        for each one of them.
@@ -161,7 +209,7 @@ private:
      */
     bool _register_parameters();
 
-    bool _update_speaker_arrangements(int inputs, int outputs);
+    bool _update_speaker_arrangements(AEffect* instance, int inputs, int outputs);
 
     /**
      * @brief For plugins that support stereo I/0 and not mono through SetSpeakerArrangements,
@@ -183,12 +231,31 @@ private:
     bool _can_do_soft_bypass;
     bool _double_mono_input;
     int _number_of_programs{0};
+    std::atomic<int> _current_program{0};
 
     BypassManager _bypass_manager{_bypassed};
 
     std::string _plugin_path;
     LibraryHandle _library_handle;
-    AEffect *_plugin_handle;
+    std::atomic<AEffect*> _plugin_handle;
+
+    /* Instances with a new program set are handed over to the rt thread through
+     * _pending_plugin_handle. The replaced instance is run in parallel during the
+     * crossfade and then handed back through _retired_plugin_handle to be closed
+     * by a worker thread. Only the rt thread changes _plugin_handle once the plugin
+     * is initialised, so non-rt code must hold _instance_lock while using it, as
+     * replaced instances are only closed with the lock held. */
+    mutable std::mutex _instance_lock;
+    std::atomic<AEffect*> _pending_plugin_handle{nullptr};
+    AEffect* _fading_plugin_handle{nullptr};
+    std::atomic<AEffect*> _retired_plugin_handle{nullptr};
+    BypassManager _program_crossfade{false};
+
+    /* Parameter values set by the rt thread after the current values were copied to a
+     * new instance, NaN for parameters that were not changed. Preallocated in init() */
+    std::atomic<bool> _preparing_instance{false};
+    std::vector<float> _parameters_during_swap;
+    ChunkSampleBuffer _crossfade_buffer{VST_WRAPPER_MAX_N_CHANNELS};
 
     VstTimeInfo _time_info;
 };
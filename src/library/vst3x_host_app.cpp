@@ -25,6 +25,7 @@
 
 #include "vst3x_host_app.h"
 #include "vst3x_wrapper.h"
+#include "library/shared_instance_cache.h"
 #include "logging.h"
 
 namespace sushi {
@@ -34,6 +35,13 @@ SUSHI_GET_LOGGER_WITH_MODULE_NAME("vst3");
 
 constexpr char HOST_NAME[] = "Sushi";
 
+namespace {
+
+/* Plugin modules with their factories, shared by all instances of plugins from the same module */
+SharedInstanceCache<std::string, VST3::Hosting::Module> module_cache;
+
+} // anonymous namespace
+
 Steinberg::tresult SushiHostApplication::getName(Steinberg::Vst::String128 name)
 
 {
@@ -161,7 +169,10 @@ PluginInstance::~PluginInstance()
 bool PluginInstance::load_plugin(const std::string& plugin_path, const std::string& plugin_name)
 {
     std::string error_msg;
-    _module = VST3::Hosting::Module::create(plugin_path, error_msg);
+    _module = module_cache.get(plugin_path, [&]()
+    {
+        return VST3::Hosting::Module::create(plugin_path, error_msg);
+    });
     if (!_module)
     {
         SUSHI_LOG_ERROR("Failed to load VST3 Module: {}", error_msg);
@@ -23,6 +23,130 @@
 namespace sushi {
 namespace vst3{
 
+template <class Interface>
+inline Steinberg::tresult query_host_owned_interface(Interface* instance, const Steinberg::TUID iid, void** obj)
+{
+    if (Steinberg::FUnknownPrivate::iidEqual(iid, Interface::iid) ||
+        Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::FUnknown::iid))
+    {
+        *obj = instance;
+        return Steinberg::kResultOk;
+    }
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+}
+
+Steinberg::tresult SushiParamValueQueue::getPoint(Steinberg::int32 index,
+                                                  Steinberg::int32& sample_offset,
+                                                  Steinberg::Vst::ParamValue& value)
+{
+    if (index < 0 || index >= _point_count)
+    {
+        return Steinberg::kResultFalse;
+    }
+    sample_offset = _points[index].offset;
+    value = _points[index].value;
+    return Steinberg::kResultOk;
+}
+
+Steinberg::tresult SushiParamValueQueue::addPoint(Steinberg::int32 sample_offset,
+                                                  Steinberg::Vst::ParamValue value,
+                                                  Steinberg::int32& index)
+{
+    int pos = _point_count;
+    for (int i = 0; i < _point_count; ++i)
+    {
+        if (_points[i].offset == sample_offset)
+        {
+            _points[i].value = value;
+            index = i;
+            return Steinberg::kResultOk;
+        }
+        if (_points[i].offset > sample_offset)
+        {
+            pos = i;
+            break;
+        }
+    }
+    if (_point_count >= static_cast<int>(_points.size()))
+    {
+        return Steinberg::kResultFalse;
+    }
+    for (int i = _point_count; i > pos; --i)
+    {
+        _points[i] = _points[i - 1];
+    }
+    _points[pos] = {sample_offset, value};
+    _point_count++;
+    index = pos;
+    return Steinberg::kResultOk;
+}
+
+Steinberg::tresult SushiParamValueQueue::queryInterface(const Steinberg::TUID iid, void** obj)
+{
+    return query_host_owned_interface<Steinberg::Vst::IParamValueQueue>(this, iid, obj);
+}
+
+Steinberg::Vst::IParamValueQueue* SushiParameterChanges::getParameterData(Steinberg::int32 index)
+{
+    if (index < 0 || index >= _queue_count)
+    {
+        return nullptr;
+    }
+    return &_queues[index];
+}
+
+Steinberg::Vst::IParamValueQueue* SushiParameterChanges::addParameterData(const Steinberg::Vst::ParamID& id,
+                                                                          Steinberg::int32& index)
+{
+    for (int i = 0; i < _queue_count; ++i)
+    {
+        if (_queues[i].getParameterId() == id)
+        {
+            index = i;
+            return &_queues[i];
+        }
+    }
+    if (_queue_count >= static_cast<int>(_queues.size()))
+    {
+        return nullptr;
+    }
+    index = _queue_count;
+    auto& queue = _queues[_queue_count++];
+    queue.reset(id);
+    return &queue;
+}
+
+Steinberg::tresult SushiParameterChanges::queryInterface(const Steinberg::TUID iid, void** obj)
+{
+    return query_host_owned_interface<Steinberg::Vst::IParameterChanges>(this, iid, obj);
+}
+
+Steinberg::tresult SushiEventList::getEvent(Steinberg::int32 index, Steinberg::Vst::Event& event)
+{
+    if (index < 0 || index >= _event_count)
+    {
+        return Steinberg::kInvalidArgument;
+    }
+    event = _events[index];
+    return Steinberg::kResultOk;
+}
+
+Steinberg::tresult SushiEventList::addEvent(Steinberg::Vst::Event& event)
+{
+    if (_event_count >= static_cast<int>(_events.size()))
+    {
+        return Steinberg::kResultFalse;
+    }
+    _events[_event_count++] = event;
+    return Steinberg::kResultOk;
+}
+
+Steinberg::tresult SushiEventList::queryInterface(const Steinberg::TUID iid, void** obj)
+{
+    return query_host_owned_interface<Steinberg::Vst::IEventList>(this, iid, obj);
+}
+
 void SushiProcessData::assign_buffers(const ChunkSampleBuffer& input, ChunkSampleBuffer& output,
                                       int in_channels, int out_channels)
 {
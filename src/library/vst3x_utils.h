@@ -22,13 +22,13 @@
 #define SUSHI_VST3X_UTILS_H
 
 #include <cassert>
+#include <array>
+#include <vector>
 
 #include "pluginterfaces/base/ipluginbase.h"
 #include "pluginterfaces/vst/ivstaudioprocessor.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "pluginterfaces/vst/ivstevents.h"
-#include "public.sdk/source/vst/hosting/eventlist.h"
-#include "public.sdk/source/vst/hosting/parameterchanges.h"
 
 #include "library/sample_buffer.h"
 #include "library/rt_event.h"
@@ -37,6 +37,129 @@ namespace sushi {
 namespace vst3 {
 
 constexpr int VST_WRAPPER_MAX_N_CHANNELS = 8;
+constexpr int VST_WRAPPER_PARAMETER_QUEUE_SIZE = 16;
+
+/**
+ * @brief Fixed capacity implementation of IParamValueQueue. Points are kept sorted on
+ *        sample offset and a point added at an existing offset replaces the old value.
+ *        Never allocates.
+ */
+class SushiParamValueQueue : public Steinberg::Vst::IParamValueQueue
+{
+public:
+    /**
+     * @brief Empty the queue and assign it to a new parameter id
+     * @param id The Vst3 parameter id
+     */
+    void reset(Steinberg::Vst::ParamID id)
+    {
+        _id = id;
+        _point_count = 0;
+    }
+
+    Steinberg::Vst::ParamID PLUGIN_API getParameterId() override {return _id;}
+
+    Steinberg::int32 PLUGIN_API getPointCount() override {return _point_count;}
+
+    Steinberg::tresult PLUGIN_API getPoint(Steinberg::int32 index,
+                                           Steinberg::int32& sample_offset,
+                                           Steinberg::Vst::ParamValue& value) override;
+
+    Steinberg::tresult PLUGIN_API addPoint(Steinberg::int32 sample_offset,
+                                           Steinberg::Vst::ParamValue value,
+                                           Steinberg::int32& index) override;
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** obj) override;
+    /* Owned by the host, so reference counting is a no-op */
+    Steinberg::uint32 PLUGIN_API addRef() override {return 1000;}
+    Steinberg::uint32 PLUGIN_API release() override {return 1000;}
+
+private:
+    struct Point
+    {
+        Steinberg::int32 offset;
+        Steinberg::Vst::ParamValue value;
+    };
+    Steinberg::Vst::ParamID _id{0};
+    int _point_count{0};
+    std::array<Point, VST_WRAPPER_PARAMETER_QUEUE_SIZE> _points;
+};
+
+/**
+ * @brief Implementation of IParameterChanges where all queues are allocated up front
+ *        by set_max_parameters() so that adding parameter changes during processing
+ *        never allocates.
+ */
+class SushiParameterChanges : public Steinberg::Vst::IParameterChanges
+{
+public:
+    /**
+     * @brief Allocate queues for the given number of parameters. Not safe to call
+     *        from the audio thread.
+     * @param max_parameters The maximum number of different parameters that can be
+     *        changed in one process call, typically the plugin's parameter count.
+     */
+    void set_max_parameters(int max_parameters)
+    {
+        _queues.resize(max_parameters);
+        _queue_count = 0;
+    }
+
+    /**
+     * @brief Remove all parameter changes, does not free any memory
+     */
+    void clear()
+    {
+        _queue_count = 0;
+    }
+
+    Steinberg::int32 PLUGIN_API getParameterCount() override {return _queue_count;}
+
+    Steinberg::Vst::IParamValueQueue* PLUGIN_API getParameterData(Steinberg::int32 index) override;
+
+    Steinberg::Vst::IParamValueQueue* PLUGIN_API addParameterData(const Steinberg::Vst::ParamID& id,
+                                                                  Steinberg::int32& index) override;
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** obj) override;
+    Steinberg::uint32 PLUGIN_API addRef() override {return 1000;}
+    Steinberg::uint32 PLUGIN_API release() override {return 1000;}
+
+private:
+    std::vector<SushiParamValueQueue> _queues;
+    int _queue_count{0};
+};
+
+/**
+ * @brief Fixed capacity implementation of IEventList. Events that don't fit are
+ *        dropped instead of growing the list.
+ */
+class SushiEventList : public Steinberg::Vst::IEventList
+{
+public:
+    explicit SushiEventList(int max_events) : _events(max_events) {}
+
+    /**
+     * @brief Remove all events, does not free any memory
+     */
+    void clear()
+    {
+        _event_count = 0;
+    }
+
+    Steinberg::int32 PLUGIN_API getEventCount() override {return _event_count;}
+
+    Steinberg::tresult PLUGIN_API getEvent(Steinberg::int32 index, Steinberg::Vst::Event& event) override;
+
+    Steinberg::tresult PLUGIN_API addEvent(Steinberg::Vst::Event& event) override;
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** obj) override;
+    Steinberg::uint32 PLUGIN_API addRef() override {return 1000;}
+    Steinberg::uint32 PLUGIN_API release() override {return 1000;}
+
+private:
+    std::vector<Steinberg::Vst::Event> _events;
+    int _event_count{0};
+};
 
 /**
  * @brief Wrapping the processdata in our own class for convenience
@@ -44,10 +167,10 @@ constexpr int VST_WRAPPER_MAX_N_CHANNELS = 8;
 class SushiProcessData : public Steinberg::Vst::ProcessData
 {
 public:
-    SushiProcessData(Steinberg::Vst::EventList* in_event_list,
-                     Steinberg::Vst::EventList* out_event_list,
-                     Steinberg::Vst::ParameterChanges* in_parameter_changes,
-                     Steinberg::Vst::ParameterChanges* out_parameter_changes) :
+    SushiProcessData(SushiEventList* in_event_list,
+                     SushiEventList* out_event_list,
+                     SushiParameterChanges* in_parameter_changes,
+                     SushiParameterChanges* out_parameter_changes) :
                                     _in_events(in_event_list),
                                     _out_events(out_event_list),
                                     _in_parameters(in_parameter_changes),
@@ -59,7 +182,7 @@ public:
         outputs = &_output_buffers;
         numInputs = 1;  /* Note: number of busses, not channels */
         numOutputs = 1; /* Note: number of busses, not channels */
-        numSamples = AUDIO_CHUNK_SIZE;
+        numSamples = audio_chunk_size();
         symbolicSampleSize = Steinberg::Vst::SymbolicSampleSizes::kSample32;
         processMode = Steinberg::Vst::ProcessModes::kRealtime;
         processContext = &_context;
@@ -85,8 +208,8 @@ public:
     {
         _in_events->clear();
         _out_events->clear();
-        _in_parameters->clearQueue();
-        _out_parameters->clearQueue();
+        _in_parameters->clear();
+        _out_parameters->clear();
     }
 
 private:
@@ -96,10 +219,10 @@ private:
     Steinberg::Vst::AudioBusBuffers _output_buffers;
     Steinberg::Vst::ProcessContext  _context;
     /* Keep pointers to the implementations so we can call clear on them */
-    Steinberg::Vst::EventList* _in_events;
-    Steinberg::Vst::EventList* _out_events;
-    Steinberg::Vst::ParameterChanges* _in_parameters;
-    Steinberg::Vst::ParameterChanges* _out_parameters;
+    SushiEventList* _in_events;
+    SushiEventList* _out_events;
+    SushiParameterChanges* _in_parameters;
+    SushiParameterChanges* _out_parameters;
 };
 
 /**
@@ -530,8 +530,8 @@ ProcessorReturnCode Vst3xWrapper::set_program(int program)
 bool Vst3xWrapper::_register_parameters()
 {
     int param_count = _instance.controller()->getParameterCount();
-    _in_parameter_changes.setMaxParameters(param_count);
-    _out_parameter_changes.setMaxParameters(param_count);
+    _in_parameter_changes.set_max_parameters(param_count);
+    _out_parameter_changes.set_max_parameters(param_count);
 
     for (int i = 0; i < param_count; ++i)
     {
@@ -715,7 +715,7 @@ bool Vst3xWrapper::_setup_processing()
 {
     _process_data.processContext->sampleRate = _sample_rate;
     Steinberg::Vst::ProcessSetup setup;
-    setup.maxSamplesPerBlock = AUDIO_CHUNK_SIZE;
+    setup.maxSamplesPerBlock = audio_chunk_size();
     setup.processMode = Steinberg::Vst::ProcessModes::kRealtime;
     setup.sampleRate = _sample_rate;
     setup.symbolicSampleSize = Steinberg::Vst::SymbolicSampleSizes::kSample32;
@@ -27,8 +27,6 @@
 #include <utility>
 
 #include "pluginterfaces/base/ipluginbase.h"
-#include "public.sdk/source/vst/hosting/eventlist.h"
-#include "public.sdk/source/vst/hosting/parameterchanges.h"
 
 #include "fifo/circularfifo_memory_relaxed_aquire_release.h"
 
@@ -200,10 +198,10 @@ private:
     PluginInstance _instance;
     ComponentHandler _component_handler{this};
 
-    Steinberg::Vst::EventList _in_event_list{VST_WRAPPER_NOTE_EVENT_QUEUE_SIZE};
-    Steinberg::Vst::EventList _out_event_list{VST_WRAPPER_NOTE_EVENT_QUEUE_SIZE};
-    Steinberg::Vst::ParameterChanges _in_parameter_changes;
-    Steinberg::Vst::ParameterChanges _out_parameter_changes;
+    SushiEventList _in_event_list{VST_WRAPPER_NOTE_EVENT_QUEUE_SIZE};
+    SushiEventList _out_event_list{VST_WRAPPER_NOTE_EVENT_QUEUE_SIZE};
+    SushiParameterChanges _in_parameter_changes;
+    SushiParameterChanges _out_parameter_changes;
 
     SushiProcessData _process_data{&_in_event_list,
                                    &_out_event_list,
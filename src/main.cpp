@@ -33,12 +33,14 @@
 #include "generated/version.h"
 #include "engine/audio_engine.h"
 #include "audio_frontends/offline_frontend.h"
+#include "audio_frontends/stress_frontend.h"
 #include "audio_frontends/jack_frontend.h"
 #include "audio_frontends/xenomai_raspa_frontend.h"
 #include "engine/json_configurator.h"
 #include "control_frontends/osc_frontend.h"
 #include "control_frontends/alsa_midi_frontend.h"
 #include "library/parameter_dump.h"
+#include "library/chunk_size.h"
 
 #ifdef SUSHI_BUILD_WITH_RPC_INTERFACE
 #include "sushi_rpc/grpc_server.h"
@@ -48,6 +50,7 @@ enum class FrontendType
 {
     OFFLINE,
     DUMMY,
+    STRESS,
     JACK,
     XENOMAI_RASPA,
     NONE
@@ -75,6 +78,9 @@ constexpr std::array SUSHI_ENABLED_BUILD_OPTIONS = {
 #ifdef SUSHI_BUILD_WITH_ABLETON_LINK
         "ableton link",
 #endif
+#ifdef SUSHI_BUILD_WITH_RT_SAFETY_CHECKS
+        "rt safety checks",
+#endif
 };
 
 bool                    exit_flag = false;
@@ -116,7 +122,7 @@ void print_version_and_build_info()
     }
     std::cout << std::endl;
 
-    std::cout << "Audio buffer size in frames: " << AUDIO_CHUNK_SIZE << std::endl;
+    std::cout << "Audio buffer size in frames: " << AUDIO_CHUNK_SIZE << " (max)" << std::endl;
     std::cout << "Git commit: " << SUSHI_GIT_COMMIT_HASH << std::endl;
     std::cout << "Built on: " << SUSHI_BUILD_TIMESTAMP << std::endl;
 }
@@ -162,6 +168,9 @@ int main(int argc, char* argv[])
 
     std::string input_filename;
     std::string output_filename;
+    std::string midi_filename;
+    std::string automation_filename;
+    std::string hash_filename;
 
     std::string log_level = std::string(SUSHI_LOG_LEVEL_DEFAULT);
     std::string log_filename = std::string(SUSHI_LOG_FILENAME_DEFAULT);
@@ -173,12 +182,21 @@ int main(int argc, char* argv[])
     std::string grpc_listening_address = std::string(SUSHI_GRPC_LISTENING_PORT);
     FrontendType frontend_type = FrontendType::NONE;
     bool connect_ports = false;
+    bool use_jack_midi = false;
     bool debug_mode_switches = false;
     int  rt_cpu_cores = 1;
+    int  audio_chunk_size = AUDIO_CHUNK_SIZE;
     bool enable_timings = false;
     bool enable_flush_interval = false;
     bool enable_parameter_dump = false;
+    bool deterministic = false;
     std::chrono::seconds log_flush_interval = std::chrono::seconds(0);
+    bool stress_paced = false;
+    float stress_midi_rate = std::strtof(SUSHI_STRESS_MIDI_RATE_DEFAULT, nullptr);
+    float stress_parameter_rate = std::strtof(SUSHI_STRESS_PARAMETER_RATE_DEFAULT, nullptr);
+    float stress_graph_edit_rate = 0.0f;
+    std::chrono::seconds stress_duration = std::chrono::seconds(0);
+    std::chrono::seconds stress_report_interval = std::chrono::seconds(std::strtol(SUSHI_STRESS_REPORT_INTERVAL_DEFAULT, nullptr, 0));
 
     for (int i=0; i<cl_parser.optionsCount(); i++)
     {
@@ -231,10 +249,55 @@ int main(int argc, char* argv[])
             output_filename.assign(opt.arg);
             break;
 
+        case OPT_IDX_MIDI_FILE:
+            midi_filename.assign(opt.arg);
+            break;
+
+        case OPT_IDX_AUTOMATION_FILE:
+            automation_filename.assign(opt.arg);
+            break;
+
+        case OPT_IDX_DETERMINISTIC:
+            deterministic = true;
+            break;
+
+        case OPT_IDX_HASH_FILE:
+            hash_filename.assign(opt.arg);
+            deterministic = true;
+            break;
+
         case OPT_IDX_USE_DUMMY:
             frontend_type = FrontendType::DUMMY;
             break;
 
+        case OPT_IDX_USE_STRESS:
+            frontend_type = FrontendType::STRESS;
+            break;
+
+        case OPT_IDX_STRESS_PACED:
+            stress_paced = true;
+            break;
+
+        case OPT_IDX_STRESS_MIDI_RATE:
+            stress_midi_rate = std::strtof(opt.arg, nullptr);
+            break;
+
+        case OPT_IDX_STRESS_PARAMETER_RATE:
+            stress_parameter_rate = std::strtof(opt.arg, nullptr);
+            break;
+
+        case OPT_IDX_STRESS_GRAPH_EDIT_RATE:
+            stress_graph_edit_rate = std::strtof(opt.arg, nullptr);
+            break;
+
+        case OPT_IDX_STRESS_DURATION:
+            stress_duration = std::chrono::seconds(std::strtol(opt.arg, nullptr, 0));
+            break;
+
+        case OPT_IDX_STRESS_REPORT_INTERVAL:
+            stress_report_interval = std::chrono::seconds(std::strtol(opt.arg, nullptr, 0));
+            break;
+
         case OPT_IDX_USE_JACK:
             frontend_type = FrontendType::JACK;
             break;
@@ -243,6 +306,10 @@ int main(int argc, char* argv[])
             connect_ports = true;
             break;
 
+        case OPT_IDX_JACK_MIDI:
+            use_jack_midi = true;
+            break;
+
         case OPT_IDX_JACK_CLIENT:
             jack_client_name.assign(opt.arg);
             break;
@@ -279,6 +346,10 @@ int main(int argc, char* argv[])
             grpc_listening_address = opt.arg;
             break;
 
+        case OPT_IDX_AUDIO_CHUNK_SIZE:
+            audio_chunk_size = atoi(opt.arg);
+            break;
+
         default:
             SushiArg::print_error("Unhandled option '", opt, "' \n");
             break;
@@ -314,6 +385,24 @@ int main(int argc, char* argv[])
     // Main body //
     ////////////////////////////////////////////////////////////////////////////////
 
+    if (sushi::set_audio_chunk_size(audio_chunk_size) == false)
+    {
+        error_exit("Invalid audio chunk size: " + std::to_string(audio_chunk_size) +
+                   ", must be a power of 2 between " + std::to_string(MIN_AUDIO_CHUNK_SIZE) +
+                   " and " + std::to_string(AUDIO_CHUNK_SIZE));
+    }
+    SUSHI_LOG_INFO("Audio chunk size: {} samples", sushi::audio_chunk_size());
+
+    if (deterministic)
+    {
+        if (frontend_type != FrontendType::OFFLINE && frontend_type != FrontendType::DUMMY)
+        {
+            error_exit("Deterministic processing is only available with the offline and dummy frontends");
+        }
+        /* Tracks are rendered in graph order when processing on a single core */
+        rt_cpu_cores = 1;
+    }
+
     if (frontend_type == FrontendType::XENOMAI_RASPA)
     {
         twine::init_xenomai(); // must be called before setting up any worker pools
@@ -363,8 +452,10 @@ int main(int argc, char* argv[])
                                                                                                  jack_server_name,
                                                                                                  connect_ports,
                                                                                                  cv_inputs,
-                                                                                                 cv_outputs);
-            audio_frontend = std::make_unique<sushi::audio_frontend::JackFrontend>(engine.get());
+                                                                                                 cv_outputs,
+                                                                                                 use_jack_midi ? midi_inputs : 0,
+                                                                                                 use_jack_midi ? midi_outputs : 0);
+            audio_frontend = std::make_unique<sushi::audio_frontend::JackFrontend>(engine.get(), midi_dispatcher.get());
             break;
         }
 
@@ -395,8 +486,24 @@ int main(int argc, char* argv[])
                                                                                                     output_filename,
                                                                                                     dummy,
                                                                                                     cv_inputs,
-                                                                                                    cv_outputs);
-            audio_frontend = std::make_unique<sushi::audio_frontend::OfflineFrontend>(engine.get());
+                                                                                                    cv_outputs,
+                                                                                                    deterministic,
+                                                                                                    hash_filename);
+            audio_frontend = std::make_unique<sushi::audio_frontend::OfflineFrontend>(engine.get(), midi_dispatcher.get());
+            break;
+        }
+
+        case FrontendType::STRESS:
+        {
+            SUSHI_LOG_INFO("Setting up stress test audio frontend");
+            frontend_config = std::make_unique<sushi::audio_frontend::StressFrontendConfiguration>(stress_paced,
+                                                                                                   stress_midi_rate,
+                                                                                                   stress_parameter_rate,
+                                                                                                   stress_graph_edit_rate,
+                                                                                                   stress_report_interval,
+                                                                                                   cv_inputs,
+                                                                                                   cv_outputs);
+            audio_frontend = std::make_unique<sushi::audio_frontend::StressFrontend>(engine.get(), midi_dispatcher.get());
             break;
         }
 
@@ -446,6 +553,27 @@ int main(int argc, char* argv[])
         {
             error_exit("Failed to load Event list from Json config file");
         }
+        auto offline_frontend = static_cast<sushi::audio_frontend::OfflineFrontend*>(audio_frontend.get());
+        if (midi_filename.empty() == false)
+        {
+            auto [midi_status, midi_events] = sushi::midi_file::read_midi_file(midi_filename);
+            if (midi_status != sushi::midi_file::MidiFileStatus::OK || offline_frontend->add_midi_events(midi_events) == false)
+            {
+                error_exit("Failed to load midi file " + midi_filename);
+            }
+        }
+        if (automation_filename.empty() == false)
+        {
+            auto [automation_status, automation] = sushi::automation_file::read_automation_file(automation_filename);
+            if (automation_status != sushi::automation_file::AutomationFileStatus::OK)
+            {
+                error_exit("Failed to load automation file " + automation_filename);
+            }
+            if (offline_frontend->add_automation(automation) == false)
+            {
+                SUSHI_LOG_WARNING("Not all automated parameters in {} were found", automation_filename);
+            }
+        }
     }
     else
     {
@@ -474,7 +602,15 @@ int main(int argc, char* argv[])
 
     if (frontend_type == FrontendType::JACK || frontend_type == FrontendType::XENOMAI_RASPA)
     {
-        midi_frontend = std::make_unique<sushi::midi_frontend::AlsaMidiFrontend>(midi_inputs, midi_outputs, midi_dispatcher.get());
+        if (use_jack_midi && frontend_type == FrontendType::JACK)
+        {
+            /* Midi is read and written by the Jack frontend in the audio callback */
+            midi_frontend = std::make_unique<sushi::midi_frontend::NullMidiFrontend>(midi_dispatcher.get());
+        }
+        else
+        {
+            midi_frontend = std::make_unique<sushi::midi_frontend::AlsaMidiFrontend>(midi_inputs, midi_outputs, midi_dispatcher.get());
+        }
 
         osc_frontend = std::make_unique<sushi::control_frontend::OSCFrontend>(engine.get(), engine->controller(), osc_server_port, osc_send_port);
         auto osc_status = osc_frontend->init();
@@ -517,7 +653,14 @@ int main(int argc, char* argv[])
     {
         std::mutex m;
         std::unique_lock<std::mutex> lock(m);
-        exit_notifier.wait(lock, exit_condition);
+        if (frontend_type == FrontendType::STRESS && stress_duration.count() > 0)
+        {
+            exit_notifier.wait_for(lock, stress_duration, exit_condition);
+        }
+        else
+        {
+            exit_notifier.wait(lock, exit_condition);
+        }
     }
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +32,9 @@
 #define SUSHI_JSON_FILENAME_DEFAULT "config.json"
 #define SUSHI_SAMPLE_RATE_DEFAULT 48000
 #define SUSHI_JACK_CLIENT_NAME_DEFAULT "sushi"
+#define SUSHI_STRESS_MIDI_RATE_DEFAULT "100"
+#define SUSHI_STRESS_PARAMETER_RATE_DEFAULT "1000"
+#define SUSHI_STRESS_REPORT_INTERVAL_DEFAULT "10"
 #define SUSHI_OSC_SERVER_PORT 24024
 #define SUSHI_OSC_SEND_PORT 24023
 #define SUSHI_GRPC_LISTENING_PORT "[::]:51051"
@@ -110,18 +113,31 @@ enum OptionIndex
     OPT_IDX_USE_OFFLINE,
     OPT_IDX_INPUT_FILE,
     OPT_IDX_OUTPUT_FILE,
+    OPT_IDX_MIDI_FILE,
+    OPT_IDX_AUTOMATION_FILE,
+    OPT_IDX_DETERMINISTIC,
+    OPT_IDX_HASH_FILE,
     OPT_IDX_USE_DUMMY,
+    OPT_IDX_USE_STRESS,
+    OPT_IDX_STRESS_PACED,
+    OPT_IDX_STRESS_MIDI_RATE,
+    OPT_IDX_STRESS_PARAMETER_RATE,
+    OPT_IDX_STRESS_GRAPH_EDIT_RATE,
+    OPT_IDX_STRESS_DURATION,
+    OPT_IDX_STRESS_REPORT_INTERVAL,
     OPT_IDX_USE_JACK,
     OPT_IDX_CONNECT_PORTS,
     OPT_IDX_JACK_CLIENT,
     OPT_IDX_JACK_SERVER,
+    OPT_IDX_JACK_MIDI,
     OPT_IDX_USE_XENOMAI_RASPA,
     OPT_IDX_XENOMAI_DEBUG_MODE_SW,
     OPT_IDX_MULTICORE_PROCESSING,
     OPT_IDX_TIMINGS_STATISTICS,
     OPT_IDX_OSC_RECEIVE_PORT,
     OPT_IDX_OSC_SEND_PORT,
-    OPT_IDX_GRPC_LISTEN_ADDRESS
+    OPT_IDX_GRPC_LISTEN_ADDRESS,
+    OPT_IDX_AUDIO_CHUNK_SIZE
 };
 
 // Option types (UNUSED is generally used for options that take a value as argument)
@@ -223,6 +239,38 @@ const optionparser::Descriptor usage[] =
         SushiArg::NonEmpty,
         "\t\t-O <filename>, --output=<filename> \tSpecify output file [default= (input_file).proc.wav]."
     },
+    {
+        OPT_IDX_MIDI_FILE,
+        OPT_TYPE_UNUSED,
+        "",
+        "midi-file",
+        SushiArg::NonEmpty,
+        "\t\t--midi-file=<filename> \tPlay a Standard Midi File on midi input 0, for --offline and --dummy options."
+    },
+    {
+        OPT_IDX_AUTOMATION_FILE,
+        OPT_TYPE_UNUSED,
+        "",
+        "automation-file",
+        SushiArg::NonEmpty,
+        "\t\t--automation-file=<filename> \tPlay back a parameter automation file, for --offline and --dummy options."
+    },
+    {
+        OPT_IDX_DETERMINISTIC,
+        OPT_TYPE_DISABLED,
+        "",
+        "deterministic",
+        SushiArg::Optional,
+        "\t\t--deterministic \tReproducible processing for --offline and --dummy options. Control events are processed between chunks and multicore processing is disabled."
+    },
+    {
+        OPT_IDX_HASH_FILE,
+        OPT_TYPE_UNUSED,
+        "",
+        "hash-file",
+        SushiArg::NonEmpty,
+        "\t\t--hash-file=<filename> \tWrite a hash of every track's output for every chunk to file, implies --deterministic."
+    },
     {
         OPT_IDX_USE_DUMMY,
         OPT_TYPE_DISABLED,
@@ -231,6 +279,62 @@ const optionparser::Descriptor usage[] =
         SushiArg::Optional,
         "\t\t-d --dummy \tUse dummy audio frontend. Useful for debugging."
     },
+    {
+        OPT_IDX_USE_STRESS,
+        OPT_TYPE_DISABLED,
+        "",
+        "stress",
+        SushiArg::Optional,
+        "\t\t--stress \tUse stress test audio frontend. Processes without audio hardware while generating control events and reports the processing load."
+    },
+    {
+        OPT_IDX_STRESS_PACED,
+        OPT_TYPE_DISABLED,
+        "",
+        "stress-paced",
+        SushiArg::Optional,
+        "\t\t--stress-paced \tProcess audio at the speed of the wall clock with --stress, otherwise as fast as possible."
+    },
+    {
+        OPT_IDX_STRESS_MIDI_RATE,
+        OPT_TYPE_UNUSED,
+        "",
+        "stress-midi-rate",
+        SushiArg::NonEmpty,
+        "\t\t--stress-midi-rate=<rate> \tMidi notes on and off per second sent with --stress [default=" SUSHI_STRESS_MIDI_RATE_DEFAULT "]."
+    },
+    {
+        OPT_IDX_STRESS_PARAMETER_RATE,
+        OPT_TYPE_UNUSED,
+        "",
+        "stress-parameter-rate",
+        SushiArg::NonEmpty,
+        "\t\t--stress-parameter-rate=<rate> \tParameter changes per second sent with --stress [default=" SUSHI_STRESS_PARAMETER_RATE_DEFAULT "]."
+    },
+    {
+        OPT_IDX_STRESS_GRAPH_EDIT_RATE,
+        OPT_TYPE_UNUSED,
+        "",
+        "stress-graph-edit-rate",
+        SushiArg::NonEmpty,
+        "\t\t--stress-graph-edit-rate=<rate> \tPlugins added or removed per second with --stress [default=0]."
+    },
+    {
+        OPT_IDX_STRESS_DURATION,
+        OPT_TYPE_UNUSED,
+        "",
+        "stress-duration",
+        SushiArg::Numeric,
+        "\t\t--stress-duration=<seconds> \tExit after running the stress test for this long, 0 runs until interrupted [default=0]."
+    },
+    {
+        OPT_IDX_STRESS_REPORT_INTERVAL,
+        OPT_TYPE_UNUSED,
+        "",
+        "stress-report-interval",
+        SushiArg::Numeric,
+        "\t\t--stress-report-interval=<seconds> \tSeconds between load reports with --stress, 0 only reports at exit [default=" SUSHI_STRESS_REPORT_INTERVAL_DEFAULT "]."
+    },
     {
         OPT_IDX_USE_JACK,
         OPT_TYPE_DISABLED,
@@ -263,6 +367,14 @@ const optionparser::Descriptor usage[] =
         SushiArg::NonEmpty,
         "\t\t--server-name=<jack server name> \tSpecify name of Jack server to connect to [determined by jack if empty]."
     },
+    {
+        OPT_IDX_JACK_MIDI,
+        OPT_TYPE_DISABLED,
+        "",
+        "jack-midi",
+        SushiArg::Optional,
+        "\t\t--jack-midi \tUse Jack midi ports with sample accurate timing instead of Alsa midi."
+    },
     {
         OPT_IDX_USE_XENOMAI_RASPA,
         OPT_TYPE_DISABLED,
@@ -319,6 +431,14 @@ const optionparser::Descriptor usage[] =
         SushiArg::NonEmpty,
         "\t\t--grpc-address=<port> \tgRPC listening address in the format: address:port. By default accepts incoming connections from all ip:s [default port=" SUSHI_GRPC_LISTENING_PORT "]."
     },
+    {
+        OPT_IDX_AUDIO_CHUNK_SIZE,
+        OPT_TYPE_UNUSED,
+        "",
+        "audio-chunk-size",
+        SushiArg::Numeric,
+        "\t\t--audio-chunk-size=<n> \tProcess audio in chunks of n samples. Must be a power of 2, not larger than the compiled in buffer size [default=compiled in buffer size]."
+    },
     // Don't touch this one (set default values for optionparse library)
     { 0, 0, 0, 0, 0, 0}
 };
@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include "plugins/arpeggiator_plugin.h"
+#include "library/internal_plugin_registry.h"
 #include "logging.h"
 
 namespace sushi {
@@ -105,7 +106,7 @@ void ArpeggiatorPlugin::process_audio(const ChunkSampleBuffer&/*in_buffer*/, Chu
             _last_note_beat = _host_control.transport()->current_beats();
         }
         double beat = _host_control.transport()->current_beats();
-        double last_beat_this_chunk = _host_control.transport()->current_beats(AUDIO_CHUNK_SIZE);
+        double last_beat_this_chunk = _host_control.transport()->current_beats(audio_chunk_size());
         double beat_period = last_beat_this_chunk - beat;
         auto notes_this_chunk = std::min(MULTIPLIER_8TH_NOTE * (last_beat_this_chunk - _last_note_beat), 2.0);
 
@@ -118,8 +119,8 @@ void ArpeggiatorPlugin::process_audio(const ChunkSampleBuffer&/*in_buffer*/, Chu
             if (fraction > 0)
             {
                 /* If fraction is not positive, then there was a missed beat in an underrun */
-                offset = std::min(static_cast<int>(std::round(AUDIO_CHUNK_SIZE * fraction / beat_period)),
-                                  AUDIO_CHUNK_SIZE - 1);
+                offset = std::min(static_cast<int>(std::round(audio_chunk_size() * fraction / beat_period)),
+                                  audio_chunk_size() - 1);
             }
 
             RtEvent note_off = RtEvent::make_note_off_event(this->id(), offset, 0, _current_note, 1.0f);
@@ -199,5 +200,8 @@ int Arpeggiator::next_note()
     }
     return _notes[_note_idx] + _octave_idx * OCTAVE;
 }
+
+SUSHI_REGISTER_INTERNAL_PLUGIN(ArpeggiatorPlugin, "sushi.testing.arpeggiator");
+
 }// namespace sample_player_plugin
 }// namespace sushi
@@ -23,6 +23,7 @@
 #include <cmath>
 
 #include "plugins/control_to_cv_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace control_to_cv_plugin {
@@ -240,5 +241,8 @@ float pitch_to_cv(float value)
     // Currently just assuming [0, 1] covers a 10 octave linear range.
     return std::clamp(value / 120.f, 0.0f, 1.0f);
 }
+
+SUSHI_REGISTER_INTERNAL_PLUGIN(ControlToCvPlugin, "sushi.testing.control_to_cv");
+
 }// namespace control_to_cv_plugin
 }// namespace sushi
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include <cmath>
 
 #include "plugins/cv_to_control_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace cv_to_control_plugin {
@@ -199,5 +200,8 @@ std::pair<int, float> cv_to_pitch(float value)
     double fraction = modf(value * 120.0f , &int_note);
     return {static_cast<int>(int_note), static_cast<float>(fraction)};
 }
+
+SUSHI_REGISTER_INTERNAL_PLUGIN(CvToControlPlugin, "sushi.testing.cv_to_control");
+
 }// namespace cv_to_control_plugin
 }// namespace sushi
\ No newline at end of file
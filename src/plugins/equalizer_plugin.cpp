@@ -21,6 +21,7 @@
 #include <cassert>
 
 #include "equalizer_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace equalizer_plugin {
@@ -54,11 +55,7 @@ ProcessorReturnCode EqualizerPlugin::init(float sample_rate)
 {
     _sample_rate = sample_rate;
 
-    for (auto& f : _filters)
-    {
-        f.set_smoothing(AUDIO_CHUNK_SIZE);
-        f.reset();
-    }
+    _filter.reset();
 
     return ProcessorReturnCode::OK;
 }
@@ -88,14 +85,12 @@ void EqualizerPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSam
     if (!_bypassed)
     {
         /* Recalculate the coefficients once per audio chunk, this makes for
-         * predictable cpu load for every chunk */
+         * predictable cpu load for every chunk. All channels are filtered in
+         * parallel and changes are ramped over the chunk */
         dsp::biquad::Coefficients coefficients;
         dsp::biquad::calc_biquad_peak(coefficients, _sample_rate, frequency, q, gain);
-        for (int i = 0; i < _current_input_channels; ++i)
-        {
-            _filters[i].set_coefficients(coefficients);
-            _filters[i].process(in_buffer.channel(i), out_buffer.channel(i), AUDIO_CHUNK_SIZE);
-        }
+        _filter.set_coefficients(0, coefficients);
+        _filter.process(in_buffer, out_buffer);
     }
     else
     {
@@ -103,5 +98,7 @@ void EqualizerPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSam
     }
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(EqualizerPlugin, "sushi.testing.equalizer");
+
 }// namespace equalizer_plugin
 }// namespace sushi
\ No newline at end of file
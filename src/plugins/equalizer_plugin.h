@@ -48,7 +48,7 @@ public:
 
 private:
     float _sample_rate;
-    dsp::biquad::BiquadFilter _filters[MAX_CHANNELS_SUPPORTED];
+    dsp::biquad::BiquadCascade<1, MAX_CHANNELS_SUPPORTED> _filter;
 
     FloatParameterValue* _frequency;
     FloatParameterValue* _gain;
@@ -18,13 +18,37 @@
  * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
  */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 
 #include "gain_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace gain_plugin {
 
+constexpr float MIN_GAIN_DB = -120.0f;
+constexpr float MAX_GAIN_DB = 24.0f;
+
+namespace {
+
+/* Multiplies one channel with a gain curve, written out here so the compiler can
+ * vectorise it for the static chunk sizes */
+inline void apply_gain_curve(const float* in, float* out, const float* gain, int samples)
+{
+    with_static_chunk_size(samples, [&](auto frames)
+    {
+        for (int i = 0; i < frames; ++i)
+        {
+            out[i] = in[i] * gain[i];
+        }
+    });
+}
+
+} // anonymous namespace
+
 GainPlugin::GainPlugin(HostControl host_control) : InternalPlugin(host_control)
 {
     _max_input_channels = MAX_CHANNELS;
@@ -32,8 +56,8 @@ GainPlugin::GainPlugin(HostControl host_control) : InternalPlugin(host_control)
     Processor::set_name(DEFAULT_NAME);
     Processor::set_label(DEFAULT_LABEL);
     _gain_parameter = register_float_parameter("gain", "Gain", "dB",
-                                               0.0f, -120.0f, 24.0f,
-                                               new dBToLinPreProcessor(-120.0f, 24.0f));
+                                               0.0f, MIN_GAIN_DB, MAX_GAIN_DB,
+                                               new dBToLinPreProcessor(MIN_GAIN_DB, MAX_GAIN_DB));
     assert(_gain_parameter);
 }
 
@@ -52,14 +76,75 @@ void GainPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBu
     float gain = _gain_parameter->processed_value();
     if (!_bypassed)
     {
+        if (_gain_cv_signal)
+        {
+            _process_with_cv_signal(in_buffer, out_buffer);
+            return;
+        }
         out_buffer.clear();
         out_buffer.add_with_gain(in_buffer, gain);
     } else
     {
+        _gain_cv_signal = nullptr;
         bypass_process(in_buffer, out_buffer);
     }
 }
 
+void GainPlugin::set_bypassed(bool bypassed)
+{
+    /* A cv signal is only valid for the chunk it was set for */
+    _gain_cv_signal = nullptr;
+    Processor::set_bypassed(bypassed);
+}
+
+bool GainPlugin::supports_cv_signal(ObjectId parameter_id) const
+{
+    return parameter_id == _gain_parameter->descriptor()->id();
+}
+
+void GainPlugin::set_cv_signal(ObjectId parameter_id, const float* signal)
+{
+    if (parameter_id == _gain_parameter->descriptor()->id())
+    {
+        _gain_cv_signal = signal;
+    }
+}
+
+void GainPlugin::_process_with_cv_signal(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer)
+{
+    int samples = in_buffer.frame_count();
+    /* Same mapping as the parameter's dBToLinPreProcessor, inlined to avoid going
+     * through the parameter for every sample */
+    std::array<float, AUDIO_CHUNK_SIZE> gain;
+    for (int i = 0; i < samples; ++i)
+    {
+        float gain_db = MIN_GAIN_DB + (MAX_GAIN_DB - MIN_GAIN_DB) * std::clamp(_gain_cv_signal[i], 0.0f, 1.0f);
+        gain[i] = std::pow(10.0f, gain_db / 20.0f);
+    }
+    /* Same channel handling as add_with_gain(), a mono input is sent to all outputs */
+    if (in_buffer.channel_count() == 1)
+    {
+        for (int ch = 0; ch < out_buffer.channel_count(); ++ch)
+        {
+            apply_gain_curve(in_buffer.channel(0), out_buffer.channel(ch), gain.data(), samples);
+        }
+    }
+    else if (in_buffer.channel_count() == out_buffer.channel_count())
+    {
+        for (int ch = 0; ch < out_buffer.channel_count(); ++ch)
+        {
+            apply_gain_curve(in_buffer.channel(ch), out_buffer.channel(ch), gain.data(), samples);
+        }
+    }
+    else
+    {
+        out_buffer.clear();
+    }
+    /* Only valid for one chunk */
+    _gain_cv_signal = nullptr;
+}
+
+SUSHI_REGISTER_INTERNAL_PLUGIN(GainPlugin, "sushi.testing.gain");
 
 }// namespace gain_plugin
 }// namespace sushi
\ No newline at end of file
@@ -41,8 +41,17 @@ public:
 
     void process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer) override;
 
+    void set_bypassed(bool bypassed) override;
+
+    bool supports_cv_signal(ObjectId parameter_id) const override;
+
+    void set_cv_signal(ObjectId parameter_id, const float* signal) override;
+
 private:
+    void _process_with_cv_signal(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer);
+
     FloatParameterValue* _gain_parameter;
+    const float* _gain_cv_signal{nullptr};
 };
 
 }// namespace gain_plugin
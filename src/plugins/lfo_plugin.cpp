@@ -21,6 +21,7 @@
 #include <cassert>
 
 #include "lfo_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace lfo_plugin {
@@ -47,13 +48,13 @@ LfoPlugin::~LfoPlugin() = default;
 
 ProcessorReturnCode LfoPlugin::init(float sample_rate)
 {
-    _buffers_per_second = sample_rate / AUDIO_CHUNK_SIZE;
+    _buffers_per_second = sample_rate / audio_chunk_size();
     return ProcessorReturnCode::OK;
 }
 
 void LfoPlugin::configure(float sample_rate)
 {
-    _buffers_per_second = sample_rate / AUDIO_CHUNK_SIZE;
+    _buffers_per_second = sample_rate / audio_chunk_size();
 }
 
 void LfoPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer)
@@ -63,5 +64,7 @@ void LfoPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuf
     this->set_parameter_and_notify(_out_parameter, (std::sin(_phase) + 1) * 0.5f);
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(LfoPlugin, "sushi.testing.lfo");
+
 }// namespace lfo_plugin
 }// namespace sushi
\ No newline at end of file
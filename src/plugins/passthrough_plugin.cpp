@@ -22,6 +22,7 @@
 #include <cassert>
 
 #include "passthrough_plugin.h"
+#include "library/internal_plugin_registry.h"
 
 namespace sushi {
 namespace passthrough_plugin {
@@ -51,6 +52,7 @@ PassthroughPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSample
     }
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(PassthroughPlugin, "sushi.testing.passthrough");
 
 }// namespace passthrough_plugin
 }// namespace sushi
\ No newline at end of file
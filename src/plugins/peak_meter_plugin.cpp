@@ -21,6 +21,8 @@
 #include <cassert>
 
 #include "peak_meter_plugin.h"
+#include "library/internal_plugin_registry.h"
+#include "dsp_library/level_analysis.h"
 
 namespace sushi {
 namespace peak_meter_plugin {
@@ -57,15 +59,11 @@ void PeakMeterPlugin::process_audio(const ChunkSampleBuffer &in_buffer, ChunkSam
 
     for (int ch = 0; ch < std::min(MAX_METERED_CHANNELS, in_buffer.channel_count()); ++ch)
     {
-        float max = 0.0f;
-        for (int i{0}; i < AUDIO_CHUNK_SIZE; ++i)
-        {
-            max = std::max(max, std::abs(in_buffer.channel(ch)[i]));
-        }
-        _smoothed[ch] = _smoothing_coef * _smoothed[ch] + (1.0f - _smoothing_coef) * max;
+        auto levels = dsp::analyse_levels(in_buffer.channel(ch), in_buffer.frame_count());
+        _smoothed[ch] = _smoothing_coef * _smoothed[ch] + (1.0f - _smoothing_coef) * levels.peak;
     }
 
-    _sample_count += AUDIO_CHUNK_SIZE;
+    _sample_count += in_buffer.frame_count();
     if (_sample_count > _refresh_interval)
     {
         _sample_count -= _refresh_interval;
@@ -88,9 +86,10 @@ void PeakMeterPlugin::configure(float sample_rate)
 void PeakMeterPlugin::_update_refresh_interval(float sample_rate)
 {
     _refresh_interval = static_cast<int>(std::round(sample_rate / REFRESH_RATE));
-    _smoothing_coef = std::exp(-2.0f * M_PI * SMOOTHING_CUTOFF * AUDIO_CHUNK_SIZE/ sample_rate);
+    _smoothing_coef = std::exp(-2.0f * M_PI * SMOOTHING_CUTOFF * audio_chunk_size()/ sample_rate);
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(PeakMeterPlugin, "sushi.testing.peakmeter");
 
 }// namespace gain_plugin
 }// namespace sushi
\ No newline at end of file
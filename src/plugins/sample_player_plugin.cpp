@@ -18,10 +18,16 @@
  * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 #include <sndfile.h>
 
 #include "sample_player_plugin.h"
+#include "library/internal_plugin_registry.h"
+#include "library/mapped_blob.h"
 #include "logging.h"
 
 namespace sushi {
@@ -29,6 +35,180 @@ namespace sample_player_plugin {
 
 SUSHI_GET_LOGGER_WITH_MODULE_NAME("sampleplayer");
 
+using sample_player_voice::SampleData;
+
+namespace {
+
+/* Reads the frames of a streamed sample, takes ownership of the file */
+class SndfileReader : public sample_player_voice::SampleReader
+{
+public:
+    explicit SndfileReader(SNDFILE* file) : _file(file) {}
+
+    ~SndfileReader() override
+    {
+        sf_close(_file);
+    }
+
+    int64_t read(int64_t start_frame, float* destination, int64_t frames) override
+    {
+        if (sf_seek(_file, start_frame, SEEK_SET) < 0)
+        {
+            return 0;
+        }
+        return sf_readf_float(_file, destination, frames);
+    }
+
+private:
+    SNDFILE* _file;
+};
+
+/* Reads the frames of a streamed sample from the file of a memory mapped sample and keeps
+ * the mapping alive. The frames are read from the file and not copied from the mapping,
+ * so that a file truncated while loaded is read as silence instead of raising SIGBUS. */
+class MappedReader : public sample_player_voice::SampleReader
+{
+public:
+    MappedReader(std::shared_ptr<const MappedBlob> blob,
+                 size_t offset,
+                 int64_t frames) : _blob(std::move(blob)), _offset(offset), _frames(frames) {}
+
+    int64_t read(int64_t start_frame, float* destination, int64_t frames) override
+    {
+        int64_t count = std::clamp<int64_t>(_frames - start_frame, 0, frames);
+        auto bytes = _blob->read(_offset + start_frame * sizeof(float),
+                                 reinterpret_cast<uint8_t*>(destination),
+                                 count * sizeof(float));
+        return static_cast<int64_t>(bytes / sizeof(float));
+    }
+
+private:
+    std::shared_ptr<const MappedBlob> _blob;
+    size_t  _offset;
+    int64_t _frames;
+};
+
+/* The guard frames of a mapped sample are the zero padding after the end of the mapping */
+static_assert(sample_player_voice::GUARD_FRAMES * sizeof(float) <= MappedBlob::PADDING_BYTES);
+
+uint32_t read_le32(const uint8_t* data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint16_t read_le16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+/* Find the frames of a mono sample stored as 32 bit floats that can be used directly from
+ * a mapped file. Either a raw file with the extension .f32 in native byte order, or a wav
+ * file with the data chunk last, so that the frames are followed by the zero padding of
+ * the mapping. Returns false if the file is in any other format. */
+bool find_float_frames(const std::string& file_name, const MappedBlob& blob, const float*& frames, int64_t& count)
+{
+    constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+    const uint8_t* data = blob.data();
+    size_t size = blob.size();
+
+    if (file_name.size() > 4 && file_name.compare(file_name.size() - 4, 4, ".f32") == 0)
+    {
+        frames = reinterpret_cast<const float*>(data);
+        count = static_cast<int64_t>(size / sizeof(float));
+        return size % sizeof(float) == 0;
+    }
+    if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__ || size < 12 ||
+        std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+    bool float_mono = false;
+    size_t pos = 12;
+    while (size - pos >= 8)
+    {
+        size_t chunk_size = read_le32(data + pos + 4);
+        const uint8_t* chunk = data + pos + 8;
+        if (chunk_size > size - pos - 8)
+        {
+            return false;
+        }
+        if (std::memcmp(data + pos, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            uint16_t format = read_le16(chunk);
+            if (format == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 26)
+            {
+                format = read_le16(chunk + 24);
+            }
+            float_mono = format == WAVE_FORMAT_IEEE_FLOAT && read_le16(chunk + 2) == 1 && read_le16(chunk + 14) == 32;
+        }
+        else if (std::memcmp(data + pos, "data", 4) == 0)
+        {
+            size_t offset = pos + 8;
+            if (float_mono == false || offset % alignof(float) != 0 || offset + chunk_size != size)
+            {
+                return false;
+            }
+            frames = reinterpret_cast<const float*>(chunk);
+            count = static_cast<int64_t>(chunk_size / sizeof(float));
+            return true;
+        }
+        pos += 8 + chunk_size + (chunk_size & 1);
+    }
+    return false;
+}
+
+/* Create a sample from frames in a mapped file, the rest after the head is streamed from
+ * the file. If the head could not be locked in memory, it is copied instead, so that
+ * the rt thread never waits for the file to be read. */
+SampleData* create_mapped_sample(std::shared_ptr<const MappedBlob> blob,
+                                 const float* frames_start,
+                                 int64_t frames,
+                                 bool head_locked)
+{
+    int64_t head_frames = std::min(frames, STREAMING_HEAD_FRAMES);
+    std::unique_ptr<sample_player_voice::SampleReader> reader;
+    if (head_frames < frames)
+    {
+        auto offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(frames_start) - blob->data());
+        reader = std::make_unique<MappedReader>(blob, offset, frames);
+    }
+    if (head_locked == false)
+    {
+        /* The guard frames are the zero padding of the mapping, see find_float_frames() */
+        std::vector<float> head(frames_start, frames_start + head_frames + sample_player_voice::GUARD_FRAMES);
+        return new SampleData(std::move(head), frames, std::move(reader));
+    }
+    return new SampleData(std::move(blob), frames_start, head_frames, frames, std::move(reader));
+}
+
+/* Load a sample without copying it if it is stored as floats, see find_float_frames().
+ * Only the head of the sample is read in advance and locked in memory. The file must
+ * not be modified while the sample is loaded, as the head is used from the mapping. */
+SampleData* load_mapped_sample(const std::string& file_name)
+{
+    auto blob = MappedBlob::map(file_name);
+    const float* frames_start;
+    int64_t frames;
+    if (blob == nullptr || find_float_frames(file_name, *blob, frames_start, frames) == false || frames == 0)
+    {
+        return nullptr;
+    }
+    int64_t head_frames = std::min(frames, STREAMING_HEAD_FRAMES);
+    auto offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(frames_start) - blob->data());
+    auto head_bytes = (head_frames + sample_player_voice::GUARD_FRAMES) * sizeof(float);
+    blob->prefetch(offset, head_bytes);
+    bool locked = blob->lock(offset, head_bytes);
+    if (locked == false)
+    {
+        SUSHI_LOG_WARNING("Failed to lock sample {} in memory, copying the head of it", file_name);
+    }
+    SUSHI_LOG_INFO("Mapped {} frames from sample file {}", frames, file_name);
+    return create_mapped_sample(std::move(blob), frames_start, frames, locked);
+}
+
+} // anonymous namespace
+
 SamplePlayerPlugin::SamplePlayerPlugin(HostControl host_control) : InternalPlugin(host_control)
 {
     Processor::set_name(DEFAULT_NAME);
@@ -54,16 +234,23 @@ SamplePlayerPlugin::SamplePlayerPlugin(HostControl host_control) : InternalPlugi
                                                   new FloatParameterPreProcessor(0.0f, 10.0f));
 
     [[maybe_unused]] bool str_pr_ok = register_string_property("sample_file", "Sample File", "");
-    assert(_volume_parameter && _attack_parameter && _decay_parameter && _sustain_parameter && _release_parameter && str_pr_ok);
+
+    _polyphony_parameter = register_int_parameter("polyphony", "Polyphony", "",
+                                                  DEFAULT_POLYPHONY, 1, MAX_POLYPHONY,
+                                                  new IntParameterPreProcessor(1, MAX_POLYPHONY));
+
+    _sample_file_property_id = parameter_from_name("sample_file")->id();
+
+    assert(_volume_parameter && _attack_parameter && _decay_parameter && _sustain_parameter && _release_parameter &&
+           str_pr_ok && _polyphony_parameter);
 }
 
 ProcessorReturnCode SamplePlayerPlugin::init(float sample_rate)
 {
-    _sample.set_sample(&_dummy_sample, 0);
     for (auto& voice : _voices)
     {
         voice.set_samplerate(sample_rate);
-        voice.set_sample(&_sample);
+        voice.set_sample(_sample_data);
     }
 
     return ProcessorReturnCode::OK;
@@ -93,7 +280,8 @@ void SamplePlayerPlugin::set_bypassed(bool bypassed)
 
 SamplePlayerPlugin::~SamplePlayerPlugin()
 {
-    delete _sample_buffer;
+    delete _sample_data;
+    delete _pending_sample;
     delete _sample_file_property;
 }
 
@@ -107,31 +295,10 @@ void SamplePlayerPlugin::process_event(const RtEvent& event)
             {
                 break;
             }
-            bool voice_allocated = false;
             auto key_event = event.keyboard_event();
             SUSHI_LOG_DEBUG("Sample Player: note ON, num. {}, vel. {}",
                             key_event->note(), key_event->velocity());
-            for (auto& voice : _voices)
-            {
-                if (!voice.active())
-                {
-                    voice.note_on(key_event->note(), key_event->velocity(), event.sample_offset());
-                    voice_allocated = true;
-                    break;
-                }
-            }
-            // TODO - improve voice stealing algorithm
-            if (!voice_allocated)
-            {
-                for (auto& voice : _voices)
-                {
-                    if (voice.stopping())
-                    {
-                        voice.note_on(key_event->note(), key_event->velocity(), event.sample_offset());
-                        break;
-                    }
-                }
-            }
+            _allocate_voice().note_on(key_event->note(), key_event->velocity(), event.sample_offset());
             break;
         }
         case RtEventType::NOTE_OFF:
@@ -172,16 +339,22 @@ void SamplePlayerPlugin::process_event(const RtEvent& event)
         case RtEventType::ASYNC_WORK_NOTIFICATION:
         {
             auto typed_event = event.async_work_completion_event();
-            if (typed_event->sending_event_id() == _pending_event_id &&
-                typed_event->return_status() == SampleChangeStatus::SUCCESS)
+            if (_stream_request_pending && typed_event->sending_event_id() == _stream_event_id)
             {
-                float* old_sample = _sample_buffer;
-                _sample_buffer = reinterpret_cast<float*>(_pending_sample.data);
-                _sample.set_sample(_sample_buffer, _pending_sample.size / sizeof(float));
-                /* Delete the old sample data outside the rt thread */
-                BlobData data{0, reinterpret_cast<uint8_t*>(old_sample)};
-                auto delete_event = RtEvent::make_delete_blob_event(data);
-                output_event(delete_event);
+                _stream_request_pending = false;
+            }
+            else if (typed_event->sending_event_id() == _pending_event_id &&
+                     typed_event->return_status() == SampleChangeStatus::SUCCESS)
+            {
+                auto old_sample = _set_sample(_pending_sample);
+                _pending_sample = nullptr;
+                /* Delete the old sample data outside the rt thread. This runs on the same thread
+                 * as the stream callbacks, so no stream can be reading from it when deleted */
+                if (old_sample)
+                {
+                    output_event(RtEvent::make_async_work_event(&SamplePlayerPlugin::delete_sample_callback,
+                                                                this->id(), old_sample));
+                }
             }
             break;
         }
@@ -212,24 +385,128 @@ void SamplePlayerPlugin::process_audio(const ChunkSampleBuffer& /* in_buffer */,
     {
         out_buffer.add_with_gain(_buffer, gain);
     }
+    _request_stream_data();
+}
+
+sample_player_voice::Voice& SamplePlayerPlugin::_allocate_voice()
+{
+    int polyphony = _polyphony_parameter->processed_value();
+    int selected = 0;
+    int quietest_released = -1;
+    for (int i = 0; i < polyphony; ++i)
+    {
+        auto& voice = _voices[i];
+        if (!voice.active())
+        {
+            selected = i;
+            quietest_released = -1;
+            break;
+        }
+        if (voice.stopping() && (quietest_released < 0 || voice.level() < _voices[quietest_released].level()))
+        {
+            quietest_released = i;
+        }
+        if (_voice_start_counts[i] < _voice_start_counts[selected])
+        {
+            selected = i;
+        }
+    }
+    if (quietest_released >= 0)
+    {
+        selected = quietest_released;
+    }
+    _voice_start_counts[selected] = ++_note_on_count;
+    return _voices[selected];
+}
+
+SampleData* SamplePlayerPlugin::_set_sample(SampleData* sample)
+{
+    auto old_sample = _sample_data;
+    _sample_data = sample;
+    for (auto& voice : _voices)
+    {
+        voice.set_sample(_sample_data);
+    }
+    return old_sample;
+}
+
+void SamplePlayerPlugin::_request_stream_data()
+{
+    if (_stream_request_pending || _sample_data == nullptr || _sample_data->streamed() == false)
+    {
+        return;
+    }
+    for (auto& voice : _voices)
+    {
+        if (voice.stream().needs_data())
+        {
+            auto e = RtEvent::make_async_work_event(&SamplePlayerPlugin::stream_callback, this->id(), this);
+            _stream_event_id = e.async_work_event()->event_id();
+            _stream_request_pending = true;
+            output_event(e);
+            return;
+        }
+    }
+}
+
+void SamplePlayerPlugin::_fill_streams()
+{
+    for (auto& voice : _voices)
+    {
+        voice.stream().fill();
+    }
+}
+
+void SamplePlayerPlugin::_allocate_streams()
+{
+    for (auto& voice : _voices)
+    {
+        voice.stream().allocate();
+    }
 }
 
-BlobData SamplePlayerPlugin::load_sample_file(const std::string &file_name)
+SampleData* SamplePlayerPlugin::load_sample_file(const std::string &file_name)
 {
+    if (auto mapped_sample = load_mapped_sample(file_name); mapped_sample)
+    {
+        return mapped_sample;
+    }
     SNDFILE*    sample_file;
     SF_INFO     soundfile_info = {};
     if (! (sample_file = sf_open(file_name.c_str(), SFM_READ, &soundfile_info)) )
     {
         SUSHI_LOG_ERROR("Failed to open sample file: {}", file_name);
-        return {0, nullptr};
+        return nullptr;
     }
-    assert(soundfile_info.channels == 1);
-    float* sample_buffer = new float[soundfile_info.frames];
-    int samples = sf_readf_float(sample_file, sample_buffer, soundfile_info.frames);
-    assert(samples == soundfile_info.frames);
-    sf_close(sample_file);
+    if (soundfile_info.channels != 1)
+    {
+        SUSHI_LOG_ERROR("Sample file {} has {} channels, only mono samples are supported", file_name, soundfile_info.channels);
+        sf_close(sample_file);
+        return nullptr;
+    }
+    auto reader = std::make_unique<SndfileReader>(sample_file);
+    int64_t frames = soundfile_info.frames;
 
-    return BlobData{static_cast<int>(samples * sizeof(float)), reinterpret_cast<uint8_t*>(sample_buffer)};
+    if (frames <= STREAMING_THRESHOLD_FRAMES)
+    {
+        std::vector<float> data(frames);
+        data.resize(std::max<int64_t>(0, reader->read(0, data.data(), frames)));
+        if (data.empty())
+        {
+            return nullptr;
+        }
+        return new SampleData(std::move(data));
+    }
+
+    /* Too long to keep in memory, only load the start of the sample and stream the rest */
+    std::vector<float> head(STREAMING_HEAD_FRAMES + sample_player_voice::GUARD_FRAMES);
+    if (reader->read(0, head.data(), head.size()) != static_cast<int64_t>(head.size()))
+    {
+        SUSHI_LOG_ERROR("Failed to read sample file: {}", file_name);
+        return nullptr;
+    }
+    SUSHI_LOG_INFO("Streaming {} frames from sample file {}", frames, file_name);
+    return new SampleData(std::move(head), frames, std::move(reader));
 }
 
 int SamplePlayerPlugin::_non_rt_callback(EventId id)
@@ -239,9 +516,17 @@ int SamplePlayerPlugin::_non_rt_callback(EventId id)
         /* Note that this doesn't handle multiple requests at once, several outstanding work
          * requests can leak the address string */
         auto sample_data = load_sample_file(*_sample_file_property);
+        if (sample_data)
+        {
+            set_string_property_value(_sample_file_property_id, *_sample_file_property);
+            if (sample_data->streamed())
+            {
+                _allocate_streams();
+            }
+        }
         delete _sample_file_property;
         _sample_file_property = nullptr;
-        if (sample_data.size > 0)
+        if (sample_data)
         {
             _pending_sample = sample_data;
             SUSHI_LOG_INFO("SamplePlayer: Successfully loaded sample data");
@@ -256,6 +541,7 @@ int SamplePlayerPlugin::_non_rt_callback(EventId id)
     }
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(SamplePlayerPlugin, "sushi.testing.sampleplayer");
 
 }// namespace sample_player_plugin
 }// namespace sushi
@@ -29,7 +29,14 @@
 namespace sushi {
 namespace sample_player_plugin {
 
-constexpr size_t TOTAL_POLYPHONY = 8;
+constexpr int MAX_POLYPHONY = 32;
+constexpr int DEFAULT_POLYPHONY = 8;
+
+/* Samples longer than this are streamed from disk instead of loaded into memory */
+constexpr int64_t STREAMING_THRESHOLD_FRAMES = 4 * 1024 * 1024;
+/* Frames preloaded from streamed samples, must cover the time it takes for the
+ * non-rt thread to read the first pages of a stream */
+constexpr int64_t STREAMING_HEAD_FRAMES = 64 * 1024;
 
 static const std::string DEFAULT_NAME = "sushi.testing.sampleplayer";
 static const std::string DEFAULT_LABEL = "Sample player";
@@ -63,13 +70,36 @@ public:
         return reinterpret_cast<SamplePlayerPlugin*>(data)->_non_rt_callback(id);
     }
 
+    static int stream_callback(void* data, EventId /*id*/)
+    {
+        reinterpret_cast<SamplePlayerPlugin*>(data)->_fill_streams();
+        return SampleChangeStatus::SUCCESS;
+    }
+
+    static int delete_sample_callback(void* data, EventId /*id*/)
+    {
+        delete reinterpret_cast<sample_player_voice::SampleData*>(data);
+        return SampleChangeStatus::SUCCESS;
+    }
+
 private:
-    BlobData load_sample_file(const std::string &file_name);
+    sample_player_voice::SampleData* load_sample_file(const std::string &file_name);
     int _non_rt_callback(EventId id);
 
-    float*  _sample_buffer{nullptr};
-    float   _dummy_sample{0.0f};
-    dsp::Sample _sample;
+    /* Pick a voice for a new note, free voices first, then the quietest voice that
+     * is released and last the voice that was started first */
+    sample_player_voice::Voice& _allocate_voice();
+
+    /* Stop all voices and set a new sample, returns the previous one */
+    sample_player_voice::SampleData* _set_sample(sample_player_voice::SampleData* sample);
+
+    void _request_stream_data();
+    void _fill_streams();
+
+    /* Allocate the stream buffers of all voices, before a streamed sample is set */
+    void _allocate_streams();
+
+    sample_player_voice::SampleData* _sample_data{nullptr};
 
     SampleBuffer<AUDIO_CHUNK_SIZE> _buffer{1};
     FloatParameterValue* _volume_parameter;
@@ -77,12 +107,20 @@ private:
     FloatParameterValue* _decay_parameter;
     FloatParameterValue* _sustain_parameter;
     FloatParameterValue* _release_parameter;
+    IntParameterValue*   _polyphony_parameter;
 
     std::string*         _sample_file_property{nullptr};
+    ObjectId             _sample_file_property_id{0};
     EventId              _pending_event_id{0};
-    BlobData             _pending_sample{0, 0};
+    sample_player_voice::SampleData* _pending_sample{nullptr};
+
+    EventId              _stream_event_id{0};
+    bool                 _stream_request_pending{false};
 
-    std::array<sample_player_voice::Voice, TOTAL_POLYPHONY> _voices;
+    std::array<sample_player_voice::Voice, MAX_POLYPHONY> _voices;
+    /* Note on count when each voice was started, for finding the oldest voice */
+    std::array<uint64_t, MAX_POLYPHONY> _voice_start_counts{};
+    uint64_t             _note_on_count{0};
 };
 
 
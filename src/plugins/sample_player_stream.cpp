@@ -0,0 +1,157 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Sample data and disk streaming for the sample player plugin
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "plugins/sample_player_stream.h"
+
+namespace sample_player_voice {
+
+SampleData::SampleData(std::vector<float> data) : _head(std::move(data))
+{
+    _frames = static_cast<int64_t>(_head.size());
+    _head_frames = _frames;
+    _head.resize(_head.size() + GUARD_FRAMES, 0.0f);
+    _head_data = _head.data();
+}
+
+SampleData::SampleData(std::vector<float> head,
+                       int64_t frames,
+                       std::unique_ptr<SampleReader> reader) : _head(std::move(head)),
+                                                               _frames(frames),
+                                                               _reader(std::move(reader))
+{
+    assert(_head.size() >= GUARD_FRAMES);
+    _head_frames = static_cast<int64_t>(_head.size()) - GUARD_FRAMES;
+    _head_data = _head.data();
+}
+
+SampleData::SampleData(std::shared_ptr<const sushi::MappedBlob> blob,
+                       const float* head,
+                       int64_t head_frames,
+                       int64_t frames,
+                       std::unique_ptr<SampleReader> reader) : _blob(std::move(blob)),
+                                                               _head_data(head),
+                                                               _head_frames(head_frames),
+                                                               _frames(frames),
+                                                               _reader(std::move(reader))
+{
+    assert(_blob && head_frames <= frames);
+    assert(head_frames == frames || _reader);
+}
+
+void SampleStream::allocate()
+{
+    if (_pages == nullptr)
+    {
+        _pages.reset(new float[PAGES * (PAGE_FRAMES + GUARD_FRAMES)]);
+        std::fill(_pages.get(), _pages.get() + PAGES * (PAGE_FRAMES + GUARD_FRAMES), 0.0f);
+    }
+}
+
+void SampleStream::start(const SampleData* sample)
+{
+    _rt_sample = (sample && sample->streamed() && _pages) ? sample : nullptr;
+    _rt_generation++;
+    _sample.store(_rt_sample, std::memory_order_relaxed);
+    _consumed.store(0, std::memory_order_relaxed);
+    _generation.store(_rt_generation, std::memory_order_release);
+}
+
+SampleSegment SampleStream::segment(int64_t frame)
+{
+    if (_rt_sample == nullptr)
+    {
+        return {nullptr, frame, frame};
+    }
+    assert(frame >= _rt_sample->head_frames());
+    auto page = static_cast<uint32_t>((frame - _rt_sample->head_frames()) / PAGE_FRAMES);
+    int64_t first = _rt_sample->head_frames() + static_cast<int64_t>(page) * PAGE_FRAMES;
+    int64_t last = first + PAGE_FRAMES - 1;
+
+    /* Release earlier pages even if this one is not available yet, otherwise the
+     * queue could fill up with pages that will never be used */
+    if (page > _consumed.load(std::memory_order_relaxed))
+    {
+        _consumed.store(page, std::memory_order_release);
+    }
+    uint64_t filled = _filled.load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(filled >> 32) != _rt_generation || page >= static_cast<uint32_t>(filled))
+    {
+        return {nullptr, first, last};
+    }
+    return {_page(page), first, last};
+}
+
+bool SampleStream::needs_data() const
+{
+    if (_rt_sample == nullptr)
+    {
+        return false;
+    }
+    uint64_t filled = _filled.load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(filled >> 32) != _rt_generation)
+    {
+        return true;
+    }
+    auto pages = static_cast<uint32_t>(filled);
+    int64_t end = _rt_sample->head_frames() + static_cast<int64_t>(pages) * PAGE_FRAMES;
+    return end < _rt_sample->frames() && pages - _consumed.load(std::memory_order_relaxed) < PAGES;
+}
+
+void SampleStream::fill()
+{
+    uint32_t generation = _generation.load(std::memory_order_acquire);
+    const SampleData* sample = _sample.load(std::memory_order_relaxed);
+    if (generation != _fill_generation)
+    {
+        _fill_generation = generation;
+        _fill_count = 0;
+    }
+    if (sample == nullptr)
+    {
+        return;
+    }
+
+    while (true)
+    {
+        /* If the rt thread skipped ahead, the pages in between are not needed */
+        _fill_count = std::max(_fill_count, _consumed.load(std::memory_order_acquire));
+        int64_t first = sample->head_frames() + static_cast<int64_t>(_fill_count) * PAGE_FRAMES;
+        if (_fill_count - _consumed.load(std::memory_order_acquire) >= PAGES || first >= sample->frames())
+        {
+            break;
+        }
+        /* The stream was restarted, the new stream is read on the next call */
+        if (_generation.load(std::memory_order_acquire) != generation)
+        {
+            break;
+        }
+        float* page = _page(_fill_count);
+        int64_t frames = PAGE_FRAMES + GUARD_FRAMES;
+        int64_t read = std::clamp<int64_t>(sample->reader()->read(first, page, frames), 0, frames);
+        std::fill(page + read, page + frames, 0.0f);
+        _fill_count++;
+        _filled.store(static_cast<uint64_t>(generation) << 32 | _fill_count, std::memory_order_release);
+    }
+}
+
+} // end namespace sample_player_voice
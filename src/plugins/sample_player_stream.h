@@ -0,0 +1,211 @@
+/*
+ * Copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk
+ *
+ * SUSHI is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU Affero General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * SUSHI is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * SUSHI.  If not, see http://www.gnu.org/licenses/
+ */
+
+/**
+ * @brief Sample data and disk streaming for the sample player plugin
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_SAMPLE_PLAYER_STREAM_H
+#define SUSHI_SAMPLE_PLAYER_STREAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "library/constants.h"
+#include "library/mapped_blob.h"
+
+namespace sample_player_voice {
+
+/* Frames kept after the last playable frame of every buffer of sample data. One is
+ * needed for the interpolation and one guards against rounding when rendering in blocks */
+constexpr int GUARD_FRAMES = 2;
+
+/**
+ * @brief Reads frames of a mono sample from disk or another slow source. Only used
+ *        from the non-rt thread.
+ */
+class SampleReader
+{
+public:
+    virtual ~SampleReader() = default;
+
+    /**
+     * @brief Read consecutive frames of the sample
+     * @param start_frame The first frame to read
+     * @param destination Buffer to read the frames to
+     * @param frames The number of frames to read
+     * @return The number of frames read, less than frames at the end of the sample
+     */
+    virtual int64_t read(int64_t start_frame, float* destination, int64_t frames) = 0;
+};
+
+/**
+ * @brief The data of a mono sample. Either the whole sample is held in memory, or only
+ *        a preloaded head of it while the rest is streamed by the voices' SampleStreams.
+ *        The memory is either owned by the sample or part of a memory mapped file.
+ */
+class SampleData
+{
+    SUSHI_DECLARE_NON_COPYABLE(SampleData);
+public:
+    /**
+     * @brief Create a sample that is held completely in memory
+     * @param data All frames of the sample
+     */
+    explicit SampleData(std::vector<float> data);
+
+    /**
+     * @brief Create a sample where only the head is held in memory
+     * @param head The first frames of the sample followed by GUARD_FRAMES more frames
+     * @param frames The total number of frames in the sample
+     * @param reader Used to read the frames after the head
+     */
+    SampleData(std::vector<float> head, int64_t frames, std::unique_ptr<SampleReader> reader);
+
+    /**
+     * @brief Create a sample from frames in a memory mapped file, without copying them
+     * @param blob The mapped file, the sample keeps a reference to it
+     * @param head The first frame of the sample, inside the mapped file. The head must be
+     *        followed by GUARD_FRAMES more frames, which are 0 after the end of the sample,
+     *        and all of it must be locked in memory
+     * @param head_frames The number of frames to read directly from the mapped file
+     * @param frames The total number of frames in the sample
+     * @param reader Used to read the frames after the head, nullptr if head_frames == frames
+     */
+    SampleData(std::shared_ptr<const sushi::MappedBlob> blob,
+               const float* head,
+               int64_t head_frames,
+               int64_t frames,
+               std::unique_ptr<SampleReader> reader);
+
+    /**
+     * @return The total number of frames in the sample
+     */
+    int64_t frames() const {return _frames;}
+
+    /**
+     * @return The number of frames held in memory, not counting the guard frames
+     */
+    int64_t head_frames() const {return _head_frames;}
+
+    const float* head() const {return _head_data;}
+
+    bool streamed() const {return _reader != nullptr;}
+
+    SampleReader* reader() const {return _reader.get();}
+
+private:
+    std::vector<float> _head;
+    std::shared_ptr<const sushi::MappedBlob> _blob;
+    const float* _head_data;
+    int64_t _head_frames;
+    int64_t _frames;
+    std::unique_ptr<SampleReader> _reader;
+};
+
+/**
+ * @brief A contiguous range of frames of a sample. All positions with
+ *        first <= floor(position) <= last can be interpolated from it.
+ */
+struct SampleSegment
+{
+    const float* data;  // data[0] is frame first, nullptr if the frames are not available
+    int64_t first;
+    int64_t last;
+};
+
+/**
+ * @brief Streams the part of a sample that comes after its preloaded head, for one voice.
+ *        Frames are passed in fixed size pages through a lock-free single producer, single
+ *        consumer queue. The rt thread consumes pages and the non-rt thread fills them by
+ *        calling fill(). Starting a new stream invalidates all filled pages, so a stream
+ *        can be restarted from the rt thread at any time without waiting for the non-rt
+ *        thread.
+ */
+class SampleStream
+{
+    SUSHI_DECLARE_NON_COPYABLE(SampleStream);
+public:
+    static constexpr int PAGE_FRAMES = 2048;
+    static constexpr int PAGES = 8;
+
+    SampleStream() = default;
+
+    /**
+     * @brief Allocate the pages, called from the non-rt thread before a streamed sample is
+     *        passed to start(). The pages are kept once allocated, so that only streams that
+     *        have been used for a streamed sample take up memory.
+     */
+    void allocate();
+
+    /**
+     * @brief Start streaming a sample from the end of its head, called from the rt thread.
+     *        If the pages are not allocated, nothing after the head of the sample is played.
+     * @param sample The sample to stream, or nullptr to stop streaming
+     */
+    void start(const SampleData* sample);
+
+    /**
+     * @brief Stop streaming, called from the rt thread
+     */
+    void stop() {start(nullptr);}
+
+    /**
+     * @brief Get the page that holds a given frame, called from the rt thread. Pages before
+     *        it are released, so frames must be requested in increasing order.
+     * @param frame The frame, must be after the head of the sample
+     * @return The page as a segment, with data set to nullptr if it has not been read yet
+     */
+    SampleSegment segment(int64_t frame);
+
+    /**
+     * @brief Called from the rt thread
+     * @return true if there are free pages that fill() would read data to
+     */
+    bool needs_data() const;
+
+    /**
+     * @brief Read data to all free pages, called from the non-rt thread
+     */
+    void fill();
+
+private:
+    float* _page(uint32_t page) {return _pages.get() + (page % PAGES) * (PAGE_FRAMES + GUARD_FRAMES);}
+
+    std::unique_ptr<float[]> _pages;
+
+    /* Set by the rt thread when (re)starting, the generation is written last */
+    std::atomic<const SampleData*> _sample{nullptr};
+    std::atomic<uint32_t>          _generation{0};
+    /* Set by the non-rt thread, generation in the upper 32 bits, number of pages filled in the lower */
+    std::atomic<uint64_t>          _filled{0};
+    /* Set by the rt thread, all pages before this one can be reused */
+    std::atomic<uint32_t>          _consumed{0};
+
+    /* Only touched by the rt thread */
+    const SampleData* _rt_sample{nullptr};
+    uint32_t          _rt_generation{0};
+
+    /* Only touched by the non-rt thread */
+    uint32_t          _fill_generation{0};
+    uint32_t          _fill_count{0};
+};
+
+} // end namespace sample_player_voice
+
+#endif //SUSHI_SAMPLE_PLAYER_STREAM_H
@@ -18,9 +18,11 @@
  * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
  */
 
+#include <array>
 #include <cassert>
 #include <cmath>
 
+#include "dsp_library/sample_wrapper.h"
 #include "plugins/sample_player_voice.h"
 
 namespace sample_player_voice {
@@ -36,36 +38,66 @@ namespace sample_player_voice {
  */
 void Voice::note_on(int note, float velocity, int offset)
 {
-    offset = std::min(offset, AUDIO_CHUNK_SIZE - 1);
+    offset = std::min(offset, sushi::audio_chunk_size() - 1);
 
-    /* Completely ignore any currently playing note, it will be cut off abruptly */
+    /* A sounding note is faded out first, as cutting it off abruptly would click. A note
+     * that has not been rendered yet can be replaced directly */
+    switch (_state)
+    {
+        case SamplePlayMode::PLAYING:
+        case SamplePlayMode::STOPPING:
+            _state = SamplePlayMode::STEALING;
+            _steal_offset = std::max(offset, _start_offset);
+            _steal_frames_left = _steal_fade_frames;
+            [[fallthrough]];
+
+        case SamplePlayMode::STEALING:
+            _current_note = note;
+            _queued_velocity = velocity;
+            _queued_note_off = false;
+            break;
+
+        default:
+            _start_note(note, velocity, offset);
+    }
+}
+
+void Voice::_start_note(int note, float velocity, int offset)
+{
     _state = SamplePlayMode::STARTING;
     /* Quadratic velocity curve */
     _velocity_gain = velocity * velocity;
     _start_offset = offset;
-    _stop_offset = AUDIO_CHUNK_SIZE;
+    _stop_offset = sushi::audio_chunk_size();
     _playback_pos = 0.0;
     _current_note = note;
     /* The root note of the sample is assumed to be C4 in 44100 Hz*/
     _playback_speed = powf(2, (note - 60)/12.0f) * _samplerate / SAMPLE_FILE_RATE;
     _envelope.gate(true);
+    _stream.start(_sample);
 }
 
 /* Release velocity is ignored atm. Has any synth ever supported it? */
 void Voice::note_off(float /*velocity*/, int offset)
 {
-    assert(offset < AUDIO_CHUNK_SIZE);
+    assert(offset < sushi::audio_chunk_size());
     if (_state == SamplePlayMode::PLAYING || _state == SamplePlayMode::STARTING)
     {
         _state = SamplePlayMode::STOPPING;
         _stop_offset = offset;
     }
+    else if (_state == SamplePlayMode::STEALING)
+    {
+        /* The queued note is released as soon as it starts */
+        _queued_note_off = true;
+    }
 }
 
 void Voice::reset()
 {
     _state = SamplePlayMode::STOPPED;
     _envelope.reset();
+    _stream.stop();
 }
 
 void Voice::render(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer)
@@ -74,25 +106,46 @@ void Voice::render(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer)
     {
         return;
     }
-    /* Handle only mono samples for now */
-    float* out = output_buffer.channel(0);
-
+    if (_state == SamplePlayMode::STEALING)
+    {
+        int fade_end = _render_steal_fade(output_buffer);
+        if (fade_end >= output_buffer.frame_count())
+        {
+            return;
+        }
+        bool note_off = _queued_note_off;
+        _start_note(_current_note, _queued_velocity, fade_end);
+        if (note_off)
+        {
+            _state = SamplePlayMode::STOPPING;
+            _stop_offset = fade_end;
+        }
+    }
+    /* The envelope is calculated first, as it can't be vectorised, and the sample is then
+     * rendered in blocks. Handle only mono samples for now */
+    std::array<float, AUDIO_CHUNK_SIZE> gain;
     for (int i = _start_offset; i < _stop_offset; ++i)
     {
-        out[i] += _sample->at(_playback_pos) * _velocity_gain * _envelope.tick(1);
-        _playback_pos += _playback_speed;
+        gain[i] = _velocity_gain * _envelope.tick(1);
     }
+    int end = _stop_offset;
 
     /* If there is a note off event, set the envelope to off and
      * render the rest of the chunk */
     if (_state == SamplePlayMode::STOPPING)
     {
         _envelope.gate(false);
-        for (int i = _stop_offset; i < AUDIO_CHUNK_SIZE; ++i)
+        for (int i = _stop_offset; i < output_buffer.frame_count(); ++i)
         {
-            out[i] += _sample->at(_playback_pos) * _velocity_gain * _envelope.tick(1);
-            _playback_pos += _playback_speed;
+            gain[i] = _velocity_gain * _envelope.tick(1);
         }
+        end = output_buffer.frame_count();
+    }
+
+    if (_render_sample(output_buffer.channel(0) + _start_offset, gain.data() + _start_offset, end - _start_offset) == false)
+    {
+        reset();
+        return;
     }
 
     /* Handle state changes and reset render limits */
@@ -106,7 +159,7 @@ void Voice::render(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer)
         case SamplePlayMode::STOPPING:
             if (_envelope.finished())
             {
-                _state = SamplePlayMode::STOPPED;
+                reset();
             }
             break;
 
@@ -116,4 +169,66 @@ void Voice::render(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer)
 
 }
 
+int Voice::_render_steal_fade(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer)
+{
+    /* The stolen note plays as before up to the new note on and is then faded out
+     * linearly from its current level */
+    std::array<float, AUDIO_CHUNK_SIZE> gain;
+    for (int i = _start_offset; i < _steal_offset; ++i)
+    {
+        gain[i] = _velocity_gain * _envelope.tick(1);
+    }
+    if (_steal_frames_left == _steal_fade_frames)
+    {
+        _steal_gain = _velocity_gain * _envelope.level();
+    }
+    int end = _steal_offset;
+    for (; end < output_buffer.frame_count() && _steal_frames_left > 0; ++end)
+    {
+        gain[end] = _steal_gain * static_cast<float>(_steal_frames_left--) / static_cast<float>(_steal_fade_frames);
+    }
+    /* If the sample ends during the fade, the rest of it is just silent */
+    _render_sample(output_buffer.channel(0) + _start_offset, gain.data() + _start_offset, end - _start_offset);
+    _start_offset = 0;
+    _steal_offset = 0;
+    return end;
+}
+
+bool Voice::_render_sample(float* output, const float* gain, int samples)
+{
+    if (_sample == nullptr)
+    {
+        return false;
+    }
+    int rendered = 0;
+    while (rendered < samples)
+    {
+        auto frame = static_cast<int64_t>(_playback_pos);
+        if (frame >= _sample->frames())
+        {
+            return false;
+        }
+        SampleSegment segment{_sample->head(), 0, _sample->head_frames() - 1};
+        if (frame >= _sample->head_frames())
+        {
+            segment = _stream.segment(frame);
+        }
+        /* Render as many samples as can be interpolated from this segment. Any rounding
+         * error in the last one is covered by the guard frames */
+        int64_t last = std::min(segment.last, _sample->frames() - 1);
+        double remaining = static_cast<double>(last + 1) - _playback_pos;
+        int count = std::min(samples - rendered, static_cast<int>(std::ceil(remaining / _playback_speed)));
+        /* If the stream has not caught up, the samples are left silent */
+        if (segment.data)
+        {
+            dsp::interpolate_and_add(segment.data + (frame - segment.first),
+                                     static_cast<float>(_playback_pos - frame), _playback_speed,
+                                     gain + rendered, output + rendered, count);
+        }
+        _playback_pos += count * static_cast<double>(_playback_speed);
+        rendered += count;
+    }
+    return true;
+}
+
 }// namespace sample_player_voice
\ No newline at end of file
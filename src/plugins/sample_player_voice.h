@@ -21,21 +21,27 @@
 #ifndef SUSHI_SAMPLE_VOICE_H
 #define SUSHI_SAMPLE_VOICE_H
 
+#include <algorithm>
+
 #include "library/sample_buffer.h"
-#include "dsp_library/sample_wrapper.h"
 #include "dsp_library/envelopes.h"
+#include "plugins/sample_player_stream.h"
 
 namespace sample_player_voice {
 
 // TODO eventually make this configurable
 constexpr float SAMPLE_FILE_RATE = 44100.0f;
 
+/* Time to fade out a sounding note when the voice is restarted with a new note */
+constexpr float STEAL_FADE_TIME = 0.002f;
+
 enum class SamplePlayMode
 {
     STOPPED,
     STARTING,
     PLAYING,
-    STOPPING
+    STOPPING,
+    STEALING
 };
 
 
@@ -46,7 +52,7 @@ class Voice
 public:
     Voice() {};
 
-    Voice(float samplerate, dsp::Sample* sample) : _samplerate(samplerate), _sample(sample) {}
+    Voice(float samplerate, const SampleData* sample) : _samplerate(samplerate), _sample(sample) {}
 
     /**
      * @brief Runtime samplerate configuration.
@@ -57,13 +63,18 @@ public:
         _playback_speed = _playback_speed * samplerate / _samplerate;
         _envelope.set_samplerate(samplerate);
         _samplerate = samplerate;
+        _steal_fade_frames = std::max(1, static_cast<int>(STEAL_FADE_TIME * samplerate));
     }
 
     /**
-     * @brief Runtime sample configuration
-     * @param sample
+     * @brief Runtime sample configuration, stops any currently playing note
+     * @param sample The sample to play, the voice does not take ownership of it
      */
-    void set_sample(dsp::Sample* sample) {_sample = sample;}
+    void set_sample(const SampleData* sample)
+    {
+        reset();
+        _sample = sample;
+    }
 
     /**
      * @brief Set the envelope parameters.
@@ -83,7 +94,7 @@ public:
      * @brief Is currently in the release phase but still playing.
      * @return True if note is currently off but still sounding.
      */
-    bool stopping() {return _state == SamplePlayMode::STOPPING;}
+    bool stopping() {return _state == SamplePlayMode::STOPPING || (_state == SamplePlayMode::STEALING && _queued_note_off);}
 
     /**
      * @brief Return the current note being played, if any.
@@ -92,7 +103,19 @@ public:
     int current_note() {return _current_note;}
 
     /**
-     * @brief Play a new note within this audio chunk
+     * @brief The current output level of the voice, ignoring the sample itself.
+     * @return The envelope level multiplied with the velocity gain.
+     */
+    float level() const {return _velocity_gain * _envelope.level();}
+
+    /**
+     * @brief Stream used when playing samples that don't fit in memory.
+     */
+    SampleStream& stream() {return _stream;}
+
+    /**
+     * @brief Play a new note within this audio chunk. If a note is already sounding, it
+     *        is faded out over STEAL_FADE_TIME before the new note starts.
      * @param note The midi note number to play, with 60 as middle C.
      * @param velocity Velocity of the note to play. 0 to 1.
      * @param time_offset Offset in samples from the start of the chunk.
@@ -118,17 +141,35 @@ public:
     void render(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer);
 
 private:
+    void _start_note(int note, float velocity, int offset);
+
+    /* Render the fade out of a stolen note, returns the frame where the fade ended or
+     * the chunk size if it continues in the next chunk */
+    int _render_steal_fade(sushi::SampleBuffer<AUDIO_CHUNK_SIZE>& output_buffer);
+
+    /* Add samples from the current playback position to output, returns false if the end
+     * of the sample was reached */
+    bool _render_sample(float* output, const float* gain, int samples);
 
     float _samplerate{44100};
-    dsp::Sample* _sample;
+    const SampleData* _sample{nullptr};
+    SampleStream _stream;
     SamplePlayMode _state{SamplePlayMode::STOPPED};
     dsp::AdsrEnvelope _envelope;
     int _current_note;
-    float _playback_speed;
-    float _velocity_gain;
+    float _playback_speed{1.0f};
+    float _velocity_gain{0.0f};
     double _playback_pos{0.0};
     int _start_offset{0};
     int _stop_offset{0};
+
+    /* The note to start when the fade out of a stolen note is done */
+    float _queued_velocity{0.0f};
+    bool _queued_note_off{false};
+    int _steal_offset{0};
+    int _steal_fade_frames{static_cast<int>(STEAL_FADE_TIME * 44100)};
+    int _steal_frames_left{0};
+    float _steal_gain{0.0f};
 };
 
 } // end namespace sample_player_voice
@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include "plugins/step_sequencer_plugin.h"
+#include "library/internal_plugin_registry.h"
 #include "logging.h"
 
 namespace sushi {
@@ -132,7 +133,7 @@ void StepSequencerPlugin::process_audio(const ChunkSampleBuffer& in_buffer, Chun
     }
 
     float start_beat = _host_control.transport()->current_bar_beats() * MULTIPLIER_8TH_NOTE;
-    float end_beat = _host_control.transport()->current_bar_beats(AUDIO_CHUNK_SIZE) * MULTIPLIER_8TH_NOTE;
+    float end_beat = _host_control.transport()->current_bar_beats(audio_chunk_size()) * MULTIPLIER_8TH_NOTE;
 
     /* New 8th note during this chunk */
     if (static_cast<int>(end_beat) - static_cast<int>(start_beat) != 0)
@@ -179,5 +180,7 @@ int snap_to_scale(int note, const std::array<int, 12>& scale)
     return scale[note % OCTAVE] + octave * OCTAVE;
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(StepSequencerPlugin, "sushi.testing.step_sequencer");
+
 }// namespace step_sequencer_plugin
 }// namespace sushi
@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include "plugins/transposer_plugin.h"
+#include "library/internal_plugin_registry.h"
 #include "library/midi_decoder.h"
 #include "library/midi_encoder.h"
 #include "logging.h"
@@ -135,5 +136,7 @@ void TransposerPlugin::process_audio(const ChunkSampleBuffer&, ChunkSampleBuffer
     }
 }
 
+SUSHI_REGISTER_INTERNAL_PLUGIN(TransposerPlugin, "sushi.testing.transposer");
+
 }// namespace transposer_plugin
 }// namespace sushi
@@ -0,0 +1,73 @@
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+#include "library/sample_buffer.h"
+#include "dsp_library/biquad_filter.h"
+
+using namespace sushi;
+using namespace dsp::biquad;
+
+constexpr float SAMPLE_RATE = 48000;
+constexpr int CHANNELS = 2;
+constexpr int SECTIONS = 4;
+
+/* A 4 band stereo eq built from one filter instance per band and channel.
+ * Arg is 1 if the coefficients should change every chunk, 0 if they are constant */
+static void BM_BiquadFilterPerChannel(benchmark::State& state)
+{
+    std::array<BiquadFilter, SECTIONS * CHANNELS> filters;
+    for (auto& filter : filters)
+    {
+        filter.set_smoothing(AUDIO_CHUNK_SIZE);
+    }
+    ChunkSampleBuffer buffer(CHANNELS);
+    std::fill(buffer.channel(0), buffer.channel(0) + AUDIO_CHUNK_SIZE, 0.5f);
+    Coefficients coefficients;
+    float gain = 1.0f;
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            gain = gain > 1.5f ? 1.0f : gain + 0.01f;
+        }
+        for (int s = 0; s < SECTIONS; ++s)
+        {
+            calc_biquad_peak(coefficients, SAMPLE_RATE, 100.0f * (s + 1), 1.0f, gain);
+            for (int ch = 0; ch < CHANNELS; ++ch)
+            {
+                filters[s * CHANNELS + ch].set_coefficients(coefficients);
+                filters[s * CHANNELS + ch].process(buffer.channel(ch), buffer.channel(ch), AUDIO_CHUNK_SIZE);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_CHUNK_SIZE);
+}
+BENCHMARK(BM_BiquadFilterPerChannel)->Arg(0)->Arg(1);
+
+/* The same eq as a cascade processing both channels in parallel */
+static void BM_BiquadCascade(benchmark::State& state)
+{
+    BiquadCascade<SECTIONS, CHANNELS> filter;
+    ChunkSampleBuffer buffer(CHANNELS);
+    std::fill(buffer.channel(0), buffer.channel(0) + AUDIO_CHUNK_SIZE, 0.5f);
+    Coefficients coefficients;
+    float gain = 1.0f;
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            gain = gain > 1.5f ? 1.0f : gain + 0.01f;
+        }
+        for (int s = 0; s < SECTIONS; ++s)
+        {
+            calc_biquad_peak(coefficients, SAMPLE_RATE, 100.0f * (s + 1), 1.0f, gain);
+            filter.set_coefficients(s, coefficients);
+        }
+        filter.process(buffer, buffer);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_CHUNK_SIZE);
+}
+BENCHMARK(BM_BiquadCascade)->Arg(0)->Arg(1);
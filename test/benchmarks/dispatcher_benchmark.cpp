@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include "engine/audio_engine.h"
+#include "engine/event_dispatcher.h"
+#include "engine/midi_dispatcher.h"
+#include "library/midi_encoder.h"
+
+using namespace sushi;
+using namespace sushi::engine;
+
+constexpr float SAMPLE_RATE = 48000;
+
+/* Deletes posted events directly so that only the cost of the
+ * midi dispatcher is measured and no events pile up */
+class DiscardingEventDispatcher : public dispatcher::BaseEventDispatcher
+{
+public:
+    void post_event(Event* event) override {delete event;}
+    int process(Event* /*event*/) override {return EventStatus::HANDLED_OK;}
+    int poster_id() override {return dispatcher::AUDIO_ENGINE_ID;}
+};
+
+class DiscardingEngine : public AudioEngine
+{
+public:
+    DiscardingEngine(float sample_rate) : AudioEngine(sample_rate) {}
+
+    dispatcher::BaseEventDispatcher* event_dispatcher() override {return &_discarding_dispatcher;}
+
+private:
+    DiscardingEventDispatcher _discarding_dispatcher;
+};
+
+static void BM_MidiDispatcherSendMidi(benchmark::State& state)
+{
+    DiscardingEngine engine(SAMPLE_RATE);
+    engine.create_track("track", 2);
+    midi_dispatcher::MidiDispatcher dispatcher(&engine);
+    dispatcher.set_midi_inputs(1);
+    dispatcher.connect_kb_to_track(0, "track");
+    auto note_on = midi::encode_note_on(0, 60, 1.0f);
+    for (auto _ : state)
+    {
+        dispatcher.send_midi(0, note_on, IMMEDIATE_PROCESS);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MidiDispatcherSendMidi);
+
+static void BM_MidiDispatcherSendMidiRt(benchmark::State& state)
+{
+    AudioEngine engine(SAMPLE_RATE);
+    engine.create_track("track", 2);
+    midi_dispatcher::MidiDispatcher dispatcher(&engine);
+    dispatcher.set_midi_inputs(1);
+    dispatcher.connect_kb_to_track(0, "track");
+    auto note_on = midi::encode_note_on(0, 60, 1.0f);
+    for (auto _ : state)
+    {
+        dispatcher.send_midi_rt(0, note_on, 0);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MidiDispatcherSendMidiRt);
+
+/* A parameter change posted from a control frontend, converted and delivered to the
+ * realtime queue, and a notification coming back from the realtime side. The
+ * dispatcher runs in synchronous mode so that no event thread is involved */
+static void BM_EventDispatcherRoundTrip(benchmark::State& state)
+{
+    AudioEngine engine(SAMPLE_RATE);
+    RtSafeRtEventFifo in_rt_queue;
+    RtSafeRtEventFifo out_rt_queue;
+    dispatcher::EventDispatcher dispatcher(&engine, &in_rt_queue, &out_rt_queue);
+    dispatcher.set_synchronous_mode(true);
+    RtEvent received;
+    for (auto _ : state)
+    {
+        dispatcher.post_event(new ParameterChangeEvent(ParameterChangeEvent::Subtype::FLOAT_PARAMETER_CHANGE,
+                                                       1, 2, 0.5f, IMMEDIATE_PROCESS));
+        dispatcher.process_pending_events();
+        out_rt_queue.pop(received);
+
+        in_rt_queue.push(RtEvent::make_parameter_change_event(1, 0, 2, 0.5f));
+        dispatcher.process_pending_events();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventDispatcherRoundTrip);
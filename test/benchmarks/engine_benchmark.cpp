@@ -0,0 +1,86 @@
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "engine/audio_engine.h"
+
+using namespace sushi;
+using namespace sushi::engine;
+
+constexpr float SAMPLE_RATE = 48000;
+constexpr int CHANNELS = 2;
+
+/* Engine with a number of stereo tracks, each with a chain of gain plugins,
+ * all tracks are fed from and summed to the main input/output bus */
+static std::unique_ptr<AudioEngine> make_engine(int tracks, int plugins_per_track, int cores)
+{
+    auto engine = std::make_unique<AudioEngine>(SAMPLE_RATE, cores);
+    engine->set_audio_input_channels(CHANNELS);
+    engine->set_audio_output_channels(CHANNELS);
+    for (int t = 0; t < tracks; ++t)
+    {
+        auto track_name = "track_" + std::to_string(t);
+        engine->create_track(track_name, CHANNELS);
+        engine->connect_audio_input_bus(0, 0, track_name);
+        engine->connect_audio_output_bus(0, 0, track_name);
+        for (int p = 0; p < plugins_per_track; ++p)
+        {
+            engine->add_plugin_to_track(track_name, "sushi.testing.gain", track_name + "_gain_" + std::to_string(p),
+                                        "", PluginType::INTERNAL);
+        }
+    }
+    return engine;
+}
+
+static void BM_TrackRender(benchmark::State& state)
+{
+    auto engine = make_engine(1, static_cast<int>(state.range(0)), 1);
+    auto track = engine->all_tracks().front();
+    std::fill(track->input_channel(0).channel(0), track->input_channel(0).channel(0) + AUDIO_CHUNK_SIZE, 0.5f);
+    for (auto _ : state)
+    {
+        track->render();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_CHUNK_SIZE);
+}
+BENCHMARK(BM_TrackRender)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
+
+/* Args are the number of tracks and the number of cores to process on */
+static void BM_EngineProcessChunk(benchmark::State& state)
+{
+    auto engine = make_engine(static_cast<int>(state.range(0)), 4, static_cast<int>(state.range(1)));
+    ChunkSampleBuffer in_buffer(CHANNELS);
+    ChunkSampleBuffer out_buffer(CHANNELS);
+    ControlBuffer in_controls;
+    ControlBuffer out_controls;
+    for (int c = 0; c < CHANNELS; ++c)
+    {
+        std::fill(in_buffer.channel(c), in_buffer.channel(c) + AUDIO_CHUNK_SIZE, 0.5f);
+    }
+    int64_t samplecount = 0;
+    for (auto _ : state)
+    {
+        Time time = std::chrono::microseconds(samplecount * 1'000'000 / static_cast<int64_t>(SAMPLE_RATE));
+        engine->process_chunk(&in_buffer, &out_buffer, &in_controls, &out_controls, time, samplecount);
+        samplecount += AUDIO_CHUNK_SIZE;
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_CHUNK_SIZE);
+}
+BENCHMARK(BM_EngineProcessChunk)->Args({1, 1})->Args({8, 1})->Args({8, 2})->Args({8, 4})->UseRealTime();
+
+/* Lookup of the first and last of 128 plugins, the engine is shared between runs
+ * as processor ids are a limited resource */
+static void BM_ParameterIdFromName(benchmark::State& state)
+{
+    static auto engine = make_engine(8, 16, 1);
+    int plugin = static_cast<int>(state.range(0));
+    auto processor_name = "track_" + std::to_string(plugin / 16) + "_gain_" + std::to_string(plugin % 16);
+    for (auto _ : state)
+    {
+        auto [status, id] = engine->parameter_id_from_name(processor_name.c_str(), "gain");
+        benchmark::DoNotOptimize(id);
+    }
+}
+BENCHMARK(BM_ParameterIdFromName)->Arg(0)->Arg(127);
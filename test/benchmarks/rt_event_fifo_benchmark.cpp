@@ -0,0 +1,31 @@
+#include <benchmark/benchmark.h>
+
+#include "library/rt_event_fifo.h"
+
+using namespace sushi;
+
+constexpr int FIFO_SIZE = 128;
+
+/* Push and pop a batch of events, as the engine does with the events of one chunk */
+template <class FifoType>
+static void BM_RtEventFifoPushPop(benchmark::State& state)
+{
+    FifoType fifo;
+    auto events = static_cast<int>(state.range(0));
+    RtEvent event = RtEvent::make_parameter_change_event(1, 0, 2, 0.5f);
+    RtEvent received;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < events; ++i)
+        {
+            fifo.push(event);
+        }
+        while (fifo.pop(received))
+        {
+            benchmark::DoNotOptimize(received);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * events);
+}
+BENCHMARK_TEMPLATE(BM_RtEventFifoPushPop, RtEventFifo<FIFO_SIZE>)->Arg(1)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(BM_RtEventFifoPushPop, RtSafeRtEventFifo)->Arg(1)->Arg(16)->Arg(64);
@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include "library/sample_buffer.h"
+
+using namespace sushi;
+
+constexpr int INTERLEAVED_CHANNELS = 2;
+
+static void fill_buffer(ChunkSampleBuffer& buffer, float value)
+{
+    for (int c = 0; c < buffer.channel_count(); ++c)
+    {
+        std::fill(buffer.channel(c), buffer.channel(c) + buffer.frame_count(), value);
+    }
+}
+
+static void BM_SampleBufferReplace(benchmark::State& state)
+{
+    ChunkSampleBuffer source(static_cast<int>(state.range(0)));
+    ChunkSampleBuffer dest(static_cast<int>(state.range(0)));
+    fill_buffer(source, 0.5f);
+    for (auto _ : state)
+    {
+        dest.replace(source);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * source.frame_count() * source.channel_count());
+}
+BENCHMARK(BM_SampleBufferReplace)->Arg(2)->Arg(8);
+
+static void BM_SampleBufferAddWithGain(benchmark::State& state)
+{
+    ChunkSampleBuffer source(static_cast<int>(state.range(0)));
+    ChunkSampleBuffer dest(static_cast<int>(state.range(0)));
+    fill_buffer(source, 0.5f);
+    for (auto _ : state)
+    {
+        dest.clear();
+        dest.add_with_gain(source, 0.7f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * source.frame_count() * source.channel_count());
+}
+BENCHMARK(BM_SampleBufferAddWithGain)->Arg(2)->Arg(8);
+
+static void BM_SampleBufferAddWithRamp(benchmark::State& state)
+{
+    ChunkSampleBuffer source(static_cast<int>(state.range(0)));
+    ChunkSampleBuffer dest(static_cast<int>(state.range(0)));
+    fill_buffer(source, 0.5f);
+    for (auto _ : state)
+    {
+        dest.clear();
+        dest.add_with_ramp(source, 0.2f, 0.8f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * source.frame_count() * source.channel_count());
+}
+BENCHMARK(BM_SampleBufferAddWithRamp)->Arg(2)->Arg(8);
+
+static void BM_SampleBufferApplyGain(benchmark::State& state)
+{
+    ChunkSampleBuffer buffer(static_cast<int>(state.range(0)));
+    fill_buffer(buffer, 0.5f);
+    /* Alternate between gains that cancel out exactly, to keep the values in range */
+    float gain = 2.0f;
+    for (auto _ : state)
+    {
+        buffer.apply_gain(gain);
+        gain = 1.0f / gain;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * buffer.frame_count() * buffer.channel_count());
+}
+BENCHMARK(BM_SampleBufferApplyGain)->Arg(2)->Arg(8);
+
+static void BM_SampleBufferInterleaving(benchmark::State& state)
+{
+    ChunkSampleBuffer buffer(INTERLEAVED_CHANNELS);
+    float interleaved[INTERLEAVED_CHANNELS * AUDIO_CHUNK_SIZE] = {};
+    for (auto _ : state)
+    {
+        buffer.from_interleaved(interleaved);
+        buffer.to_interleaved(interleaved);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * buffer.frame_count() * buffer.channel_count());
+}
+BENCHMARK(BM_SampleBufferInterleaving);
+
+static void BM_SampleBufferCountClipped(benchmark::State& state)
+{
+    ChunkSampleBuffer buffer(static_cast<int>(state.range(0)));
+    fill_buffer(buffer, 0.5f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(buffer.count_clipped_samples());
+    }
+    state.SetItemsProcessed(state.iterations() * buffer.frame_count() * buffer.channel_count());
+}
+BENCHMARK(BM_SampleBufferCountClipped)->Arg(2)->Arg(8);
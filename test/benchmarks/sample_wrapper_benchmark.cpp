@@ -0,0 +1,46 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "library/constants.h"
+#include "dsp_library/sample_wrapper.h"
+
+using namespace dsp;
+
+constexpr int SAMPLE_FRAMES = 4 * AUDIO_CHUNK_SIZE + 2;
+
+/* The single loop interpolate_and_add() replaced, kept as a reference. It only
+ * vectorises on targets with gather instructions */
+static void interpolate_and_add_gather(const float* __restrict data, float position, float speed,
+                                       const float* __restrict gain, float* __restrict output, int samples)
+{
+    for (int i = 0; i < samples; ++i)
+    {
+        float pos = position + static_cast<float>(i) * speed;
+        int index = static_cast<int>(pos);
+        float weight = pos - static_cast<float>(index);
+        output[i] += (data[index + 1] * weight + data[index] * (1.0f - weight)) * gain[i];
+    }
+}
+
+/* Render one chunk of a voice. Arg is the playback speed in percent */
+template <void (*interpolate)(const float*, float, float, const float*, float*, int)>
+static void BM_Interpolate(benchmark::State& state)
+{
+    std::vector<float> data(SAMPLE_FRAMES);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<float>(i % 100) / 100.0f;
+    }
+    std::vector<float> gain(AUDIO_CHUNK_SIZE, 0.5f);
+    std::vector<float> output(AUDIO_CHUNK_SIZE, 0.0f);
+    float speed = static_cast<float>(state.range(0)) / 100.0f;
+    for (auto _ : state)
+    {
+        interpolate(data.data(), 0.25f, speed, gain.data(), output.data(), AUDIO_CHUNK_SIZE);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_CHUNK_SIZE);
+}
+BENCHMARK_TEMPLATE(BM_Interpolate, interpolate_and_add_gather)->Arg(50)->Arg(100)->Arg(150);
+BENCHMARK_TEMPLATE(BM_Interpolate, interpolate_and_add)->Arg(50)->Arg(100)->Arg(150);
@@ -54,3 +54,55 @@ TEST_F(TestJackFrontend, TestOperation)
 }
 
 
+
+TEST_F(TestJackFrontend, TestMidiPorts)
+{
+    MidiDispatcher midi_dispatcher(&_engine);
+    midi_dispatcher.set_midi_inputs(1);
+    midi_dispatcher.set_midi_outputs(1);
+    ASSERT_EQ(MidiDispatcherStatus::OK, midi_dispatcher.connect_kb_to_track(0, "track"));
+    ASSERT_EQ(MidiDispatcherStatus::OK, midi_dispatcher.connect_track_to_output(0, "track", 3));
+
+    JackFrontend module_under_test(&_engine, &midi_dispatcher);
+    JackFrontendConfiguration config("Jack Client", "Jack Server", false, CV_CHANNELS, CV_CHANNELS, 1, 1);
+    auto ret_code = module_under_test.init(&config);
+    ASSERT_EQ(AudioFrontendStatus::OK, ret_code);
+
+    /* Simulate a note from the engine in the first chunk */
+    module_under_test._out_controls.midi_events.push(RtEvent::make_note_on_event(0, 10, 0, 48, 1.0f));
+    jack_activate(module_under_test._client);
+
+    /* The incoming note should be delivered directly to the engine */
+    EXPECT_TRUE(_engine.got_rt_event);
+    EXPECT_FALSE(static_cast<EventDispatcherMockup*>(_engine.event_dispatcher())->got_event());
+
+    /* And the outgoing note written with its sample offset */
+    EXPECT_EQ(10u, written_midi_time);
+    EXPECT_EQ(3u, written_midi_size);
+    EXPECT_EQ(0x93, written_midi_data[0]);
+    EXPECT_EQ(48, written_midi_data[1]);
+    module_under_test.cleanup();
+}
+
+TEST_F(TestJackFrontend, TestMidiOutputOrder)
+{
+    MidiDispatcher midi_dispatcher(&_engine);
+    midi_dispatcher.set_midi_outputs(1);
+    ASSERT_EQ(MidiDispatcherStatus::OK, midi_dispatcher.connect_track_to_output(0, "track", 0));
+
+    JackFrontend module_under_test(&_engine, &midi_dispatcher);
+    JackFrontendConfiguration config("Jack Client", "Jack Server", false, CV_CHANNELS, CV_CHANNELS, 0, 1);
+    ASSERT_EQ(AudioFrontendStatus::OK, module_under_test.init(&config));
+
+    /* Events from different tracks may come out of order, all should still be written */
+    module_under_test._out_controls.midi_events.push(RtEvent::make_note_on_event(0, 20, 0, 50, 1.0f));
+    module_under_test._out_controls.midi_events.push(RtEvent::make_note_on_event(0, 10, 0, 48, 1.0f));
+    module_under_test._out_controls.midi_events.push(RtEvent::make_note_on_event(0, 15, 0, 49, 1.0f));
+    jack_activate(module_under_test._client);
+
+    EXPECT_EQ(3, written_midi_count);
+    EXPECT_EQ(20u, written_midi_time);
+    EXPECT_EQ(50, written_midi_data[1]);
+    EXPECT_EQ(0, module_under_test._dropped_midi_output_events.load());
+    module_under_test.cleanup();
+}
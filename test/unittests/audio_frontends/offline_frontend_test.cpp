@@ -1,7 +1,10 @@
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 #include "gtest/gtest.h"
 
 #include "test_utils/engine_mockup.h"
+#include "engine/audio_engine.h"
 #include "engine/json_configurator.h"
 #include "test_utils/test_utils.h"
 
@@ -127,16 +130,71 @@ TEST_F(TestOfflineFrontend, TestAddSequencerEvents)
     ASSERT_EQ(jsonconfig::JsonConfigReturnStatus::OK, status);
     _module_under_test->add_sequencer_events(events);
 
-    auto event_q = _module_under_test->_event_queue;
+    auto& event_q = _module_under_test->_rt_event_queue;
     ASSERT_EQ(4u, event_q.size());
 
-    // Check that queue is sorted by time
-    auto jt = --event_q.end();
-    for(auto it = event_q.begin(); it != jt; ++it)
+    // Check that queue is sorted by sample position and that times are converted to samples
+    EXPECT_EQ(static_cast<int64_t>(0.1 * SAMPLE_RATE), event_q.front().sample);
+    EXPECT_EQ(static_cast<int64_t>(0.9 * SAMPLE_RATE), event_q.back().sample);
+    for (auto it = event_q.begin(); it != event_q.end() - 1; ++it)
     {
-        ASSERT_GE((*it)->time(), (*(it + 1))->time());
+        ASSERT_LE(it->sample, (it + 1)->sample);
+        ASSERT_EQ(RtEventType::FLOAT_PARAMETER_CHANGE, it->event.type());
     }
+}
+
+TEST_F(TestOfflineFrontend, TestAddAutomation)
+{
+    automation_file::AutomationData automation;
+    automation.parameters.push_back({"gain_0_l", "gain"});
+    automation.events.push_back({200, 0, 0.5f});
+    automation.events.push_back({100, 0, 0.25f});
+    automation.events.push_back({100, 1, 0.75f}); // Refers to a non-existing parameter
+
+    ASSERT_TRUE(_module_under_test->add_automation(automation));
+    auto& event_q = _module_under_test->_rt_event_queue;
+    ASSERT_EQ(2u, event_q.size());
+    EXPECT_EQ(100, event_q[0].sample);
+    EXPECT_FLOAT_EQ(0.25f, event_q[0].event.parameter_change_event()->value());
+    EXPECT_EQ(200, event_q[1].sample);
+    EXPECT_FLOAT_EQ(0.5f, event_q[1].event.parameter_change_event()->value());
+}
+
+TEST_F(TestOfflineFrontend, TestAddMidiEvents)
+{
+    std::vector<midi_file::MidiFileEvent> events = {{0.5, 0, {0x90, 60, 100, 0}},
+                                                    {0.25, 0, {0x80, 60, 0, 0}}};
+
+    // Without a midi dispatcher, midi can not be sequenced
+    ASSERT_FALSE(_module_under_test->add_midi_events(events));
+
+    OfflineFrontend frontend(&_engine, &_midi_dispatcher);
+    ASSERT_TRUE(frontend.add_midi_events(events, 1));
+    auto& event_q = frontend._midi_event_queue;
+    ASSERT_EQ(2u, event_q.size());
+    EXPECT_EQ(static_cast<int64_t>(0.25 * SAMPLE_RATE), event_q[0].sample);
+    EXPECT_EQ(1, event_q[0].midi_input);
+    EXPECT_EQ(0x80, event_q[0].data[0]);
+    EXPECT_EQ(static_cast<int64_t>(0.5 * SAMPLE_RATE), event_q[1].sample);
+}
 
+TEST_F(TestOfflineFrontend, TestProcessEvents)
+{
+    int chunk_size = _module_under_test->_buffer.frame_count();
+    automation_file::AutomationData automation;
+    automation.parameters.push_back({"gain_0_l", "gain"});
+    automation.events.push_back({chunk_size + 5, 0, 0.5f});
+    automation.events.push_back({3, 0, 0.25f});
+    ASSERT_TRUE(_module_under_test->add_automation(automation));
+
+    _module_under_test->_process_events(0);
+    EXPECT_TRUE(_engine.got_rt_event);
+    EXPECT_EQ(1u, _module_under_test->_rt_event_index);
+    EXPECT_EQ(3, _module_under_test->_rt_event_queue[0].event.sample_offset());
+
+    _module_under_test->_process_events(chunk_size);
+    EXPECT_EQ(2u, _module_under_test->_rt_event_index);
+    EXPECT_EQ(5, _module_under_test->_rt_event_queue[1].event.sample_offset());
 }
 
 TEST_F(TestOfflineFrontend, TestNoiseGeneration)
@@ -160,6 +218,89 @@ TEST_F(TestOfflineFrontend, TestNoiseGeneration)
     ASSERT_NEAR(INPUT_NOISE_LEVEL, rms, 0.002f);
 }
 
+TEST_F(TestOfflineFrontend, TestBufferHash)
+{
+    ChunkSampleBuffer buffer(2);
+    test_utils::fill_sample_buffer(buffer, 0.5f);
+    auto hash = hash_buffer(buffer);
+    EXPECT_NE(HASH_OFFSET_BASIS, hash);
+    EXPECT_EQ(hash, hash_buffer(buffer));
+
+    // The smallest possible change should give a different hash
+    buffer.channel(1)[AUDIO_CHUNK_SIZE - 1] = std::nextafter(0.5f, 1.0f);
+    EXPECT_NE(hash, hash_buffer(buffer));
+}
+
+TEST_F(TestOfflineFrontend, TestDeterministicMode)
+{
+    std::string hash_file_name("./test_hashes.txt");
+    OfflineFrontendConfiguration config("", "", true, CV_CHANNELS, CV_CHANNELS, true, hash_file_name);
+    auto ret_code = _module_under_test->init(&config);
+    ASSERT_EQ(AudioFrontendStatus::OK, ret_code);
+    EXPECT_TRUE(_module_under_test->_deterministic);
+    EXPECT_TRUE(_module_under_test->_hash_file.is_open());
+
+    _module_under_test->cleanup();
+    EXPECT_FALSE(_module_under_test->_deterministic);
+    EXPECT_FALSE(_module_under_test->_hash_file.is_open());
+    std::remove(hash_file_name.c_str());
+
+    OfflineFrontendConfiguration invalid_config("", "", true, CV_CHANNELS, CV_CHANNELS, true, "/not/a/valid/path");
+    ret_code = _module_under_test->init(&invalid_config);
+    ASSERT_EQ(AudioFrontendStatus::INVALID_OUTPUT_FILE, ret_code);
+}
+
+/* Render a file with a real engine in deterministic mode and return the track hashes */
+std::string render_track_hashes(const std::string& input_file, const std::string& hash_file_name)
+{
+    AudioEngine engine(SAMPLE_RATE);
+    OfflineFrontend frontend(&engine);
+    OfflineFrontendConfiguration config(input_file, "./test_out.wav", false, CV_CHANNELS, CV_CHANNELS, true, hash_file_name);
+    EXPECT_EQ(AudioFrontendStatus::OK, frontend.init(&config));
+
+    EXPECT_EQ(EngineReturnStatus::OK, engine.create_track("main", 2));
+    EXPECT_EQ(EngineReturnStatus::OK, engine.connect_audio_input_bus(0, 0, "main"));
+    EXPECT_EQ(EngineReturnStatus::OK, engine.add_plugin_to_track("main", "sushi.testing.gain", "gain", "", PluginType::INTERNAL));
+    /* A graph change should be made between the same chunks on every run */
+    engine.event_dispatcher()->post_event(new AddTrackEvent("added", 2, IMMEDIATE_PROCESS));
+    frontend.run();
+    frontend.cleanup();
+
+    std::ifstream hash_file(hash_file_name);
+    std::stringstream hashes;
+    hashes << hash_file.rdbuf();
+    std::remove(hash_file_name.c_str());
+    return hashes.str();
+}
+
+TEST(TestOfflineFrontendDeterminism, TestReproducibleHashes)
+{
+    std::string test_data_file = test_utils::get_data_dir_path();
+    test_data_file.append("test_sndfile_05.wav");
+
+    auto hashes = render_track_hashes(test_data_file, "./test_hashes_1.txt");
+    ASSERT_FALSE(hashes.empty());
+    EXPECT_EQ(hashes, render_track_hashes(test_data_file, "./test_hashes_2.txt"));
+
+    /* The added track is there from the second chunk on */
+    std::istringstream lines(hashes);
+    int64_t first_sample = -1;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::istringstream fields(line);
+        int64_t sample;
+        std::string track;
+        fields >> sample >> track;
+        if (track == "added")
+        {
+            first_sample = sample;
+            break;
+        }
+    }
+    EXPECT_EQ(AUDIO_CHUNK_SIZE, first_sample);
+}
+
 TEST(TestAudioFrontendInternals, TestRampCvOutput)
 {
     float data_buffer[AUDIO_CHUNK_SIZE];
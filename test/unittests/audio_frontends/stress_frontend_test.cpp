@@ -0,0 +1,109 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "test_utils/engine_mockup.h"
+
+#define private public
+#include "audio_frontends/stress_frontend.cpp"
+
+using namespace sushi;
+using namespace sushi::audio_frontend;
+using namespace sushi::midi_dispatcher;
+
+constexpr float SAMPLE_RATE = 44000;
+constexpr int CV_CHANNELS = 0;
+
+TEST(TestLoadHistogram, TestPercentiles)
+{
+    LoadHistogram module_under_test;
+    EXPECT_FLOAT_EQ(0.0f, LoadHistogram::percentile(module_under_test.counts(), 50));
+
+    for (int i = 0; i < 99; ++i)
+    {
+        module_under_test.add(0.1f);
+    }
+    module_under_test.add(0.9f);
+    auto counts = module_under_test.counts();
+    EXPECT_NEAR(0.1f, LoadHistogram::percentile(counts, 50), 0.005f);
+    EXPECT_NEAR(0.1f, LoadHistogram::percentile(counts, 99), 0.005f);
+    EXPECT_NEAR(0.9f, LoadHistogram::percentile(counts, 99.9f), 0.005f);
+    EXPECT_NEAR(0.9f, LoadHistogram::percentile(counts, 100), 0.005f);
+
+    /* Values out of range end up in the first and last bins */
+    module_under_test.add(-1.0f);
+    module_under_test.add(10.0f);
+    counts = module_under_test.counts();
+    EXPECT_EQ(1u, counts.front());
+    EXPECT_EQ(1u, counts.back());
+    EXPECT_FLOAT_EQ(LoadHistogram::MAX_LOAD, LoadHistogram::percentile(counts, 100));
+}
+
+class TestStressFrontend : public ::testing::Test
+{
+protected:
+    TestStressFrontend()
+    {
+    }
+
+    void SetUp()
+    {
+        _module_under_test = new StressFrontend(&_engine, &_midi_dispatcher);
+    }
+
+    void TearDown()
+    {
+        delete _module_under_test;
+    }
+
+    EngineMockup _engine{SAMPLE_RATE};
+    MidiDispatcher _midi_dispatcher{&_engine};
+    StressFrontend* _module_under_test;
+};
+
+TEST_F(TestStressFrontend, TestInit)
+{
+    StressFrontendConfiguration config(true, 10, 20, 30, std::chrono::seconds(5), CV_CHANNELS, CV_CHANNELS);
+    ASSERT_EQ(AudioFrontendStatus::OK, _module_under_test->init(&config));
+    EXPECT_TRUE(_module_under_test->_paced);
+    EXPECT_FLOAT_EQ(10, _module_under_test->_midi_rate);
+    EXPECT_FLOAT_EQ(20, _module_under_test->_parameter_rate);
+    EXPECT_FLOAT_EQ(30, _module_under_test->_graph_edit_rate);
+    EXPECT_EQ(std::chrono::seconds(5), _module_under_test->_report_interval);
+
+    /* Cleanup without having run should not do anything */
+    _module_under_test->cleanup();
+    EXPECT_FALSE(_engine.process_called);
+}
+
+TEST_F(TestStressFrontend, TestUnpacedProcessing)
+{
+    StressFrontendConfiguration config(false, 1000, 0, 0, std::chrono::seconds(0), CV_CHANNELS, CV_CHANNELS);
+    ASSERT_EQ(AudioFrontendStatus::OK, _module_under_test->init(&config));
+    _module_under_test->run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    _module_under_test->cleanup();
+
+    EXPECT_TRUE(_engine.process_called);
+    auto counters = _module_under_test->_read_counters();
+    EXPECT_GT(counters.chunks, 0u);
+    EXPECT_GT(counters.midi_messages, 0u);
+    /* All notes should have been released */
+    EXPECT_TRUE(_module_under_test->_held_notes.empty());
+}
+
+TEST_F(TestStressFrontend, TestPacedProcessing)
+{
+    StressFrontendConfiguration config(true, 0, 0, 0, std::chrono::seconds(0), CV_CHANNELS, CV_CHANNELS);
+    ASSERT_EQ(AudioFrontendStatus::OK, _module_under_test->init(&config));
+    _module_under_test->run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    _module_under_test->cleanup();
+
+    /* 100 ms should be around 69 chunks of 64 samples, allow for a slow test machine but
+     * it should never be much more than that, unlike when running unpaced */
+    auto counters = _module_under_test->_read_counters();
+    EXPECT_GT(counters.chunks, 10u);
+    EXPECT_LT(counters.chunks, 100u);
+    EXPECT_EQ(0u, counters.midi_messages);
+}
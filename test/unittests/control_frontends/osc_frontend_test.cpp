@@ -102,6 +102,79 @@ TEST_F(TestOSCFrontend, TestSendParameterChange)
     ASSERT_FALSE(_controller.was_recently_called());
 }
 
+TEST_F(TestOSCFrontend, TestNumericParameterArguments)
+{
+    ASSERT_TRUE(_module_under_test.connect_to_parameter("sampler", "volume"));
+    lo_send(_address, "/parameter/sampler/volume", "i", 3);
+
+    ASSERT_TRUE(wait_for_event());
+    auto args = _controller.get_args_from_last_call();
+    EXPECT_EQ(0, std::stoi(args["parameter id"]));
+    EXPECT_FLOAT_EQ(3.0f, std::stof(args["value"]));
+
+    lo_send(_address, "/parameter/sampler/volume", "d", 0.75);
+    ASSERT_TRUE(wait_for_event());
+    args = _controller.get_args_from_last_call();
+    EXPECT_FLOAT_EQ(0.75f, std::stof(args["value"]));
+
+    /* Non numeric arguments are still rejected */
+    lo_send(_address, "/parameter/sampler/volume", "T");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_FALSE(_controller.was_recently_called());
+}
+
+TEST_F(TestOSCFrontend, TestWildcardParameterChange)
+{
+    ASSERT_TRUE(_module_under_test.connect_to_parameter("sampler", "volume"));
+    lo_send(_address, "/parameter/sampler/*", "f", 0.25f);
+
+    ASSERT_TRUE(wait_for_event());
+    auto args = _controller.get_args_from_last_call();
+    EXPECT_FLOAT_EQ(0.25f, std::stof(args["value"]));
+
+    /* Pattern that does not match any registered path */
+    lo_send(_address, "/parameter/drums/*", "f", 0.5f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_FALSE(_controller.was_recently_called());
+}
+
+TEST_F(TestOSCFrontend, TestParameterChangeBundle)
+{
+    ASSERT_TRUE(_module_under_test.connect_to_parameter("sampler", "volume"));
+    lo_bundle bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+    lo_message first = lo_message_new();
+    lo_message_add_float(first, 0.2f);
+    lo_bundle_add_message(bundle, "/parameter/sampler/volume", first);
+    lo_message second = lo_message_new();
+    lo_message_add_float(second, 0.8f);
+    lo_bundle_add_message(bundle, "/parameter/sampler/volume", second);
+    lo_send_bundle(_address, bundle);
+    lo_bundle_free_recursive(bundle);
+
+    /* Only the last value in the bundle should be applied */
+    ASSERT_TRUE(wait_for_event());
+    auto args = _controller.get_args_from_last_call();
+    EXPECT_FLOAT_EQ(0.8f, std::stof(args["value"]));
+    EXPECT_TRUE(_module_under_test._bundled_changes.empty());
+}
+
+TEST_F(TestOSCFrontend, TestOutgoingParameterCoalescing)
+{
+    ASSERT_TRUE(_module_under_test.connect_from_parameter("sampler", "volume"));
+    for (float value : {0.1f, 0.2f, 0.3f})
+    {
+        ParameterChangeNotificationEvent event(ParameterChangeNotificationEvent::Subtype::FLOAT_PARAMETER_CHANGE_NOT,
+                                               0, 0, value, IMMEDIATE_PROCESS);
+        _module_under_test.process(&event);
+    }
+    ASSERT_EQ(1u, _module_under_test._pending_outgoing.size());
+    EXPECT_FLOAT_EQ(0.3f, _module_under_test._pending_outgoing.front()->value);
+
+    ParameterNotificationFlushEvent flush_event(IMMEDIATE_PROCESS);
+    _module_under_test.process(&flush_event);
+    EXPECT_TRUE(_module_under_test._pending_outgoing.empty());
+}
+
 TEST_F(TestOSCFrontend, TestSendNoteOn)
 {
     ASSERT_TRUE(_module_under_test.connect_kb_to_track("sampler"));
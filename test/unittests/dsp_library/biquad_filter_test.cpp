@@ -0,0 +1,149 @@
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "test_utils/test_utils.h"
+#include "dsp_library/biquad_filter.h"
+
+using namespace sushi;
+using namespace dsp::biquad;
+
+constexpr float TEST_SAMPLERATE = 48000;
+constexpr Coefficients UNITY = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+constexpr Coefficients HALF_GAIN = {0.5f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+TEST(TestBiquadFilter, TestRampAndConvergence)
+{
+    BiquadFilter module_under_test(UNITY);
+    module_under_test.set_smoothing(AUDIO_CHUNK_SIZE);
+    std::array<float, AUDIO_CHUNK_SIZE> input;
+    std::array<float, AUDIO_CHUNK_SIZE> output;
+    input.fill(1.0f);
+
+    module_under_test.process(input.data(), output.data(), AUDIO_CHUNK_SIZE);
+    for (auto sample : output)
+    {
+        ASSERT_FLOAT_EQ(1.0f, sample);
+    }
+
+    /* The gain should be ramped linearly over one chunk and then stay at the target */
+    module_under_test.set_coefficients(HALF_GAIN);
+    module_under_test.process(input.data(), output.data(), AUDIO_CHUNK_SIZE);
+    for (int i = 1; i < AUDIO_CHUNK_SIZE; ++i)
+    {
+        ASSERT_LT(output[i], output[i - 1]);
+    }
+    EXPECT_NEAR(0.5f, output.back(), 1.0e-6f);
+
+    /* Setting the same coefficients again should not restart the ramp */
+    module_under_test.set_coefficients(HALF_GAIN);
+    module_under_test.process(input.data(), output.data(), AUDIO_CHUNK_SIZE);
+    for (auto sample : output)
+    {
+        ASSERT_EQ(0.5f, sample);
+    }
+}
+
+TEST(TestBiquadCascade, TestRampAndConvergence)
+{
+    BiquadCascade<1, 2> module_under_test;
+    module_under_test.set_coefficients(0, UNITY);
+    module_under_test.reset();
+    ChunkSampleBuffer buffer(2);
+
+    test_utils::fill_sample_buffer(buffer, 1.0f);
+    module_under_test.process(buffer, buffer);
+    test_utils::assert_buffer_value(1.0f, buffer);
+
+    module_under_test.set_coefficients(0, HALF_GAIN);
+    module_under_test.process(buffer, buffer);
+    for (int ch = 0; ch < buffer.channel_count(); ++ch)
+    {
+        for (int i = 1; i < AUDIO_CHUNK_SIZE; ++i)
+        {
+            ASSERT_LT(buffer.channel(ch)[i], buffer.channel(ch)[i - 1]);
+        }
+        EXPECT_NEAR(0.5f, buffer.channel(ch)[AUDIO_CHUNK_SIZE - 1], 1.0e-6f);
+    }
+
+    module_under_test.set_coefficients(0, HALF_GAIN);
+    test_utils::fill_sample_buffer(buffer, 1.0f);
+    module_under_test.process(buffer, buffer);
+    test_utils::assert_buffer_value(0.5f, buffer);
+}
+
+/* With a runtime chunk size below the maximum only that many frames should be
+ * touched and the coefficients should reach their targets at the end of the chunk */
+TEST(TestBiquadCascade, TestRuntimeChunkSize)
+{
+    constexpr int SMALL_CHUNK_SIZE = AUDIO_CHUNK_SIZE / 2;
+    test_utils::AudioChunkSizeGuard chunk_size_guard;
+    ASSERT_TRUE(set_audio_chunk_size(SMALL_CHUNK_SIZE));
+    BiquadCascade<1, 2> module_under_test;
+    module_under_test.set_coefficients(0, UNITY);
+    module_under_test.reset();
+    ChunkSampleBuffer buffer(2);
+    ASSERT_EQ(SMALL_CHUNK_SIZE, buffer.frame_count());
+    test_utils::fill_sample_buffer(buffer, 1.0f);
+
+    module_under_test.set_coefficients(0, HALF_GAIN);
+    module_under_test.process(buffer, buffer);
+    for (int ch = 0; ch < buffer.channel_count(); ++ch)
+    {
+        for (int i = 1; i < SMALL_CHUNK_SIZE; ++i)
+        {
+            ASSERT_LT(buffer.channel(ch)[i], buffer.channel(ch)[i - 1]);
+        }
+        EXPECT_NEAR(0.5f, buffer.channel(ch)[SMALL_CHUNK_SIZE - 1], 1.0e-6f);
+    }
+}
+
+/* Each lane of the cascade should give the same result as a single channel
+ * filter per section run one after another */
+TEST(TestBiquadCascade, TestMatchesSingleChannelFilter)
+{
+    constexpr int SECTIONS = 2;
+    constexpr int CHANNELS = 3;
+    std::array<Coefficients, SECTIONS * CHANNELS> coefficients;
+    for (int ch = 0; ch < CHANNELS; ++ch)
+    {
+        calc_biquad_peak(coefficients[ch * SECTIONS], TEST_SAMPLERATE, 200.0f * (ch + 1), 0.7f, 2.0f);
+        calc_biquad_peak(coefficients[ch * SECTIONS + 1], TEST_SAMPLERATE, 5000.0f, 2.0f, 0.25f);
+    }
+
+    BiquadCascade<SECTIONS, 4> module_under_test;
+    std::array<BiquadFilter, SECTIONS * CHANNELS> reference;
+    for (int ch = 0; ch < CHANNELS; ++ch)
+    {
+        for (int s = 0; s < SECTIONS; ++s)
+        {
+            module_under_test.set_coefficients(s, ch, coefficients[ch * SECTIONS + s]);
+            reference[ch * SECTIONS + s] = BiquadFilter(coefficients[ch * SECTIONS + s]);
+        }
+    }
+    module_under_test.reset();
+
+    std::mt19937 rand_gen(1234);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    ChunkSampleBuffer in_buffer(CHANNELS);
+    ChunkSampleBuffer out_buffer(CHANNELS);
+    std::array<float, AUDIO_CHUNK_SIZE> expected;
+    for (int chunk = 0; chunk < 4; ++chunk)
+    {
+        for (int ch = 0; ch < CHANNELS; ++ch)
+        {
+            std::generate(in_buffer.channel(ch), in_buffer.channel(ch) + AUDIO_CHUNK_SIZE, [&]() {return noise(rand_gen);});
+        }
+        module_under_test.process(in_buffer, out_buffer);
+
+        for (int ch = 0; ch < CHANNELS; ++ch)
+        {
+            reference[ch * SECTIONS].process(in_buffer.channel(ch), expected.data(), AUDIO_CHUNK_SIZE);
+            reference[ch * SECTIONS + 1].process(expected.data(), expected.data(), AUDIO_CHUNK_SIZE);
+            for (int i = 0; i < AUDIO_CHUNK_SIZE; ++i)
+            {
+                ASSERT_NEAR(expected[i], out_buffer.channel(ch)[i], 1.0e-5f);
+            }
+        }
+    }
+}
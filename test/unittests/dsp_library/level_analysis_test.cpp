@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+
+#include "test_utils/test_utils.h"
+#include "dsp_library/level_analysis.h"
+
+using namespace sushi;
+using namespace dsp;
+
+TEST(TestLevelAnalysis, TestSingleChannel)
+{
+    std::array<float, 16> data;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = i % 2 == 0 ? 0.75f : -0.25f;
+    }
+    data[5] = -1.5f;
+    data[12] = 1.0f;
+    auto result = analyse_levels(data.data(), static_cast<int>(data.size()));
+
+    EXPECT_FLOAT_EQ(1.5f, result.peak);
+    EXPECT_EQ(2, result.clipped_samples);
+    float sum = 0.0f;
+    float square_sum = 0.0f;
+    for (auto sample : data)
+    {
+        sum += sample;
+        square_sum += sample * sample;
+    }
+    EXPECT_FLOAT_EQ(sum / data.size(), result.dc_offset);
+    EXPECT_FLOAT_EQ(square_sum / data.size(), result.mean_square);
+}
+
+TEST(TestLevelAnalysis, TestBuffer)
+{
+    ChunkSampleBuffer buffer(3);
+    test_utils::fill_sample_buffer(buffer, 0.5f);
+    buffer.channel(1)[3] = -2.0f;
+    std::vector<LevelAnalysis> results(2);
+    analyse_levels(buffer, results);
+
+    EXPECT_FLOAT_EQ(0.5f, results[0].peak);
+    EXPECT_FLOAT_EQ(0.25f, results[0].mean_square);
+    EXPECT_FLOAT_EQ(0.5f, results[0].dc_offset);
+    EXPECT_EQ(0, results[0].clipped_samples);
+
+    EXPECT_FLOAT_EQ(2.0f, results[1].peak);
+    EXPECT_EQ(1, results[1].clipped_samples);
+    EXPECT_LT(results[1].dc_offset, 0.5f);
+}
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #define private public
@@ -26,3 +28,38 @@ TEST_F(TestSampleWrapper, TestSampleInterpolation)
     // Get interpolated values
     EXPECT_FLOAT_EQ(1.5f, _module_under_test.at(2.5f));
 }
+
+TEST_F(TestSampleWrapper, TestBlockInterpolation)
+{
+    constexpr int SAMPLES = 6;
+    const float gain[SAMPLES] = {1.0f, 1.0f, 0.5f, 1.0f, 2.0f, 1.0f};
+    float output[SAMPLES] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+    interpolate_and_add(SAMPLE_DATA, 0.25f, 0.5f, gain, output, SAMPLES);
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        EXPECT_FLOAT_EQ(1.0f + _module_under_test.at(0.25 + i * 0.5) * gain[i], output[i]);
+    }
+}
+
+TEST_F(TestSampleWrapper, TestBlockInterpolationSpeeds)
+{
+    constexpr int SAMPLES = 100;
+    std::vector<float> data(200);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<float>(i % 7) - 3.0f;
+    }
+    Sample sample(data.data(), static_cast<int>(data.size()));
+    std::vector<float> gain(SAMPLES, 0.5f);
+
+    /* The original speed and a speed rendered over several blocks */
+    for (float speed : {1.0f, 1.5f})
+    {
+        std::vector<float> output(SAMPLES, 0.0f);
+        interpolate_and_add(data.data(), 0.75f, speed, gain.data(), output.data(), SAMPLES);
+        for (int i = 0; i < SAMPLES; ++i)
+        {
+            ASSERT_NEAR(sample.at(0.75 + i * speed) * 0.5f, output[i], 1.0e-5f);
+        }
+    }
+}
@@ -10,12 +10,94 @@
 #define protected public
 
 #include "engine/audio_engine.cpp"
+#include "plugins/equalizer_plugin.h"
 
 constexpr unsigned int SAMPLE_RATE = 44000;
 constexpr int TEST_CHANNEL_COUNT = 4;
 using namespace sushi;
 using namespace sushi::engine;
 
+TEST(TestChunkSync, TestMultipleChunks)
+{
+    constexpr int CHUNKS = 4;
+    constexpr int WORKERS = 3;
+    ChunkSync module_under_test;
+    std::array<std::atomic<int>, WORKERS> rendered_chunks{};
+    module_under_test.start(CHUNKS, WORKERS);
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < WORKERS; ++w)
+    {
+        workers.emplace_back([&, w]()
+        {
+            for (int chunk = 0; chunk < module_under_test.chunks(); ++chunk)
+            {
+                if (module_under_test.wait_for_chunk(chunk) == false)
+                {
+                    break;
+                }
+                rendered_chunks[w]++;
+                module_under_test.notify_rendered();
+            }
+        });
+    }
+
+    for (int chunk = 0; chunk < CHUNKS - 1; ++chunk)
+    {
+        module_under_test.publish_chunk();
+        module_under_test.wait_for_rendered_chunk();
+        /* No worker should be ahead of or behind the audio thread */
+        for (const auto& rendered : rendered_chunks)
+        {
+            EXPECT_EQ(chunk + 1, rendered.load());
+        }
+    }
+    /* Ending the period early should release the workers */
+    module_under_test.finish();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    for (const auto& rendered : rendered_chunks)
+    {
+        EXPECT_EQ(CHUNKS - 1, rendered.load());
+    }
+}
+
+TEST(TestChunkSync, TestSleepingWaiters)
+{
+    constexpr int CHUNKS = 2;
+    ChunkSync module_under_test;
+    std::atomic<int> rendered_chunks{0};
+    module_under_test.start(CHUNKS, 1);
+
+    /* Waits long enough for both sides to stop spinning and sleep */
+    std::thread worker([&]()
+    {
+        for (int chunk = 0; chunk < module_under_test.chunks(); ++chunk)
+        {
+            if (module_under_test.wait_for_chunk(chunk) == false)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            rendered_chunks++;
+            module_under_test.notify_rendered();
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    module_under_test.publish_chunk();
+    module_under_test.wait_for_rendered_chunk();
+    EXPECT_EQ(1, rendered_chunks.load());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    module_under_test.finish();
+    worker.join();
+    EXPECT_EQ(1, rendered_chunks.load());
+    module_under_test.reset();
+    EXPECT_EQ(0, module_under_test.chunks());
+}
+
 /*
 * Engine tests
 */
@@ -38,15 +120,18 @@ TEST_F(TestClipDetector, TestClipping)
 {
     RtSafeRtEventFifo queue;
     ChunkSampleBuffer buffer(TEST_CHANNEL_COUNT);
+    std::vector<dsp::LevelAnalysis> levels(TEST_CHANNEL_COUNT);
     test_utils::fill_sample_buffer(buffer, 0.5f);
-    _module_under_test.detect_clipped_samples(buffer, queue, false);
+    dsp::analyse_levels(buffer, levels);
+    _module_under_test.detect_clipped_samples(levels, queue, false);
     /* No samples outside (-1.0, 1.0) so this should result in no notifications */
     ASSERT_TRUE(queue.empty());
 
     /* Set 2 samples to clipped, we should now have 2 clip notifications */
     buffer.channel(1)[10] = 1.5f;
     buffer.channel(3)[6] = -1.3f;
-    _module_under_test.detect_clipped_samples(buffer, queue, false);
+    dsp::analyse_levels(buffer, levels);
+    _module_under_test.detect_clipped_samples(levels, queue, false);
     ASSERT_FALSE(queue.empty());
     RtEvent notification;
     ASSERT_TRUE(queue.pop(notification));
@@ -57,11 +142,12 @@ TEST_F(TestClipDetector, TestClipping)
     ASSERT_EQ(ClipNotificationRtEvent::ClipChannelType::OUTPUT, notification.clip_notification_event()->channel_type());
 
     /* But calling again immediately should not trigger due to the rate limiting */
-    _module_under_test.detect_clipped_samples(buffer, queue, false);
+    dsp::analyse_levels(buffer, levels);
+    _module_under_test.detect_clipped_samples(levels, queue, false);
     ASSERT_TRUE(queue.empty());
 
     /* But calling with audio_inout set to true should trigger 2 new */
-    _module_under_test.detect_clipped_samples(buffer, queue, true);
+    _module_under_test.detect_clipped_samples(levels, queue, true);
     ASSERT_FALSE(queue.empty());
     ASSERT_TRUE(queue.pop(notification));
     ASSERT_EQ(ClipNotificationRtEvent::ClipChannelType::INPUT, notification.clip_notification_event()->channel_type());
@@ -70,6 +156,32 @@ TEST_F(TestClipDetector, TestClipping)
 
 }
 
+TEST(TestLevelMeter, TestLevels)
+{
+    LevelMeter module_under_test(SAMPLE_RATE);
+    module_under_test.set_channels(2);
+    std::vector<dsp::LevelAnalysis> levels = {{0.5f, 0.25f, 0.1f, 0}, {1.0f, 0.0f, 0.0f, 0}};
+    module_under_test.update(levels);
+    auto meter_levels = module_under_test.levels();
+    ASSERT_EQ(2u, meter_levels.size());
+    /* Instant attack for peaks, smoothed rms */
+    EXPECT_FLOAT_EQ(0.5f, meter_levels[0].peak);
+    EXPECT_FLOAT_EQ(1.0f, meter_levels[1].peak);
+    EXPECT_GT(meter_levels[0].rms, 0.0f);
+    EXPECT_LT(meter_levels[0].rms, 0.5f);
+
+    /* Peaks should fall slowly and rms approach the true value */
+    levels = {{0.0f, 0.25f, 0.1f, 0}, {0.0f, 0.0f, 0.0f, 0}};
+    for (int i = 0; i < SAMPLE_RATE / AUDIO_CHUNK_SIZE * 5; ++i)
+    {
+        module_under_test.update(levels);
+    }
+    meter_levels = module_under_test.levels();
+    EXPECT_LT(meter_levels[1].peak, 0.01f);
+    EXPECT_NEAR(0.5f, meter_levels[0].rms, 0.001f);
+    EXPECT_NEAR(0.1f, meter_levels[0].dc_offset, 0.001f);
+}
+
 /*
 * Engine tests
 */
@@ -295,6 +407,293 @@ TEST_F(TestEngine, TestAddAndRemovePlugin)
     ASSERT_EQ(EngineReturnStatus::INVALID_TRACK, status);
 }
 
+TEST_F(TestEngine, TestGraphSnapshot)
+{
+    auto empty_snapshot = _module_under_test->graph_snapshot();
+    ASSERT_TRUE(empty_snapshot);
+    EXPECT_TRUE(empty_snapshot->tracks().empty());
+
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("left", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("left", "sushi.testing.gain", "gain",
+                                                                              "", PluginType::INTERNAL));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("left", "sushi.testing.equalizer", "eq",
+                                                                              "", PluginType::INTERNAL));
+    auto snapshot = _module_under_test->graph_snapshot();
+    ASSERT_EQ(1u, snapshot->tracks().size());
+    EXPECT_EQ("left", snapshot->tracks()[0].track->name());
+    ASSERT_EQ(2u, snapshot->tracks()[0].processors.size());
+    EXPECT_EQ("gain", snapshot->tracks()[0].processors[0]->name());
+    EXPECT_EQ("eq", snapshot->tracks()[0].processors[1]->name());
+    EXPECT_EQ(3u, snapshot->processors().size());
+    auto track_id = snapshot->tracks()[0].track->id();
+    EXPECT_EQ(&snapshot->tracks()[0], snapshot->track(track_id));
+    EXPECT_EQ(nullptr, snapshot->track(123456));
+    EXPECT_EQ("eq", snapshot->processor(snapshot->tracks()[0].processors[1]->id())->name());
+    EXPECT_EQ(nullptr, snapshot->processor(123456));
+    EXPECT_EQ(snapshot->tracks()[0].processors[1], snapshot->processor("eq"));
+    EXPECT_EQ(nullptr, snapshot->processor("not_found"));
+
+    /* Parameter lookups across processors */
+    auto eq = snapshot->processor("eq");
+    auto gain_parameter = eq->parameter_from_name("gain");
+    ASSERT_NE(nullptr, gain_parameter);
+    EXPECT_EQ(gain_parameter, snapshot->parameter("eq", "gain"));
+    EXPECT_EQ(gain_parameter, snapshot->parameter(eq->id(), gain_parameter->id()));
+    EXPECT_EQ(nullptr, snapshot->parameter("eq", "not_found"));
+    EXPECT_EQ(nullptr, snapshot->parameter("not_found", "gain"));
+    EXPECT_EQ(nullptr, snapshot->parameter(eq->id(), 123456));
+
+    /* Published snapshots are never changed, and keep removed processors alive */
+    std::weak_ptr<Processor> gain = snapshot->processors().at("gain");
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->remove_plugin_from_track("left", "gain"));
+    EXPECT_TRUE(empty_snapshot->tracks().empty());
+    ASSERT_EQ(2u, snapshot->tracks()[0].processors.size());
+    EXPECT_FALSE(gain.expired());
+    EXPECT_EQ("gain", gain.lock()->name());
+
+    auto new_snapshot = _module_under_test->graph_snapshot();
+    ASSERT_EQ(1u, new_snapshot->tracks()[0].processors.size());
+    EXPECT_EQ("eq", new_snapshot->tracks()[0].processors[0]->name());
+    EXPECT_EQ(0u, new_snapshot->processors().count("gain"));
+
+    /* Dropping the last reference outside the engine must not destroy the processor,
+     * that is left to the worker thread */
+    snapshot.reset();
+    EXPECT_FALSE(gain.expired());
+    _module_under_test->release_retired_graph_snapshots();
+    EXPECT_TRUE(gain.expired());
+
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->remove_plugin_from_track("left", "eq"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->delete_track("left"));
+    EXPECT_TRUE(_module_under_test->graph_snapshot()->tracks().empty());
+    EXPECT_TRUE(_module_under_test->graph_snapshot()->processors().empty());
+}
+
+TEST_F(TestEngine, TestSessionSaveAndRestore)
+{
+    auto set_parameter = [&](const std::string& processor_name, const std::string& parameter_name, float value)
+    {
+        auto processor = _module_under_test->_processors[processor_name].get();
+        auto parameter = processor->parameter_from_name(parameter_name);
+        auto event = RtEvent::make_parameter_change_event(processor->id(), 0, parameter->id(), value);
+        processor->process_event(event);
+    };
+    auto get_parameter = [&](const std::string& processor_name, const std::string& parameter_name)
+    {
+        auto processor = _module_under_test->_processors[processor_name].get();
+        return processor->parameter_value(processor->parameter_from_name(parameter_name)->id()).second;
+    };
+
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("main", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_audio_input_bus(0, 0, "main"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_audio_output_bus(1, 0, "main"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.gain", "gain",
+                                                                              "", PluginType::INTERNAL));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.equalizer", "eq",
+                                                                              "", PluginType::INTERNAL));
+    set_parameter("gain", "gain", 0.25f);
+    set_parameter("main", "pan", 0.75f);
+    auto [status, session] = _module_under_test->save_session();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+    ASSERT_FALSE(session.empty());
+
+    /* Edit the graph and the parameters */
+    auto gain_instance = _module_under_test->_processors["gain"].get();
+    auto main_track = _module_under_test->_processors["main"].get();
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->remove_plugin_from_track("main", "eq"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.passthrough",
+                                                                              "passthrough", "", PluginType::INTERNAL));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("extra", 1));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_audio_output_channel(3, 0, "extra"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("extra", "sushi.testing.gain",
+                                                                              "extra_gain", "", PluginType::INTERNAL));
+    set_parameter("gain", "gain", 0.9f);
+    set_parameter("main", "pan", 0.1f);
+    gain_instance->set_bypassed(true);
+
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->restore_session(session));
+    auto snapshot = _module_under_test->graph_snapshot();
+    ASSERT_EQ(1u, snapshot->tracks().size());
+    const auto& track = snapshot->tracks()[0];
+    EXPECT_EQ(main_track, track.track.get());
+    ASSERT_EQ(2u, track.processors.size());
+    EXPECT_EQ(gain_instance, track.processors[0].get());
+    EXPECT_EQ("eq", track.processors[1]->name());
+    EXPECT_EQ(3u, snapshot->processors().size());
+    EXPECT_EQ(nullptr, snapshot->processor("extra"));
+    EXPECT_EQ(nullptr, snapshot->processor("passthrough"));
+    EXPECT_EQ(0u, _module_under_test->_plugin_info.count("extra_gain"));
+
+    EXPECT_FALSE(gain_instance->bypassed());
+    EXPECT_FLOAT_EQ(0.25f, get_parameter("gain", "gain"));
+    EXPECT_FLOAT_EQ(0.75f, get_parameter("main", "pan"));
+
+    ASSERT_EQ(2u, _module_under_test->_in_audio_connections.size());
+    ASSERT_EQ(2u, _module_under_test->_out_audio_connections.size());
+    EXPECT_EQ(2, _module_under_test->_out_audio_connections[0].engine_channel);
+    EXPECT_EQ(main_track->id(), _module_under_test->_out_audio_connections[1].track);
+
+    /* Restoring the same session again should not change anything */
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->restore_session(session));
+    EXPECT_EQ(snapshot->processors().size(), _module_under_test->graph_snapshot()->processors().size());
+    EXPECT_EQ(gain_instance, _module_under_test->graph_snapshot()->tracks()[0].processors[0].get());
+
+    EXPECT_EQ(EngineReturnStatus::ERROR, _module_under_test->restore_session(std::vector<uint8_t>(10, 0)));
+}
+
+TEST_F(TestEngine, TestInvalidSessionRestore)
+{
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("main", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_audio_input_bus(0, 0, "main"));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.gain", "gain",
+                                                                              "", PluginType::INTERNAL));
+    auto [status, data] = _module_under_test->save_session();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+    auto [valid, saved] = SessionSnapshot::deserialize(data);
+    ASSERT_TRUE(valid);
+
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("extra", 1));
+    auto expect_unchanged = [&]()
+    {
+        auto snapshot = _module_under_test->graph_snapshot();
+        ASSERT_EQ(2u, snapshot->tracks().size());
+        ASSERT_EQ(1u, snapshot->tracks()[0].processors.size());
+        EXPECT_EQ(2u, _module_under_test->_in_audio_connections.size());
+    };
+
+    /* Invalid sessions should be rejected before anything in the engine is changed */
+    auto negative_channel = saved;
+    negative_channel.output_connections.push_back({0, -1, "main"});
+    EXPECT_EQ(EngineReturnStatus::INVALID_CHANNEL, _module_under_test->restore_session(negative_channel.serialize()));
+    expect_unchanged();
+
+    auto unknown_track = saved;
+    unknown_track.input_connections.push_back({0, 0, "unknown"});
+    EXPECT_EQ(EngineReturnStatus::INVALID_TRACK, _module_under_test->restore_session(unknown_track.serialize()));
+    expect_unchanged();
+
+    auto duplicate_name = saved;
+    duplicate_name.tracks[0].processors.push_back(duplicate_name.tracks[0].processors[0]);
+    EXPECT_EQ(EngineReturnStatus::INVALID_PLUGIN_NAME, _module_under_test->restore_session(duplicate_name.serialize()));
+    expect_unchanged();
+
+    auto track_named_as_processor = saved;
+    track_named_as_processor.tracks.push_back(saved.tracks[0]);
+    track_named_as_processor.tracks[1].track.name = "gain";
+    track_named_as_processor.tracks[1].processors.clear();
+    EXPECT_EQ(EngineReturnStatus::INVALID_TRACK, _module_under_test->restore_session(track_named_as_processor.serialize()));
+    expect_unchanged();
+
+    auto invalid_busses = saved;
+    invalid_busses.tracks[0].output_busses = TRACK_MAX_BUSSES + 1;
+    EXPECT_EQ(EngineReturnStatus::INVALID_BUS, _module_under_test->restore_session(invalid_busses.serialize()));
+    expect_unchanged();
+
+    /* A processor that is not on any track must not be taken for a track */
+    auto orphan = new equalizer_plugin::EqualizerPlugin(_module_under_test->_host_control);
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->_register_processor(orphan, "orphan"));
+    auto orphan_track = saved;
+    orphan_track.tracks[0].track.name = "orphan";
+    orphan_track.input_connections[0].track = "orphan";
+    orphan_track.input_connections[1].track = "orphan";
+    EXPECT_EQ(EngineReturnStatus::INVALID_TRACK, _module_under_test->restore_session(orphan_track.serialize()));
+    expect_unchanged();
+    EXPECT_EQ(nullptr, _module_under_test->_track_from_name("orphan"));
+    EXPECT_EQ(nullptr, _module_under_test->_track_from_name("gain"));
+    EXPECT_NE(nullptr, _module_under_test->_track_from_name("main"));
+
+    EXPECT_EQ(EngineReturnStatus::OK, _module_under_test->restore_session(data));
+    EXPECT_EQ(1u, _module_under_test->graph_snapshot()->tracks().size());
+}
+
+TEST_F(TestEngine, TestSessionProperties)
+{
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("main", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.sampleplayer",
+                                                                              "sampler", "", PluginType::INTERNAL));
+    auto sampler = static_cast<InternalPlugin*>(_module_under_test->_processors["sampler"].get());
+    auto property_id = sampler->parameter_from_name("sample_file")->id();
+    sampler->set_string_property_value(property_id, "sample.wav");
+
+    auto [status, data] = _module_under_test->save_session();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+    auto [valid, session] = SessionSnapshot::deserialize(data);
+    ASSERT_TRUE(valid);
+    const auto& properties = session.tracks[0].processors[0].string_properties;
+    ASSERT_EQ(1u, properties.size());
+    EXPECT_EQ("sample_file", properties[0].name);
+    EXPECT_EQ("sample.wav", properties[0].value);
+}
+
+TEST_F(TestEngine, TestRealtimeSessionRestore)
+{
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("main", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.equalizer", "eq",
+                                                                              "", PluginType::INTERNAL));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->add_plugin_to_track("main", "sushi.testing.gain", "gain",
+                                                                              "", PluginType::INTERNAL));
+    auto [status, session] = _module_under_test->save_session();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+
+    /* Swap the order of the plugins and add a track, restoring should reorder the
+     * existing plugins rather than create new ones */
+    auto eq_instance = _module_under_test->_processors["eq"].get();
+    auto gain_instance = _module_under_test->_processors["gain"].get();
+    auto track = _module_under_test->_audio_graph[0];
+    ASSERT_TRUE(track->remove(eq_instance->id()));
+    ASSERT_TRUE(track->add(eq_instance));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("extra", 2));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_audio_input_bus(0, 0, "extra"));
+
+    std::atomic<bool> running{true};
+    auto faux_rt_thread = [&running](AudioEngine* e)
+    {
+        SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(TEST_CHANNEL_COUNT);
+        SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(TEST_CHANNEL_COUNT);
+        ControlBuffer control_buffer;
+        while (running)
+        {
+            e->process_chunk(&in_buffer, &out_buffer, &control_buffer, &control_buffer, Time(0), 0);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    };
+    _module_under_test->enable_realtime(true);
+    auto rt = std::thread(faux_rt_thread, _module_under_test);
+    status = _module_under_test->restore_session(session);
+    running = false;
+    rt.join();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+
+    auto snapshot = _module_under_test->graph_snapshot();
+    ASSERT_EQ(1u, snapshot->tracks().size());
+    ASSERT_EQ(2u, snapshot->tracks()[0].processors.size());
+    EXPECT_EQ(eq_instance, snapshot->tracks()[0].processors[0].get());
+    EXPECT_EQ(gain_instance, snapshot->tracks()[0].processors[1].get());
+    EXPECT_TRUE(_module_under_test->_in_audio_connections.empty());
+}
+
+TEST_F(TestEngine, TestTimedOutSessionRestore)
+{
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->create_track("main", 2));
+    auto [status, session] = _module_under_test->save_session();
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+
+    /* Without an audio thread the update is never acknowledged, it should be kept
+     * until it is committed and then destroyed by the worker */
+    _module_under_test->enable_realtime(true);
+    EXPECT_EQ(EngineReturnStatus::ERROR, _module_under_test->restore_session(session));
+    ASSERT_EQ(1u, _module_under_test->_retired_session_updates.size());
+    _module_under_test->release_retired_graph_snapshots();
+    EXPECT_EQ(1u, _module_under_test->_retired_session_updates.size());
+
+    SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(TEST_CHANNEL_COUNT);
+    SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(TEST_CHANNEL_COUNT);
+    ControlBuffer control_buffer;
+    _module_under_test->process_chunk(&in_buffer, &out_buffer, &control_buffer, &control_buffer, Time(0), 0);
+    _module_under_test->release_retired_graph_snapshots();
+    EXPECT_TRUE(_module_under_test->_retired_session_updates.empty());
+}
+
 TEST_F(TestEngine, TestSetSamplerate)
 {
     auto status = _module_under_test->create_track("left", 2);
@@ -403,13 +802,89 @@ TEST_F(TestEngine, TestCvRouting)
     ControlBuffer in_controls;
     ControlBuffer out_controls;
 
-    in_controls.cv_values[1] = 0.5;
+    std::fill(in_controls.cv_signals.channel(1), in_controls.cv_signals.channel(1) + in_controls.cv_signals.frame_count(), 0.5f);
     _module_under_test->process_chunk(&in_buffer, &out_buffer, &in_controls, &out_controls, Time(0), 0);
     _module_under_test->process_chunk(&in_buffer, &out_buffer, &in_controls, &out_controls, Time(0), 0);
 
     // We should have a non-zero value in this slot
     ASSERT_NE(0.0f, out_controls.cv_values[1]);
+    // The lfo has no audio rate cv support so the value should have been sent as an event
+    ASSERT_EQ(1u, _module_under_test->_cv_in_routes.size());
+    EXPECT_FALSE(_module_under_test->_cv_in_routes[0].audio_rate);
+    EXPECT_FLOAT_EQ(0.5f, _module_under_test->_cv_in_routes[0].last_value);
+}
+
+TEST_F(TestEngine, TestCvChangeDetection)
+{
+    _module_under_test->create_track("lfo_track", 0);
+    auto status = _module_under_test->add_plugin_to_track("lfo_track",
+                                                          "sushi.testing.lfo",
+                                                          "lfo",
+                                                          "   ",
+                                                          PluginType::INTERNAL);
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->set_cv_input_channels(1));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_cv_to_parameter("lfo", "freq", 0));
+    auto lfo = _module_under_test->mutable_processor(_module_under_test->processor_id_from_name("lfo").second);
+    ASSERT_TRUE(lfo);
+    ObjectId param_id = lfo->parameter_from_name("freq")->id();
+    ControlBuffer in_controls;
+    auto& cv = in_controls.cv_signals;
+
+    std::fill(cv.channel(0), cv.channel(0) + cv.frame_count(), 0.25f);
+    _module_under_test->_route_cv_gate_ins(in_controls);
+    EXPECT_FLOAT_EQ(0.25f, lfo->parameter_value(param_id).second);
+
+    // Change the parameter behind the back of the cv routing, static cv should not send new events
+    auto event = RtEvent::make_parameter_change_event(lfo->id(), 0, param_id, 0.75f);
+    lfo->process_event(event);
+    _module_under_test->_route_cv_gate_ins(in_controls);
+    EXPECT_FLOAT_EQ(0.75f, lfo->parameter_value(param_id).second);
+
+    // Changes below the threshold are ignored
+    cv.channel(0)[cv.frame_count() - 1] = 0.25f + CV_CHANGE_THRESHOLD / 2;
+    _module_under_test->_route_cv_gate_ins(in_controls);
+    EXPECT_FLOAT_EQ(0.75f, lfo->parameter_value(param_id).second);
+
+    cv.channel(0)[cv.frame_count() - 1] = 0.5f;
+    _module_under_test->_route_cv_gate_ins(in_controls);
+    EXPECT_FLOAT_EQ(0.5f, lfo->parameter_value(param_id).second);
+}
+
+TEST_F(TestEngine, TestAudioRateCvRouting)
+{
+    _module_under_test->create_track("track", 2);
+    _module_under_test->connect_audio_input_bus(0, 0, "track");
+    _module_under_test->connect_audio_output_bus(0, 0, "track");
+    auto status = _module_under_test->add_plugin_to_track("track",
+                                                          "sushi.testing.gain",
+                                                          "gain",
+                                                          "   ",
+                                                          PluginType::INTERNAL);
+    ASSERT_EQ(EngineReturnStatus::OK, status);
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->set_cv_input_channels(1));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_cv_to_parameter("gain", "gain", 0));
+    ASSERT_TRUE(_module_under_test->_cv_in_routes[0].audio_rate);
+    auto gain = _module_under_test->mutable_processor(_module_under_test->processor_id_from_name("gain").second);
+    ObjectId param_id = gain->parameter_from_name("gain")->id();
+    float initial_value = gain->parameter_value(param_id).second;
+
+    ChunkSampleBuffer in_buffer(TEST_CHANNEL_COUNT);
+    ChunkSampleBuffer out_buffer(TEST_CHANNEL_COUNT);
+    test_utils::fill_sample_buffer(in_buffer, 1.0f);
+    ControlBuffer in_controls;
+    ControlBuffer out_controls;
+    auto& cv = in_controls.cv_signals;
+    // 0.875 corresponds to +6dB
+    std::fill(cv.channel(0), cv.channel(0) + cv.frame_count(), 0.875f);
+    _module_under_test->process_chunk(&in_buffer, &out_buffer, &in_controls, &out_controls, Time(0), 0);
+
+    // The cv signal is applied by the processor directly and not through parameter changes
+    auto main_bus = ChunkSampleBuffer::create_non_owning_buffer(out_buffer, 0, 2);
+    test_utils::assert_buffer_value(2.0f, main_bus, test_utils::DECIBEL_ERROR);
+    EXPECT_FLOAT_EQ(initial_value, gain->parameter_value(param_id).second);
 }
+
 TEST_F(TestEngine, TestGateRouting)
 {
     /* Build a cv/gate to midi to cv/gate chain and verify gate changes travel through it*/
@@ -450,4 +925,45 @@ TEST_F(TestEngine, TestGateRouting)
     // A gate high event on gate input 1 should result in a gate high on gate output 0
     ASSERT_TRUE(out_controls.gate_values[0]);
     ASSERT_EQ(1u, out_controls.gate_values.count());
-}
\ No newline at end of file
+}
+
+TEST_F(TestEngine, TestGateSync)
+{
+    EXPECT_EQ(EngineReturnStatus::ERROR, _module_under_test->connect_gate_to_sync(MAX_ENGINE_GATE_PORTS, 4));
+    EXPECT_EQ(EngineReturnStatus::ERROR, _module_under_test->connect_gate_to_sync(1, 0));
+    EXPECT_EQ(EngineReturnStatus::ERROR, _module_under_test->connect_sync_to_gate(-1, 4));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_gate_to_sync(1, 4));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->connect_sync_to_gate(2, 4));
+    ASSERT_EQ(EngineReturnStatus::OK, _module_under_test->set_cv_input_channels(1));
+    _module_under_test->set_tempo_sync_mode(SyncMode::GATE_INPUT);
+    _module_under_test->set_tempo(60);
+    _module_under_test->set_transport_mode(PlayingMode::PLAYING);
+
+    ChunkSampleBuffer in_buffer(1);
+    ChunkSampleBuffer out_buffer(1);
+    ControlBuffer in_controls;
+    ControlBuffer out_controls;
+
+    /* Clock the engine with one pulse every 100 chunks */
+    constexpr int PULSE_CHUNKS = 100;
+    int output_pulses = 0;
+    bool prev_output = false;
+    int64_t samples = 0;
+    for (int i = 0; i < 20 * PULSE_CHUNKS; ++i)
+    {
+        in_controls.gate_values[1] = i % PULSE_CHUNKS < PULSE_CHUNKS / 2;
+        _module_under_test->process_chunk(&in_buffer, &out_buffer, &in_controls, &out_controls, Time(0), samples);
+        samples += AUDIO_CHUNK_SIZE;
+        if (out_controls.gate_values[2] && prev_output == false)
+        {
+            output_pulses++;
+        }
+        prev_output = out_controls.gate_values[2];
+    }
+    float expected_tempo = 60.0f * SAMPLE_RATE / (PULSE_CHUNKS * AUDIO_CHUNK_SIZE * 4);
+    EXPECT_NEAR(expected_tempo, _module_under_test->transport()->current_tempo(), 0.01);
+    EXPECT_NEAR(5.0, _module_under_test->transport()->current_beats(), 0.05);
+
+    /* The sync output follows the tempo of the input */
+    EXPECT_NEAR(20, output_pulses, 1);
+}
@@ -71,7 +71,8 @@ protected:
     {
         _module_under_test = new EventDispatcher(&_test_engine,
                                                  &_in_rt_queue,
-                                                 &_out_rt_queue);
+                                                 &_out_rt_queue,
+                                                 &_parameter_notifications);
     }
 
     void TearDown()
@@ -83,6 +84,7 @@ protected:
     EngineMockup        _test_engine{44100};
     RtSafeRtEventFifo   _in_rt_queue;
     RtSafeRtEventFifo   _out_rt_queue;
+    ParameterNotificationArea _parameter_notifications;
     DummyPoster         _poster;
 };
 
@@ -161,6 +163,22 @@ TEST_F(TestEventDispatcher, TestFromRtEventParameterChangeNotification)
     ASSERT_TRUE(_poster.event_received());
 }
 
+TEST_F(TestEventDispatcher, TestParameterNotificationsFromSnapshot)
+{
+    auto buffer = _parameter_notifications.add(10, 4);
+    buffer->set(2, 0.5f);
+    buffer->set(2, 0.75f);
+    _module_under_test->subscribe_to_parameter_change_notifications(&_poster);
+
+    /* Notifications are only published once per chunk, when the sync event arrives */
+    crank_event_loop_once();
+    ASSERT_FALSE(_poster.event_received());
+
+    _in_rt_queue.push(RtEvent::make_synchronisation_event(IMMEDIATE_PROCESS));
+    crank_event_loop_once();
+    ASSERT_TRUE(_poster.event_received());
+    EXPECT_FALSE(buffer->dirty());
+}
 
 TEST_F(TestEventDispatcher, TestCompletionCallback)
 {
@@ -203,6 +221,57 @@ TEST_F(TestEventDispatcher, TestAsyncCallbackFromProcessor)
     EXPECT_EQ(123u, typed_event->processor_id());
 }
 
+TEST_F(TestEventDispatcher, TestSynchronousMode)
+{
+    _module_under_test->set_synchronous_mode(true);
+    _module_under_test->run();
+    ASSERT_FALSE(_module_under_test->_event_thread.joinable());
+
+    _module_under_test->register_poster(&_poster);
+    auto event = new Event(IMMEDIATE_PROCESS);
+    event->set_receiver(DUMMY_POSTER_ID);
+    _module_under_test->post_event(event);
+    std::this_thread::sleep_for(EVENT_PROCESS_WAIT_TIME * 2);
+    ASSERT_FALSE(_poster.event_received());
+
+    /* Asynchronous work should be done and its completion notification
+     * sent back in the same call, without involving the worker thread */
+    auto rt_event = RtEvent::make_async_work_event(dummy_processor_callback, 123, nullptr);
+    _in_rt_queue.push(rt_event);
+    _module_under_test->process_pending_events();
+    ASSERT_TRUE(_poster.event_received());
+    ASSERT_FALSE(_out_rt_queue.empty());
+    _out_rt_queue.pop(rt_event);
+    EXPECT_EQ(RtEventType::ASYNC_WORK_NOTIFICATION, rt_event.type());
+
+    /* Engine events are also executed in the same call */
+    auto engine_event = new SetEngineTempoEvent(130, IMMEDIATE_PROCESS);
+    engine_event->set_completion_cb(dummy_callback, nullptr);
+    completed = false;
+    _module_under_test->post_event(engine_event);
+    _module_under_test->process_pending_events();
+    EXPECT_TRUE(completed);
+
+    _module_under_test->set_synchronous_mode(false);
+    ASSERT_TRUE(_module_under_test->_event_thread.joinable());
+}
+
+TEST_F(TestEventDispatcher, TestEventsWaitingForTheirTime)
+{
+    /* An event that is not due yet should be retried on the next pass, not spun on */
+    auto event = new ParameterChangeEvent(ParameterChangeEvent::Subtype::FLOAT_PARAMETER_CHANGE, 0, 0, 0.5f,
+                                          IMMEDIATE_PROCESS + std::chrono::seconds(1));
+    _module_under_test->post_event(event);
+    crank_event_loop_once();
+    ASSERT_EQ(1u, _module_under_test->_waiting_list.size());
+    EXPECT_TRUE(_out_rt_queue.empty());
+
+    _module_under_test->set_time(IMMEDIATE_PROCESS + std::chrono::seconds(1));
+    crank_event_loop_once();
+    EXPECT_TRUE(_module_under_test->_waiting_list.empty());
+    EXPECT_FALSE(_out_rt_queue.empty());
+}
+
 class TestWorker : public ::testing::Test
 {
 public:
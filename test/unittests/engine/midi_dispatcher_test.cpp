@@ -46,6 +46,8 @@ const MidiDataByte TEST_CTRL_CH_MSG_2 = {0xB5, 40, 75, 0}; /* Channel 5, cc 40 *
 const MidiDataByte TEST_CTRL_CH_MSG_3 = {0xB5, 39, 75, 0}; /* Channel 5, cc 39 */
 const MidiDataByte TEST_PRG_CH_MSG   =  {0xC5, 40, 0, 0};  /* Channel 5, prg 40 */
 const MidiDataByte TEST_PRG_CH_MSG_2  = {0xC4, 45, 0, 0};  /* Channel 4, prg 45 */
+const MidiDataByte TEST_CLOCK_MSG     = {0xF8, 0, 0, 0};
+const MidiDataByte TEST_START_MSG     = {0xFA, 0, 0, 0};
 
 
 TEST(TestMidiDispatcherEventCreation, TestMakeNoteOnEvent)
@@ -139,6 +141,27 @@ TEST(TestMidiDispatcherEventCreation, TestMakeProgramChangeEvent)
     delete event;
 }
 
+TEST(TestMidiDispatcherEventCreation, TestMakeRtEvents)
+{
+    InputConnection connection = {25, 26, 0, 1, false, 64};
+    RtEvent event = make_note_on_event(connection, NoteOnMessage{1, 46, 64}, 12);
+    EXPECT_EQ(RtEventType::NOTE_ON, event.type());
+    EXPECT_EQ(25u, event.processor_id());
+    EXPECT_EQ(12, event.sample_offset());
+    EXPECT_EQ(46, event.keyboard_event()->note());
+    EXPECT_NEAR(0.5, event.keyboard_event()->velocity(), 0.05);
+
+    event = make_note_on_event(connection, NoteOnMessage{1, 46, 0}, 13);
+    EXPECT_EQ(RtEventType::NOTE_OFF, event.type());
+    EXPECT_EQ(13, event.sample_offset());
+
+    event = make_param_change_event(connection, ControlChangeMessage{1, 50, 32}, 14);
+    EXPECT_EQ(RtEventType::FLOAT_PARAMETER_CHANGE, event.type());
+    EXPECT_EQ(14, event.sample_offset());
+    EXPECT_EQ(26u, event.parameter_change_event()->param_id());
+    EXPECT_NEAR(0.25, event.parameter_change_event()->value(), 0.01);
+}
+
 class TestMidiDispatcher : public ::testing::Test
 {
 protected:
@@ -288,3 +311,72 @@ TEST_F(TestMidiDispatcher, TestProgramChangeConnection)
     _module_under_test.send_midi(2, TEST_PRG_CH_MSG, IMMEDIATE_PROCESS);
     EXPECT_FALSE(_test_dispatcher->got_event());
 }
+
+TEST_F(TestMidiDispatcher, TestRealtimeKeyboardDataConnection)
+{
+    _module_under_test.send_midi_rt(1, TEST_NOTE_ON_MSG, 10);
+    EXPECT_FALSE(_test_engine.got_rt_event);
+
+    _module_under_test.set_midi_inputs(5);
+    _module_under_test.connect_kb_to_track(1, "processor");
+    _module_under_test.send_midi_rt(1, TEST_NOTE_ON_MSG, 10);
+    EXPECT_TRUE(_test_engine.got_rt_event);
+    /* Nothing should go through the non-realtime event dispatcher */
+    EXPECT_FALSE(_test_dispatcher->got_event());
+
+    /* Program changes are not supported from the realtime thread */
+    _test_engine.got_rt_event = false;
+    _module_under_test.connect_pc_to_processor(1, "processor");
+    _module_under_test.send_midi_rt(1, TEST_PRG_CH_MSG, 10);
+    EXPECT_FALSE(_test_engine.got_rt_event);
+    EXPECT_FALSE(_test_dispatcher->got_event());
+}
+
+TEST_F(TestMidiDispatcher, TestRealtimeKeyboardDataOutConnection)
+{
+    std::array<MidiOutputMessage, 4> messages;
+    auto event = RtEvent::make_note_on_event(0, 20, 12, 48, 1.0f);
+    EXPECT_EQ(0, _module_under_test.encode_rt_event(event, messages.data(), messages.size()));
+
+    _module_under_test.set_midi_outputs(3);
+    ASSERT_EQ(MidiDispatcherStatus::OK, _module_under_test.connect_track_to_output(1, "processor", 5));
+    ASSERT_EQ(MidiDispatcherStatus::OK, _module_under_test.connect_track_to_output(2, "processor", 6));
+    ASSERT_EQ(2, _module_under_test.encode_rt_event(event, messages.data(), messages.size()));
+    EXPECT_EQ(1, messages[0].output);
+    EXPECT_EQ(0x95, messages[0].data[0]);
+    EXPECT_EQ(48, messages[0].data[1]);
+    EXPECT_EQ(127, messages[0].data[2]);
+    EXPECT_EQ(2, messages[1].output);
+    EXPECT_EQ(0x96, messages[1].data[0]);
+
+    /* Output is limited by the size of the array */
+    EXPECT_EQ(1, _module_under_test.encode_rt_event(event, messages.data(), 1));
+
+    /* Non keyboard events are ignored */
+    auto param_event = RtEvent::make_parameter_change_event(0, 0, 1, 0.5f);
+    EXPECT_EQ(0, _module_under_test.encode_rt_event(param_event, messages.data(), messages.size()));
+}
+
+TEST_F(TestMidiDispatcher, TestClockMessages)
+{
+    /* Clock messages are always passed on, without any connections */
+    _module_under_test.send_midi(1, TEST_START_MSG, IMMEDIATE_PROCESS);
+    auto event = _test_dispatcher->retrieve_event();
+    ASSERT_TRUE(event);
+    ASSERT_TRUE(event->maps_to_rt_event());
+    auto rt_event = event->to_rt_event(5);
+    ASSERT_EQ(RtEventType::SYNC_CLOCK, rt_event.type());
+    EXPECT_EQ(SyncMode::MIDI, rt_event.sync_clock_event()->source());
+    EXPECT_EQ(SyncClockRtEvent::ClockType::START, rt_event.sync_clock_event()->clock_type());
+    EXPECT_EQ(24, rt_event.sync_clock_event()->ppq_ticks());
+
+    _module_under_test.send_midi(1, TEST_CLOCK_MSG, IMMEDIATE_PROCESS);
+    event = _test_dispatcher->retrieve_event();
+    ASSERT_TRUE(event);
+    EXPECT_EQ(SyncClockRtEvent::ClockType::TICK, event->to_rt_event(0).sync_clock_event()->clock_type());
+    EXPECT_FALSE(_test_dispatcher->got_event());
+
+    _module_under_test.send_midi_rt(1, TEST_CLOCK_MSG, 10);
+    EXPECT_TRUE(_test_engine.got_rt_event);
+    EXPECT_FALSE(_test_dispatcher->got_event());
+}
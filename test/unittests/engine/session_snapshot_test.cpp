@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+
+#include "engine/session_snapshot.cpp"
+
+using namespace sushi;
+using namespace sushi::engine;
+
+SessionSnapshot make_test_session()
+{
+    SessionSnapshot session;
+    SessionSnapshot::TrackState track;
+    track.track.name = "main";
+    track.track.parameters.push_back({"gain", 0.5f});
+    track.track.parameters.push_back({"pan", 0.25f});
+    track.channels = 2;
+
+    SessionSnapshot::ProcessorState synth;
+    synth.name = "synth";
+    synth.plugin = PluginInfo{"", "/path/to/synth.so", PluginType::VST2X};
+    synth.bypassed = true;
+    synth.has_program = true;
+    synth.program = 12;
+    synth.parameters.push_back({"cutoff", 0.125f});
+    track.processors.push_back(synth);
+
+    SessionSnapshot::ProcessorState eq;
+    eq.name = "eq";
+    eq.plugin = PluginInfo{"sushi.testing.equalizer", "", PluginType::INTERNAL};
+    eq.string_properties.push_back({"sample_file", "/path/to/sample.wav"});
+    eq.data_properties.push_back({"data", {0, 1, 2, 255}});
+    track.processors.push_back(eq);
+    session.tracks.push_back(track);
+
+    SessionSnapshot::TrackState bus_track;
+    bus_track.track.name = "busses";
+    bus_track.input_busses = 2;
+    bus_track.output_busses = 3;
+    session.tracks.push_back(bus_track);
+
+    session.input_connections.push_back({0, 1, "main"});
+    session.output_connections.push_back({3, 2, "busses"});
+    return session;
+}
+
+TEST(TestSessionSnapshot, TestSerialization)
+{
+    auto session = make_test_session();
+    auto data = session.serialize();
+    auto [ok, restored] = SessionSnapshot::deserialize(data);
+    ASSERT_TRUE(ok);
+
+    ASSERT_EQ(2u, restored.tracks.size());
+    const auto& track = restored.tracks[0];
+    EXPECT_EQ("main", track.track.name);
+    EXPECT_EQ(2, track.channels);
+    ASSERT_EQ(2u, track.track.parameters.size());
+    EXPECT_EQ("pan", track.track.parameters[1].name);
+    EXPECT_FLOAT_EQ(0.25f, track.track.parameters[1].value);
+
+    ASSERT_EQ(2u, track.processors.size());
+    const auto& synth = track.processors[0];
+    EXPECT_EQ("synth", synth.name);
+    EXPECT_EQ(session.tracks[0].processors[0].plugin, synth.plugin);
+    EXPECT_TRUE(synth.bypassed);
+    EXPECT_TRUE(synth.has_program);
+    EXPECT_EQ(12, synth.program);
+    ASSERT_EQ(1u, synth.parameters.size());
+    EXPECT_EQ("cutoff", synth.parameters[0].name);
+    EXPECT_FLOAT_EQ(0.125f, synth.parameters[0].value);
+    EXPECT_EQ(PluginType::INTERNAL, track.processors[1].plugin.type);
+    EXPECT_FALSE(track.processors[1].bypassed);
+    EXPECT_TRUE(synth.string_properties.empty());
+    ASSERT_EQ(1u, track.processors[1].string_properties.size());
+    EXPECT_EQ("sample_file", track.processors[1].string_properties[0].name);
+    EXPECT_EQ("/path/to/sample.wav", track.processors[1].string_properties[0].value);
+    ASSERT_EQ(1u, track.processors[1].data_properties.size());
+    EXPECT_EQ("data", track.processors[1].data_properties[0].name);
+    EXPECT_EQ(std::vector<uint8_t>({0, 1, 2, 255}), track.processors[1].data_properties[0].value);
+
+    EXPECT_EQ(2, restored.tracks[1].input_busses);
+    EXPECT_EQ(3, restored.tracks[1].output_busses);
+
+    ASSERT_EQ(1u, restored.input_connections.size());
+    EXPECT_EQ(0, restored.input_connections[0].engine_channel);
+    EXPECT_EQ(1, restored.input_connections[0].track_channel);
+    EXPECT_EQ("main", restored.input_connections[0].track);
+    ASSERT_EQ(1u, restored.output_connections.size());
+    EXPECT_EQ("busses", restored.output_connections[0].track);
+
+    /* Serialising again should give identical data */
+    EXPECT_EQ(data, restored.serialize());
+}
+
+TEST(TestSessionSnapshot, TestInvalidData)
+{
+    auto data = make_test_session().serialize();
+    EXPECT_FALSE(SessionSnapshot::deserialize(std::vector<uint8_t>()).first);
+
+    /* Any truncation should be detected */
+    for (size_t length = 0; length < data.size(); ++length)
+    {
+        std::vector<uint8_t> truncated(data.begin(), data.begin() + length);
+        EXPECT_FALSE(SessionSnapshot::deserialize(truncated).first);
+    }
+
+    auto trailing_data = data;
+    trailing_data.push_back(0);
+    EXPECT_FALSE(SessionSnapshot::deserialize(trailing_data).first);
+
+    auto wrong_magic = data;
+    wrong_magic[0]++;
+    EXPECT_FALSE(SessionSnapshot::deserialize(wrong_magic).first);
+
+    /* A huge element count should fail and not try to allocate */
+    auto huge_count = data;
+    huge_count[8] = 0xff;
+    huge_count[9] = 0xff;
+    huge_count[10] = 0xff;
+    huge_count[11] = 0x7f;
+    EXPECT_FALSE(SessionSnapshot::deserialize(huge_count).first);
+}
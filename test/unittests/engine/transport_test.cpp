@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include "engine/transport.cpp"
+#include "library/rt_event_fifo.h"
 
 using namespace sushi;
 using namespace sushi::engine;
@@ -132,4 +133,151 @@ TEST_F(TestTransport, TestPlayStateChange)
     _module_under_test.set_time(std::chrono::seconds(3), 132000);
     EXPECT_TRUE(_module_under_test.playing());
     EXPECT_EQ(PlayStateChange::UNCHANGED, _module_under_test.current_state_change());
-}
\ No newline at end of file
+}
+
+TEST_F(TestTransport, TestMidiClockStartWithFirstTick)
+{
+    _module_under_test.set_sample_rate(TEST_SAMPLERATE);
+    _module_under_test.set_time_signature({4, 4}, false);
+    _module_under_test.set_tempo(120, false);
+    _module_under_test.set_playing_mode(PlayingMode::PLAYING, false);
+    _module_under_test.set_sync_mode(SyncMode::INTERNAL, false);
+    _module_under_test.set_time(std::chrono::seconds(0), 0);
+    _module_under_test.set_time(std::chrono::seconds(1), TEST_SAMPLERATE);
+    ASSERT_GT(_module_under_test.current_beats(), 1.0);
+
+    /* The first start message after switching to midi sync arrives in the same chunk
+     * as the first tick, it should still rewind the position */
+    _module_under_test.set_sync_mode(SyncMode::MIDI, false);
+    int64_t samples = 2 * TEST_SAMPLERATE;
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::MIDI, SyncClockRtEvent::ClockType::START, 24));
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::MIDI, SyncClockRtEvent::ClockType::TICK, 24));
+    _module_under_test.set_time(std::chrono::seconds(2), samples);
+    EXPECT_TRUE(_module_under_test.playing());
+    EXPECT_LT(_module_under_test.current_beats(), 1.0 / 24.0);
+}
+
+TEST_F(TestTransport, TestMidiClockSync)
+{
+    _module_under_test.set_sample_rate(TEST_SAMPLERATE);
+    _module_under_test.set_time_signature({4, 4}, false);
+    _module_under_test.set_tempo(120, false);
+    _module_under_test.set_sync_mode(SyncMode::MIDI, false);
+    _module_under_test.set_time(std::chrono::seconds(0), 0);
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::MIDI, SyncClockRtEvent::ClockType::START, 24));
+
+    /* Clock the transport at 100 bpm with up to 1 ms of jitter on every tick */
+    constexpr double TICK_PERIOD = 60.0 / 100.0 / 24.0 * TEST_SAMPLERATE;
+    constexpr double FIRST_TICK = 1000;
+    int64_t samples = 0;
+    int tick = 0;
+    double prev_beats = 0;
+    while (samples < 4 * TEST_SAMPLERATE)
+    {
+        samples += AUDIO_CHUNK_SIZE;
+        _module_under_test.set_time(std::chrono::seconds(0), samples);
+        ASSERT_GE(_module_under_test.current_beats(), prev_beats);
+        prev_beats = _module_under_test.current_beats();
+        while (true)
+        {
+            double jitter = (tick * 7919 % 97 - 48) / 1000.0 * TEST_SAMPLERATE / 48.0;
+            auto tick_time = static_cast<int64_t>(FIRST_TICK + tick * TICK_PERIOD + jitter);
+            if (tick_time >= samples + AUDIO_CHUNK_SIZE)
+            {
+                break;
+            }
+            int offset = static_cast<int>(std::max<int64_t>(0, tick_time - samples));
+            _module_under_test.process_event(RtEvent::make_sync_clock_event(offset, SyncMode::MIDI, SyncClockRtEvent::ClockType::TICK, 24));
+            tick++;
+        }
+    }
+    EXPECT_TRUE(_module_under_test.playing());
+    EXPECT_NEAR(100.0, _module_under_test.current_tempo(), 0.2);
+    double expected_beats = (samples - FIRST_TICK) / TICK_PERIOD / 24.0;
+    EXPECT_NEAR(expected_beats, _module_under_test.current_beats(), 0.05);
+
+    /* Clock ticks from other sources are ignored */
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::GATE_INPUT, SyncClockRtEvent::ClockType::STOP, 4));
+    _module_under_test.set_time(std::chrono::seconds(0), samples + AUDIO_CHUNK_SIZE);
+    EXPECT_TRUE(_module_under_test.playing());
+
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::MIDI, SyncClockRtEvent::ClockType::STOP, 24));
+    _module_under_test.set_time(std::chrono::seconds(0), samples + 2 * AUDIO_CHUNK_SIZE);
+    EXPECT_FALSE(_module_under_test.playing());
+    EXPECT_EQ(PlayStateChange::STOPPING, _module_under_test.current_state_change());
+
+    /* A start message rewinds the position */
+    _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::MIDI, SyncClockRtEvent::ClockType::START, 24));
+    _module_under_test.set_time(std::chrono::seconds(0), samples + 3 * AUDIO_CHUNK_SIZE);
+    EXPECT_TRUE(_module_under_test.playing());
+    EXPECT_DOUBLE_EQ(0.0, _module_under_test.current_beats());
+}
+
+TEST_F(TestTransport, TestClockSyncTempoChange)
+{
+    _module_under_test.set_sample_rate(TEST_SAMPLERATE);
+    _module_under_test.set_playing_mode(PlayingMode::PLAYING, false);
+    _module_under_test.set_sync_mode(SyncMode::GATE_INPUT, false);
+
+    /* Ticks arriving at the start of each chunk with a period of 100 chunks at 4 ppq */
+    auto run = [&](int64_t& samples, int chunks, int period)
+    {
+        for (int i = 0; i < chunks; ++i)
+        {
+            _module_under_test.set_time(std::chrono::seconds(0), samples);
+            if (samples % (period * AUDIO_CHUNK_SIZE) == 0)
+            {
+                _module_under_test.process_event(RtEvent::make_sync_clock_event(0, SyncMode::GATE_INPUT, SyncClockRtEvent::ClockType::TICK, 4));
+            }
+            samples += AUDIO_CHUNK_SIZE;
+        }
+    };
+    int64_t samples = 0;
+    run(samples, 1000, 100);
+    EXPECT_NEAR(60.0 * TEST_SAMPLERATE / (100 * AUDIO_CHUNK_SIZE * 4), _module_under_test.current_tempo(), 0.01);
+
+    /* A large change in tempo is followed immediately */
+    run(samples, 210, 70);
+    EXPECT_NEAR(60.0 * TEST_SAMPLERATE / (70 * AUDIO_CHUNK_SIZE * 4), _module_under_test.current_tempo(), 0.01);
+
+    /* When the clock stops, the last tempo is kept and the position stops moving */
+    run(samples, 500, 1000000);
+    double beats = _module_under_test.current_beats();
+    run(samples, 100, 1000000);
+    EXPECT_DOUBLE_EQ(beats, _module_under_test.current_beats());
+    EXPECT_NEAR(60.0 * TEST_SAMPLERATE / (70 * AUDIO_CHUNK_SIZE * 4), _module_under_test.current_tempo(), 0.01);
+}
+
+TEST_F(TestTransport, TestNotifications)
+{
+    RtEventFifo<10> queue;
+    RtEvent event;
+    _module_under_test.set_sample_rate(TEST_SAMPLERATE);
+    _module_under_test.set_event_output(&queue);
+    _module_under_test.set_tempo(DEFAULT_TEMPO, false);
+    _module_under_test.set_playing_mode(PlayingMode::STOPPED, false);
+    _module_under_test.set_time(std::chrono::seconds(0), 0);
+    EXPECT_TRUE(queue.empty());
+
+    /* Changes are notified on the following chunk */
+    _module_under_test.process_event(RtEvent::make_playing_mode_event(0, PlayingMode::PLAYING));
+    _module_under_test.process_event(RtEvent::make_tempo_event(0, 130));
+    _module_under_test.set_time(std::chrono::seconds(0), AUDIO_CHUNK_SIZE);
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_EQ(RtEventType::PLAYING_MODE, event.type());
+    EXPECT_EQ(PlayingMode::PLAYING, event.playing_mode_event()->mode());
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_EQ(RtEventType::TEMPO, event.type());
+    EXPECT_FLOAT_EQ(130, event.tempo_event()->tempo());
+    EXPECT_TRUE(queue.empty());
+
+    /* Tempo notifications are rate limited, but the latest tempo is always notified */
+    _module_under_test.process_event(RtEvent::make_tempo_event(0, 140));
+    _module_under_test.set_time(std::chrono::seconds(0), 2 * AUDIO_CHUNK_SIZE);
+    EXPECT_TRUE(queue.empty());
+    _module_under_test.set_time(std::chrono::seconds(1), TEST_SAMPLERATE);
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_EQ(RtEventType::TEMPO, event.type());
+    EXPECT_FLOAT_EQ(140, event.tempo_event()->tempo());
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,75 @@
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+#include "library/automation_file.cpp"
+
+using namespace sushi;
+using namespace sushi::automation_file;
+
+AutomationData make_test_data()
+{
+    AutomationData automation;
+    automation.parameters.push_back({"synth", "cutoff"});
+    automation.parameters.push_back({"main_gain", "gain"});
+    automation.events.push_back({0, 0, 0.25f});
+    automation.events.push_back({48000, 1, 0.5f});
+    automation.events.push_back({1LL << 40, 0, 1.0f});
+    return automation;
+}
+
+TEST(TestAutomationFile, TestSerialisation)
+{
+    auto data = serialise_automation_data(make_test_data());
+    ASSERT_GT(data.size(), 8u);
+    EXPECT_EQ('S', data[0]);
+    EXPECT_EQ('T', data[7]);
+
+    auto [status, automation] = parse_automation_data(data);
+    ASSERT_EQ(AutomationFileStatus::OK, status);
+    ASSERT_EQ(2u, automation.parameters.size());
+    EXPECT_EQ("synth", automation.parameters[0].processor);
+    EXPECT_EQ("cutoff", automation.parameters[0].parameter);
+    EXPECT_EQ("main_gain", automation.parameters[1].processor);
+    EXPECT_EQ("gain", automation.parameters[1].parameter);
+
+    ASSERT_EQ(3u, automation.events.size());
+    EXPECT_EQ(48000, automation.events[1].sample);
+    EXPECT_EQ(1u, automation.events[1].parameter);
+    EXPECT_FLOAT_EQ(0.5f, automation.events[1].value);
+    EXPECT_EQ(1LL << 40, automation.events[2].sample);
+}
+
+TEST(TestAutomationFile, TestInvalidData)
+{
+    auto data = serialise_automation_data(make_test_data());
+
+    auto truncated = data;
+    truncated.pop_back();
+    auto [status, automation] = parse_automation_data(truncated);
+    EXPECT_EQ(AutomationFileStatus::INVALID_FORMAT, status);
+
+    auto wrong_magic = data;
+    wrong_magic[0] = 'X';
+    std::tie(status, automation) = parse_automation_data(wrong_magic);
+    EXPECT_EQ(AutomationFileStatus::INVALID_FORMAT, status);
+
+    auto invalid_parameter = make_test_data();
+    invalid_parameter.events[0].parameter = 2;
+    std::tie(status, automation) = parse_automation_data(serialise_automation_data(invalid_parameter));
+    EXPECT_EQ(AutomationFileStatus::INVALID_FORMAT, status);
+
+    std::tie(status, automation) = read_automation_file("this_is_not_a_valid_file.aut");
+    EXPECT_EQ(AutomationFileStatus::INVALID_FILE, status);
+}
+
+TEST(TestAutomationFile, TestReadWriteFile)
+{
+    std::string filename = "./test_automation.aut";
+    ASSERT_EQ(AutomationFileStatus::OK, write_automation_file(filename, make_test_data()));
+    auto [status, automation] = read_automation_file(filename);
+    std::remove(filename.c_str());
+    ASSERT_EQ(AutomationFileStatus::OK, status);
+    EXPECT_EQ(2u, automation.parameters.size());
+    EXPECT_EQ(3u, automation.events.size());
+}
@@ -108,6 +108,15 @@ TEST(EventTest, TestToRtEvent)
     EXPECT_EQ(RtEventType::SET_BYPASS, rt_event.type());
     EXPECT_TRUE(rt_event.processor_command_event()->value());
     EXPECT_EQ(10u, rt_event.processor_command_event()->processor_id());
+
+    auto clock_event = SyncClockEvent(SyncMode::MIDI, SyncClockRtEvent::ClockType::START, 24, IMMEDIATE_PROCESS);
+    EXPECT_TRUE(clock_event.maps_to_rt_event());
+    rt_event = clock_event.to_rt_event(13);
+    EXPECT_EQ(RtEventType::SYNC_CLOCK, rt_event.type());
+    EXPECT_EQ(13, rt_event.sync_clock_event()->sample_offset());
+    EXPECT_EQ(SyncMode::MIDI, rt_event.sync_clock_event()->source());
+    EXPECT_EQ(SyncClockRtEvent::ClockType::START, rt_event.sync_clock_event()->clock_type());
+    EXPECT_EQ(24, rt_event.sync_clock_event()->ppq_ticks());
 }
 
 TEST(EventTest, TestFromRtEvent)
@@ -224,4 +233,28 @@ TEST(EventTest, TestFromRtEvent)
     EXPECT_TRUE(event->is_async_work_event());
     EXPECT_TRUE(event->process_asynchronously());
     delete event;
+
+    auto tempo_event = RtEvent::make_tempo_event(0, 125.0f);
+    event = Event::from_rt_event(tempo_event, IMMEDIATE_PROCESS);
+    ASSERT_TRUE(event != nullptr);
+    ASSERT_TRUE(event->is_engine_notification());
+    EXPECT_EQ(EngineNotificationEvent::Subtype::TEMPO, static_cast<EngineNotificationEvent*>(event)->subtype());
+    EXPECT_FLOAT_EQ(125.0f, static_cast<TempoNotificationEvent*>(event)->tempo());
+    delete event;
+
+    auto playing_mode_event = RtEvent::make_playing_mode_event(0, PlayingMode::PLAYING);
+    event = Event::from_rt_event(playing_mode_event, IMMEDIATE_PROCESS);
+    ASSERT_TRUE(event != nullptr);
+    ASSERT_TRUE(event->is_engine_notification());
+    EXPECT_EQ(EngineNotificationEvent::Subtype::PLAYING_MODE, static_cast<EngineNotificationEvent*>(event)->subtype());
+    EXPECT_EQ(PlayingMode::PLAYING, static_cast<PlayingModeNotificationEvent*>(event)->mode());
+    delete event;
+
+    auto peers_event = RtEvent::make_link_peers_notification_event(0, 3);
+    event = Event::from_rt_event(peers_event, IMMEDIATE_PROCESS);
+    ASSERT_TRUE(event != nullptr);
+    ASSERT_TRUE(event->is_engine_notification());
+    EXPECT_EQ(EngineNotificationEvent::Subtype::LINK_PEERS, static_cast<EngineNotificationEvent*>(event)->subtype());
+    EXPECT_EQ(3, static_cast<LinkPeersNotificationEvent*>(event)->peers());
+    delete event;
 }
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "library/internal_plugin.h"
+#include "library/internal_plugin_registry.h"
+#include "test_utils/host_control_mockup.h"
+
+using namespace sushi;
+
+class RegistryTestPlugin : public InternalPlugin
+{
+public:
+    RegistryTestPlugin(HostControl host_control) : InternalPlugin(host_control)
+    {
+        set_name("registry_test_plugin");
+    }
+
+    void process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer) override
+    {
+        out_buffer = in_buffer;
+    }
+};
+
+SUSHI_REGISTER_INTERNAL_PLUGIN(RegistryTestPlugin, "sushi.testing.registry_test");
+
+/* Known FNV-1a test vectors, also checks that the hash can be evaluated at compile time */
+static_assert(plugin_uid_hash("") == 0x811c9dc5u);
+static_assert(plugin_uid_hash("a") == 0xe40c292cu);
+static_assert(plugin_uid_hash("foobar") == 0xbf9cf968u);
+
+TEST(TestInternalPluginRegistry, TestCreate)
+{
+    HostControlMockup host_control;
+    std::unique_ptr<Processor> instance(InternalPluginRegistry::create("sushi.testing.registry_test",
+                                                                        host_control.make_host_control_mockup()));
+    ASSERT_TRUE(instance);
+    EXPECT_EQ("registry_test_plugin", instance->name());
+
+    EXPECT_EQ(nullptr, InternalPluginRegistry::create("sushi.testing.not_registered",
+                                                      host_control.make_host_control_mockup()));
+    EXPECT_EQ(nullptr, InternalPluginRegistry::create("", host_control.make_host_control_mockup()));
+}
+
+TEST(TestInternalPluginRegistry, TestAdd)
+{
+    auto uids = InternalPluginRegistry::uids();
+    EXPECT_NE(uids.end(), std::find(uids.begin(), uids.end(), "sushi.testing.registry_test"));
+
+    /* Adding the same uid again should fail */
+    EXPECT_FALSE(InternalPluginRegistry::add("sushi.testing.registry_test",
+                                             plugin_uid_hash("sushi.testing.registry_test"),
+                                             [](HostControl) -> Processor* {return nullptr;}));
+    EXPECT_EQ(uids.size(), InternalPluginRegistry::uids().size());
+}
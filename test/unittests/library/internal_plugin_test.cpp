@@ -22,6 +22,9 @@ public:
         set_name("test_plugin");
     }
 
+    using InternalPlugin::set_string_property_value;
+    using InternalPlugin::set_data_property_value;
+
     void process_audio(const ChunkSampleBuffer &in_buffer, ChunkSampleBuffer &out_buffer) override
     {
         out_buffer = in_buffer;
@@ -77,6 +80,31 @@ TEST_F(InternalPluginTest, TestParameterRegistration)
     EXPECT_EQ(3, value->processed_value());
 }
 
+TEST_F(InternalPluginTest, TestPropertyValues)
+{
+    ASSERT_TRUE(_module_under_test->register_string_property("string", "String", ""));
+    ASSERT_TRUE(_module_under_test->register_data_property("data", "Data", ""));
+    ObjectId string_id = _module_under_test->parameter_from_name("string")->id();
+    ObjectId data_id = _module_under_test->parameter_from_name("data")->id();
+
+    auto [status, value] = _module_under_test->string_property_value(string_id);
+    EXPECT_EQ(ProcessorReturnCode::OK, status);
+    EXPECT_EQ("", value);
+
+    auto plugin = static_cast<TestPlugin*>(_module_under_test);
+    plugin->set_string_property_value(string_id, "a string");
+    EXPECT_EQ("a string", _module_under_test->string_property_value(string_id).second);
+
+    uint8_t bytes[] = {1, 2, 3};
+    plugin->set_data_property_value(data_id, BlobData{3, bytes});
+    auto [data_status, data] = _module_under_test->data_property_value(data_id);
+    EXPECT_EQ(ProcessorReturnCode::OK, data_status);
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), data);
+
+    EXPECT_EQ(ProcessorReturnCode::PARAMETER_NOT_FOUND, _module_under_test->string_property_value(data_id + 10).first);
+    EXPECT_EQ(ProcessorReturnCode::PARAMETER_NOT_FOUND, _module_under_test->data_property_value(string_id).first);
+}
+
 TEST_F(InternalPluginTest, TestDuplicateParameterNames)
 {
     auto test_param = _module_under_test->register_int_parameter("param_2", "Param 2", "", 1, 0, 10,
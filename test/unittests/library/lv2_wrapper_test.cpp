@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <filesystem>
+
 #include "gtest/gtest.h"
 
 #include "test_utils/test_utils.h"
@@ -153,6 +156,22 @@ TEST_F(TestLv2Wrapper, TestLV2PluginInterraction)
     EXPECT_EQ("-33.000000", formattedValue);
 }
 
+TEST_F(TestLv2Wrapper, TestSharedWorld)
+{
+    auto ret = SetUp("http://lv2plug.in/plugins/eg-amp");
+    ASSERT_EQ(ProcessorReturnCode::OK, ret);
+
+    auto other_instance = std::make_unique<LV2_Wrapper>(_host_control.make_host_control_mockup(TEST_SAMPLE_RATE),
+                                                        "http://lv2plug.in/plugins/eg-amp");
+    ASSERT_EQ(ProcessorReturnCode::OK, other_instance->init(TEST_SAMPLE_RATE));
+
+    // Both instances should share the world, plugin descriptor and urid map
+    EXPECT_EQ(_module_under_test->_model->world(), other_instance->_model->world());
+    EXPECT_EQ(_module_under_test->_model->plugin_class(), other_instance->_model->plugin_class());
+    EXPECT_EQ(_module_under_test->_model->map(LV2_ATOM__Float), other_instance->_model->map(LV2_ATOM__Float));
+    EXPECT_NE(_module_under_test->_model->plugin_instance(), other_instance->_model->plugin_instance());
+}
+
 TEST_F(TestLv2Wrapper, TestProcessingWithParameterChanges)
 {
     auto ret = SetUp("http://lv2plug.in/plugins/eg-amp");
@@ -501,6 +520,7 @@ TEST_F(TestLv2Wrapper, TestSynth)
     _module_under_test->_pause_audio_processing();
 
     _module_under_test->set_program(1);
+    EXPECT_EQ(1, _module_under_test->current_program());
 
     // A compromise, for the unit tests to be able to run.
     // It simulates the series of events in the live multithreaded program.
@@ -518,4 +538,57 @@ TEST_F(TestLv2Wrapper, TestSynth)
     _module_under_test->process_audio(in_buffer, out_buffer);
 }
 
+/*
+ * Presets are loaded into the world shared by all instances. Program changes and state
+ * saving on two live instances must not deadlock on the shared world lock, and
+ * destroying one instance must not unload the presets used by the other.
+ */
+TEST_F(TestLv2Wrapper, TestSharedPresets)
+{
+    SetUp("http://drobilla.net/plugins/mda/JX10");
+
+    if (_module_under_test == nullptr)
+    {
+        std::cout << "'http://drobilla.net/plugins/mda/JX10' plugin not installed - please install it to ensure full suite of unit tests has run."
+                  << std::endl;
+        return;
+    }
+
+    auto other_instance = std::make_unique<LV2_Wrapper>(_host_control.make_host_control_mockup(TEST_SAMPLE_RATE),
+                                                        "http://drobilla.net/plugins/mda/JX10");
+    ASSERT_EQ(ProcessorReturnCode::OK, other_instance->init(TEST_SAMPLE_RATE));
+    ASSERT_EQ(52, other_instance->program_count());
+
+    _module_under_test->_pause_audio_processing();
+    ASSERT_EQ(ProcessorReturnCode::OK, _module_under_test->set_program(2));
+    ASSERT_EQ(ProcessorReturnCode::OK, other_instance->set_program(3));
+    _module_under_test->_resume_audio_processing();
+    EXPECT_EQ(2, _module_under_test->current_program());
+    EXPECT_EQ(3, other_instance->current_program());
+
+    char state_dir[] = "/tmp/sushi_lv2_state_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(state_dir));
+    _module_under_test->_model->state()->save(state_dir);
+    other_instance->_model->state()->save(state_dir);
+    std::filesystem::remove_all(state_dir);
+
+    other_instance.reset();
+
+    auto model = _module_under_test->_model.get();
+    std::string preset_uri = model->state()->program_name(4);
+    {
+        std::lock_guard<std::mutex> lock(model->world()->lilv_mutex());
+        auto preset_node = lilv_new_uri(model->lilv_world(), preset_uri.c_str());
+        auto preset = lilv_state_new_from_world(model->lilv_world(), &model->get_map(), preset_node);
+        lilv_node_free(preset_node);
+        ASSERT_NE(nullptr, preset);
+        lilv_state_free(preset);
+    }
+
+    _module_under_test->_pause_audio_processing();
+    ASSERT_EQ(ProcessorReturnCode::OK, _module_under_test->set_program(4));
+    _module_under_test->_resume_audio_processing();
+    EXPECT_EQ(4, _module_under_test->current_program());
+}
+
 #endif //SUSHI_BUILD_WITH_LV2_MDA_TESTS
@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "library/mapped_blob.cpp"
+
+using namespace sushi;
+
+class TestMappedBlob : public ::testing::Test
+{
+protected:
+    TestMappedBlob() {}
+
+    void SetUp()
+    {
+        char path[] = "/tmp/sushi_mapped_blob_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        _path = path;
+    }
+
+    void TearDown()
+    {
+        unlink(_path.c_str());
+    }
+
+    void write_file(const std::vector<uint8_t>& content)
+    {
+        FILE* file = fopen(_path.c_str(), "wb");
+        ASSERT_NE(nullptr, file);
+        ASSERT_EQ(content.size(), fwrite(content.data(), 1, content.size(), file));
+        fclose(file);
+    }
+
+    std::string _path;
+};
+
+TEST_F(TestMappedBlob, TestMapping)
+{
+    std::vector<uint8_t> content(5000);
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<uint8_t>(i % 251 + 1);
+    }
+    write_file(content);
+
+    auto blob = MappedBlob::map(_path);
+    ASSERT_TRUE(blob);
+    ASSERT_EQ(content.size(), blob->size());
+    EXPECT_EQ(0, std::memcmp(content.data(), blob->data(), content.size()));
+    for (size_t i = 0; i < MappedBlob::PADDING_BYTES; ++i)
+    {
+        ASSERT_EQ(0, blob->data()[content.size() + i]);
+    }
+    /* Locking may not be permitted in the test environment, only test that it doesn't crash */
+    blob->prefetch(0, 100);
+    blob->prefetch(content.size() + MappedBlob::PADDING_BYTES + 10000, 100);
+    blob->lock(0, content.size());
+    EXPECT_FALSE(blob->lock(0, 0));
+}
+
+TEST_F(TestMappedBlob, TestRead)
+{
+    std::vector<uint8_t> content(5000);
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<uint8_t>(i % 251 + 1);
+    }
+    write_file(content);
+    auto blob = MappedBlob::map(_path);
+    ASSERT_TRUE(blob);
+
+    std::vector<uint8_t> buffer(1000);
+    ASSERT_EQ(1000u, blob->read(100, buffer.data(), 1000));
+    EXPECT_EQ(0, std::memcmp(content.data() + 100, buffer.data(), 1000));
+    EXPECT_EQ(200u, blob->read(4800, buffer.data(), 1000));
+    EXPECT_EQ(0u, blob->read(6000, buffer.data(), 1000));
+
+    /* A truncated file should give a short read and not crash */
+    ASSERT_EQ(0, truncate(_path.c_str(), 1000));
+    EXPECT_EQ(0u, blob->read(2000, buffer.data(), 1000));
+    EXPECT_EQ(500u, blob->read(500, buffer.data(), 1000));
+}
+
+TEST_F(TestMappedBlob, TestSharing)
+{
+    write_file(std::vector<uint8_t>(100, 1));
+    auto blob = MappedBlob::map(_path);
+    auto other_blob = MappedBlob::map(_path);
+    ASSERT_TRUE(blob);
+    EXPECT_EQ(blob.get(), other_blob.get());
+    EXPECT_EQ(2, blob.use_count());
+
+    /* A modified file is not shared with users of the old version */
+    write_file(std::vector<uint8_t>(200, 2));
+    auto modified_blob = MappedBlob::map(_path);
+    ASSERT_TRUE(modified_blob);
+    EXPECT_NE(blob.get(), modified_blob.get());
+    EXPECT_EQ(200u, modified_blob->size());
+    EXPECT_EQ(2, modified_blob->data()[0]);
+}
+
+TEST_F(TestMappedBlob, TestErrors)
+{
+    EXPECT_FALSE(MappedBlob::map(_path));
+    EXPECT_FALSE(MappedBlob::map("/tmp"));
+    EXPECT_FALSE(MappedBlob::map("/this/file/does/not/exist"));
+}
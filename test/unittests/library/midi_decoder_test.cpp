@@ -51,6 +51,20 @@ TEST (MidiDecoderTest, TestDecodeMessageType) {
     EXPECT_EQ(MessageType::UNKNOWN, decode_message_type(TEST_UNKNOWN_MSG));
 }
 
+TEST (MidiDecoderTest, TestDecodeMessageSize)
+{
+    EXPECT_EQ(3, decode_message_size(TEST_NOTE_ON_MSG));
+    EXPECT_EQ(3, decode_message_size(TEST_CTRL_CH_MSG));
+    EXPECT_EQ(3, decode_message_size(TEST_PITCH_B_MSG));
+    EXPECT_EQ(2, decode_message_size(TEST_PROG_CH_MSG));
+    EXPECT_EQ(2, decode_message_size(TEST_CHAN_PRES_MSG));
+    EXPECT_EQ(3, decode_message_size(TEST_SONG_POS_MSG));
+    EXPECT_EQ(2, decode_message_size(TEST_SONG_SEL_MSG));
+    EXPECT_EQ(1, decode_message_size(TEST_CLOCK_MSG));
+    EXPECT_EQ(0, decode_message_size({0xF0, 0x7E, 0, 0}));
+    EXPECT_EQ(0, decode_message_size(TEST_UNKNOWN_MSG));
+}
+
 TEST (MidiDecoderTest, TestDecodeChannel)
 {
     EXPECT_EQ(5, decode_channel({0x35, 0, 0, 0}));
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "library/midi_file.cpp"
+
+using namespace sushi;
+using namespace sushi::midi_file;
+
+/* Format 1 file with 96 ticks per quarter note, a tempo track and one note track */
+const std::vector<uint8_t> TEST_FILE = {
+    'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2, 0, 96,
+    /* Tempo track, 60 bpm from tick 96 */
+    'M', 'T', 'r', 'k', 0, 0, 0, 11,
+    0x60, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,
+    0x00, 0xFF, 0x2F, 0x00,
+    /* Note track, running status is used for the second and third event */
+    'M', 'T', 'r', 'k', 0, 0, 0, 22,
+    0x00, 0x90, 60, 100,
+    0x60, 64, 100,
+    0x60, 60, 0,
+    0x00, 0xC1, 5,
+    0x81, 0x40, 0x80, 64, 0,
+    0x00, 0xFF, 0x2F, 0x00
+};
+
+TEST(TestMidiFile, TestParseMidiFile)
+{
+    auto [status, events] = parse_midi_file(TEST_FILE);
+    ASSERT_EQ(MidiFileStatus::OK, status);
+    ASSERT_EQ(5u, events.size());
+
+    EXPECT_DOUBLE_EQ(0.0, events[0].time);
+    EXPECT_EQ(1, events[0].track);
+    EXPECT_EQ(0x90, events[0].data[0]);
+    EXPECT_EQ(60, events[0].data[1]);
+    EXPECT_EQ(100, events[0].data[2]);
+
+    // One quarter note at the default 120 bpm
+    EXPECT_DOUBLE_EQ(0.5, events[1].time);
+    EXPECT_EQ(0x90, events[1].data[0]);
+    EXPECT_EQ(64, events[1].data[1]);
+
+    // Followed by one quarter note at 60 bpm
+    EXPECT_DOUBLE_EQ(1.5, events[2].time);
+    EXPECT_EQ(0x90, events[2].data[0]);
+    EXPECT_EQ(0, events[2].data[2]);
+
+    EXPECT_DOUBLE_EQ(1.5, events[3].time);
+    EXPECT_EQ(0xC1, events[3].data[0]);
+    EXPECT_EQ(5, events[3].data[1]);
+
+    EXPECT_DOUBLE_EQ(3.5, events[4].time);
+    EXPECT_EQ(0x80, events[4].data[0]);
+}
+
+TEST(TestMidiFile, TestSmpteDivision)
+{
+    /* 25 fps with 40 ticks per frame gives 1 ms per tick */
+    std::vector<uint8_t> file = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0xE7, 40,
+                                 'M', 'T', 'r', 'k', 0, 0, 0, 9,
+                                 0x83, 0x60, 0x90, 60, 100,
+                                 0x00, 0xFF, 0x2F, 0x00};
+    auto [status, events] = parse_midi_file(file);
+    ASSERT_EQ(MidiFileStatus::OK, status);
+    ASSERT_EQ(1u, events.size());
+    EXPECT_DOUBLE_EQ(0.48, events[0].time);
+}
+
+TEST(TestMidiFile, TestInvalidFiles)
+{
+    auto [status, events] = parse_midi_file({'R', 'I', 'F', 'F', 0, 0, 0, 6});
+    EXPECT_EQ(MidiFileStatus::INVALID_FORMAT, status);
+    EXPECT_TRUE(events.empty());
+
+    // Truncated track chunk
+    std::vector<uint8_t> truncated(TEST_FILE.begin(), TEST_FILE.end() - 10);
+    std::tie(status, events) = parse_midi_file(truncated);
+    EXPECT_EQ(MidiFileStatus::INVALID_FORMAT, status);
+
+    // Data byte without a preceding status byte
+    std::vector<uint8_t> no_status = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+                                      'M', 'T', 'r', 'k', 0, 0, 0, 3, 0x00, 60, 100};
+    std::tie(status, events) = parse_midi_file(no_status);
+    EXPECT_EQ(MidiFileStatus::INVALID_FORMAT, status);
+
+    std::tie(status, events) = read_midi_file("this_is_not_a_valid_file.mid");
+    EXPECT_EQ(MidiFileStatus::INVALID_FILE, status);
+}
@@ -0,0 +1,69 @@
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "library/parameter_notifications.h"
+
+using namespace sushi;
+
+struct Notification
+{
+    ObjectId processor;
+    ObjectId parameter;
+    float value;
+};
+
+TEST(TestParameterNotificationBuffer, TestCoalescing)
+{
+    ParameterNotificationBuffer module_under_test(70);
+    EXPECT_FALSE(module_under_test.dirty());
+
+    EXPECT_TRUE(module_under_test.set(3, 0.1f));
+    EXPECT_TRUE(module_under_test.set(3, 0.2f));
+    EXPECT_TRUE(module_under_test.set(69, 0.3f));
+    EXPECT_TRUE(module_under_test.set(3, 0.4f));
+    EXPECT_FALSE(module_under_test.set(70, 0.5f));
+    EXPECT_TRUE(module_under_test.dirty());
+
+    std::vector<Notification> notifications;
+    int count = module_under_test.consume([&](ObjectId parameter, float value)
+                                          {
+                                              notifications.push_back({0, parameter, value});
+                                          });
+    ASSERT_EQ(2, count);
+    ASSERT_EQ(2u, notifications.size());
+    EXPECT_EQ(3u, notifications[0].parameter);
+    EXPECT_FLOAT_EQ(0.4f, notifications[0].value);
+    EXPECT_EQ(69u, notifications[1].parameter);
+    EXPECT_FLOAT_EQ(0.3f, notifications[1].value);
+
+    EXPECT_FALSE(module_under_test.dirty());
+    EXPECT_EQ(0, module_under_test.consume([](ObjectId, float) {}));
+}
+
+TEST(TestParameterNotificationArea, TestConsume)
+{
+    ParameterNotificationArea module_under_test;
+    auto buffer_1 = module_under_test.add(1, 2);
+    auto buffer_2 = module_under_test.add(2, 2);
+    buffer_1->set(1, 1.0f);
+    buffer_2->set(0, 2.0f);
+    buffer_2->set(0, 3.0f);
+
+    std::vector<Notification> notifications;
+    auto collect = [&](ObjectId processor, ObjectId parameter, float value)
+    {
+        notifications.push_back({processor, parameter, value});
+    };
+    EXPECT_EQ(2, module_under_test.consume(collect));
+    ASSERT_EQ(2u, notifications.size());
+    EXPECT_EQ(1u, notifications[0].processor);
+    EXPECT_EQ(1u, notifications[0].parameter);
+    EXPECT_EQ(2u, notifications[1].processor);
+    EXPECT_FLOAT_EQ(3.0f, notifications[1].value);
+
+    buffer_1->set(0, 1.0f);
+    module_under_test.remove(1);
+    notifications.clear();
+    EXPECT_EQ(0, module_under_test.consume(collect));
+    EXPECT_TRUE(notifications.empty());
+}
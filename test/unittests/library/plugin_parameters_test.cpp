@@ -48,9 +48,9 @@ protected:
     uint8_t* TEST_DATA = new uint8_t[3];
     BlobData blob{3, TEST_DATA};
 
-    FloatParameterDescriptor _module_under_test_float{"float_parameter", "FloatParameter", "fl", -10.0f, 10.0f, new ParameterPreProcessor<float>(-10, 10)};
-    IntParameterDescriptor _module_under_test_int{"int_parameter", "IntParameter", "int", -10, 10, new ParameterPreProcessor<int>(-10, 10)};
-    BoolParameterDescriptor _module_under_test_bool{"bool_parameter", "BoolParameter", "bool", false, true, new ParameterPreProcessor<bool>(0, 1)};
+    FloatParameterDescriptor _module_under_test_float{"float_parameter", "FloatParameter", "fl", -10.0f, 10.0f, new FloatParameterPreProcessor(-10, 10)};
+    IntParameterDescriptor _module_under_test_int{"int_parameter", "IntParameter", "int", -10, 10, new IntParameterPreProcessor(-10, 10)};
+    BoolParameterDescriptor _module_under_test_bool{"bool_parameter", "BoolParameter", "bool", false, true, new BoolParameterPreProcessor(0, 1)};
     StringPropertyDescriptor _module_under_test_string{"string_parameter", "String Parameter", ""};
     DataPropertyDescriptor _module_under_test_data{"data_parameter", "Data Parameter", "data"};
 };
@@ -85,7 +85,9 @@ TEST_F(TestParameter, TestTypeNameAndLabel)
 TEST(TestParameterValue, TestSet)
 {
     dBToLinPreProcessor pre_processor(-6.0f, 6.0f);
-    auto value = ParameterStorage::make_float_parameter_storage(nullptr, 0.0f, &pre_processor);
+    ParameterBlock block;
+    int index = block.add_parameter(nullptr, 0.0f, &pre_processor);
+    auto value = ParameterStorage::make_parameter_storage(&block, index);
     /* Check correct defaults */
     EXPECT_EQ(ParameterType::FLOAT, value.float_parameter_value()->type());
     EXPECT_FLOAT_EQ(1.0f, value.float_parameter_value()->processed_value());
@@ -95,4 +97,80 @@ TEST(TestParameterValue, TestSet)
     value.float_parameter_value()->set(pre_processor.to_normalized(6.0f));
     EXPECT_NEAR(2.0f, value.float_parameter_value()->processed_value(), 0.01f);
     EXPECT_FLOAT_EQ(6.0f, value.float_parameter_value()->domain_value());
-}
\ No newline at end of file
+}
+
+/* A preprocessor of a kind unknown to ParameterBlock */
+class SquarePreProcessor : public ParameterPreProcessor<float>
+{
+public:
+    SquarePreProcessor(float min, float max): ParameterPreProcessor<float>(min, max, PreProcessorKind::CUSTOM) {}
+
+    float process_to_plugin(float value) override
+    {
+        return value * value;
+    }
+};
+
+TEST(TestParameterPreProcessor, TestExplicitKind)
+{
+    /* Derived preprocessors can not end up linear by default */
+    EXPECT_FALSE((std::is_constructible_v<ParameterPreProcessor<float>, float, float>));
+    EXPECT_TRUE(std::is_final_v<FloatParameterPreProcessor>);
+
+    EXPECT_EQ(PreProcessorKind::LINEAR, FloatParameterPreProcessor(0.0f, 1.0f).kind());
+    EXPECT_EQ(PreProcessorKind::DB_TO_LIN, dBToLinPreProcessor(-12.0f, 12.0f).kind());
+    EXPECT_EQ(PreProcessorKind::CUSTOM, SquarePreProcessor(0.0f, 4.0f).kind());
+}
+
+TEST(TestParameterBlock, TestMixedTypes)
+{
+    FloatParameterPreProcessor linear(-10.0f, 10.0f);
+    LinTodBPreProcessor lin_to_db(0.0f, 10.0f);
+    SquarePreProcessor square(0.0f, 4.0f);
+    IntParameterPreProcessor int_linear(0, 10);
+    ParameterBlock block;
+
+    EXPECT_EQ(0, block.add_parameter(nullptr, 5.0f, &linear));
+    EXPECT_EQ(1, block.add_parameter(nullptr, 1.0f, &lin_to_db));
+    EXPECT_EQ(2, block.add_parameter(nullptr, 2.0f, &square));
+    EXPECT_EQ(3, block.add_parameter(nullptr, 3, &int_linear));
+    EXPECT_EQ(4, block.add_bool_parameter(nullptr, true));
+    ASSERT_EQ(5, block.size());
+
+    EXPECT_EQ(ParameterType::FLOAT, block.type(2));
+    EXPECT_EQ(ParameterType::INT, block.type(3));
+    EXPECT_EQ(ParameterType::BOOL, block.type(4));
+
+    /* Defaults should be mapped exactly as the preprocessors map them */
+    EXPECT_FLOAT_EQ(5.0f, block.processed_value(0));
+    EXPECT_FLOAT_EQ(0.75f, block.normalized_value(0));
+    EXPECT_NEAR(0.0f, block.processed_value(1), test_utils::DECIBEL_ERROR);
+    EXPECT_FLOAT_EQ(4.0f, block.processed_value(2));
+    EXPECT_FLOAT_EQ(3.0f, block.processed_value(3));
+    EXPECT_FLOAT_EQ(1.0f, block.processed_value(4));
+
+    block.set_normalized(0, 0.25f);
+    block.set_normalized(1, 0.2f);
+    block.set_normalized(2, 0.75f);
+    block.set_normalized(3, 0.55f);
+    block.set_normalized(4, 0.0f);
+    EXPECT_FLOAT_EQ(-5.0f, block.processed_value(0));
+    EXPECT_FLOAT_EQ(-5.0f, block.domain_value<float>(0));
+    EXPECT_NEAR(6.02f, block.processed_value(1), test_utils::DECIBEL_ERROR);
+    EXPECT_FLOAT_EQ(2.0f, block.domain_value<float>(1));
+    EXPECT_FLOAT_EQ(9.0f, block.processed_value(2));
+    EXPECT_FLOAT_EQ(3.0f, block.domain_value<float>(2));
+    EXPECT_FLOAT_EQ(5.0f, block.processed_value(3));
+    EXPECT_EQ(5, block.domain_value<int>(3));
+    EXPECT_FLOAT_EQ(0.0f, block.processed_value(4));
+
+    /* Handles should see the same values */
+    IntParameterValue int_value(&block, 3);
+    EXPECT_EQ(5, int_value.processed_value());
+    int_value.set_processed(8.0f);
+    EXPECT_FLOAT_EQ(0.8f, block.normalized_value(3));
+    BoolParameterValue bool_value(&block, 4);
+    EXPECT_FALSE(bool_value.processed_value());
+    bool_value.set(true);
+    EXPECT_TRUE(bool_value.domain_value());
+}
@@ -2,6 +2,7 @@
 #define private public
 
 #include "library/rt_event.h"
+#include "library/rt_event_fifo.h"
 
 using namespace sushi;
 
@@ -151,6 +152,18 @@ TEST (TestRealtimeEvents, TestFactoryFunction)
     EXPECT_EQ(RtEventType::SYNC_MODE, event.type());
     EXPECT_EQ(28, event.sync_mode_event()->sample_offset());
     EXPECT_EQ(SyncMode::MIDI, event.sync_mode_event()->mode());
+
+    event = RtEvent::make_sync_clock_event(29, SyncMode::GATE_INPUT, SyncClockRtEvent::ClockType::TICK, 4);
+    EXPECT_EQ(RtEventType::SYNC_CLOCK, event.type());
+    EXPECT_EQ(29, event.sync_clock_event()->sample_offset());
+    EXPECT_EQ(SyncMode::GATE_INPUT, event.sync_clock_event()->source());
+    EXPECT_EQ(SyncClockRtEvent::ClockType::TICK, event.sync_clock_event()->clock_type());
+    EXPECT_EQ(4, event.sync_clock_event()->ppq_ticks());
+
+    event = RtEvent::make_link_peers_notification_event(30, 2);
+    EXPECT_EQ(RtEventType::LINK_PEERS_NOTIFICATION, event.type());
+    EXPECT_EQ(30, event.link_peers_notification_event()->sample_offset());
+    EXPECT_EQ(2, event.link_peers_notification_event()->peers());
 }
 
 TEST(TestRealtimeEvents, TestReturnableEvents)
@@ -178,3 +191,16 @@ TEST(TestRealtimeEvents, TestIsKeyboardEvent)
     EXPECT_TRUE(is_keyboard_event(event));
 }
 
+TEST(TestRealtimeEvents, TestFifoFailedPushes)
+{
+    RtSafeRtEventFifo fifo;
+    int pushed = 0;
+    while (fifo.push(RtEvent::make_stop_engine_event()))
+    {
+        ++pushed;
+    }
+    EXPECT_GT(pushed, 0);
+    EXPECT_EQ(1u, fifo.failed_pushes());
+    fifo.send_event(RtEvent::make_stop_engine_event());
+    EXPECT_EQ(2u, fifo.failed_pushes());
+}
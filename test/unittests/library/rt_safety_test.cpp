@@ -0,0 +1,133 @@
+#include <mutex>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "twine/twine.h"
+#include "library/rt_safety.cpp"
+
+using namespace sushi;
+using namespace sushi::rt_safety;
+
+#ifdef SUSHI_BUILD_WITH_RT_SAFETY_CHECKS
+
+namespace {
+void fail_test_on_violation(ViolationType type, ObjectId processor_id)
+{
+    ADD_FAILURE() << "RT safety violation: " << to_string(type) << " in processor " << processor_id;
+}
+
+/* Make every test in the suite fail on any RT safety violation while the tests run */
+class RtSafetyEnvironment : public ::testing::Environment
+{
+public:
+    void SetUp() override
+    {
+        _previous_handler = set_violation_handler(fail_test_on_violation);
+    }
+
+    void TearDown() override
+    {
+        set_violation_handler(_previous_handler);
+    }
+
+private:
+    ViolationHandler _previous_handler;
+};
+
+[[maybe_unused]] ::testing::Environment* const rt_safety_environment =
+        ::testing::AddGlobalTestEnvironment(new RtSafetyEnvironment);
+
+int recorded_violations = 0;
+ViolationType recorded_type;
+ObjectId recorded_processor;
+
+void record_violation(ViolationType type, ObjectId processor_id)
+{
+    recorded_violations++;
+    recorded_type = type;
+    recorded_processor = processor_id;
+}
+
+/* Keep the compiler from optimising away allocations */
+void* volatile sink;
+}
+
+class TestRtSafety : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        recorded_violations = 0;
+        _previous_handler = set_violation_handler(record_violation);
+    }
+
+    void TearDown()
+    {
+        set_violation_handler(_previous_handler);
+    }
+
+    ViolationHandler _previous_handler;
+};
+
+TEST_F(TestRtSafety, TestNoViolationsOutsideRtThread)
+{
+    auto string = new std::string(100, 'a');
+    sink = string;
+    delete string;
+    std::mutex mutex;
+    mutex.lock();
+    mutex.unlock();
+    EXPECT_EQ(0, recorded_violations);
+}
+
+TEST_F(TestRtSafety, TestAllocationIsDetected)
+{
+    twine::ThreadRtFlag rt_flag;
+    {
+        ScopedProcessorMarker marker(12);
+        sink = std::malloc(128);
+        EXPECT_EQ(1, recorded_violations);
+        EXPECT_EQ(ViolationType::ALLOCATION, recorded_type);
+        EXPECT_EQ(12u, recorded_processor);
+    }
+    std::free(sink);
+    EXPECT_EQ(2, recorded_violations);
+    EXPECT_EQ(ViolationType::DEALLOCATION, recorded_type);
+    EXPECT_EQ(NO_PROCESSOR, recorded_processor);
+}
+
+TEST_F(TestRtSafety, TestLockIsDetected)
+{
+    std::mutex mutex;
+    twine::ThreadRtFlag rt_flag;
+    ScopedProcessorMarker outer_marker(1);
+    {
+        ScopedProcessorMarker inner_marker(2);
+    }
+    mutex.lock();
+    mutex.unlock();
+    EXPECT_EQ(1, recorded_violations);
+    EXPECT_EQ(ViolationType::LOCK, recorded_type);
+    EXPECT_EQ(1u, recorded_processor);
+}
+
+TEST_F(TestRtSafety, TestSuspend)
+{
+    twine::ThreadRtFlag rt_flag;
+    ScopedSuspend suspend;
+    auto string = new std::string(100, 'a');
+    sink = string;
+    delete string;
+    EXPECT_EQ(0, recorded_violations);
+}
+
+#else
+
+TEST(TestRtSafety, TestDisabledChecks)
+{
+    ScopedProcessorMarker marker(12);
+    EXPECT_EQ(NO_PROCESSOR, current_processor());
+    EXPECT_EQ(0, violation_count());
+}
+
+#endif
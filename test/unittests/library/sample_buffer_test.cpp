@@ -396,4 +396,32 @@ TEST (TestSampleBuffer, TestCountClippedSamples)
     ASSERT_EQ(3, buffer.count_clipped_samples(0,2));
     ASSERT_EQ(2, buffer.count_clipped_samples(1,1));
     ASSERT_EQ(1, buffer.count_clipped_samples(0,1));
-}
\ No newline at end of file
+}
+
+TEST (TestSampleBuffer, TestRuntimeChunkSize)
+{
+    constexpr int SMALL_CHUNK_SIZE = AUDIO_CHUNK_SIZE / 2;
+    test_utils::AudioChunkSizeGuard chunk_size_guard;
+    ASSERT_FALSE(set_audio_chunk_size(AUDIO_CHUNK_SIZE * 2));
+    ASSERT_FALSE(set_audio_chunk_size(SMALL_CHUNK_SIZE + 1));
+    ASSERT_TRUE(set_audio_chunk_size(SMALL_CHUNK_SIZE));
+
+    SampleBuffer<AUDIO_CHUNK_SIZE> buffer(2);
+    SampleBuffer<AUDIO_CHUNK_SIZE> mono_buffer(1);
+    EXPECT_EQ(SMALL_CHUNK_SIZE, buffer.frame_count());
+    EXPECT_EQ(buffer.channel(0) + SMALL_CHUNK_SIZE, buffer.channel(1));
+
+    test_utils::fill_sample_buffer(buffer, 1.0f);
+    test_utils::fill_sample_buffer(mono_buffer, 0.5f);
+    buffer.add_with_gain(mono_buffer, 2.0f);
+    test_utils::assert_buffer_value(2.0f, buffer);
+
+    buffer.ramp(0.0f, 1.0f);
+    EXPECT_FLOAT_EQ(0.0f, buffer.channel(1)[0]);
+    EXPECT_FLOAT_EQ(2.0f, buffer.channel(1)[SMALL_CHUNK_SIZE - 1]);
+
+    // Non-owning buffers inherit the chunk size of the buffer they wrap
+    auto right = SampleBuffer<AUDIO_CHUNK_SIZE>::create_non_owning_buffer(buffer, 1, 1);
+    EXPECT_EQ(SMALL_CHUNK_SIZE, right.frame_count());
+    EXPECT_EQ(buffer.channel(1), right.channel(0));
+}
@@ -0,0 +1,75 @@
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "library/shared_instance_cache.h"
+
+using namespace sushi;
+
+struct CountedInstance
+{
+    explicit CountedInstance(const std::string& name, int& count) : name(name), count(count) {count++;}
+    ~CountedInstance() {count--;}
+
+    std::string name;
+    int& count;
+};
+
+class TestSharedInstanceCache : public ::testing::Test
+{
+protected:
+    TestSharedInstanceCache() {}
+
+    std::shared_ptr<CountedInstance> _get(const std::string& key)
+    {
+        return _module_under_test.get(key, [&]()
+        {
+            _created++;
+            return std::make_shared<CountedInstance>(key, _alive);
+        });
+    }
+
+    SharedInstanceCache<std::string, CountedInstance> _module_under_test;
+    int _created{0};
+    int _alive{0};
+};
+
+TEST_F(TestSharedInstanceCache, TestSharing)
+{
+    auto instance = _get("a");
+    auto same_instance = _get("a");
+    auto other_instance = _get("b");
+    ASSERT_TRUE(instance);
+    EXPECT_EQ(instance, same_instance);
+    EXPECT_NE(instance, other_instance);
+    EXPECT_EQ("b", other_instance->name);
+    EXPECT_EQ(2, _created);
+    EXPECT_EQ(2, _module_under_test.size());
+}
+
+TEST_F(TestSharedInstanceCache, TestRelease)
+{
+    auto instance = _get("a");
+    auto same_instance = _get("a");
+    instance.reset();
+    EXPECT_EQ(1, _alive);
+
+    /* The object should be destroyed with the last user and created again on the next request */
+    same_instance.reset();
+    EXPECT_EQ(0, _alive);
+    EXPECT_EQ(0, _module_under_test.size());
+    instance = _get("a");
+    EXPECT_EQ(2, _created);
+    EXPECT_EQ(1, _alive);
+}
+
+TEST_F(TestSharedInstanceCache, TestFailedCreation)
+{
+    auto instance = _module_under_test.get("a", []() {return std::shared_ptr<CountedInstance>();});
+    EXPECT_FALSE(instance);
+    EXPECT_EQ(0, _module_under_test.size());
+
+    /* A failed creation should not be cached */
+    instance = _get("a");
+    EXPECT_TRUE(instance);
+}
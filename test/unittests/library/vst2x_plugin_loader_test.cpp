@@ -38,3 +38,26 @@ TEST_F(TestVst2xPluginLoader, TestLoadPlugin)
     PluginLoader::close_library_handle(library_handle);
 }
 
+TEST_F(TestVst2xPluginLoader, TestSharedLibrary)
+{
+    char* full_again_path = realpath("libvst2_test_plugin.so", NULL);
+    auto library_handle = PluginLoader::get_library_handle_for_plugin(full_again_path);
+    auto other_library_handle = PluginLoader::get_library_handle_for_plugin(full_again_path);
+    free(full_again_path);
+    ASSERT_NE(nullptr, library_handle);
+
+    // All instances of a plugin should share the same library
+    EXPECT_EQ(library_handle, other_library_handle);
+    auto plugin = PluginLoader::load_plugin(library_handle);
+    auto other_plugin = PluginLoader::load_plugin(other_library_handle);
+    ASSERT_NE(nullptr, plugin);
+    ASSERT_NE(nullptr, other_plugin);
+    EXPECT_NE(plugin, other_plugin);
+
+    plugin->dispatcher(plugin, effClose, 0, 0, nullptr, 0.0f);
+    other_plugin->dispatcher(other_plugin, effClose, 0, 0, nullptr, 0.0f);
+    PluginLoader::close_library_handle(library_handle);
+    EXPECT_EQ(nullptr, library_handle);
+    EXPECT_NE(nullptr, other_library_handle);
+    PluginLoader::close_library_handle(other_library_handle);
+}
@@ -110,7 +110,7 @@ TEST_F(TestVst2xWrapper, TestParameterSetViaEvent)
     SetUp("libvst2_test_plugin.so");
     auto event = RtEvent::make_parameter_change_event(0, 0, 0, 0.123f);
     _module_under_test->process_event(event);
-    auto handle = _module_under_test->_plugin_handle;
+    auto handle = _module_under_test->_plugin_handle.load();
     EXPECT_EQ(0.123f, handle->getParameter(handle, 0));
 }
 
@@ -286,3 +286,60 @@ TEST_F(TestVst2xWrapper, TestProgramManagement)
     ASSERT_EQ("Program 2", programs[1]);
     ASSERT_EQ(3u, programs.size());
 }
+
+TEST_F(TestVst2xWrapper, TestProgramChangeCrossfade)
+{
+    SetUp("libvst2_test_plugin.so");
+    RtSafeRtEventFifo queue;
+    _module_under_test->set_event_output(&queue);
+    ChunkSampleBuffer in_buffer(2);
+    ChunkSampleBuffer out_buffer(2);
+    test_utils::fill_sample_buffer(in_buffer, 1.0f);
+
+    // Parameter values set by the host should carry over to the new instance
+    _module_under_test->process_event(RtEvent::make_parameter_change_event(0, 0, 0, 0.5f));
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(0.5f, out_buffer);
+
+    ASSERT_EQ(ProcessorReturnCode::OK, _module_under_test->set_program(2));
+    EXPECT_EQ(2, _module_under_test->current_program());
+    EXPECT_EQ("Program 3", _module_under_test->current_program_name());
+
+    // The output should be crossfaded from the old to the new instance without dropping out
+    for (int i = 0; i < chunks_to_ramp(TEST_SAMPLE_RATE); ++i)
+    {
+        _module_under_test->process_audio(in_buffer, out_buffer);
+        test_utils::assert_buffer_value(0.5f, out_buffer, 1.0e-6f);
+    }
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(0.5f, out_buffer);
+    EXPECT_FLOAT_EQ(0.5f, _module_under_test->parameter_value(0).second);
+    EXPECT_EQ(2, _module_under_test->_vst_dispatcher(effGetProgram, 0, 0, nullptr, 0));
+
+    // The old instance should be handed over to a worker to be closed
+    RtEvent event;
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_EQ(RtEventType::ASYNC_WORK, event.type());
+    auto typed_event = event.async_work_event();
+    typed_event->callback()(typed_event->callback_data(), 0);
+    EXPECT_EQ(nullptr, _module_under_test->_retired_plugin_handle.load());
+    EXPECT_EQ(nullptr, _module_under_test->_fading_plugin_handle);
+}
+
+TEST_F(TestVst2xWrapper, TestParameterChangeDuringProgramChange)
+{
+    SetUp("libvst2_test_plugin.so");
+    ChunkSampleBuffer in_buffer(2);
+    ChunkSampleBuffer out_buffer(2);
+    _module_under_test->process_audio(in_buffer, out_buffer);
+
+    // A parameter change sent after the program change should not be lost when the new instance is swapped in
+    ASSERT_EQ(ProcessorReturnCode::OK, _module_under_test->set_program(1));
+    _module_under_test->process_event(RtEvent::make_parameter_change_event(0, 0, 0, 0.25f));
+    _module_under_test->process_audio(in_buffer, out_buffer);
+
+    auto handle = _module_under_test->_plugin_handle.load();
+    ASSERT_NE(nullptr, _module_under_test->_fading_plugin_handle);
+    EXPECT_EQ(0.25f, handle->getParameter(handle, 0));
+    EXPECT_TRUE(std::isnan(_module_under_test->_parameters_during_swap[0]));
+}
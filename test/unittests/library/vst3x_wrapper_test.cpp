@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include "test_utils/test_utils.h"
+#include "test_utils/allocation_counter.h"
 #include "library/rt_event_fifo.h"
 #include "library/vst3x_utils.cpp"
 #include "test_utils/host_control_mockup.h"
@@ -129,6 +130,100 @@ TEST_F(TestVst3xWrapper, TestProcessing)
     EXPECT_FLOAT_EQ(1.0f, out_buffer.channel(1)[1]);
 }
 
+TEST_F(TestVst3xWrapper, TestProcessingDoesNotAllocate)
+{
+    SetUp(PLUGIN_FILE, PLUGIN_NAME);
+    ChunkSampleBuffer in_buffer(2);
+    ChunkSampleBuffer out_buffer(2);
+    test_utils::fill_sample_buffer(in_buffer, 1);
+    auto note_on = RtEvent::make_note_on_event(0, 5, 0, 48, 1.0f);
+    auto note_off = RtEvent::make_note_off_event(0, 10, 0, 48, 1.0f);
+
+    /* Run once first so that any lazy initialisation in the plugin is done */
+    _module_under_test->process_audio(in_buffer, out_buffer);
+
+    test_utils::AllocationCounter counter;
+    for (int i = 0; i < 10; ++i)
+    {
+        /* Use different offsets and parameter ids to force new queues and points */
+        _module_under_test->process_event(RtEvent::make_parameter_change_event(0u, i, DELAY_PARAM_ID, 0.1f * i));
+        _module_under_test->process_event(RtEvent::make_parameter_change_event(0u, i + 1, DELAY_PARAM_ID, 0.2f));
+        _module_under_test->process_event(RtEvent::make_parameter_change_event(0u, i, BYPASS_PARAM_ID, 0.0f));
+        _module_under_test->process_event(note_on);
+        _module_under_test->process_event(note_off);
+        _module_under_test->process_audio(in_buffer, out_buffer);
+    }
+    EXPECT_EQ(0, counter.allocations());
+}
+
+TEST(TestVst3xUtils, TestParameterChanges)
+{
+    SushiParameterChanges module_under_test;
+    module_under_test.set_max_parameters(2);
+    EXPECT_EQ(0, module_under_test.getParameterCount());
+
+    Steinberg::int32 index;
+    auto queue = module_under_test.addParameterData(10, index);
+    ASSERT_TRUE(queue);
+    EXPECT_EQ(0, index);
+    EXPECT_EQ(queue, module_under_test.addParameterData(10, index));
+    ASSERT_TRUE(module_under_test.addParameterData(11, index));
+    EXPECT_EQ(1, index);
+    /* Full */
+    EXPECT_FALSE(module_under_test.addParameterData(12, index));
+    EXPECT_EQ(2, module_under_test.getParameterCount());
+
+    /* Points should be sorted on offset and replaced if the offset already exists */
+    EXPECT_EQ(Steinberg::kResultOk, queue->addPoint(8, 0.5, index));
+    EXPECT_EQ(Steinberg::kResultOk, queue->addPoint(2, 0.25, index));
+    EXPECT_EQ(0, index);
+    EXPECT_EQ(Steinberg::kResultOk, queue->addPoint(8, 0.75, index));
+    EXPECT_EQ(1, index);
+    ASSERT_EQ(2, queue->getPointCount());
+    Steinberg::int32 offset;
+    Steinberg::Vst::ParamValue value;
+    ASSERT_EQ(Steinberg::kResultOk, queue->getPoint(0, offset, value));
+    EXPECT_EQ(2, offset);
+    EXPECT_DOUBLE_EQ(0.25, value);
+    ASSERT_EQ(Steinberg::kResultOk, queue->getPoint(1, offset, value));
+    EXPECT_EQ(8, offset);
+    EXPECT_DOUBLE_EQ(0.75, value);
+    EXPECT_NE(Steinberg::kResultOk, queue->getPoint(2, offset, value));
+
+    for (int i = 0; i < VST_WRAPPER_PARAMETER_QUEUE_SIZE; ++i)
+    {
+        queue->addPoint(10 + i, 0.0, index);
+    }
+    EXPECT_EQ(VST_WRAPPER_PARAMETER_QUEUE_SIZE, queue->getPointCount());
+
+    module_under_test.clear();
+    EXPECT_EQ(0, module_under_test.getParameterCount());
+    EXPECT_FALSE(module_under_test.getParameterData(0));
+    queue = module_under_test.addParameterData(12, index);
+    ASSERT_TRUE(queue);
+    EXPECT_EQ(12u, queue->getParameterId());
+    EXPECT_EQ(0, queue->getPointCount());
+}
+
+TEST(TestVst3xUtils, TestEventList)
+{
+    SushiEventList module_under_test(2);
+    Steinberg::Vst::Event event{};
+    event.sampleOffset = 3;
+    EXPECT_EQ(Steinberg::kResultOk, module_under_test.addEvent(event));
+    EXPECT_EQ(Steinberg::kResultOk, module_under_test.addEvent(event));
+    EXPECT_NE(Steinberg::kResultOk, module_under_test.addEvent(event));
+    ASSERT_EQ(2, module_under_test.getEventCount());
+
+    Steinberg::Vst::Event result;
+    ASSERT_EQ(Steinberg::kResultOk, module_under_test.getEvent(1, result));
+    EXPECT_EQ(3, result.sampleOffset);
+    EXPECT_NE(Steinberg::kResultOk, module_under_test.getEvent(2, result));
+
+    module_under_test.clear();
+    EXPECT_EQ(0, module_under_test.getEventCount());
+}
+
 TEST_F(TestVst3xWrapper, TestBypassProcessing)
 {
     SetUp(PLUGIN_FILE, PLUGIN_NAME);
@@ -120,6 +120,49 @@ TEST_F(TestGainPlugin, TestProcess)
     test_utils::assert_buffer_value(2.0f, out_buffer, test_utils::DECIBEL_ERROR);
 }
 
+TEST_F(TestGainPlugin, TestProcessWithCvSignal)
+{
+    SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(2);
+    SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(2);
+    SampleBuffer<AUDIO_CHUNK_SIZE> cv_buffer(1);
+    test_utils::fill_sample_buffer(in_buffer, 1.0f);
+    test_utils::fill_sample_buffer(cv_buffer, 0.875f);
+    _module_under_test->set_input_channels(2);
+    _module_under_test->set_output_channels(2);
+    ObjectId gain_id = _module_under_test->_gain_parameter->descriptor()->id();
+    ASSERT_TRUE(_module_under_test->supports_cv_signal(gain_id));
+
+    _module_under_test->set_cv_signal(gain_id, cv_buffer.channel(0));
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(2.0f, out_buffer, test_utils::DECIBEL_ERROR);
+
+    /* The signal is only valid for one chunk, after that the parameter value is used */
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(1.0f, out_buffer, test_utils::DECIBEL_ERROR);
+}
+
+TEST_F(TestGainPlugin, TestCvSignalChannelsAndBypass)
+{
+    SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(1);
+    SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(2);
+    SampleBuffer<AUDIO_CHUNK_SIZE> cv_buffer(1);
+    test_utils::fill_sample_buffer(in_buffer, 1.0f);
+    test_utils::fill_sample_buffer(cv_buffer, 0.875f);
+    ObjectId gain_id = _module_under_test->_gain_parameter->descriptor()->id();
+
+    /* A mono input is sent to all output channels */
+    _module_under_test->set_cv_signal(gain_id, cv_buffer.channel(0));
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(2.0f, out_buffer, test_utils::DECIBEL_ERROR);
+
+    /* Bypassing drops the cv signal */
+    _module_under_test->set_cv_signal(gain_id, cv_buffer.channel(0));
+    _module_under_test->set_bypassed(true);
+    _module_under_test->set_bypassed(false);
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    test_utils::assert_buffer_value(1.0f, out_buffer, test_utils::DECIBEL_ERROR);
+}
+
 class TestEqualizerPlugin : public ::testing::Test
 {
 protected:
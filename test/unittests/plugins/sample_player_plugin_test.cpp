@@ -1,3 +1,7 @@
+#include <cstdlib>
+
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 
 #include "test_utils/test_utils.h"
@@ -6,6 +10,7 @@
 
 #define private public
 
+#include "plugins/sample_player_stream.cpp"
 #include "plugins/sample_player_voice.cpp"
 #include "plugins/sample_player_plugin.cpp"
 
@@ -19,6 +24,65 @@ const int SAMPLE_DATA_LENGTH = sizeof(SAMPLE_DATA) / sizeof(float);
 
 static const std::string SAMPLE_FILE = "Kawai-K11-GrPiano-C4_mono.wav";
 
+/* Sample where every frame has its own index as value */
+class RampReader : public SampleReader
+{
+public:
+    explicit RampReader(int64_t frames) : _frames(frames) {}
+
+    int64_t read(int64_t start_frame, float* destination, int64_t frames) override
+    {
+        int64_t count = std::max<int64_t>(0, std::min(frames, _frames - start_frame));
+        for (int64_t i = 0; i < count; ++i)
+        {
+            destination[i] = static_cast<float>(start_frame + i);
+        }
+        return count;
+    }
+
+private:
+    int64_t _frames;
+};
+
+SampleData* make_streamed_ramp(int64_t head_frames, int64_t frames)
+{
+    auto reader = std::make_unique<RampReader>(frames);
+    std::vector<float> head(head_frames + GUARD_FRAMES);
+    reader->read(0, head.data(), head.size());
+    return new SampleData(std::move(head), frames, std::move(reader));
+}
+
+/* Write a mono wav file with 32 bit float samples to a new temporary file */
+std::string write_float_wav(const std::vector<float>& frames)
+{
+    char path[] = "/tmp/sushi_sample_XXXXXX";
+    int fd = mkstemp(path);
+    auto data_size = static_cast<uint32_t>(frames.size() * sizeof(float));
+    auto write_le = [&](uint32_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+        {
+            uint8_t byte = static_cast<uint8_t>(value >> (i * 8));
+            EXPECT_EQ(1, write(fd, &byte, 1));
+        }
+    };
+    EXPECT_EQ(4, write(fd, "RIFF", 4));
+    write_le(36 + data_size, 4);
+    EXPECT_EQ(8, write(fd, "WAVEfmt ", 8));
+    write_le(16, 4);
+    write_le(3, 2);                  // IEEE float
+    write_le(1, 2);                  // Channels
+    write_le(44100, 4);
+    write_le(44100 * sizeof(float), 4);
+    write_le(sizeof(float), 2);
+    write_le(32, 2);
+    EXPECT_EQ(4, write(fd, "data", 4));
+    write_le(data_size, 4);
+    EXPECT_EQ(data_size, write(fd, frames.data(), data_size));
+    close(fd);
+    return path;
+}
+
 
 /* Test the Voice class */
 class TestSamplerVoice : public ::testing::Test
@@ -37,7 +101,7 @@ protected:
     void TearDown()
     {
     }
-    dsp::Sample _sample{SAMPLE_DATA, SAMPLE_DATA_LENGTH};
+    SampleData _sample{std::vector<float>(SAMPLE_DATA, SAMPLE_DATA + SAMPLE_DATA_LENGTH)};
     Voice _module_under_test;
 };
 
@@ -85,6 +149,154 @@ TEST_F(TestSamplerVoice, TestNoteOff)
     EXPECT_FLOAT_EQ(0.0f, buf[4]);
 }
 
+TEST_F(TestSamplerVoice, TestSampleEnd)
+{
+    sushi::SampleBuffer<AUDIO_CHUNK_SIZE> buffer(1);
+    buffer.clear();
+
+    _module_under_test.note_on(60, 1.0f, 0);
+    _module_under_test.render(buffer);
+    EXPECT_FLOAT_EQ(1.0f, buffer.channel(0)[4]);
+    EXPECT_FLOAT_EQ(0.0f, buffer.channel(0)[5]);
+    /* The voice should stop by itself when there is no more sample data to play */
+    EXPECT_FALSE(_module_under_test.active());
+}
+
+TEST_F(TestSamplerVoice, TestStreaming)
+{
+    constexpr int64_t HEAD_FRAMES = 16;
+    constexpr int64_t FRAMES = HEAD_FRAMES + 3 * SampleStream::PAGE_FRAMES + 100;
+    std::unique_ptr<SampleData> sample(make_streamed_ramp(HEAD_FRAMES, FRAMES));
+    _module_under_test.stream().allocate();
+    _module_under_test.set_sample(sample.get());
+    sushi::SampleBuffer<AUDIO_CHUNK_SIZE> buffer(1);
+    buffer.clear();
+
+    _module_under_test.note_on(60, 1.0f, 0);
+    EXPECT_TRUE(_module_under_test.stream().needs_data());
+    _module_under_test.render(buffer);
+
+    /* Only the head should be played, the rest is silent until the stream is filled */
+    float* buf = buffer.channel(0);
+    EXPECT_FLOAT_EQ(15.0f, buf[15]);
+    EXPECT_FLOAT_EQ(0.0f, buf[16]);
+    EXPECT_FLOAT_EQ(0.0f, buf[AUDIO_CHUNK_SIZE - 1]);
+
+    int64_t position = AUDIO_CHUNK_SIZE;
+    while (position + AUDIO_CHUNK_SIZE <= FRAMES)
+    {
+        _module_under_test.stream().fill();
+        buffer.clear();
+        _module_under_test.render(buffer);
+        for (int i = 0; i < AUDIO_CHUNK_SIZE; ++i)
+        {
+            ASSERT_FLOAT_EQ(static_cast<float>(position + i), buf[i]);
+        }
+        position += AUDIO_CHUNK_SIZE;
+    }
+    _module_under_test.stream().fill();
+    buffer.clear();
+    _module_under_test.render(buffer);
+    EXPECT_FLOAT_EQ(static_cast<float>(FRAMES - 1), buf[FRAMES - position - 1]);
+    EXPECT_FLOAT_EQ(0.0f, buf[FRAMES - position]);
+    EXPECT_FALSE(_module_under_test.active());
+    EXPECT_FALSE(_module_under_test.stream().needs_data());
+}
+
+TEST_F(TestSamplerVoice, TestStreamRestart)
+{
+    constexpr int64_t HEAD_FRAMES = 16;
+    std::unique_ptr<SampleData> sample(make_streamed_ramp(HEAD_FRAMES, 20 * SampleStream::PAGE_FRAMES));
+    _module_under_test.stream().allocate();
+    _module_under_test.set_sample(sample.get());
+    sushi::SampleBuffer<AUDIO_CHUNK_SIZE> buffer(1);
+    float* buf = buffer.channel(0);
+
+    _module_under_test.note_on(60, 1.0f, 0);
+    for (int i = 0; i < 100; ++i)
+    {
+        _module_under_test.stream().fill();
+        buffer.clear();
+        _module_under_test.render(buffer);
+    }
+    EXPECT_FLOAT_EQ(static_cast<float>(100 * AUDIO_CHUNK_SIZE - 1), buf[AUDIO_CHUNK_SIZE - 1]);
+
+    /* Restarting the note should not play any pages from the previous stream once
+     * the old note has faded out */
+    _module_under_test.note_on(60, 1.0f, 0);
+    int start = _module_under_test._steal_fade_frames;
+    for (; start >= AUDIO_CHUNK_SIZE; start -= AUDIO_CHUNK_SIZE)
+    {
+        buffer.clear();
+        _module_under_test.render(buffer);
+    }
+    ASSERT_LT(start + HEAD_FRAMES, AUDIO_CHUNK_SIZE);
+    buffer.clear();
+    _module_under_test.render(buffer);
+    EXPECT_FLOAT_EQ(15.0f, buf[start + 15]);
+    EXPECT_FLOAT_EQ(0.0f, buf[start + 16]);
+
+    _module_under_test.stream().fill();
+    buffer.clear();
+    _module_under_test.render(buffer);
+    EXPECT_FLOAT_EQ(static_cast<float>(AUDIO_CHUNK_SIZE - start), buf[0]);
+}
+
+TEST_F(TestSamplerVoice, TestUnallocatedStream)
+{
+    /* Without allocated pages only the head of a streamed sample is played */
+    std::unique_ptr<SampleData> sample(make_streamed_ramp(16, 4 * SampleStream::PAGE_FRAMES));
+    EXPECT_EQ(nullptr, _module_under_test.stream()._pages);
+    _module_under_test.set_sample(sample.get());
+    sushi::SampleBuffer<AUDIO_CHUNK_SIZE> buffer(1);
+    buffer.clear();
+
+    _module_under_test.note_on(60, 1.0f, 0);
+    EXPECT_FALSE(_module_under_test.stream().needs_data());
+    _module_under_test.render(buffer);
+    EXPECT_FLOAT_EQ(15.0f, buffer.channel(0)[15]);
+    EXPECT_FLOAT_EQ(0.0f, buffer.channel(0)[16]);
+}
+
+TEST_F(TestSamplerVoice, TestStealFade)
+{
+    SampleData sample(std::vector<float>(10000, 1.0f));
+    _module_under_test.set_sample(&sample);
+    sushi::SampleBuffer<AUDIO_CHUNK_SIZE> buffer(1);
+    float* buf = buffer.channel(0);
+    int fade_frames = _module_under_test._steal_fade_frames;
+    ASSERT_GT(fade_frames, 1);
+
+    _module_under_test.note_on(60, 1.0f, 0);
+    buffer.clear();
+    _module_under_test.render(buffer);
+    test_utils::assert_buffer_value(1.0f, buffer);
+
+    /* Restarting the voice should fade out the old note instead of cutting it off */
+    _module_under_test.note_on(62, 0.5f, 10);
+    EXPECT_EQ(62, _module_under_test.current_note());
+    std::vector<float> output;
+    for (int i = 0; i < fade_frames / AUDIO_CHUNK_SIZE + 2; ++i)
+    {
+        buffer.clear();
+        _module_under_test.render(buffer);
+        output.insert(output.end(), buf, buf + AUDIO_CHUNK_SIZE);
+    }
+    EXPECT_FLOAT_EQ(1.0f, output[9]);
+    for (int i = 10; i < 10 + fade_frames; ++i)
+    {
+        ASSERT_LE(output[i], output[i - 1]);
+        ASSERT_GT(output[i], 0.0f);
+    }
+    EXPECT_LT(output[9 + fade_frames], 2.0f / fade_frames);
+
+    /* And then start the new note with its own velocity */
+    EXPECT_FLOAT_EQ(0.25f, output[10 + fade_frames]);
+    EXPECT_FLOAT_EQ(0.25f, output.back());
+    EXPECT_TRUE(_module_under_test.active());
+    EXPECT_FALSE(_module_under_test.stopping());
+}
+
 
 /* Test the Plugin */
 class TestSamplePlayerPlugin : public ::testing::Test
@@ -115,7 +327,9 @@ TEST_F(TestSamplePlayerPlugin, TestSampleLoading)
     std::string* path = new std::string(test_utils::get_data_dir_path());
     path->append(SAMPLE_FILE);
     auto sample_ev = RtEvent::make_string_parameter_change_event(0,0,5,path);
-    ASSERT_EQ(nullptr, _module_under_test->_sample_buffer);
+    ASSERT_EQ(nullptr, _module_under_test->_sample_data);
+    auto old_sample = new SampleData(std::vector<float>(SAMPLE_DATA, SAMPLE_DATA + SAMPLE_DATA_LENGTH));
+    _module_under_test->_set_sample(old_sample);
     _module_under_test->process_event(sample_ev);
 
     /* Simulate an event dispatcher receieving the event and calling the non-rt callback */
@@ -131,17 +345,126 @@ TEST_F(TestSamplePlayerPlugin, TestSampleLoading)
     _module_under_test->process_event(completion_event);
 
     /* Sample should now be changed */
-    ASSERT_NE(nullptr, _module_under_test->_sample_buffer);
+    ASSERT_NE(nullptr, _module_under_test->_sample_data);
+    ASSERT_NE(old_sample, _module_under_test->_sample_data);
+
+    /* Plugin should have put an event on the output queue to delete the old sample */
+    ASSERT_TRUE(queue.pop(async_event));
+    typed_event = async_event.async_work_event();
+    ASSERT_EQ(old_sample, typed_event->callback_data());
+    typed_event->callback()(typed_event->callback_data(), typed_event->event_id());
+}
+
+TEST_F(TestSamplePlayerPlugin, TestMappedLoading)
+{
+    std::vector<float> frames(3000);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i] = static_cast<float>(i);
+    }
+    auto path = write_float_wav(frames);
+    std::unique_ptr<SampleData> sample(_module_under_test->load_sample_file(path));
+    ASSERT_TRUE(sample);
+    EXPECT_FALSE(sample->streamed());
+    ASSERT_EQ(3000, sample->frames());
+    ASSERT_EQ(3000, sample->head_frames());
+    EXPECT_FLOAT_EQ(1234.0f, sample->head()[1234]);
+    EXPECT_FLOAT_EQ(0.0f, sample->head()[3000]);
+    EXPECT_FLOAT_EQ(0.0f, sample->head()[3001]);
 
-    /* Plugin should have put a delete event on the output queue, just check that it's there */
-    ASSERT_FALSE(queue.empty());
+    /* Loading the same file again should share the data instead of copying it */
+    std::unique_ptr<SampleData> other_sample(_module_under_test->load_sample_file(path));
+    ASSERT_TRUE(other_sample);
+    EXPECT_EQ(sample->head(), other_sample->head());
+    unlink(path.c_str());
+}
+
+TEST_F(TestSamplePlayerPlugin, TestMappedStreaming)
+{
+    std::vector<float> frames(STREAMING_HEAD_FRAMES + 5000);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i] = static_cast<float>(i);
+    }
+    auto path = write_float_wav(frames);
+    std::unique_ptr<SampleData> sample(_module_under_test->load_sample_file(path));
+    unlink(path.c_str());
+    ASSERT_TRUE(sample);
+    ASSERT_TRUE(sample->streamed());
+    ASSERT_EQ(STREAMING_HEAD_FRAMES, sample->head_frames());
+    EXPECT_FLOAT_EQ(static_cast<float>(STREAMING_HEAD_FRAMES + 1), sample->head()[STREAMING_HEAD_FRAMES + 1]);
+
+    /* The reader should stop at the end of the sample */
+    std::vector<float> buffer(100);
+    ASSERT_EQ(100, sample->reader()->read(STREAMING_HEAD_FRAMES + 10, buffer.data(), 100));
+    EXPECT_FLOAT_EQ(static_cast<float>(STREAMING_HEAD_FRAMES + 10), buffer[0]);
+    EXPECT_FLOAT_EQ(static_cast<float>(STREAMING_HEAD_FRAMES + 109), buffer[99]);
+    EXPECT_EQ(50, sample->reader()->read(sample->frames() - 50, buffer.data(), 100));
+    EXPECT_EQ(0, sample->reader()->read(sample->frames(), buffer.data(), 100));
+}
+
+TEST_F(TestSamplePlayerPlugin, TestMappedStreamingTruncated)
+{
+    std::vector<float> frames(STREAMING_HEAD_FRAMES + 5000, 1.0f);
+    auto path = write_float_wav(frames);
+    std::unique_ptr<SampleData> sample(_module_under_test->load_sample_file(path));
+    ASSERT_TRUE(sample);
+    ASSERT_TRUE(sample->streamed());
+
+    /* Frames past the end of a file truncated while loaded are not read */
+    ASSERT_EQ(0, truncate(path.c_str(), 1024));
+    unlink(path.c_str());
+    std::vector<float> buffer(100);
+    EXPECT_EQ(0, sample->reader()->read(STREAMING_HEAD_FRAMES + 10, buffer.data(), 100));
+}
+
+TEST_F(TestSamplePlayerPlugin, TestMappedLoadingWithoutLock)
+{
+    std::vector<float> frames(STREAMING_HEAD_FRAMES + 5000);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i] = static_cast<float>(i);
+    }
+    auto path = write_float_wav(frames);
+    auto blob = MappedBlob::map(path);
+    unlink(path.c_str());
+    ASSERT_TRUE(blob);
+    const float* frames_start;
+    int64_t frame_count;
+    ASSERT_TRUE(find_float_frames(path, *blob, frames_start, frame_count));
+
+    /* If the head can't be locked it should be copied, and the rest streamed from the mapping */
+    std::unique_ptr<SampleData> sample(create_mapped_sample(blob, frames_start, frame_count, false));
+    blob.reset();
+    ASSERT_TRUE(sample);
+    ASSERT_TRUE(sample->streamed());
+    EXPECT_NE(frames_start, sample->head());
+    ASSERT_EQ(STREAMING_HEAD_FRAMES, sample->head_frames());
+    EXPECT_FLOAT_EQ(static_cast<float>(STREAMING_HEAD_FRAMES + 1), sample->head()[STREAMING_HEAD_FRAMES + 1]);
+
+    std::vector<float> buffer(100);
+    ASSERT_EQ(100, sample->reader()->read(STREAMING_HEAD_FRAMES + 10, buffer.data(), 100));
+    EXPECT_FLOAT_EQ(static_cast<float>(STREAMING_HEAD_FRAMES + 10), buffer[0]);
+
+    /* Short samples are copied completely, followed by zeroed guard frames */
+    std::vector<float> short_frames(100, 1.0f);
+    path = write_float_wav(short_frames);
+    blob = MappedBlob::map(path);
+    unlink(path.c_str());
+    ASSERT_TRUE(find_float_frames(path, *blob, frames_start, frame_count));
+    sample.reset(create_mapped_sample(blob, frames_start, frame_count, false));
+    EXPECT_FALSE(sample->streamed());
+    ASSERT_EQ(100, sample->head_frames());
+    EXPECT_FLOAT_EQ(1.0f, sample->head()[99]);
+    EXPECT_FLOAT_EQ(0.0f, sample->head()[100]);
+    EXPECT_FLOAT_EQ(0.0f, sample->head()[101]);
 }
 
 TEST_F(TestSamplePlayerPlugin, TestProcessing)
 {
     SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(1);
     SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(1);
-    _module_under_test->_sample.set_sample(SAMPLE_DATA, SAMPLE_DATA_LENGTH);
+    _module_under_test->_set_sample(new SampleData(std::vector<float>(SAMPLE_DATA, SAMPLE_DATA + SAMPLE_DATA_LENGTH)));
     out_buffer.clear();
     _module_under_test->process_audio(in_buffer, out_buffer);
     test_utils::assert_buffer_value(0.0f, out_buffer);
@@ -151,9 +474,9 @@ TEST_F(TestSamplePlayerPlugin, TestEventProcessing)
 {
     SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(1);
     SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(1);
-    BlobData data = _module_under_test->load_sample_file(test_utils::get_data_dir_path().append(SAMPLE_FILE));
-    ASSERT_NE(0, data.size);
-    _module_under_test->_sample.set_sample(reinterpret_cast<float*>(data.data), data.size * sizeof(float));
+    SampleData* data = _module_under_test->load_sample_file(test_utils::get_data_dir_path().append(SAMPLE_FILE));
+    ASSERT_NE(nullptr, data);
+    _module_under_test->_set_sample(data);
     out_buffer.clear();
     RtEvent note_on = RtEvent::make_note_on_event(0, 5, 0, 60, 1.0f);
     RtEvent note_on2 = RtEvent::make_note_on_event(0, 50, 0, 65, 1.0f);
@@ -174,5 +497,63 @@ TEST_F(TestSamplePlayerPlugin, TestEventProcessing)
     _module_under_test->set_bypassed(false);
     _module_under_test->process_audio(in_buffer, out_buffer);
     test_utils::assert_buffer_value(0.0f, out_buffer);
-    delete data.data;
+}
+
+TEST_F(TestSamplePlayerPlugin, TestVoiceStealing)
+{
+    _module_under_test->_set_sample(new SampleData(std::vector<float>(100000, 1.0f)));
+    auto polyphony_id = _module_under_test->parameter_from_name("polyphony")->id();
+    _module_under_test->process_event(RtEvent::make_parameter_change_event(0, 0, polyphony_id, 1.0f / (MAX_POLYPHONY - 1)));
+    ASSERT_EQ(2, _module_under_test->_polyphony_parameter->processed_value());
+
+    auto& voices = _module_under_test->_voices;
+    _module_under_test->process_event(RtEvent::make_note_on_event(0, 0, 0, 60, 1.0f));
+    _module_under_test->process_event(RtEvent::make_note_on_event(0, 0, 0, 62, 1.0f));
+    EXPECT_EQ(60, voices[0].current_note());
+    EXPECT_EQ(62, voices[1].current_note());
+
+    /* With all voices playing, the oldest one should be stolen */
+    _module_under_test->process_event(RtEvent::make_note_on_event(0, 0, 0, 64, 1.0f));
+    EXPECT_EQ(64, voices[0].current_note());
+    EXPECT_EQ(62, voices[1].current_note());
+    EXPECT_FALSE(voices[2].active());
+
+    /* A released voice should be stolen before the oldest one */
+    _module_under_test->process_event(RtEvent::make_note_off_event(0, 0, 0, 64, 1.0f));
+    _module_under_test->process_event(RtEvent::make_note_on_event(0, 0, 0, 65, 1.0f));
+    EXPECT_EQ(65, voices[0].current_note());
+    EXPECT_EQ(62, voices[1].current_note());
+}
+
+TEST_F(TestSamplePlayerPlugin, TestStreamRequests)
+{
+    RtSafeRtEventFifo queue;
+    _module_under_test->set_event_output(&queue);
+    EXPECT_EQ(nullptr, _module_under_test->_voices[0].stream()._pages);
+    _module_under_test->_allocate_streams();
+    _module_under_test->_set_sample(make_streamed_ramp(1000, 100000));
+    SampleBuffer<AUDIO_CHUNK_SIZE> in_buffer(1);
+    SampleBuffer<AUDIO_CHUNK_SIZE> out_buffer(1);
+
+    /* No request should be made when no voices are playing */
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    ASSERT_TRUE(queue.empty());
+
+    _module_under_test->process_event(RtEvent::make_note_on_event(0, 0, 0, 60, 1.0f));
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    RtEvent event;
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_EQ(RtEventType::ASYNC_WORK, event.type());
+
+    /* Only one request should be outstanding at a time */
+    _module_under_test->process_audio(in_buffer, out_buffer);
+    ASSERT_TRUE(queue.empty());
+
+    auto typed_event = event.async_work_event();
+    int status = typed_event->callback()(typed_event->callback_data(), typed_event->event_id());
+    EXPECT_FALSE(_module_under_test->_voices[0].stream().needs_data());
+    _module_under_test->process_event(RtEvent::make_async_work_completion_event(typed_event->processor_id(),
+                                                                                typed_event->event_id(),
+                                                                                status));
+    EXPECT_FALSE(_module_under_test->_stream_request_pending);
 }
@@ -0,0 +1,78 @@
+/**
+ * @brief Replacement global operator new/delete with per thread allocation counting
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+namespace {
+thread_local bool counting_enabled = false;
+thread_local int allocation_count = 0;
+
+void* counted_malloc(std::size_t size)
+{
+    if (counting_enabled)
+    {
+        allocation_count++;
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+} // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept
+{
+    std::free(ptr);
+}
+
+namespace test_utils {
+
+AllocationCounter::AllocationCounter()
+{
+    allocation_count = 0;
+    counting_enabled = true;
+}
+
+AllocationCounter::~AllocationCounter()
+{
+    counting_enabled = false;
+}
+
+int AllocationCounter::allocations() const
+{
+    return allocation_count;
+}
+
+} // end namespace test_utils
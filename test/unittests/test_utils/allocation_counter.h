@@ -0,0 +1,32 @@
+/**
+ * @brief Utility for counting heap allocations made from the current thread,
+ *        used to verify that realtime code paths do not allocate.
+ * @copyright 2017-2019 Modern Ancient Instruments Networked AB, dba Elk, Stockholm
+ */
+
+#ifndef SUSHI_ALLOCATION_COUNTER_H
+#define SUSHI_ALLOCATION_COUNTER_H
+
+namespace test_utils {
+
+/**
+ * @brief Counts calls to the global operator new made on the calling thread
+ *        during the lifetime of the object. Counting is implemented by the
+ *        replacement operator new in allocation_counter.cpp.
+ */
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+
+    ~AllocationCounter();
+
+    /**
+     * @return The number of allocations made on this thread since construction
+     */
+    int allocations() const;
+};
+
+} // end namespace test_utils
+
+#endif //SUSHI_ALLOCATION_COUNTER_H
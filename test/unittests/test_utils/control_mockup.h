@@ -193,6 +193,16 @@ public:
         return std::pair<ControlStatus, CpuTimings>(default_control_status, default_timings);
     };
 
+    virtual std::pair<ControlStatus, std::vector<AudioLevel>> get_engine_input_levels() const override
+    {
+        return std::pair<ControlStatus, std::vector<AudioLevel>>(default_control_status, {});
+    };
+
+    virtual std::pair<ControlStatus, std::vector<AudioLevel>> get_engine_output_levels() const override
+    {
+        return std::pair<ControlStatus, std::vector<AudioLevel>>(default_control_status, {});
+    };
+
     virtual ControlStatus reset_all_timings() override
     {
         _recently_called = true;
@@ -338,6 +348,13 @@ public:
 
     virtual ControlStatus set_string_property_value(int /* processor_id */, int /* parameter_id */, const std::string& /* value */) override { return default_control_status; };
 
+    virtual std::pair<ControlStatus, std::vector<uint8_t>> save_session() const override
+    {
+        return std::pair<ControlStatus, std::vector<uint8_t>>(default_control_status, std::vector<uint8_t>());
+    };
+
+    virtual ControlStatus restore_session(const std::vector<uint8_t>& /* session */) override { return default_control_status; };
+
     std::unordered_map<std::string,std::string> get_args_from_last_call()
     {
         return _args_from_last_call;
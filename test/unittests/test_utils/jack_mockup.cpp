@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cerrno>
+
 #include <jack/jack.h>
 #include <jack/midiport.h>
 
@@ -7,9 +10,16 @@
 
 constexpr int JACK_NFRAMES = 128;
 constexpr uint64_t FRAMETIME_64_SMP_44100 = 64 * 1000000 / 48000;
+constexpr jack_nframes_t MIDI_EVENT_TIME = 70;
 uint8_t midi_buffer[3] = {0x81, 60, 45};
 float buffer[JACK_NFRAMES];
 
+/* Last midi event written to an output port */
+jack_nframes_t written_midi_time = 0;
+uint8_t written_midi_data[3] = {0, 0, 0};
+size_t written_midi_size = 0;
+int written_midi_count = 0;
+
 struct _jack_port
 {
     int no{0};
@@ -49,7 +59,7 @@ jack_port_t * jack_port_register (jack_client_t* client,
                                   unsigned long /*buffer_size*/)
 {
     static int i = 0;
-    return &client->mocked_ports[i++];
+    return &client->mocked_ports[i++ % 10];
 }
 
 int jack_set_process_callback (jack_client_t* client,
@@ -96,11 +106,35 @@ int jack_midi_event_get(jack_midi_event_t *event,
                         void* /*port_buffer*/,
                         uint32_t /*event_index*/)
 {
+    event->time = MIDI_EVENT_TIME;
     event->size = 3;
     event->buffer = midi_buffer;
     return 0;
 }
 
+void jack_midi_clear_buffer(void* /*port_buffer*/)
+{
+    written_midi_time = 0;
+    written_midi_count = 0;
+}
+
+int jack_midi_event_write(void* /*port_buffer*/,
+                          jack_nframes_t time,
+                          const jack_midi_data_t* data,
+                          size_t data_size)
+{
+    /* Like Jack, refuse events that are earlier than the previously written event */
+    if (written_midi_count > 0 && time < written_midi_time)
+    {
+        return ENOBUFS;
+    }
+    ++written_midi_count;
+    written_midi_time = time;
+    written_midi_size = data_size;
+    std::copy(data, data + std::min<size_t>(data_size, 3), written_midi_data);
+    return 0;
+}
+
 
 int jack_get_cycle_times(const jack_client_t* /*client*/, jack_nframes_t* current_frames,
                          jack_time_t* current_usecs, jack_time_t* next_usecs, float* period_usecs)
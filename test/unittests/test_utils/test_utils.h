@@ -22,7 +22,7 @@ inline void fill_sample_buffer(SampleBuffer <size> &buffer, float value)
 {
     for (int ch = 0; ch < buffer.channel_count(); ++ch)
     {
-        std::fill(buffer.channel(ch), buffer.channel(ch) + size, value);
+        std::fill(buffer.channel(ch), buffer.channel(ch) + buffer.frame_count(), value);
     }
 };
 
@@ -31,7 +31,7 @@ inline void assert_buffer_value(float value, const SampleBuffer <size> &buffer)
 {
     for (int ch = 0; ch < buffer.channel_count(); ++ch)
     {
-        for (int i = 0; i < size; ++i)
+        for (int i = 0; i < buffer.frame_count(); ++i)
         {
             ASSERT_FLOAT_EQ(value, buffer.channel(ch)[i]);
         }
@@ -43,7 +43,7 @@ inline void assert_buffer_value(float value, const SampleBuffer <size> &buffer,
 {
     for (int ch = 0; ch < buffer.channel_count(); ++ch)
     {
-        for (int i = 0; i < size; ++i)
+        for (int i = 0; i < buffer.frame_count(); ++i)
         {
             ASSERT_NEAR(value, buffer.channel(ch)[i], error_margin);
         }
@@ -99,6 +99,24 @@ inline void print_buffer(ChunkSampleBuffer& buffer, int channels)
     }
 }
 
+// Restores the global audio chunk size when going out of scope, so that a test
+// changing it does not leak the new size into tests run after it.
+class AudioChunkSizeGuard
+{
+public:
+    AudioChunkSizeGuard() : _chunk_size(audio_chunk_size()) {}
+
+    ~AudioChunkSizeGuard()
+    {
+        set_audio_chunk_size(_chunk_size);
+    }
+
+    AudioChunkSizeGuard(const AudioChunkSizeGuard&) = delete;
+    AudioChunkSizeGuard& operator=(const AudioChunkSizeGuard&) = delete;
+
+private:
+    int _chunk_size;
+};
 
 // Macro to hide unused variable warnings when using structured bindings
 #define DECLARE_UNUSED(var) [[maybe_unused]] auto unused_##var = var